@@ -0,0 +1,216 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+
+#include "ofs/asset_cook.h"
+#include "ofs/shader.h"
+#include "ofs/mesh.h"
+#include "ofs/bench.h"
+
+// Startup from the sources against startup from an asset pack.
+//  - sources: every shader under ../shader read and preprocessed, every image
+//    in ../resources decoded and uploaded with its mips, the built-in meshes
+//    generated and optimised
+//  - pack / pack bc: the same from a pack cooked here, with 8-bit textures and
+//    with BC1/BC7 ones
+//  - one scene: a fresh mount loading only what lighting_casters_directional
+//    uses, and how much of the mapping that brings in (Linux only)
+//
+// Textures from the 8-bit pack must match the decoded sources or the bench fails.
+
+const int ROUNDS = 10;
+const char* PACK = "bench_assets.pack";
+const char* PACK_BC = "bench_assets_bc.pack";
+
+struct Sources {
+    std::vector<std::string> shaders;
+    std::vector<std::string> images;
+};
+
+Sources findSources() {
+    Sources sources;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator("../shader")) {
+        if (entry.path().extension() == ".glsl") {
+            sources.shaders.push_back(entry.path().string());
+        }
+    }
+    for (const auto &entry : std::filesystem::directory_iterator("../resources")) {
+        if (entry.path().extension() != ".ktx2") {
+            sources.images.push_back(entry.path().string());
+        }
+    }
+    std::sort(sources.shaders.begin(), sources.shaders.end());
+    std::sort(sources.images.begin(), sources.images.end());
+    return sources;
+}
+
+bool cook(const Sources &sources, const char* path, bool compress) {
+    AssetPackWriter writer;
+    for (const std::string &shader : sources.shaders) {
+        writer.addShader(shader);
+    }
+    for (const std::string &image : sources.images) {
+        uint32_t vkFormat = 0;
+        if (compress) {
+            int width, height, channels;
+            stbi_info(image.c_str(), &width, &height, &channels);
+            vkFormat = channels == 4 ? VK_FORMAT_BC7_UNORM_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+        }
+        writer.addTexture(image, true, vkFormat);
+    }
+    for (const BuiltinMesh &mesh : BUILTIN_MESHES) {
+        writer.addMesh(mesh.name, mesh.build());
+    }
+    return writer.write(path);
+}
+
+// Loads a scene the way the demos do. Returns the textures, still acquired.
+std::vector<unsigned int> load(const std::vector<std::string> &shaders, const std::vector<std::string> &images,
+                               const std::vector<std::string> &meshNames) {
+    ShaderPreprocessor preprocessor;
+    ShaderSource source;
+    for (const std::string &shader : shaders) {
+        preprocessor.process(shader, "", source);
+    }
+    std::vector<unsigned int> textures;
+    for (const std::string &image : images) {
+        textures.push_back(TextureCache::instance().acquire(image));
+    }
+    MeshBuffer meshes;
+    for (const std::string &name : meshNames) {
+        meshes.addBuiltin(name);
+    }
+    meshes.upload();
+    glFinish();
+    return textures;
+}
+
+void release(const std::vector<unsigned int> &textures) {
+    for (unsigned int texture : textures) {
+        TextureCache::instance().release(texture);
+    }
+}
+
+double time(const Sources &sources, const std::vector<std::string> &meshNames) {
+    BenchTimer timer;
+    for (int i = 0; i < ROUNDS; i++) {
+        release(load(sources.shaders, sources.images, meshNames));
+    }
+    return timer.elapsedMs() / ROUNDS;
+}
+
+std::vector<unsigned char> readLevel0(unsigned int texture) {
+    int width, height;
+    GLStateCache::instance().bindTexture(GL_TEXTURE_2D, texture);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+    std::vector<unsigned char> pixels((size_t) width * height * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    return pixels;
+}
+
+// Resident size of the mapping of path in this process, -1 where unknown.
+long mappedResidentKiB(const std::string &path) {
+#ifdef __linux__
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    bool inPack = false;
+    std::string name = std::filesystem::absolute(path).lexically_normal().string();
+    while (std::getline(smaps, line)) {
+        if (!line.empty() && isxdigit((unsigned char) line[0]) && line.find('-') != std::string::npos
+            && line.find(' ') > line.find('-')) {
+            inPack = line.size() >= name.size() && line.compare(line.size() - name.size(), name.size(), name) == 0;
+        } else if (inPack && line.compare(0, 4, "Rss:") == 0) {
+            return std::stol(line.substr(4));
+        }
+    }
+#endif
+    return -1;
+}
+
+int main(int argc, char** argv) {
+    Context context(argc, argv);
+    if (!createBenchContext(context, 64, 64, "bench_asset_pack")) {
+        return 1;
+    }
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+
+    Sources sources = findSources();
+    std::vector<std::string> meshNames;
+    for (const BuiltinMesh &mesh : BUILTIN_MESHES) {
+        meshNames.push_back(mesh.name);
+    }
+    AssetPack &pack = AssetPack::instance();
+    pack.unmount();
+
+    BenchTimer cookTimer;
+    bool cooked = cook(sources, PACK, false);
+    double cookMs = cookTimer.elapsedMs();
+    cooked = cooked && cook(sources, PACK_BC, true);
+    if (!cooked) {
+        return 1;
+    }
+    std::cout << sources.shaders.size() << " shaders, " << sources.images.size() << " images, " << meshNames.size()
+              << " meshes, cooked in " << cookMs << " ms" << std::endl;
+
+    std::vector<unsigned int> reference = load({}, sources.images, {});
+    std::vector<std::vector<unsigned char>> expected;
+    for (unsigned int texture : reference) {
+        expected.push_back(readLevel0(texture));
+    }
+    release(reference);
+
+    double sourcesMs = time(sources, meshNames);
+    std::cout << "sources: " << sourcesMs << " ms" << std::endl;
+
+    pack.mount(PACK);
+    double packMs = time(sources, meshNames);
+    std::vector<unsigned int> packed = load({}, sources.images, {});
+    bool same = true;
+    for (size_t i = 0; i < packed.size(); i++) {
+        same = same && readLevel0(packed[i]) == expected[i];
+    }
+    release(packed);
+    std::cout << "pack:    " << packMs << " ms (" << sourcesMs / packMs << "x), textures "
+              << (same ? "identical" : "DIFFER") << std::endl;
+
+    if (compressedFormatSupported(VK_FORMAT_BC1_RGB_UNORM_BLOCK) && compressedFormatSupported(VK_FORMAT_BC7_UNORM_BLOCK)) {
+        pack.mount(PACK_BC);
+        double bcMs = time(sources, meshNames);
+        std::cout << "pack bc: " << bcMs << " ms (" << sourcesMs / bcMs << "x), "
+                  << pack.mappedBytes() / 1024 << " KiB pack" << std::endl;
+    } else {
+        std::cout << "pack bc: BC1/BC7 not supported by the driver" << std::endl;
+    }
+
+    pack.mount(PACK);
+    pack.stats = AssetPackStats();
+    std::vector<unsigned int> scene = load({"../shader/lighting/lamp.vs.glsl", "../shader/lighting/lamp.fs.glsl",
+                                            "../shader/lighting/light.vs.glsl", "../shader/lighting/light.fs.glsl"},
+                                           {"../resources/wood_container.png", "../resources/wood_container_specular_map.png"},
+                                           {"cube"});
+    long residentKiB = mappedResidentKiB(PACK);
+    std::cout << "one scene: " << pack.stats.hits << " entries, " << pack.stats.bytesServed / 1024 << " KiB served";
+    if (residentKiB >= 0) {
+        std::cout << ", " << residentKiB << " of " << pack.mappedBytes() / 1024 << " KiB mapped in";
+    }
+    std::cout << std::endl;
+    release(scene);
+
+    pack.unmount();
+    std::filesystem::remove(PACK);
+    std::filesystem::remove(PACK_BC);
+    if (!same) {
+        std::cout << "Textures from the pack differ from the decoded sources" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,180 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+
+#include "ofs/shader.h"
+#include "ofs/mesh.h"
+#include "ofs/uniform_buffer.h"
+#include "ofs/instancing.h"
+#include "ofs/clustered_lights.h"
+#include "ofs/bench.h"
+
+// Clustered forward shading from 1 to 4096 lights, doubling each step:
+//  - light assignment on the CPU, on one thread and on every worker
+//  - GPU frame time shading each fragment's cluster, and shading every light
+//    (the ALL_LIGHTS permutation) for reference
+//
+// Usage: ofs_bench_clustered_lights [--headless] [max lights] [frames] [max reference lights]
+// The reference gets slow quickly on software rasterisers, so it stops at 512
+// lights unless told otherwise. Where both run they must produce the same
+// picture, or the bench fails.
+
+const int TARGET_WIDTH = 320;
+const int TARGET_HEIGHT = 180;
+const float NEAR_PLANE = 0.1f;
+const float FAR_PLANE = 100.0f;
+const int FLOOR_SIDE = 40;
+
+// A floor of flat tiles with a cube standing on every third one.
+std::vector<glm::mat4> scene() {
+    std::vector<glm::mat4> models;
+    for (int z = 0; z < FLOOR_SIDE; z++) {
+        for (int x = 0; x < FLOOR_SIDE; x++) {
+            glm::vec3 position(2.0f * (x - FLOOR_SIDE / 2), -1.0f, -2.0f * z);
+            models.push_back(glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(1.9f, 0.1f, 1.9f)));
+            if ((x + z) % 3 == 0) {
+                glm::mat4 model = glm::translate(glm::mat4(1.0f), position + glm::vec3(0.0f, 0.5f, 0.0f));
+                models.push_back(glm::rotate(model, glm::radians(15.0f * x), glm::vec3(0.0f, 1.0f, 0.0f)));
+            }
+        }
+    }
+    return models;
+}
+
+// Deterministic lights over the floor, one in four a spot pointing down.
+std::vector<ClusterLight> lightField(int count) {
+    std::vector<ClusterLight> lights;
+    uint32_t seed = 12345;
+    auto random = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) / (float) (1 << 24);
+    };
+    for (int i = 0; i < count; i++) {
+        glm::vec3 position((random() - 0.5f) * 2.0f * FLOOR_SIDE, random() * 3.0f, -random() * 2.0f * FLOOR_SIDE);
+        glm::vec3 color = glm::vec3(0.2f) + 0.8f * glm::vec3(random(), random(), random());
+        if (i % 4 == 3) {
+            lights.push_back(spotLight(position + glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), color, 8.0f, 25.0f, 35.0f));
+        } else {
+            lights.push_back(pointLight(position, color, 5.0f));
+        }
+    }
+    return lights;
+}
+
+double assignMs(ClusteredLights &clusters, const std::vector<ClusterLight> &lights, int frames) {
+    BenchTimer timer;
+    for (int frame = 0; frame < frames; frame++) {
+        clusters.assign(lights.data(), lights.size());
+    }
+    return timer.elapsedMs() / frames;
+}
+
+double drawMs(Shader &shader, const InstanceBuffer &instances, const Mesh &cube, int frames) {
+    shader.use();
+    return benchFrameMs(frames, [&]() {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        instances.draw(cube);
+    });
+}
+
+int main(int argc, char** argv) {
+    Context context(argc, argv);
+    std::vector<int> numbers = benchNumbers(context);
+    int maxLights = numbers.size() > 0 ? numbers[0] : 4096;
+    int frames = numbers.size() > 1 ? numbers[1] : 5;
+    int maxReference = numbers.size() > 2 ? numbers[2] : 512;
+
+    if (!createBenchContext(context, 64, 64, "bench_clustered_lights")) {
+        return 1;
+    }
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+    createBenchFramebuffer(TARGET_WIDTH, TARGET_HEIGHT);
+    GLStateCache &state = GLStateCache::instance();
+    state.enable(GL_DEPTH_TEST);
+
+    Shader clusteredShader("../shader/lighting/light.vs.glsl", "../shader/lighting/clustered.fs.glsl", "INSTANCED");
+    Shader referenceShader("../shader/lighting/light.vs.glsl", "../shader/lighting/clustered.fs.glsl", "ALL_LIGHTS|INSTANCED");
+
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 5.0f, 6.0f), glm::vec3(0.0f, 0.0f, -20.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), (float) TARGET_WIDTH / TARGET_HEIGHT, NEAR_PLANE, FAR_PLANE);
+    UniformBuffer<CameraBlock> cameraBlock(CAMERA_BLOCK_BINDING);
+    cameraBlock.data.view = view;
+    cameraBlock.data.projection = projection;
+    cameraBlock.data.viewPos = glm::vec3(0.0f, 5.0f, 6.0f);
+    cameraBlock.upload();
+
+    unsigned int white = createWhiteTexture();
+
+    int threads = std::max(4, ClusteredLights::defaultThreads());
+    ClusteredLights serial(16, 9, 24, 1);
+    ClusteredLights clusters(16, 9, 24, threads);
+    serial.setView(view, projection, NEAR_PLANE, FAR_PLANE, TARGET_WIDTH, TARGET_HEIGHT);
+    clusters.setView(view, projection, NEAR_PLANE, FAR_PLANE, TARGET_WIDTH, TARGET_HEIGHT);
+    for (Shader* shader : {&clusteredShader, &referenceShader}) {
+        clusters.attach(*shader);
+        shader->setInt("diffuseTexture", 0);
+        shader->setVec3("material.specular", glm::vec3(0.5f));
+        shader->setFloat("material.shininess", 32.0f);
+    }
+
+    MeshBuffer meshes;
+    Mesh cube = meshes.addBuiltin("cube");
+    meshes.upload();
+    unsigned int vao = meshes.createVAO();
+    std::vector<glm::mat4> models = scene();
+    InstanceBuffer instances;
+    instances.attach(vao);
+    instances.upload(models.data(), models.size());
+    state.bindVertexArray(vao);
+
+    std::cout << models.size() << " objects, " << TARGET_WIDTH << "x" << TARGET_HEIGHT << ", "
+              << clusters.tilesX << "x" << clusters.tilesY << "x" << clusters.slices << " clusters, "
+              << frames << " frames" << std::endl;
+    std::cout << std::setw(6) << "lights" << std::setw(12) << "1 thread" << std::setw(12) << (std::to_string(threads) + " threads")
+              << std::setw(10) << "indices" << std::setw(12) << "clustered" << std::setw(12) << "all lights" << std::endl;
+
+    bool ok = true;
+    std::cout << std::fixed << std::setprecision(3);
+    for (int count = 1; count <= maxLights; count *= 2) {
+        std::vector<ClusterLight> lights = lightField(count);
+        double serialMs = assignMs(serial, lights, frames);
+        double threadedMs = assignMs(clusters, lights, frames);
+        clusters.upload();
+        clusters.bind();
+
+        double clusteredMs = drawMs(clusteredShader, instances, cube, frames);
+        std::vector<unsigned char> clusteredImage = readBenchTarget(TARGET_WIDTH, TARGET_HEIGHT);
+        std::cout << std::setw(6) << count << std::setw(10) << serialMs << " ms" << std::setw(10) << threadedMs << " ms"
+                  << std::setw(10) << clusters.lightIndices().size() << std::setw(10) << clusteredMs << " ms";
+
+        if (count > maxReference) {
+            std::cout << std::setw(12) << "-" << std::endl;
+            continue;
+        }
+        double referenceMs = drawMs(referenceShader, instances, cube, frames);
+        std::vector<unsigned char> referenceImage = readBenchTarget(TARGET_WIDTH, TARGET_HEIGHT);
+        int maxDiff = 0;
+        for (size_t i = 0; i < clusteredImage.size(); i++) {
+            maxDiff = std::max(maxDiff, std::abs(clusteredImage[i] - referenceImage[i]));
+        }
+        std::cout << std::setw(10) << referenceMs << " ms" << std::endl;
+        // only the summation order differs
+        if (maxDiff > 2) {
+            std::cout << "Clustered image differs from shading every light, max channel difference " << maxDiff << std::endl;
+            ok = false;
+        }
+    }
+    if (clusters.droppedIndices > 0) {
+        std::cout << clusters.droppedIndices << " light indices did not fit into the texture buffer" << std::endl;
+    }
+
+    state.deleteTextures(1, &white);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+
+#include "ofs/shader.h"
+#include "ofs/mesh.h"
+#include "ofs/uniform_buffer.h"
+#include "ofs/instancing.h"
+#include "ofs/clustered_lights.h"
+#include "ofs/gbuffer.h"
+#include "ofs/bench.h"
+
+// Forward against deferred shading of the same clustered lights, over a
+// block of cubes deep enough that most fragments a forward pass shades are
+// covered later:
+//  - forward: shader/lighting/clustered.fs.glsl, lighting every fragment
+//  - deferred: the G-buffer pass, then one lighting pass over the visible
+//    pixels
+//
+// Usage: ofs_bench_deferred [--headless] [max lights] [frames], 16 to 4096 lights by default.
+// Both must produce the same picture up to the G-buffer's precision, or the
+// bench fails.
+
+const int TARGET_WIDTH = 320;
+const int TARGET_HEIGHT = 180;
+const float NEAR_PLANE = 0.1f;
+const float FAR_PLANE = 100.0f;
+const int BLOCK_LAYERS = 12;
+
+// Deterministic lights in and around the block, one in four a spot.
+std::vector<ClusterLight> lightField(int count) {
+    std::vector<ClusterLight> lights;
+    uint32_t seed = 12345;
+    auto random = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) / (float) (1 << 24);
+    };
+    for (int i = 0; i < count; i++) {
+        glm::vec3 position((random() - 0.5f) * 1.6f * BENCH_BLOCK_SIDE, (random() - 0.5f) * 0.8f * BENCH_BLOCK_SIDE, -2.0f - random() * 1.6f * BLOCK_LAYERS);
+        glm::vec3 color = glm::vec3(0.2f) + 0.8f * glm::vec3(random(), random(), random());
+        if (i % 4 == 3) {
+            lights.push_back(spotLight(position, glm::vec3(0.0f, 0.0f, -1.0f), color, 6.0f, 25.0f, 35.0f));
+        } else {
+            lights.push_back(pointLight(position, color, 3.0f));
+        }
+    }
+    return lights;
+}
+
+int main(int argc, char** argv) {
+    Context context(argc, argv);
+    std::vector<int> numbers = benchNumbers(context);
+    int maxLights = numbers.size() > 0 ? numbers[0] : 4096;
+    int frames = numbers.size() > 1 ? numbers[1] : 5;
+
+    if (!createBenchContext(context, 64, 64, "bench_deferred")) {
+        return 1;
+    }
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+    unsigned int target = createBenchFramebuffer(TARGET_WIDTH, TARGET_HEIGHT);
+    GLStateCache &state = GLStateCache::instance();
+    state.enable(GL_DEPTH_TEST);
+
+    Shader forwardShader("../shader/lighting/light.vs.glsl", "../shader/lighting/clustered.fs.glsl", "INSTANCED");
+    Shader geometryShader("../shader/lighting/light.vs.glsl", "../shader/deferred/gbuffer.fs.glsl", "INSTANCED");
+    Shader lightingShader("../shader/deferred/fullscreen.vs.glsl", "../shader/deferred/lighting.fs.glsl");
+
+    glm::vec3 viewPos(0.0f, 0.0f, 6.0f);
+    glm::mat4 view = glm::lookAt(viewPos, glm::vec3(0.0f, 0.0f, -10.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), (float) TARGET_WIDTH / TARGET_HEIGHT, NEAR_PLANE, FAR_PLANE);
+    UniformBuffer<CameraBlock> cameraBlock(CAMERA_BLOCK_BINDING);
+    cameraBlock.data.view = view;
+    cameraBlock.data.projection = projection;
+    cameraBlock.data.viewPos = viewPos;
+    cameraBlock.upload();
+
+    unsigned int white = createWhiteTexture();
+
+    ClusteredLights clusters;
+    clusters.setView(view, projection, NEAR_PLANE, FAR_PLANE, TARGET_WIDTH, TARGET_HEIGHT);
+    GBuffer gbuffer(TARGET_WIDTH, TARGET_HEIGHT);
+    FullscreenTriangle fullscreen;
+    clusters.attach(forwardShader);
+    clusters.attach(lightingShader);
+    gbuffer.attach(lightingShader);
+    lightingShader.setMat4fv("inverseViewProjection", glm::inverse(projection * view));
+    for (Shader* shader : {&forwardShader, &geometryShader, &lightingShader}) {
+        shader->use();
+        shader->setInt("diffuseTexture", 0);
+        shader->setVec3("material.specular", glm::vec3(0.5f));
+        shader->setFloat("material.shininess", 32.0f);
+    }
+
+    MeshBuffer meshes;
+    Mesh cube = meshes.addBuiltin("cube");
+    meshes.upload();
+    unsigned int vao = meshes.createVAO();
+    std::vector<glm::mat4> models = benchBlock(BLOCK_LAYERS);
+    InstanceBuffer instances;
+    instances.attach(vao);
+    instances.upload(models.data(), models.size());
+
+    std::cout << models.size() << " cubes in " << BLOCK_LAYERS << " layers, " << TARGET_WIDTH << "x" << TARGET_HEIGHT
+              << ", G-buffer " << gbuffer.bytes() / 1024 << " KiB, " << frames << " frames" << std::endl;
+    std::cout << std::setw(6) << "lights" << std::setw(12) << "forward" << std::setw(12) << "deferred" << std::setw(10) << "speedup" << std::endl;
+
+    bool ok = true;
+    for (int count = 16; count <= maxLights; count *= 4) {
+        std::vector<ClusterLight> lights = lightField(count);
+        clusters.assign(lights.data(), lights.size());
+        clusters.upload();
+        clusters.bind();
+        // creating the G-buffer left one of its attachments on the active unit
+        state.bindTexture(0, GL_TEXTURE_2D, white);
+
+        double forwardMs = benchFrameMs(frames, [&]() {
+            state.bindFramebuffer(GL_FRAMEBUFFER, target);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            forwardShader.use();
+            state.bindVertexArray(vao);
+            instances.draw(cube);
+        });
+        std::vector<unsigned char> forwardImage = readBenchTarget(TARGET_WIDTH, TARGET_HEIGHT);
+
+        double deferredMs = benchFrameMs(frames, [&]() {
+            gbuffer.bindForGeometry();
+            geometryShader.use();
+            state.bindVertexArray(vao);
+            instances.draw(cube);
+
+            state.bindFramebuffer(GL_FRAMEBUFFER, target);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            lightingShader.use();
+            gbuffer.bindTextures();
+            state.disable(GL_DEPTH_TEST);
+            fullscreen.draw();
+            state.enable(GL_DEPTH_TEST);
+        });
+        std::vector<unsigned char> deferredImage = readBenchTarget(TARGET_WIDTH, TARGET_HEIGHT);
+
+        int maxDiff = 0;
+        for (size_t i = 0; i < forwardImage.size(); i++) {
+            maxDiff = std::max(maxDiff, std::abs(forwardImage[i] - deferredImage[i]));
+        }
+        std::cout << std::fixed << std::setprecision(3) << std::setw(6) << count << std::setw(9) << forwardMs << " ms"
+                  << std::setw(9) << deferredMs << " ms" << std::setw(9) << std::setprecision(2) << forwardMs / deferredMs << "x" << std::endl;
+        // normals go through RG16F and the specular color through 8 bits
+        if (maxDiff > 8) {
+            std::cout << "Deferred image differs from forward, max channel difference " << maxDiff << std::endl;
+            ok = false;
+        }
+    }
+
+    state.deleteTextures(1, &white);
+    return ok ? 0 : 1;
+}
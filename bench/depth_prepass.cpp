@@ -0,0 +1,152 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+
+#include "ofs/shader.h"
+#include "ofs/mesh.h"
+#include "ofs/uniform_buffer.h"
+#include "ofs/instancing.h"
+#include "ofs/depth_prepass.h"
+#include "ofs/bench.h"
+
+// The lit cubes of the light caster demos (shader/lighting/light.fs.glsl,
+// POINT_LIGHT) over blocks of 1 to 12 layers of cubes drawn back to front,
+// so without help every layer in front overwrites the ones behind it:
+//  - fragments shaded and frame time drawing the block once
+//  - the same with a depth pre-pass in front (ofs/depth_prepass.h), counting
+//    the pre-pass's own time
+//
+// Usage: ofs_bench_depth_prepass [--headless] [max layers] [frames]
+// Both must produce the same picture but for the odd pixel on a cube's edge,
+// or the bench fails.
+
+const int TARGET_WIDTH = 320;
+const int TARGET_HEIGHT = 180;
+
+struct PassResult {
+    double ms = 0.0;
+    unsigned int shaded = 0;
+};
+
+// Draws the block frames times, with or without the pre-pass, and counts
+// the fragments the lighting shader ran for in the last frame.
+PassResult draw(DepthPrepass &prepass, Shader &lightShader, const InstanceBuffer &instances, const Mesh &cube, int frames) {
+    unsigned int query;
+    glGenQueries(1, &query);
+    PassResult result;
+    result.ms = benchFrameMs(frames, [&]() {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if (prepass.enabled) {
+            prepass.beginDepth();
+            instances.draw(cube);
+            prepass.endDepth();
+        }
+        glBeginQuery(GL_SAMPLES_PASSED, query);
+        prepass.beginShading(lightShader);
+        instances.draw(cube);
+        prepass.endShading();
+        glEndQuery(GL_SAMPLES_PASSED);
+    });
+    glGetQueryObjectuiv(query, GL_QUERY_RESULT, &result.shaded);
+    glDeleteQueries(1, &query);
+    return result;
+}
+
+int main(int argc, char** argv) {
+    Context context(argc, argv);
+    std::vector<int> numbers = benchNumbers(context);
+    int maxLayers = numbers.size() > 0 ? numbers[0] : 12;
+    int frames = numbers.size() > 1 ? numbers[1] : 5;
+
+    if (!createBenchContext(context, 64, 64, "bench_depth_prepass")) {
+        return 1;
+    }
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+    createBenchFramebuffer(TARGET_WIDTH, TARGET_HEIGHT);
+    GLStateCache &state = GLStateCache::instance();
+    state.enable(GL_DEPTH_TEST);
+
+    Shader lightShader("../shader/lighting/light.vs.glsl", "../shader/lighting/light.fs.glsl", "POINT_LIGHT|INSTANCED");
+    // no --prepass or --overdraw here, each size runs both ways
+    DepthPrepass prepass(0, NULL);
+
+    glm::vec3 viewPos(0.0f, 0.0f, 6.0f);
+    UniformBuffer<CameraBlock> cameraBlock(CAMERA_BLOCK_BINDING);
+    cameraBlock.data.view = glm::lookAt(viewPos, glm::vec3(0.0f, 0.0f, -10.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    cameraBlock.data.projection = glm::perspective(glm::radians(60.0f), (float) TARGET_WIDTH / TARGET_HEIGHT, 0.1f, 100.0f);
+    cameraBlock.data.viewPos = viewPos;
+    cameraBlock.upload();
+
+    UniformBuffer<LightBlock> lightBlock(LIGHT_BLOCK_BINDING);
+    lightBlock.data.position = glm::vec3(0.0f, 2.0f, 2.0f);
+    lightBlock.data.ambient = glm::vec3(0.1f);
+    lightBlock.data.diffuse = glm::vec3(0.8f);
+    lightBlock.data.specular = glm::vec3(1.0f);
+    lightBlock.data.constant = 1.0f;
+    lightBlock.data.linear = 0.045f;
+    lightBlock.data.quadratic = 0.0075f;
+    lightBlock.upload();
+
+    unsigned int white = createWhiteTexture();
+    lightShader.use();
+    lightShader.setInt("diffuseTexture", 0);
+    lightShader.setVec3("material.specular", glm::vec3(0.5f));
+    lightShader.setFloat("material.shininess", 32.0f);
+
+    MeshBuffer meshes;
+    Mesh cube = meshes.addBuiltin("cube");
+    meshes.upload();
+    unsigned int vao = meshes.createVAO();
+    InstanceBuffer instances;
+    instances.attach(vao);
+    state.bindVertexArray(vao);
+
+    const int pixels = TARGET_WIDTH * TARGET_HEIGHT;
+    std::cout << TARGET_WIDTH << "x" << TARGET_HEIGHT << ", " << frames << " frames, shaded fragments per pixel" << std::endl;
+    std::cout << std::setw(6) << "layers" << std::setw(8) << "cubes" << std::setw(10) << "shaded" << std::setw(12) << "no pre-pass"
+              << std::setw(10) << "shaded" << std::setw(12) << "pre-pass" << std::setw(10) << "speedup" << std::endl;
+
+    bool ok = true;
+    for (int layers = 1; layers <= maxLayers; layers = layers < 4 ? layers * 2 : layers + 4) {
+        std::vector<glm::mat4> models = benchBlock(layers);
+        instances.upload(models.data(), models.size());
+
+        prepass.enabled = false;
+        PassResult without = draw(prepass, lightShader, instances, cube, frames);
+        std::vector<unsigned char> withoutImage = readBenchTarget(TARGET_WIDTH, TARGET_HEIGHT);
+        prepass.enabled = true;
+        PassResult with = draw(prepass, lightShader, instances, cube, frames);
+        std::vector<unsigned char> withImage = readBenchTarget(TARGET_WIDTH, TARGET_HEIGHT);
+
+        // a pixel on the edge two faces of a cube share has the same depth on
+        // both; GL_LESS keeps the first face drawn, GL_EQUAL the last
+        int differing = 0;
+        for (size_t i = 0; i < withoutImage.size(); i += 4) {
+            for (int channel = 0; channel < 3; channel++) {
+                if (std::abs(withoutImage[i + channel] - withImage[i + channel]) > 2) {
+                    differing++;
+                    break;
+                }
+            }
+        }
+        std::cout << std::fixed << std::setw(6) << layers << std::setw(8) << models.size()
+                  << std::setprecision(2) << std::setw(10) << (double) without.shaded / pixels
+                  << std::setprecision(3) << std::setw(9) << without.ms << " ms"
+                  << std::setprecision(2) << std::setw(10) << (double) with.shaded / pixels
+                  << std::setprecision(3) << std::setw(9) << with.ms << " ms"
+                  << std::setprecision(2) << std::setw(9) << without.ms / with.ms << "x" << std::endl;
+        if (differing > pixels / 1000) {
+            std::cout << "Image with the pre-pass differs in " << differing << " pixels" << std::endl;
+            ok = false;
+        }
+    }
+
+    state.deleteTextures(1, &white);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+#include "ofs/shader.h"
+#include "ofs/uniform_buffer.h"
+#include "ofs/instancing.h"
+#include "ofs/bench.h"
+
+// Frame time for a grid of textured cubes drawn two ways:
+//  - one setMat4fv/setMat3fv/glDrawArrays per cube, as the demos used to
+//  - every cube from an InstanceBuffer with a single glDrawArraysInstanced
+//
+// Usage: ofs_bench_instancing [--headless] [cubes] [frames], defaults to 100000 cubes.
+// The render target is small so the per-draw CPU cost is what differs.
+
+const int TARGET_SIZE = 128;
+
+const float CUBE_VERTICES[] = {
+        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+        0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+        -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+
+        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
+        0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
+        -0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
+
+        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+
+        0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+        0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+
+        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 1.0f,
+        0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+        0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 0.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+
+        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f
+};
+
+unsigned int createCubeVAO(unsigned int vbo) {
+    unsigned int vao;
+    glGenVertexArrays(1, &vao);
+    GLStateCache &state = GLStateCache::instance();
+    state.bindVertexArray(vao);
+    state.bindBuffer(GL_ARRAY_BUFFER, vbo);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) 0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) (3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) (6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    return vao;
+}
+
+std::vector<unsigned char> readTarget() {
+    std::vector<unsigned char> pixels(TARGET_SIZE * TARGET_SIZE * 4);
+    glReadPixels(0, 0, TARGET_SIZE, TARGET_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    return pixels;
+}
+
+// Cubes on a square grid in front of the camera, each with its own rotation.
+std::vector<glm::mat4> cubeGrid(int count) {
+    std::vector<glm::mat4> models(count);
+    int side = (int) std::ceil(std::sqrt((double) count));
+    for (int i = 0; i < count; i++) {
+        glm::vec3 position(1.5f * (i % side - side / 2), 1.5f * (i / side - side / 2), -2.0f * side);
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+        models[i] = glm::rotate(model, glm::radians(20.0f * i), glm::vec3(1.0f, 0.3f, 0.5f));
+    }
+    return models;
+}
+
+int main(int argc, char** argv) {
+    Context context(argc, argv);
+    std::vector<int> numbers = benchNumbers(context);
+    int count = numbers.size() > 0 ? numbers[0] : 100000;
+    int frames = numbers.size() > 1 ? numbers[1] : 10;
+
+    if (!createBenchContext(context, 64, 64, "bench_instancing")) {
+        return 1;
+    }
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+    createBenchFramebuffer(TARGET_SIZE, TARGET_SIZE);
+    GLStateCache::instance().enable(GL_DEPTH_TEST);
+
+    Shader loopShader("../shader/lighting/light.vs.glsl", "../shader/lighting/light.fs.glsl", "DIRECTIONAL_LIGHT|SPECULAR_MAP");
+    Shader instancedShader("../shader/lighting/light.vs.glsl", "../shader/lighting/light.fs.glsl", "DIRECTIONAL_LIGHT|SPECULAR_MAP|INSTANCED");
+
+    UniformBuffer<CameraBlock> cameraBlock(CAMERA_BLOCK_BINDING);
+    cameraBlock.data.view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    cameraBlock.data.projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10000.0f);
+    cameraBlock.upload();
+    UniformBuffer<LightBlock> lightBlock(LIGHT_BLOCK_BINDING);
+    lightBlock.data.ambient = glm::vec3(0.2f);
+    lightBlock.data.diffuse = glm::vec3(0.8f);
+    lightBlock.data.direction = glm::vec3(-0.2f, -1.0f, -0.3f);
+    lightBlock.upload();
+
+    // 1x1 white diffuse/specular maps so the lighting shows up in the image check
+    unsigned int white = createWhiteTexture();
+    GLStateCache &state = GLStateCache::instance();
+    state.bindTexture(1, GL_TEXTURE_2D, white);
+    state.activeTexture(0);
+    loopShader.use();
+    loopShader.setInt("diffuseTexture", 0);
+    loopShader.setInt("specularTexture", 1);
+    instancedShader.use();
+    instancedShader.setInt("diffuseTexture", 0);
+    instancedShader.setInt("specularTexture", 1);
+
+    unsigned int vbo;
+    glGenBuffers(1, &vbo);
+    GLStateCache::instance().bindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(CUBE_VERTICES), CUBE_VERTICES, GL_STATIC_DRAW);
+    unsigned int loopVAO = createCubeVAO(vbo);
+    unsigned int instancedVAO = createCubeVAO(vbo);
+
+    std::vector<glm::mat4> models = cubeGrid(count);
+    std::vector<glm::mat3> normals(count);
+    normalMatrices(models.data(), normals.data(), count);
+    InstanceBuffer instances;
+    instances.attach(instancedVAO);
+    instances.upload(models.data(), count);
+
+    // per-draw loop
+    loopShader.use();
+    UniformHandle modelUniform = loopShader.uniform("model");
+    UniformHandle normalMatrixUniform = loopShader.uniform("normalMatrix");
+    GLStateCache::instance().bindVertexArray(loopVAO);
+    double loopMs = 0.0;
+    for (int frame = 0; frame <= frames; frame++) {
+        BenchTimer timer;
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        for (int i = 0; i < count; i++) {
+            loopShader.setMat4fv(modelUniform, models[i]);
+            loopShader.setMat3fv(normalMatrixUniform, normals[i]);
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+        }
+        glFinish();
+        // frame 0 warms up the driver and is not counted
+        if (frame > 0) {
+            loopMs += timer.elapsedMs();
+        }
+    }
+
+    std::vector<unsigned char> loopImage = readTarget();
+
+    // one instanced draw
+    instancedShader.use();
+    GLStateCache::instance().bindVertexArray(instancedVAO);
+    double instancedMs = 0.0;
+    for (int frame = 0; frame <= frames; frame++) {
+        BenchTimer timer;
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        instances.draw(GL_TRIANGLES, 0, 36);
+        glFinish();
+        if (frame > 0) {
+            instancedMs += timer.elapsedMs();
+        }
+    }
+
+    // both paths must produce the same picture
+    std::vector<unsigned char> instancedImage = readTarget();
+    int maxDiff = 0;
+    for (size_t i = 0; i < loopImage.size(); i++) {
+        maxDiff = std::max(maxDiff, std::abs(loopImage[i] - instancedImage[i]));
+    }
+
+    std::cout << count << " cubes, " << frames << " frames" << std::endl;
+    std::cout << "glDrawArrays per cube:  " << loopMs / frames << " ms/frame, " << count << " draws" << std::endl;
+    std::cout << "glDrawArraysInstanced:  " << instancedMs / frames << " ms/frame, 1 draw" << std::endl;
+
+    bool ok = maxDiff <= 1;
+    if (!ok) {
+        std::cout << "Instanced image differs from the per-draw loop, max channel difference " << maxDiff << std::endl;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+#include "ofs/shader.h"
+#include "ofs/mesh.h"
+#include "ofs/uniform_buffer.h"
+#include "ofs/instancing.h"
+#include "ofs/light_bounds.h"
+#include "ofs/bench.h"
+
+// One point light with lighting_casters_point's attenuation (1.0, 0.045,
+// 0.0075) over a large field of cubes, for luminance thresholds from 1/256
+// up:
+//  - unbounded: every fragment computes the light, as before light bounds
+//  - shader: LightBlock.radius set, fragments past it return early
+//  - culled: also cubes outside the radius drawn with AMBIENT_ONLY
+//    (LightCulledInstances), CPU time of the split included
+//
+// Usage: ofs_bench_light_bounds [--headless] [frames]
+// Cutting the light off at the threshold may change a channel by at most what
+// the threshold lets through, or the bench fails.
+
+const int TARGET_WIDTH = 960;
+const int TARGET_HEIGHT = 540;
+const int FIELD_SIDE = 40;
+
+int maxDifference(const std::vector<unsigned char> &a, const std::vector<unsigned char> &b) {
+    int result = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        result = std::max(result, std::abs(a[i] - b[i]));
+    }
+    return result;
+}
+
+// A flat field of cubes around the origin, every other one raised.
+std::vector<glm::mat4> field() {
+    std::vector<glm::mat4> models;
+    for (int z = 0; z < FIELD_SIDE; z++) {
+        for (int x = 0; x < FIELD_SIDE; x++) {
+            glm::vec3 position(1.5f * (x - FIELD_SIDE / 2), (x + z) % 2 == 0 ? -1.0f : -0.5f, 1.5f * (z - FIELD_SIDE / 2));
+            models.push_back(glm::rotate(glm::translate(glm::mat4(1.0f), position), glm::radians(7.0f * x), glm::vec3(0.0f, 1.0f, 0.0f)));
+        }
+    }
+    return models;
+}
+
+struct Scene {
+    unsigned int litVAO;
+    unsigned int unlitVAO;
+    Mesh cube;
+    Shader* lightShader;
+    Shader* ambientShader;
+};
+
+double drawMs(const Scene &scene, LightCulledInstances &instances, const LightVolume* culling, const std::vector<glm::mat4> &models, int frames) {
+    GLStateCache &state = GLStateCache::instance();
+    return benchFrameMs(frames, [&]() {
+        if (culling != NULL) {
+            instances.update(*culling, models.data(), models.size(), UNIT_CUBE_BOUNDING_RADIUS);
+        }
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        scene.lightShader->use();
+        state.bindVertexArray(scene.litVAO);
+        instances.lit.draw(scene.cube);
+        scene.ambientShader->use();
+        state.bindVertexArray(scene.unlitVAO);
+        instances.unlit.draw(scene.cube);
+    });
+}
+
+int main(int argc, char** argv) {
+    Context context(argc, argv);
+    std::vector<int> numbers = benchNumbers(context);
+    int frames = numbers.size() > 0 ? numbers[0] : 5;
+
+    if (!createBenchContext(context, 64, 64, "bench_light_bounds")) {
+        return 1;
+    }
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+    createBenchFramebuffer(TARGET_WIDTH, TARGET_HEIGHT);
+    GLStateCache &state = GLStateCache::instance();
+    state.enable(GL_DEPTH_TEST);
+
+    Shader lightShader("../shader/lighting/light.vs.glsl", "../shader/lighting/light.fs.glsl", "POINT_LIGHT|INSTANCED");
+    Shader ambientShader("../shader/lighting/light.vs.glsl", "../shader/lighting/light.fs.glsl", "POINT_LIGHT|AMBIENT_ONLY|INSTANCED");
+
+    glm::vec3 viewPos(0.0f, 20.0f, 22.0f);
+    UniformBuffer<CameraBlock> cameraBlock(CAMERA_BLOCK_BINDING);
+    cameraBlock.data.view = glm::lookAt(viewPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    cameraBlock.data.projection = glm::perspective(glm::radians(70.0f), (float) TARGET_WIDTH / TARGET_HEIGHT, 0.1f, 200.0f);
+    cameraBlock.data.viewPos = viewPos;
+    cameraBlock.upload();
+
+    UniformBuffer<LightBlock> lightBlock(LIGHT_BLOCK_BINDING);
+    lightBlock.data.position = glm::vec3(0.0f, 1.0f, 0.0f);
+    lightBlock.data.ambient = glm::vec3(0.1f);
+    lightBlock.data.diffuse = glm::vec3(0.5f);
+    lightBlock.data.specular = glm::vec3(1.0f);
+    lightBlock.data.constant = 1.0f;
+    lightBlock.data.linear = 0.045f;
+    lightBlock.data.quadratic = 0.0075f;
+
+    unsigned int white = createWhiteTexture();
+    for (Shader* shader : {&lightShader, &ambientShader}) {
+        shader->use();
+        shader->setInt("diffuseTexture", 0);
+        shader->setVec3("material.specular", glm::vec3(0.5f));
+        shader->setFloat("material.shininess", 32.0f);
+    }
+
+    MeshBuffer meshes;
+    Scene scene;
+    scene.cube = meshes.addBuiltin("cube");
+    meshes.upload();
+    scene.litVAO = meshes.createVAO();
+    scene.unlitVAO = meshes.createVAO();
+    scene.lightShader = &lightShader;
+    scene.ambientShader = &ambientShader;
+    std::vector<glm::mat4> models = field();
+    LightCulledInstances instances;
+    instances.attach(scene.litVAO, scene.unlitVAO);
+
+    // the unbounded reference: no radius, every cube lit
+    lightBlock.data.radius = 0.0f;
+    lightBlock.upload();
+    // one round with both shaders first, so neither is compiled while timed
+    LightVolume warmUp = pointLightVolume(lightBlock.data.position, 10.0f);
+    drawMs(scene, instances, &warmUp, models, 1);
+    instances.update(pointLightVolume(lightBlock.data.position, 1e6f), models.data(), models.size(), UNIT_CUBE_BOUNDING_RADIUS);
+    double unboundedMs = drawMs(scene, instances, NULL, models, frames);
+    std::vector<unsigned char> reference = readBenchTarget(TARGET_WIDTH, TARGET_HEIGHT);
+
+    std::cout << models.size() << " cubes, " << TARGET_WIDTH << "x" << TARGET_HEIGHT << ", " << frames << " frames, unbounded "
+              << std::fixed << std::setprecision(3) << unboundedMs << " ms" << std::endl;
+    std::cout << std::setw(10) << "threshold" << std::setw(9) << "radius" << std::setw(8) << "lit" << std::setw(12) << "shader"
+              << std::setw(12) << "culled" << std::setw(10) << "speedup" << std::setw(6) << "diff" << std::endl;
+
+    bool ok = true;
+    for (float threshold = LIGHT_CUTOFF_LUMINANCE; threshold <= 0.26f; threshold *= 4.0f) {
+        lightBlock.data.radius = attenuationRadius(lightBlock.data, threshold);
+        lightBlock.upload();
+        LightVolume volume = pointLightVolume(lightBlock.data.position, lightBlock.data.radius);
+
+        // every cube through the light's shader, which returns early past the radius
+        instances.update(pointLightVolume(lightBlock.data.position, 1e6f), models.data(), models.size(), UNIT_CUBE_BOUNDING_RADIUS);
+        double shaderMs = drawMs(scene, instances, NULL, models, frames);
+        int shaderDiff = maxDifference(reference, readBenchTarget(TARGET_WIDTH, TARGET_HEIGHT));
+
+        double culledMs = drawMs(scene, instances, &volume, models, frames);
+        int culledDiff = maxDifference(reference, readBenchTarget(TARGET_WIDTH, TARGET_HEIGHT));
+
+        std::cout << std::setw(10) << std::setprecision(4) << threshold << std::setw(9) << std::setprecision(1) << lightBlock.data.radius
+                  << std::setw(8) << instances.lit.count << std::setprecision(3) << std::setw(9) << shaderMs << " ms" << std::setw(9) << culledMs << " ms"
+                  << std::setw(9) << std::setprecision(2) << unboundedMs / culledMs << "x" << std::setw(6) << std::max(shaderDiff, culledDiff) << std::endl;
+        // diffuse and specular may each lose up to threshold, plus rounding
+        int allowed = (int) std::ceil(2.0f * threshold * 255.0f) + 1;
+        if (std::max(shaderDiff, culledDiff) > allowed) {
+            std::cout << "Bounded light differs by more than " << allowed << " from the unbounded one" << std::endl;
+            ok = false;
+        }
+    }
+
+    state.deleteTextures(1, &white);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <array>
+
+#include "ofs/shader.h"
+#include "ofs/uniform_buffer.h"
+#include "ofs/mesh.h"
+#include "ofs/bench.h"
+
+// For every primitive in ofs/mesh.h: memory and post-transform cache behaviour
+// of three layouts, and the time to draw each of them.
+//  - expanded: non-indexed, three vertices per triangle like the old arrays
+//  - scanline: indexed, triangles in generation order
+//  - optimized: indexed, as ofs/mesh.h emits them after optimizeVertexCache
+//
+// ACMR = vertex shader runs per triangle with a 32-entry FIFO cache.
+
+const int FRAMES = 10;
+const int DRAWS_PER_FRAME = 8;
+
+struct Layout {
+    unsigned int vao = 0;
+    unsigned int count = 0;
+    bool indexed = false;
+};
+
+Layout uploadLayout(const std::vector<MeshVertex> &vertices, const std::vector<unsigned int> &indices) {
+    Layout layout;
+    unsigned int vbo;
+    glGenVertexArrays(1, &layout.vao);
+    glGenBuffers(1, &vbo);
+    GLStateCache &state = GLStateCache::instance();
+    state.bindVertexArray(layout.vao);
+    state.bindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(MeshVertex), vertices.data(), GL_STATIC_DRAW);
+    if (!indices.empty()) {
+        unsigned int ebo;
+        glGenBuffers(1, &ebo);
+        state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        layout.indexed = true;
+        layout.count = (unsigned int) indices.size();
+    } else {
+        layout.count = (unsigned int) vertices.size();
+    }
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*) offsetof(MeshVertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*) offsetof(MeshVertex, normal));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*) offsetof(MeshVertex, texCoords));
+    glEnableVertexAttribArray(2);
+    return layout;
+}
+
+double drawMs(const Layout &layout) {
+    GLStateCache::instance().bindVertexArray(layout.vao);
+    BenchTimer timer;
+    for (int frame = 0; frame < FRAMES; frame++) {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        for (int i = 0; i < DRAWS_PER_FRAME; i++) {
+            if (layout.indexed) {
+                glDrawElements(GL_TRIANGLES, layout.count, GL_UNSIGNED_INT, 0);
+            } else {
+                glDrawArrays(GL_TRIANGLES, 0, layout.count);
+            }
+        }
+        glFinish();
+    }
+    return timer.elapsedMs() / FRAMES;
+}
+
+// Triangles sorted by their lowest vertex, which restores the row-by-row order
+// the generators produce before optimizeVertexCache runs.
+std::vector<unsigned int> scanlineOrder(const std::vector<unsigned int> &indices) {
+    std::vector<std::array<unsigned int, 3>> triangles;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        std::array<unsigned int, 3> t = {indices[i], indices[i + 1], indices[i + 2]};
+        // rotate so the winding is kept but the lowest index comes first
+        std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+        triangles.push_back(t);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    std::vector<unsigned int> sorted;
+    for (auto &t : triangles) {
+        sorted.insert(sorted.end(), t.begin(), t.end());
+    }
+    return sorted;
+}
+
+void report(const char* name, const MeshData &mesh) {
+    std::vector<MeshVertex> expanded;
+    for (unsigned int index : mesh.indices) {
+        expanded.push_back(mesh.vertices[index]);
+    }
+    std::vector<unsigned int> scanline = scanlineOrder(mesh.indices);
+
+    size_t expandedBytes = expanded.size() * sizeof(MeshVertex);
+    size_t indexedBytes = mesh.vertices.size() * sizeof(MeshVertex) + mesh.indices.size() * sizeof(unsigned int);
+
+    Layout expandedLayout = uploadLayout(expanded, std::vector<unsigned int>());
+    Layout scanlineLayout = uploadLayout(mesh.vertices, scanline);
+    Layout optimizedLayout = uploadLayout(mesh.vertices, mesh.indices);
+    // first draw of each layout pays for the driver's lazy setup
+    drawMs(expandedLayout);
+    drawMs(scanlineLayout);
+    drawMs(optimizedLayout);
+
+    std::cout << name << ": " << mesh.indices.size() / 3 << " triangles" << std::endl;
+    std::cout << "    expanded:  " << expanded.size() << " vertices, " << expandedBytes / 1024 << " KiB, ACMR 3, "
+              << drawMs(expandedLayout) << " ms/frame" << std::endl;
+    std::cout << "    scanline:  " << mesh.vertices.size() << " vertices, " << indexedBytes / 1024 << " KiB, ACMR "
+              << averageCacheMissRatio(scanline, mesh.vertices.size()) << ", " << drawMs(scanlineLayout) << " ms/frame" << std::endl;
+    std::cout << "    optimized: " << mesh.vertices.size() << " vertices, " << indexedBytes / 1024 << " KiB, ACMR "
+              << averageCacheMissRatio(mesh.indices, mesh.vertices.size()) << ", " << drawMs(optimizedLayout) << " ms/frame" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    Context context(argc, argv);
+    if (!createBenchContext(context, 64, 64, "bench_mesh")) {
+        return 1;
+    }
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+    createBenchFramebuffer(64, 64);
+    GLStateCache::instance().enable(GL_DEPTH_TEST);
+
+    Shader shader("../shader/lighting/light.vs.glsl", "../shader/lighting/light.fs.glsl", "DIRECTIONAL_LIGHT");
+    shader.use();
+    shader.setMat4fv("model", glm::mat4(1.0f));
+    shader.setMat3fv("normalMatrix", glm::mat3(1.0f));
+    UniformBuffer<CameraBlock> cameraBlock(CAMERA_BLOCK_BINDING);
+    cameraBlock.data.view = glm::lookAt(glm::vec3(0.0f, 0.0f, 2.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    cameraBlock.data.projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+    cameraBlock.upload();
+    UniformBuffer<LightBlock> lightBlock(LIGHT_BLOCK_BINDING);
+    lightBlock.upload();
+
+    report("cube", createCube());
+    report("sphere 256x128", createSphere(256, 128));
+    report("plane 256x256", createPlane(256, 256));
+    report("torus 256x128", createTorus(256, 128));
+
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <filesystem>
+
+#include "ofs/texture_cache.h"
+#include "ofs/mipmap.h"
+#include "ofs/bench.h"
+
+// CPU mip chains against glGenerateMipmap.
+//  - scalar / simd: building the chain with downsampleBoxScalar and with
+//    downsampleBox; the two must match byte for byte or the bench fails
+//  - generate: glTexImage2D of level 0 then glGenerateMipmap, the old path
+//  - storage: glTexStorage2D and every level uploaded from a prebuilt chain
+//
+// Synthetic images cover the channel counts and odd sizes the resources do not.
+
+const int CPU_REPEATS = 20;
+const int GPU_REPEATS = 20;
+
+struct Image {
+    std::string name;
+    std::vector<unsigned char> pixels;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+};
+
+Image noise(int width, int height, int channels) {
+    Image image;
+    image.name = "noise " + std::to_string(width) + "x" + std::to_string(height) + "x" + std::to_string(channels);
+    image.width = width;
+    image.height = height;
+    image.channels = channels;
+    image.pixels.resize((size_t) width * height * channels);
+    unsigned int state = 12345;
+    for (unsigned char &value : image.pixels) {
+        state = state * 1664525u + 1013904223u;
+        value = (unsigned char) (state >> 24);
+    }
+    return image;
+}
+
+std::vector<unsigned char> scalarChain(const Image &image) {
+    std::vector<unsigned char> chain(mipChainSize(image.width, image.height, image.channels));
+    std::copy(image.pixels.begin(), image.pixels.end(), chain.begin());
+    unsigned char* level = chain.data();
+    int width = image.width;
+    int height = image.height;
+    while (width > 1 || height > 1) {
+        unsigned char* next = level + (size_t) width * height * image.channels;
+        downsampleBoxScalar(level, width, height, image.channels, next);
+        level = next;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return chain;
+}
+
+// Returns false if the SIMD chain differs from the scalar one.
+bool cpu(const Image &image) {
+    std::vector<unsigned char> reference;
+    BenchTimer scalarTimer;
+    for (int i = 0; i < CPU_REPEATS; i++) {
+        reference = scalarChain(image);
+    }
+    double scalarMs = scalarTimer.elapsedMs() / CPU_REPEATS;
+
+    std::vector<unsigned char> chain;
+    BenchTimer simdTimer;
+    for (int i = 0; i < CPU_REPEATS; i++) {
+        chain = createMipChain(image.pixels.data(), image.width, image.height, image.channels);
+    }
+    double simdMs = simdTimer.elapsedMs() / CPU_REPEATS;
+
+    bool same = chain == reference;
+    std::cout << "    cpu:      scalar " << scalarMs << " ms, simd " << simdMs << " ms ("
+              << scalarMs / simdMs << "x), " << (same ? "identical" : "MISMATCH") << std::endl;
+    return same;
+}
+
+void gpu(const Image &image) {
+    GLenum format = textureFormat(image.channels);
+    std::vector<unsigned int> textures(GPU_REPEATS);
+
+    glGenTextures(GPU_REPEATS, textures.data());
+    glFinish();
+    BenchTimer generateTimer;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (unsigned int texture : textures) {
+        GLStateCache::instance().bindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels.data());
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glFinish();
+    double generateMs = generateTimer.elapsedMs() / GPU_REPEATS;
+    GLStateCache::instance().deleteTextures(GPU_REPEATS, textures.data());
+
+    std::vector<unsigned char> chain = createMipChain(image.pixels.data(), image.width, image.height, image.channels);
+    glGenTextures(GPU_REPEATS, textures.data());
+    glFinish();
+    BenchTimer storageTimer;
+    for (unsigned int texture : textures) {
+        uploadMipChain(texture, chain.data(), image.width, image.height, image.channels);
+    }
+    glFinish();
+    double storageMs = storageTimer.elapsedMs() / GPU_REPEATS;
+    GLStateCache::instance().deleteTextures(GPU_REPEATS, textures.data());
+
+    std::cout << "    gpu:      generate " << generateMs << " ms, storage + prebuilt chain " << storageMs << " ms" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    Context context(argc, argv);
+    if (!createBenchContext(context, 64, 64, "bench_mipmap")) {
+        return 1;
+    }
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+    std::cout << "Immutable storage: " << (GLAD_GL_VERSION_4_2 ? "glTexStorage2D" : "unavailable, glTexImage2D per level") << std::endl;
+
+    std::vector<std::string> paths;
+    for (const auto &entry : std::filesystem::directory_iterator("../resources")) {
+        paths.push_back(entry.path().string());
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<Image> images;
+    for (const std::string &path : paths) {
+        Image image;
+        image.name = std::filesystem::path(path).filename().string();
+        unsigned char* data = stbi_load(path.c_str(), &image.width, &image.height, &image.channels, 0);
+        if (data == NULL) {
+            std::cout << "Failed to load texture: " << path << std::endl;
+            continue;
+        }
+        image.pixels.assign(data, data + (size_t) image.width * image.height * image.channels);
+        stbi_image_free(data);
+        images.push_back(image);
+    }
+    images.push_back(noise(2048, 2048, 4));
+    images.push_back(noise(1023, 777, 4));
+    images.push_back(noise(1024, 1024, 1));
+    images.push_back(noise(333, 1000, 1));
+    images.push_back(noise(1024, 1024, 3));
+    images.push_back(noise(1023, 777, 3));
+    images.push_back(noise(1024, 1024, 2));
+    images.push_back(noise(1, 300, 2));
+
+    bool allSame = true;
+    for (const Image &image : images) {
+        std::cout << image.name << ": " << image.width << "x" << image.height << ", " << image.channels << " channels, "
+                  << mipLevelCount(image.width, image.height) << " levels" << std::endl;
+        allSame = cpu(image) && allSame;
+        gpu(image);
+    }
+
+    if (!allSame) {
+        std::cout << "SIMD mip chain differs from the scalar reference" << std::endl;
+        return 1;
+    }
+    return 0;
+}
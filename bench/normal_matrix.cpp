@@ -0,0 +1,159 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+#include "ofs/shader.h"
+#include "ofs/uniform_buffer.h"
+#include "ofs/transform.h"
+#include "ofs/bench.h"
+
+// Two measurements:
+//  - CPU: glm transpose(inverse()) per matrix against the normalMatrices() batch kernel
+//  - GPU: a high-poly sphere drawn with inverse() in the vertex shader against the
+//    CPU normal matrix uniform. The render target is tiny so the vertex stage
+//    dominates; run with LIBGL_ALWAYS_SOFTWARE=1 to measure llvmpipe.
+
+// small enough to stay in cache so the arithmetic is measured, not memory bandwidth
+const int MATRIX_COUNT = 1 << 14;
+const int CPU_REPEATS = 64;
+const int SEGMENTS = 512;
+const int FRAMES = 20;
+const int DRAWS_PER_FRAME = 4;
+
+void benchCpu() {
+    std::vector<glm::mat4> models(MATRIX_COUNT);
+    std::vector<glm::mat3> normals(MATRIX_COUNT);
+    for (int i = 0; i < MATRIX_COUNT; i++) {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(i % 100, i % 7, i % 13));
+        model = glm::rotate(model, 0.01f * i, glm::vec3(1.0f, 0.3f, 0.5f));
+        models[i] = glm::scale(model, glm::vec3(1.0f + (i % 3)));
+    }
+
+    BenchTimer timer;
+    for (int repeat = 0; repeat < CPU_REPEATS; repeat++) {
+        for (int i = 0; i < MATRIX_COUNT; i++) {
+            normals[i] = glm::transpose(glm::inverse(glm::mat3(models[i])));
+        }
+    }
+    double scalarMs = timer.elapsedMs();
+    float checksum = normals[MATRIX_COUNT / 2][1][1];
+
+    timer.reset();
+    for (int repeat = 0; repeat < CPU_REPEATS; repeat++) {
+        normalMatrices(models.data(), normals.data(), models.size());
+    }
+    double batchMs = timer.elapsedMs();
+    checksum += normals[MATRIX_COUNT / 2][1][1];
+
+    std::cout << "CPU, " << MATRIX_COUNT << " matrices x " << CPU_REPEATS << ": glm " << scalarMs << " ms, normalMatrices " << batchMs
+              << " ms (checksum " << checksum << ")" << std::endl;
+}
+
+// UV sphere with position/normal/uv interleaved like the demo cubes.
+unsigned int createSphere(int segments, int &indexCount) {
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    for (int y = 0; y <= segments; y++) {
+        for (int x = 0; x <= segments; x++) {
+            float u = (float) x / segments;
+            float v = (float) y / segments;
+            float theta = u * 2.0f * (float) M_PI;
+            float phi = v * (float) M_PI;
+            glm::vec3 p(std::cos(theta) * std::sin(phi), std::cos(phi), std::sin(theta) * std::sin(phi));
+            vertices.insert(vertices.end(), {p.x * 0.5f, p.y * 0.5f, p.z * 0.5f, p.x, p.y, p.z, u, v});
+        }
+    }
+    for (int y = 0; y < segments; y++) {
+        for (int x = 0; x < segments; x++) {
+            unsigned int a = y * (segments + 1) + x;
+            unsigned int b = a + segments + 1;
+            indices.insert(indices.end(), {a, b, a + 1, a + 1, b, b + 1});
+        }
+    }
+    indexCount = (int) indices.size();
+
+    unsigned int VAO, VBO, EBO;
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+    GLStateCache &state = GLStateCache::instance();
+    state.bindVertexArray(VAO);
+    state.bindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) 0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) (3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) (6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    return VAO;
+}
+
+double benchGpu(Shader &shader, bool uploadNormalMatrix, int indexCount) {
+    shader.use();
+    shader.setInt("diffuseTexture", 0);
+    shader.setInt("specularTexture", 1);
+    UniformHandle modelUniform = shader.uniform("model");
+    UniformHandle normalMatrixUniform = shader.uniform("normalMatrix");
+
+    BenchTimer timer;
+    for (int frame = 0; frame < FRAMES; frame++) {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        for (int i = 0; i < DRAWS_PER_FRAME; i++) {
+            glm::mat4 model = glm::rotate(glm::mat4(1.0f), 0.1f * (frame + i), glm::vec3(0.0f, 1.0f, 0.0f));
+            model = glm::scale(model, glm::vec3(1.0f, 1.5f, 1.0f));
+            shader.setMat4fv(modelUniform, model);
+            if (uploadNormalMatrix) {
+                shader.setMat3fv(normalMatrixUniform, normalMatrix(model));
+            }
+            glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+        }
+        glFinish();
+    }
+    return timer.elapsedMs() / FRAMES;
+}
+
+int main(int argc, char** argv) {
+    benchCpu();
+
+    Context context(argc, argv);
+    if (!createBenchContext(context, 64, 64, "bench_normal_matrix")) {
+        return 1;
+    }
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+    createBenchFramebuffer(64, 64);
+    GLStateCache::instance().enable(GL_DEPTH_TEST);
+
+    Shader inverseShader("../shader/bench/inverse_normal.vs.glsl", "../shader/lighting/light.fs.glsl", "POINT_LIGHT|SPECULAR_MAP");
+    Shader uniformShader("../shader/lighting/light.vs.glsl", "../shader/lighting/light.fs.glsl", "POINT_LIGHT|SPECULAR_MAP");
+
+    UniformBuffer<CameraBlock> cameraBlock(CAMERA_BLOCK_BINDING);
+    cameraBlock.data.view = glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    cameraBlock.data.projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+    cameraBlock.data.viewPos = glm::vec3(0.0f, 0.0f, 3.0f);
+    cameraBlock.upload();
+    UniformBuffer<LightBlock> lightBlock(LIGHT_BLOCK_BINDING);
+    lightBlock.data.constant = 1.0f;
+    lightBlock.upload();
+
+    int indexCount = 0;
+    unsigned int sphereVAO = createSphere(SEGMENTS, indexCount);
+    GLStateCache::instance().bindVertexArray(sphereVAO);
+    int vertexCount = (SEGMENTS + 1) * (SEGMENTS + 1);
+
+    // warm up both programs once so shader JIT is not measured
+    benchGpu(inverseShader, false, indexCount);
+    benchGpu(uniformShader, true, indexCount);
+
+    double inverseMs = benchGpu(inverseShader, false, indexCount);
+    double uniformMs = benchGpu(uniformShader, true, indexCount);
+    std::cout << "GPU, " << vertexCount << " vertices x " << DRAWS_PER_FRAME << " draws: inverse() per vertex "
+              << inverseMs << " ms/frame, CPU normal matrix " << uniformMs << " ms/frame" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <filesystem>
+
+#include "ofs/profiler.h"
+#include "ofs/bench.h"
+
+// Cost of a profiler zone, in nanoseconds per zone on top of the work it
+// wraps:
+//  - idle: compiled in, not recording
+//  - recording: one thread appending to its track
+//  - 4 threads: every thread appending to its own track at once
+//
+// Needs no GL context. The trace written at the end must hold every zone or
+// the bench fails.
+
+const int ZONES = 1 << 20;
+const int THREADS = 4;
+const char* TRACE = "bench_profiler.json";
+
+std::atomic<unsigned> sink(0);
+
+// Just enough work that the loop is not optimised away.
+inline void work(int i) {
+    sink.fetch_add((unsigned) i, std::memory_order_relaxed);
+}
+
+double nsPerIteration(bool zoned) {
+    BenchTimer timer;
+    for (int i = 0; i < ZONES; i++) {
+        if (zoned) {
+            OFS_PROFILE_ZONE("bench zone");
+            work(i);
+        } else {
+            work(i);
+        }
+    }
+    return timer.elapsedMs() * 1e6 / ZONES;
+}
+
+int main() {
+#if !OFS_PROFILE
+    std::cout << "Built with OFS_PROFILE=0, zones compile to nothing" << std::endl;
+    return 0;
+#endif
+    Profiler &profiler = Profiler::instance();
+    double baseline = nsPerIteration(false);
+    double idle = nsPerIteration(true) - baseline;
+
+    profiler.start(TRACE);
+    double recording = nsPerIteration(true) - baseline;
+
+    std::vector<double> perThread(THREADS);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([&perThread, t, baseline] {
+            OFS_PROFILE_THREAD("bench worker");
+            perThread[t] = nsPerIteration(true) - baseline;
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    double threaded = 0.0;
+    for (double ns : perThread) {
+        threaded += ns / THREADS;
+    }
+
+    std::cout << ZONES << " zones, " << baseline << " ns of work each" << std::endl;
+    std::cout << "idle:      " << idle << " ns per zone" << std::endl;
+    std::cout << "recording: " << recording << " ns per zone" << std::endl;
+    std::cout << THREADS << " threads: " << threaded << " ns per zone" << std::endl;
+
+    size_t expected = (size_t) ZONES * (THREADS + 1);
+    BenchTimer writeTimer;
+    bool written = profiler.write(TRACE);
+    double writeMs = writeTimer.elapsedMs();
+    std::ifstream trace(TRACE);
+    std::string line;
+    size_t events = 0;
+    while (std::getline(trace, line)) {
+        events += line.find("\"ph\":\"X\"") != std::string::npos;
+    }
+    std::cout << "trace: " << events << " events, " << std::filesystem::file_size(TRACE) / (1024 * 1024) << " MiB in "
+              << writeMs << " ms" << std::endl;
+    std::filesystem::remove(TRACE);
+    profiler.stop();
+    if (!written || events != expected) {
+        std::cout << "Expected " << expected << " events in the trace" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <filesystem>
+
+#include "ofs/shader.h"
+#include "ofs/bench.h"
+
+// Builds every lighting program twice, once against an empty program binary
+// cache and once warm, and prints the hit/miss counts and times for each pass.
+//
+// To run on Mesa llvmpipe without Mesa's own disk cache skewing the cold pass:
+//   LIBGL_ALWAYS_SOFTWARE=1 MESA_SHADER_CACHE_DISABLE=true ./ofs_bench_shader_cache
+// Exits non-zero if the warm pass does not hit for every program.
+
+const char* PROGRAMS[][3] = {
+        {"../shader/lighting_basic/light.vs.glsl", "../shader/lighting_basic/light.fs.glsl", ""},
+        {"../shader/lighting_specular/light.vs.glsl", "../shader/lighting_specular/light.fs.glsl", ""},
+        {"../shader/material/light.vs.glsl", "../shader/material/light.fs.glsl", ""},
+        {"../shader/diffuse_map/light.vs.glsl", "../shader/diffuse_map/light.fs.glsl", ""},
+        {"../shader/specular_map/light.vs.glsl", "../shader/specular_map/light.fs.glsl", ""},
+        {"../shader/lighting/light.vs.glsl", "../shader/lighting/light.fs.glsl", "DIRECTIONAL_LIGHT|SPECULAR_MAP"},
+        {"../shader/lighting/light.vs.glsl", "../shader/lighting/light.fs.glsl", "POINT_LIGHT|SPECULAR_MAP"},
+        {"../shader/lighting/light.vs.glsl", "../shader/lighting/light.fs.glsl", "SPOT_LIGHT|SPECULAR_MAP"},
+        {"../shader/lighting/light.vs.glsl", "../shader/lighting/light.fs.glsl", "SPOT_LIGHT|SPOT_SOFT|SPECULAR_MAP"},
+        {"../shader/lighting/lamp.vs.glsl", "../shader/lighting/lamp.fs.glsl", ""},
+};
+
+ShaderCacheStats buildAll() {
+    ShaderCache &cache = ShaderCache::instance();
+    cache.stats = ShaderCacheStats();
+    for (auto &program : PROGRAMS) {
+        Shader shader(program[0], program[1], program[2]);
+        glDeleteProgram(shader.ID);
+    }
+    glFinish();
+    return cache.stats;
+}
+
+int main(int argc, char** argv) {
+    Context context(argc, argv);
+    if (!createBenchContext(context, 64, 64, "bench_shader_cache")) {
+        return 1;
+    }
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+
+    ShaderCache &cache = ShaderCache::instance();
+    cache.directory = "bench_shader_cache";
+    std::filesystem::remove_all(cache.directory);
+    if (!cache.supported()) {
+        std::cout << "Program binaries not supported by this driver, every build compiles from source" << std::endl;
+    }
+
+    std::cout << "cold: ";
+    ShaderCacheStats cold = buildAll();
+    cache.report();
+
+    std::cout << "warm: ";
+    ShaderCacheStats warm = buildAll();
+    cache.report();
+
+    int programCount = sizeof(PROGRAMS) / sizeof(PROGRAMS[0]);
+    bool ok = cold.misses == programCount && (!cache.supported() || warm.hits == programCount);
+    if (!ok) {
+        std::cout << "Unexpected cache behaviour" << std::endl;
+    }
+
+    return ok ? 0 : 1;
+}
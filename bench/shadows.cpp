@@ -0,0 +1,286 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+#include <functional>
+
+#include "ofs/shader.h"
+#include "ofs/mesh.h"
+#include "ofs/uniform_buffer.h"
+#include "ofs/instancing.h"
+#include "ofs/shadows.h"
+#include "ofs/bench.h"
+
+// One directional light with 4 cascades of 1024, four point lights with cube
+// maps of 512 and four spot lights of 512 in a 4096 atlas, plus one more
+// point light asking for 1024 that only fits at 512, over a field of cubes on
+// a floor. Shadow pass time per frame:
+//  - every page rendered again every frame, as without a page cache
+//  - camera and lights still, every page cached
+//  - camera moving, only the cascades that step a texel rendered
+//  - point lights moving, their faces rendered
+//  - a few spinning cubes as dynamic casters: static casters copied from the
+//    atlas's static cache, the spinning ones drawn on top
+//
+// Usage: ofs_bench_shadows [--headless] [frames]
+// Shading with cached pages, and with dynamic casters drawn over the static
+// cache, must give the same picture as with every page rendered again, and
+// the shadows must darken the scene, or the bench fails.
+
+const int TARGET_WIDTH = 640;
+const int TARGET_HEIGHT = 360;
+const int FIELD_SIDE = 12;
+
+long brightness(const std::vector<unsigned char> &pixels) {
+    long sum = 0;
+    for (size_t i = 0; i < pixels.size(); i += 4) {
+        sum += pixels[i] + pixels[i + 1] + pixels[i + 2];
+    }
+    return sum;
+}
+
+// A floor and a field of cubes above it.
+std::vector<glm::mat4> field() {
+    std::vector<glm::mat4> models;
+    models.push_back(glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.0f, 0.0f)), glm::vec3(40.0f, 0.2f, 40.0f)));
+    for (int z = 0; z < FIELD_SIDE; z++) {
+        for (int x = 0; x < FIELD_SIDE; x++) {
+            glm::vec3 position(2.5f * (x - FIELD_SIDE / 2), (x * 7 + z * 3) % 4 * 0.5f, 2.5f * (z - FIELD_SIDE / 2));
+            models.push_back(glm::rotate(glm::translate(glm::mat4(1.0f), position), glm::radians(11.0f * (x + z)), glm::vec3(0.2f, 1.0f, 0.4f)));
+        }
+    }
+    return models;
+}
+
+std::vector<glm::mat4> spinning(float time) {
+    std::vector<glm::mat4> models;
+    for (int i = 0; i < 4; i++) {
+        glm::vec3 position(-4.5f + 3.0f * i, 2.5f, 1.25f);
+        models.push_back(glm::rotate(glm::translate(glm::mat4(1.0f), position), time + i, glm::vec3(0.3f, 1.0f, 0.1f)));
+    }
+    return models;
+}
+
+glm::mat4 cameraView(float time) {
+    glm::vec3 position(18.0f * std::sin(time), 10.0f, 18.0f * std::cos(time));
+    return glm::lookAt(position, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+int main(int argc, char** argv) {
+    Context context(argc, argv);
+    std::vector<int> numbers = benchNumbers(context);
+    int frames = numbers.size() > 0 ? numbers[0] : 10;
+
+    if (!createBenchContext(context, 64, 64, "bench_shadows")) {
+        return 1;
+    }
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+    unsigned int target = createBenchFramebuffer(TARGET_WIDTH, TARGET_HEIGHT);
+    GLStateCache &state = GLStateCache::instance();
+    state.enable(GL_DEPTH_TEST);
+
+    Shader lightShader("../shader/lighting/light.vs.glsl", "../shader/lighting/light.fs.glsl", "DIRECTIONAL_LIGHT|INSTANCED");
+    Shader shadowedShader("../shader/lighting/light.vs.glsl", "../shader/lighting/light.fs.glsl", "DIRECTIONAL_LIGHT|SHADOWS|INSTANCED");
+    Shader pointShader("../shader/lighting/light.vs.glsl", "../shader/lighting/light.fs.glsl", "POINT_LIGHT|SHADOWS|INSTANCED");
+
+    const float aspect = (float) TARGET_WIDTH / TARGET_HEIGHT;
+    UniformBuffer<CameraBlock> cameraBlock(CAMERA_BLOCK_BINDING);
+    cameraBlock.data.view = cameraView(0.0f);
+    cameraBlock.data.projection = glm::perspective(glm::radians(60.0f), aspect, 0.1f, 100.0f);
+    cameraBlock.data.viewPos = glm::vec3(glm::inverse(cameraBlock.data.view)[3]);
+    cameraBlock.upload();
+
+    UniformBuffer<LightBlock> lightBlock(LIGHT_BLOCK_BINDING);
+    lightBlock.data.direction = glm::vec3(-0.4f, -1.0f, -0.3f);
+    lightBlock.data.ambient = glm::vec3(0.1f);
+    lightBlock.data.diffuse = glm::vec3(0.8f);
+    lightBlock.data.specular = glm::vec3(0.5f);
+    lightBlock.data.constant = 1.0f;
+    lightBlock.data.linear = 0.045f;
+    lightBlock.data.quadratic = 0.0075f;
+
+    unsigned int white = createWhiteTexture();
+
+    Shadows shadows(4096);
+    for (Shader* shader : {&lightShader, &shadowedShader, &pointShader}) {
+        shader->use();
+        shader->setInt("diffuseTexture", 0);
+        shader->setVec3("material.specular", glm::vec3(0.5f));
+        shader->setFloat("material.shininess", 32.0f);
+    }
+    shadows.attach(shadowedShader);
+    shadows.attach(pointShader);
+
+    ShadowLight sunLight;
+    sunLight.direction = lightBlock.data.direction;
+    int sun = shadows.add(sunLight);
+    for (int i = 0; i < 4; i++) {
+        ShadowLight spot;
+        spot.type = SHADOW_SPOT;
+        spot.position = glm::vec3(-6.0f + 4.0f * i, 6.0f, 6.0f);
+        spot.direction = glm::vec3(0.0f, -1.0f, -0.6f);
+        spot.coneCos = std::cos(glm::radians(30.0f));
+        spot.range = 25.0f;
+        spot.resolution = 512;
+        shadows.add(spot);
+    }
+    std::vector<int> points;
+    for (int i = 0; i < 5; i++) {
+        ShadowLight point;
+        point.type = SHADOW_POINT;
+        point.position = glm::vec3(-8.0f + 4.0f * i, 3.0f, -2.0f);
+        point.range = 20.0f;
+        // the last one asks for more than is left
+        point.resolution = i < 4 ? 512 : 1024;
+        points.push_back(shadows.add(point));
+    }
+    lightBlock.data.position = shadows.light(points[0]).position;
+    lightBlock.upload();
+
+    MeshBuffer meshes;
+    Mesh cube = meshes.addBuiltin("cube");
+    meshes.upload();
+    unsigned int fieldVAO = meshes.createVAO();
+    unsigned int spinningVAO = meshes.createVAO();
+    InstanceBuffer fieldInstances;
+    fieldInstances.attach(fieldVAO);
+    std::vector<glm::mat4> models = field();
+    fieldInstances.upload(models.data(), models.size());
+    InstanceBuffer spinningInstances;
+    spinningInstances.attach(spinningVAO);
+
+    Shadows::DrawCasters drawField = [&](const glm::mat4&) {
+        state.bindVertexArray(fieldVAO);
+        fieldInstances.draw(cube);
+    };
+    Shadows::DrawCasters drawSpinning = [&](const glm::mat4&) {
+        state.bindVertexArray(spinningVAO);
+        spinningInstances.draw(cube);
+    };
+
+    // the scene lit by the sun, or the first point light, with its shadows
+    auto shade = [&](Shader &shader, int light) {
+        state.bindFramebuffer(GL_FRAMEBUFFER, target);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        shadows.bind(light);
+        shader.use();
+        state.bindVertexArray(fieldVAO);
+        fieldInstances.draw(cube);
+        glFinish();
+        return readBenchTarget(TARGET_WIDTH, TARGET_HEIGHT);
+    };
+
+    shadows.setCamera(cameraBlock.data.view, glm::radians(60.0f), aspect, 0.1f, 100.0f);
+    // compiles the casters' shader and fills every page
+    shadows.render(drawField);
+    std::cout << "Atlas " << shadows.atlas.size << "x" << shadows.atlas.size << ", " << models.size() << " cubes, "
+              << TARGET_WIDTH << "x" << TARGET_HEIGHT << ", " << frames << " frames" << std::endl;
+    std::cout << std::setw(18) << "case" << std::setw(12) << "rendered" << std::setw(10) << "cached" << std::setw(12) << "shadows" << std::endl;
+
+    // runs the shadow pass frames times, update moving things first
+    double everyFrameMs = 0.0;
+    auto run = [&](const char* name, const std::function<void(int)> &update, bool dynamic) {
+        double total = 0.0;
+        long rendered = 0;
+        long cached = 0;
+        for (int frame = 1; frame <= frames; frame++) {
+            update(frame);
+            BenchTimer timer;
+            if (dynamic) {
+                shadows.render(drawField, drawSpinning);
+            } else {
+                shadows.render(drawField);
+            }
+            glFinish();
+            total += timer.elapsedMs();
+            rendered += shadows.pagesRendered;
+            cached += shadows.pagesCached;
+        }
+        double ms = total / frames;
+        std::cout << std::setw(18) << name << std::fixed << std::setprecision(1) << std::setw(12) << (double) rendered / frames
+                  << std::setw(10) << (double) cached / frames << std::setprecision(3) << std::setw(9) << ms << " ms";
+        if (everyFrameMs > 0.0) {
+            std::cout << std::setprecision(2) << std::setw(8) << everyFrameMs / ms << "x";
+        }
+        std::cout << std::endl;
+        return ms;
+    };
+
+    everyFrameMs = run("every frame", [&](int) { shadows.invalidateStatic(); }, false);
+    run("still", [&](int) {}, false);
+    run("camera moving", [&](int frame) {
+        shadows.setCamera(cameraView(0.002f * frame), glm::radians(60.0f), aspect, 0.1f, 100.0f);
+    }, false);
+    run("points moving", [&](int frame) {
+        for (int point : points) {
+            shadows.light(point).position.y = 3.0f + 0.01f * frame;
+        }
+    }, false);
+    run("dynamic casters", [&](int frame) {
+        std::vector<glm::mat4> spun = spinning(0.05f * frame);
+        spinningInstances.upload(spun.data(), spun.size());
+    }, true);
+
+    // back to where the runs started, the spinning cubes left in their last
+    // pose; drawScene draws them as static casters
+    auto moveTo = [&](float time, float pointY) {
+        shadows.setCamera(cameraView(time), glm::radians(60.0f), aspect, 0.1f, 100.0f);
+        for (int point : points) {
+            shadows.light(point).position.y = pointY;
+        }
+    };
+    Shadows::DrawCasters drawScene = [&](const glm::mat4 &viewProjection) {
+        drawField(viewProjection);
+        drawSpinning(viewProjection);
+    };
+    moveTo(0.0f, 3.0f);
+
+    // the reference, every page rendered again
+    shadows.invalidateStatic();
+    shadows.render(drawScene);
+    std::vector<unsigned char> fresh = shade(shadowedShader, sun);
+    std::vector<unsigned char> freshPoint = shade(pointShader, points[0]);
+
+    // the camera and the points away and back: their pages rendered again,
+    // the spot lights' from the cache
+    moveTo(0.05f, 4.0f);
+    shadows.render(drawScene);
+    moveTo(0.0f, 3.0f);
+    shadows.render(drawScene);
+    std::vector<unsigned char> cachedImage = shade(shadowedShader, sun);
+    std::vector<unsigned char> cachedPoint = shade(pointShader, points[0]);
+
+    // the field copied from the static cache, the spinning cubes drawn on top;
+    // the first render fills the static cache
+    shadows.render(drawField, drawSpinning);
+    shadows.render(drawField, drawSpinning);
+    std::vector<unsigned char> dynamicImage = shade(shadowedShader, sun);
+    std::vector<unsigned char> dynamicPoint = shade(pointShader, points[0]);
+
+    std::vector<unsigned char> unshadowed = shade(lightShader, sun);
+    shadows.report();
+
+    bool ok = true;
+    if (fresh != cachedImage || freshPoint != cachedPoint) {
+        std::cout << "Shading with cached pages differs from freshly rendered ones" << std::endl;
+        ok = false;
+    }
+    if (fresh != dynamicImage || freshPoint != dynamicPoint) {
+        std::cout << "Shading with dynamic casters over the static cache differs from freshly rendered pages" << std::endl;
+        ok = false;
+    }
+    double darkened = 1.0 - (double) brightness(fresh) / brightness(unshadowed);
+    std::cout << "Shadows take " << std::setprecision(1) << 100.0 * darkened << "% off the sunlit picture" << std::endl;
+    if (darkened < 0.02) {
+        std::cout << "The sun casts no shadows" << std::endl;
+        ok = false;
+    }
+
+    state.deleteTextures(1, &white);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <filesystem>
+
+#include "ofs/texture_cache.h"
+#include "ofs/ktx2.h"
+#include "ofs/texture_compress.h"
+#include "ofs/bench.h"
+
+// Every image in ../resources through every block format of ofs/ktx2.h the
+// driver supports: encode time, GPU footprint against the uncompressed
+// estimate, upload time, and PSNR of level 0 as the driver decodes it. The
+// channels a format cannot carry are left out of the PSNR (alpha for BC1 and
+// ETC2, blue and alpha for BC5).
+//
+// A PSNR under MIN_PSNR means an encoder is broken and fails the bench.
+
+const double MIN_PSNR = 25.0;
+
+double psnr(const std::vector<unsigned char> &expected, const std::vector<unsigned char> &actual, int channels) {
+    double squared = 0.0;
+    size_t count = 0;
+    for (size_t i = 0; i < expected.size(); i += 4) {
+        for (int c = 0; c < channels; c++) {
+            double d = (double) expected[i + c] - actual[i + c];
+            squared += d * d;
+            count++;
+        }
+    }
+    double mse = squared / count;
+    return mse == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+int main(int argc, char** argv) {
+    Context context(argc, argv);
+    if (!createBenchContext(context, 64, 64, "bench_texture_compression")) {
+        return 1;
+    }
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+
+    std::vector<std::string> paths;
+    for (const auto &entry : std::filesystem::directory_iterator("../resources")) {
+        if (entry.path().extension() != ".ktx2") {
+            paths.push_back(entry.path().string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    bool ok = true;
+    stbi_set_flip_vertically_on_load(true);
+    for (const std::string &path : paths) {
+        int width, height, channels;
+        unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &channels, 0);
+        if (pixels == NULL) {
+            std::cout << "Failed to load texture: " << path << std::endl;
+            continue;
+        }
+        std::vector<unsigned char> rgba = expandToRGBA(pixels, width, height, channels);
+        size_t uncompressed = textureResidentBytes(width, height, channels);
+        std::cout << std::filesystem::path(path).filename().string() << ": " << width << "x" << height << ", "
+                  << channels << " channels, " << uncompressed / 1024 << " KiB uncompressed" << std::endl;
+
+        for (const Ktx2Format &format : KTX2_FORMATS) {
+            if (!compressedFormatSupported(format.vkFormat)) {
+                std::cout << "    " << format.name << ": not supported by the driver" << std::endl;
+                continue;
+            }
+            BenchTimer encodeTimer;
+            Ktx2Image image = compressTexture(pixels, width, height, channels, format.vkFormat);
+            double encodeMs = encodeTimer.elapsedMs();
+
+            unsigned int texture;
+            glGenTextures(1, &texture);
+            glFinish();
+            BenchTimer uploadTimer;
+            uploadCompressedTexture(texture, image);
+            glFinish();
+            double uploadMs = uploadTimer.elapsedMs();
+
+            std::vector<unsigned char> decoded(rgba.size());
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, decoded.data());
+            GLStateCache::instance().deleteTextures(1, &texture);
+
+            int compared = format.vkFormat == VK_FORMAT_BC5_UNORM_BLOCK ? 2 : 3;
+            if (channels == 4 && (format.vkFormat == VK_FORMAT_BC3_UNORM_BLOCK || format.vkFormat == VK_FORMAT_BC7_UNORM_BLOCK
+                                  || format.vkFormat == VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK)) {
+                compared = 4;
+            }
+            double quality = psnr(rgba, decoded, compared);
+            ok = ok && quality >= MIN_PSNR;
+            std::cout << "    " << format.name << ": " << image.byteSize() / 1024 << " KiB ("
+                      << (double) uncompressed / image.byteSize() << "x smaller), PSNR " << quality << " dB, encode "
+                      << encodeMs << " ms, upload " << uploadMs << " ms" << std::endl;
+        }
+        stbi_image_free(pixels);
+    }
+
+    if (!ok) {
+        std::cout << "PSNR under " << MIN_PSNR << " dB, an encoder is broken" << std::endl;
+        return 1;
+    }
+    return 0;
+}
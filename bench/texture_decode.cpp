@@ -0,0 +1,109 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+
+#include "ofs/texture_loader.h"
+#include "ofs/bench.h"
+
+// Wall time to get a set of images from disk into GL textures with
+// AsyncTextureLoader at 1, 4 and 16 decode threads. The GL thread runs a frame
+// loop that spends at most BUDGET_MS per frame on uploads, so the report also
+// shows how many frames had uploads and the longest update() call; a single
+// large image can take longer than the budget on its own.
+//  - resources: every image in ../resources
+//  - synthetic: 500 files copied round-robin from ../resources into a temp
+//    directory; the paths differ, so each one is decoded and uploaded
+//
+// Decoding dominates, so scaling follows the number of cores; on a single core
+// all thread counts take about the same time.
+
+const double BUDGET_MS = 2.0;
+const int SYNTHETIC_COUNT = 500;
+
+struct LoadResult {
+    double wallMs = 0.0;
+    double decodeMs = 0.0;
+    int frames = 0;
+    double longestUpdateMs = 0.0;
+};
+
+LoadResult load(const std::vector<std::string> &paths, int threads) {
+    LoadResult result;
+    std::vector<unsigned int> textures;
+    {
+        AsyncTextureLoader loader(threads, 64);
+        BenchTimer timer;
+        for (const std::string &path : paths) {
+            textures.push_back(loader.request(path));
+        }
+        while (loader.pending() > 0) {
+            auto start = std::chrono::steady_clock::now();
+            if (loader.update(BUDGET_MS) == 0) {
+                // nothing decoded yet, give the core to the workers
+                std::this_thread::yield();
+                continue;
+            }
+            double updateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            result.longestUpdateMs = std::max(result.longestUpdateMs, updateMs);
+            result.frames++;
+            glFinish();
+        }
+        result.wallMs = timer.elapsedMs();
+        result.decodeMs = loader.stats.decodeMs;
+    }
+    for (unsigned int texture : textures) {
+        TextureCache::instance().release(texture);
+    }
+    return result;
+}
+
+void report(const char* name, const std::vector<std::string> &paths) {
+    std::cout << name << ": " << paths.size() << " images" << std::endl;
+    // warm the file system cache so the first run is not penalised
+    load(paths, 1);
+    for (int threads : {1, 4, 16}) {
+        LoadResult result = load(paths, threads);
+        std::cout << "    " << threads << " threads: " << result.wallMs << " ms wall, "
+                  << result.decodeMs << " ms decoding (all threads), " << result.frames << " upload frames, longest update "
+                  << result.longestUpdateMs << " ms" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    Context context(argc, argv);
+    if (!createBenchContext(context, 64, 64, "bench_texture_decode")) {
+        return 1;
+    }
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+    std::cout << "Hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+
+    std::vector<std::string> resources;
+    for (const auto &entry : std::filesystem::directory_iterator("../resources")) {
+        resources.push_back(entry.path().string());
+    }
+    std::sort(resources.begin(), resources.end());
+    if (resources.empty()) {
+        std::cout << "No images in ../resources" << std::endl;
+        return 1;
+    }
+    report("resources", resources);
+
+    std::filesystem::path syntheticDir = std::filesystem::temp_directory_path() / "ofs_texture_decode";
+    std::filesystem::create_directories(syntheticDir);
+    std::vector<std::string> synthetic;
+    for (int i = 0; i < SYNTHETIC_COUNT; i++) {
+        const std::filesystem::path source = resources[i % resources.size()];
+        std::filesystem::path copy = syntheticDir / (std::to_string(i) + source.extension().string());
+        std::filesystem::copy_file(source, copy, std::filesystem::copy_options::overwrite_existing);
+        synthetic.push_back(copy.string());
+    }
+    report("synthetic", synthetic);
+    std::filesystem::remove_all(syntheticDir);
+
+    return 0;
+}
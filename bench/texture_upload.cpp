@@ -0,0 +1,137 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+
+#include "ofs/texture_cache.h"
+#include "ofs/pixel_upload.h"
+#include "ofs/bench.h"
+
+// Upload throughput of the images in ../resources with their mip chains,
+// ROUNDS times over, each round into fresh textures (storage is immutable).
+//  - client: uploadMipChain straight from decoded memory
+//  - orphan / persistent: PixelUploadRing, the chain copied into a mapped slot
+//    and glTexSubImage2D from the unpack buffer, slots recycled behind fences
+//
+// "GL thread" is the time spent inside GL calls, which is what a frame pays;
+// "wall" runs until glFinish. For the ring the copy into the slot is reported
+// on its own since a decode thread does it in AsyncTextureLoader.
+
+const int ROUNDS = 40;
+
+struct Image {
+    std::vector<unsigned char> chain;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+};
+
+double sinceMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void print(const char* name, size_t bytes, double glMs, double wallMs, double copyMs) {
+    double mb = bytes / 1e6;
+    std::cout << "    " << name << ": " << glMs << " ms GL thread (" << mb / glMs * 1e3 << " MB/s), "
+              << wallMs << " ms wall (" << mb / wallMs * 1e3 << " MB/s)";
+    if (copyMs > 0.0) {
+        std::cout << ", " << copyMs << " ms copying into slots";
+    }
+    std::cout << std::endl;
+}
+
+void client(const std::vector<Image> &images) {
+    std::vector<unsigned int> textures(images.size());
+    size_t bytes = 0;
+    double glMs = 0.0;
+    BenchTimer timer;
+    for (int round = 0; round < ROUNDS; round++) {
+        glGenTextures((int) textures.size(), textures.data());
+        for (size_t i = 0; i < images.size(); i++) {
+            const Image &image = images[i];
+            auto start = std::chrono::steady_clock::now();
+            uploadMipChain(textures[i], image.chain.data(), image.width, image.height, image.channels);
+            glMs += sinceMs(start);
+            bytes += image.chain.size();
+        }
+        GLStateCache::instance().deleteTextures((int) textures.size(), textures.data());
+    }
+    glFinish();
+    print("client    ", bytes, glMs, timer.elapsedMs(), 0.0);
+}
+
+void streamed(const std::vector<Image> &images, PixelUploadRing::Mode mode) {
+    PixelUploadRing ring(4, 4 << 20, mode);
+    std::vector<unsigned int> textures(images.size());
+    double copyMs = 0.0;
+    BenchTimer timer;
+    for (int round = 0; round < ROUNDS; round++) {
+        // deleting a texture with a pending upload is safe, GL keeps it alive
+        glGenTextures((int) textures.size(), textures.data());
+        for (size_t i = 0; i < images.size(); i++) {
+            const Image &image = images[i];
+            int slot;
+            while ((slot = ring.acquire()) < 0) {
+                ring.poll();
+            }
+            auto start = std::chrono::steady_clock::now();
+            memcpy(ring.memory(slot), image.chain.data(), image.chain.size());
+            copyMs += sinceMs(start);
+            ring.submit(slot, textures[i], image.width, image.height, image.channels);
+        }
+        GLStateCache::instance().deleteTextures((int) textures.size(), textures.data());
+    }
+    while (!ring.idle()) {
+        ring.poll();
+    }
+    glFinish();
+    double wallMs = timer.elapsedMs();
+    print(mode == PixelUploadRing::PERSISTENT ? "persistent" : "orphan    ", ring.stats.bytes, ring.stats.submitMs, wallMs, copyMs);
+}
+
+int main(int argc, char** argv) {
+    Context context(argc, argv);
+    if (!createBenchContext(context, 64, 64, "bench_texture_upload")) {
+        return 1;
+    }
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+
+    std::vector<std::string> paths;
+    for (const auto &entry : std::filesystem::directory_iterator("../resources")) {
+        paths.push_back(entry.path().string());
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<Image> images;
+    for (const std::string &path : paths) {
+        Image image;
+        unsigned char* data = stbi_load(path.c_str(), &image.width, &image.height, &image.channels, 0);
+        if (data == NULL) {
+            std::cout << "Failed to load texture: " << path << std::endl;
+            continue;
+        }
+        image.chain = createMipChain(data, image.width, image.height, image.channels);
+        stbi_image_free(data);
+        images.push_back(image);
+    }
+
+    std::cout << images.size() << " images x " << ROUNDS << " rounds" << std::endl;
+    // first pass of each path pays for the driver's lazy setup
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+            std::cout << "measured:" << std::endl;
+        }
+        client(images);
+        streamed(images, PixelUploadRing::ORPHAN);
+        if (GLAD_GL_VERSION_4_4) {
+            streamed(images, PixelUploadRing::PERSISTENT);
+        }
+    }
+
+    return 0;
+}
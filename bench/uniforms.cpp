@@ -0,0 +1,212 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+
+#include "ofs/shader.h"
+#include "ofs/uniform_buffer.h"
+#include "ofs/bench.h"
+
+// Replays the per-frame uniform traffic of lighting_casters_point and counts the
+// driver entry points hit per frame by swapping the glad pointers.
+//
+// The first three rows replay the traffic from before the camera and light moved
+// into uniform blocks, against shader/bench/point_light_uniforms where every
+// name still resolves. The last row drives the lighting shader the demo uses.
+
+const int FRAMES = 2000;
+
+struct DriverCalls {
+    long lookups = 0;
+    long uploads = 0;
+    long bufferUpdates = 0;
+};
+
+DriverCalls driverCalls;
+
+PFNGLGETUNIFORMLOCATIONPROC realGetUniformLocation;
+PFNGLUNIFORM1FPROC realUniform1f;
+PFNGLUNIFORM3FPROC realUniform3f;
+PFNGLUNIFORMMATRIX4FVPROC realUniformMatrix4fv;
+PFNGLBUFFERSUBDATAPROC realBufferSubData;
+
+GLint APIENTRY countGetUniformLocation(GLuint program, const GLchar* name) {
+    driverCalls.lookups++;
+    return realGetUniformLocation(program, name);
+}
+
+void APIENTRY countUniform1f(GLint location, GLfloat v0) {
+    driverCalls.uploads++;
+    realUniform1f(location, v0);
+}
+
+void APIENTRY countUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2) {
+    driverCalls.uploads++;
+    realUniform3f(location, v0, v1, v2);
+}
+
+void APIENTRY countUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+    driverCalls.uploads++;
+    realUniformMatrix4fv(location, count, transpose, value);
+}
+
+void APIENTRY countBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+    driverCalls.bufferUpdates++;
+    realBufferSubData(target, offset, size, data);
+}
+
+void installCounters() {
+    realGetUniformLocation = glad_glGetUniformLocation;
+    realUniform1f = glad_glUniform1f;
+    realUniform3f = glad_glUniform3f;
+    realUniformMatrix4fv = glad_glUniformMatrix4fv;
+    realBufferSubData = glad_glBufferSubData;
+    glad_glGetUniformLocation = countGetUniformLocation;
+    glad_glUniform1f = countUniform1f;
+    glad_glUniform3f = countUniform3f;
+    glad_glUniformMatrix4fv = countUniformMatrix4fv;
+    glad_glBufferSubData = countBufferSubData;
+}
+
+glm::mat4 cubeModel(unsigned int i) {
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0.5f * i, 0.0f, -1.0f * i));
+    return glm::rotate(model, glm::radians(20.0f * i), glm::vec3(1.0f, 0.3f, 0.5f));
+}
+
+// What Shader::set* did before the location table: one lookup per upload.
+void legacyFrame(unsigned int program, const glm::mat4 &view, const glm::mat4 &projection) {
+    glUniform3f(glGetUniformLocation(program, "viewPos"), 0.0f, 0.0f, 3.0f);
+    glUniform1f(glGetUniformLocation(program, "material.shininess"), 16.0f);
+    glUniform3f(glGetUniformLocation(program, "light.ambient"), 0.1f, 0.1f, 0.1f);
+    glUniform3f(glGetUniformLocation(program, "light.diffuse"), 0.5f, 0.5f, 0.5f);
+    glUniform3f(glGetUniformLocation(program, "light.specular"), 1.0f, 1.0f, 1.0f);
+    glUniform3f(glGetUniformLocation(program, "light.position"), 1.2f, 0.5f, 2.0f);
+    glUniform1f(glGetUniformLocation(program, "light.constant"), 1.0f);
+    glUniform1f(glGetUniformLocation(program, "light.linear"), 0.045f);
+    glUniform1f(glGetUniformLocation(program, "light.quadratic"), 0.0075f);
+    glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    for (unsigned int i = 0; i < 11; i++) {
+        glUniformMatrix4fv(glGetUniformLocation(program, "model"), 1, GL_FALSE, glm::value_ptr(cubeModel(i)));
+    }
+}
+
+void namedFrame(const Shader &shader, const glm::mat4 &view, const glm::mat4 &projection) {
+    shader.setVec3("viewPos", 0.0f, 0.0f, 3.0f);
+    shader.setFloat("material.shininess", 16.0f);
+    shader.setVec3("light.ambient", 0.1f, 0.1f, 0.1f);
+    shader.setVec3("light.diffuse", 0.5f, 0.5f, 0.5f);
+    shader.setVec3("light.specular", 1.0f, 1.0f, 1.0f);
+    shader.setVec3("light.position", 1.2f, 0.5f, 2.0f);
+    shader.setFloat("light.constant", 1.0f);
+    shader.setFloat("light.linear", 0.045f);
+    shader.setFloat("light.quadratic", 0.0075f);
+    shader.setMat4fv("view", view);
+    shader.setMat4fv("projection", projection);
+    for (unsigned int i = 0; i < 11; i++) {
+        shader.setMat4fv("model", cubeModel(i));
+    }
+}
+
+struct Handles {
+    UniformHandle viewPos, shininess, ambient, diffuse, specular, position;
+    UniformHandle constant, linear, quadratic, view, projection, model;
+};
+
+// Names the block shader does not have stay unresolved and are never set.
+Handles resolveHandles(const Shader &shader) {
+    Handles h;
+    h.viewPos = shader.uniform("viewPos");
+    h.shininess = shader.uniform("material.shininess");
+    h.ambient = shader.uniform("light.ambient");
+    h.diffuse = shader.uniform("light.diffuse");
+    h.specular = shader.uniform("light.specular");
+    h.position = shader.uniform("light.position");
+    h.constant = shader.uniform("light.constant");
+    h.linear = shader.uniform("light.linear");
+    h.quadratic = shader.uniform("light.quadratic");
+    h.view = shader.uniform("view");
+    h.projection = shader.uniform("projection");
+    h.model = shader.uniform("model");
+    return h;
+}
+
+bool allResolved(const Handles &h) {
+    return h.viewPos.valid() && h.shininess.valid() && h.ambient.valid() && h.diffuse.valid()
+        && h.specular.valid() && h.position.valid() && h.constant.valid() && h.linear.valid()
+        && h.quadratic.valid() && h.view.valid() && h.projection.valid() && h.model.valid();
+}
+
+void handleFrame(const Shader &shader, const Handles &h, const glm::mat4 &view, const glm::mat4 &projection) {
+    shader.setVec3(h.viewPos, 0.0f, 0.0f, 3.0f);
+    shader.setFloat(h.shininess, 16.0f);
+    shader.setVec3(h.ambient, 0.1f, 0.1f, 0.1f);
+    shader.setVec3(h.diffuse, 0.5f, 0.5f, 0.5f);
+    shader.setVec3(h.specular, 1.0f, 1.0f, 1.0f);
+    shader.setVec3(h.position, 1.2f, 0.5f, 2.0f);
+    shader.setFloat(h.constant, 1.0f);
+    shader.setFloat(h.linear, 0.045f);
+    shader.setFloat(h.quadratic, 0.0075f);
+    shader.setMat4fv(h.view, view);
+    shader.setMat4fv(h.projection, projection);
+    for (unsigned int i = 0; i < 11; i++) {
+        shader.setMat4fv(h.model, cubeModel(i));
+    }
+}
+
+void blockFrame(const Shader &shader, const Handles &h, UniformBuffer<CameraBlock> &cameraBlock, UniformBuffer<LightBlock> &lightBlock) {
+    cameraBlock.upload();
+    lightBlock.upload();
+    shader.setFloat(h.shininess, 16.0f);
+    for (unsigned int i = 0; i < 11; i++) {
+        shader.setMat4fv(h.model, cubeModel(i));
+    }
+}
+
+template <typename Frame>
+void run(const char* label, Frame frame) {
+    driverCalls = DriverCalls();
+    BenchTimer timer;
+    for (int i = 0; i < FRAMES; i++) {
+        frame();
+    }
+    glFinish();
+    double ms = timer.elapsedMs();
+    std::cout << label
+              << "  lookups/frame: " << (double) driverCalls.lookups / FRAMES
+              << "  uploads/frame: " << (double) driverCalls.uploads / FRAMES
+              << "  buffer updates/frame: " << (double) driverCalls.bufferUpdates / FRAMES
+              << "  us/frame: " << ms * 1000.0 / FRAMES << std::endl;
+}
+
+int main(int argc, char** argv) {
+    Context context(argc, argv);
+    if (!createBenchContext(context, 64, 64, "bench_uniforms")) {
+        return 1;
+    }
+
+    Shader legacyShader("../shader/bench/point_light_uniforms.vs.glsl", "../shader/bench/point_light_uniforms.fs.glsl");
+    Shader blockShader("../shader/lighting/light.vs.glsl", "../shader/lighting/light.fs.glsl", "POINT_LIGHT|SPECULAR_MAP");
+    UniformBuffer<CameraBlock> cameraBlock(CAMERA_BLOCK_BINDING);
+    UniformBuffer<LightBlock> lightBlock(LIGHT_BLOCK_BINDING);
+    installCounters();
+
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+
+    Handles legacyHandles = resolveHandles(legacyShader);
+    Handles blockHandles = resolveHandles(blockShader);
+    if (!allResolved(legacyHandles)) {
+        std::cout << "point_light_uniforms is missing a uniform the legacy rows upload" << std::endl;
+        return 1;
+    }
+
+    legacyShader.use();
+    run("glGetUniformLocation per set", [&]() { legacyFrame(legacyShader.ID, view, projection); });
+    run("name via location table     ", [&]() { namedFrame(legacyShader, view, projection); });
+    run("UniformHandle               ", [&]() { handleFrame(legacyShader, legacyHandles, view, projection); });
+    blockShader.use();
+    run("uniform blocks + handles    ", [&]() { blockFrame(blockShader, blockHandles, cameraBlock, lightBlock); });
+
+    return 0;
+}
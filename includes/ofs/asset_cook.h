@@ -0,0 +1,213 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_ASSET_COOK_H
+#define OPENGL_FROM_SCRATCH_OFS_ASSET_COOK_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+
+#include <stb_image.h>
+
+#include "ofs/asset_pack.h"
+#include "ofs/texture_cache.h"
+#include "ofs/texture_compress.h"
+#include "ofs/mesh.h"
+
+// Write side of ofs/asset_pack.h: collects assets in memory, then lays them
+// out and writes the pack in one go.
+//
+//     AssetPackWriter writer;
+//     writer.addShader("../shader/lighting/light.fs.glsl");
+//     writer.addTexture("../resources/wood.jpg", true, 0);
+//     writer.addMesh("cube", createCube());
+//     writer.write("assets.pack");
+class AssetPackWriter {
+public:
+    bool addShader(const std::string &path) {
+        std::vector<unsigned char> bytes;
+        if (!readBytes(path, bytes)) {
+            std::cout << "Failed to read shader source: " << path << std::endl;
+            return false;
+        }
+        Item item = newItem(path, ASSET_SHADER, 0);
+        item.data = std::move(bytes);
+        items.push_back(std::move(item));
+        return true;
+    }
+
+    // Decodes path and stores its full mip chain, block-compressed to
+    // vkFormat unless that is 0.
+    bool addTexture(const std::string &path, bool flipVertically, uint32_t vkFormat) {
+        std::vector<unsigned char> bytes;
+        if (!readBytes(path, bytes)) {
+            std::cout << "Failed to load texture: " << path << std::endl;
+            return false;
+        }
+        int width, height, channels;
+        stbi_set_flip_vertically_on_load(flipVertically);
+        unsigned char* pixels = stbi_load_from_memory(bytes.data(), (int) bytes.size(), &width, &height, &channels, 0);
+        if (pixels == NULL) {
+            std::cout << "Failed to load texture: " << path << std::endl;
+            return false;
+        }
+
+        Item item = newItem(path, ASSET_TEXTURE, flipVertically ? ASSET_FLIP_VERTICALLY : 0);
+        item.contentHash = textureContentHash(bytes, flipVertically);
+        item.params[0] = (uint32_t) width;
+        item.params[1] = (uint32_t) height;
+        item.params[2] = (uint32_t) channels;
+        item.params[3] = vkFormat;
+        if (vkFormat == 0) {
+            item.data = createMipChain(pixels, width, height, channels);
+        } else {
+            Ktx2Image image = compressTexture(pixels, width, height, channels, vkFormat);
+            for (const std::vector<unsigned char> &level : image.levels) {
+                item.data.insert(item.data.end(), level.begin(), level.end());
+            }
+        }
+        stbi_image_free(pixels);
+        items.push_back(std::move(item));
+        return true;
+    }
+
+    // Stored as "mesh/<name>", see MeshBuffer::addBuiltin().
+    void addMesh(const std::string &name, const MeshData &mesh) {
+        Item item = newItem("mesh/" + name, ASSET_MESH, 0);
+        item.sourceTime = 0;
+        item.params[0] = (uint32_t) mesh.vertices.size();
+        item.params[1] = (uint32_t) mesh.indices.size();
+        const unsigned char* vertices = (const unsigned char*) mesh.vertices.data();
+        const unsigned char* indices = (const unsigned char*) mesh.indices.data();
+        item.data.assign(vertices, vertices + mesh.vertices.size() * sizeof(MeshVertex));
+        item.data.insert(item.data.end(), indices, indices + mesh.indices.size() * sizeof(unsigned int));
+        items.push_back(std::move(item));
+    }
+
+    // Written next to path and renamed over it, so a demo that has the old
+    // pack mapped keeps reading the old file.
+    bool write(const std::string &path) {
+        std::sort(items.begin(), items.end(), [](const Item &a, const Item &b) {
+            return a.hash != b.hash ? a.hash < b.hash : a.name < b.name;
+        });
+
+        std::vector<AssetPackEntry> entries;
+        std::string names;
+        uint64_t offset = sizeof(AssetPackHeader);
+        for (const Item &item : items) {
+            uint64_t alignment = item.data.size() >= ASSET_PACK_PAGE ? ASSET_PACK_PAGE : ASSET_PACK_ALIGNMENT;
+            offset = align(offset, alignment);
+            AssetPackEntry entry;
+            memset(&entry, 0, sizeof(entry));
+            entry.hash = item.hash;
+            entry.contentHash = item.contentHash;
+            entry.offset = offset;
+            entry.size = item.data.size();
+            entry.sourceTime = item.sourceTime;
+            entry.nameOffset = (uint32_t) names.size();
+            entry.nameLength = (uint32_t) item.name.size();
+            entry.type = item.type;
+            entry.flags = item.flags;
+            memcpy(entry.params, item.params, sizeof(entry.params));
+            entries.push_back(entry);
+            names += item.name;
+            offset += item.data.size();
+        }
+
+        AssetPackHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, ASSET_PACK_MAGIC, sizeof(ASSET_PACK_MAGIC));
+        header.version = ASSET_PACK_VERSION;
+        header.entryCount = (uint32_t) entries.size();
+        header.tocOffset = align(offset, ASSET_PACK_ALIGNMENT);
+        header.namesOffset = header.tocOffset + entries.size() * sizeof(AssetPackEntry);
+        header.namesSize = names.size();
+        header.fileSize = header.namesOffset + header.namesSize;
+
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file) {
+                std::cout << "Failed to write asset pack: " << path << std::endl;
+                return false;
+            }
+            file.write((const char*) &header, sizeof(header));
+            for (size_t i = 0; i < items.size(); i++) {
+                pad(file, entries[i].offset);
+                file.write((const char*) items[i].data.data(), (std::streamsize) items[i].data.size());
+            }
+            pad(file, header.tocOffset);
+            file.write((const char*) entries.data(), (std::streamsize) (entries.size() * sizeof(AssetPackEntry)));
+            file.write(names.data(), (std::streamsize) names.size());
+            if (!file) {
+                std::cout << "Failed to write asset pack: " << path << std::endl;
+                return false;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, path, error);
+        if (error) {
+            std::cout << "Failed to write asset pack: " << path << ": " << error.message() << std::endl;
+            return false;
+        }
+        fileSize = header.fileSize;
+        return true;
+    }
+
+    size_t count() const {
+        return items.size();
+    }
+
+    // size of the last pack written
+    size_t fileSize = 0;
+
+private:
+    struct Item {
+        std::string name;
+        uint64_t hash = 0;
+        uint64_t contentHash = 0;
+        int64_t sourceTime = 0;
+        uint32_t type = 0;
+        uint32_t flags = 0;
+        uint32_t params[4] = {0, 0, 0, 0};
+        std::vector<unsigned char> data;
+    };
+
+    std::vector<Item> items;
+
+    static Item newItem(const std::string &path, AssetType type, uint32_t flags) {
+        Item item;
+        item.name = assetName(path);
+        item.hash = fnv1a64(item.name);
+        item.sourceTime = assetSourceTime(path);
+        item.type = type;
+        item.flags = flags;
+        return item;
+    }
+
+    static bool readBytes(const std::string &path, std::vector<unsigned char> &bytes) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return false;
+        }
+        bytes.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    static uint64_t align(uint64_t offset, uint64_t alignment) {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    static void pad(std::ofstream &file, uint64_t offset) {
+        static const char zeros[ASSET_PACK_PAGE] = {};
+        uint64_t position = (uint64_t) file.tellp();
+        file.write(zeros, (std::streamsize) (offset - position));
+    }
+};
+
+#endif //OPENGL_FROM_SCRATCH_OFS_ASSET_COOK_H
@@ -0,0 +1,302 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_ASSET_PACK_H
+#define OPENGL_FROM_SCRATCH_OFS_ASSET_PACK_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <filesystem>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "ofs/shader_cache.h"
+
+// Read side of the pack files ofs_cook writes: shaders, pre-decoded textures
+// and meshes in one file, mapped into memory and handed out in place.
+//
+//   header | data, every entry aligned | table of contents | names
+//
+// The table holds one AssetPackEntry per asset, sorted by the hash of its
+// name, so a lookup is a binary search and never reads a data page. Entries
+// of a page or more start on a page boundary and the mapping is advised as
+// random access, so a scene only faults in the pages of what it uses.
+// Integers are little-endian.
+//
+// Names are source paths as the demos open them (lexically normalised), so
+// cook from the directory the demos run in:
+//
+//     ofs_cook ../shader ../resources
+//
+// readShaderFile(), TextureCache, AsyncTextureLoader and MeshBuffer::addBuiltin
+// consult the mounted pack before touching the source. An entry whose source
+// file has changed since it was cooked is skipped in favour of the source.
+//
+// The pack is assets.pack in the working directory, or OFS_ASSET_PACK.
+
+const uint32_t ASSET_PACK_VERSION = 1;
+const char ASSET_PACK_MAGIC[8] = {'O', 'F', 'S', 'P', 'A', 'C', 'K', 0};
+const uint64_t ASSET_PACK_PAGE = 4096;
+// alignment of entries smaller than a page
+const uint64_t ASSET_PACK_ALIGNMENT = 64;
+
+enum AssetType : uint32_t {
+    ASSET_SHADER = 1,
+    // mip chain, level 0 first: 8-bit pixels as createMipChain() lays them
+    // out, or KTX2 blocks when vkFormat is set
+    ASSET_TEXTURE = 2,
+    // MeshVertex array followed by the 32-bit indices
+    ASSET_MESH = 3,
+};
+
+// flags of ASSET_TEXTURE
+const uint32_t ASSET_FLIP_VERTICALLY = 1;
+
+struct AssetPackHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entryCount;
+    uint64_t tocOffset;
+    uint64_t namesOffset;
+    uint64_t namesSize;
+    uint64_t fileSize;
+    uint8_t reserved[16];
+};
+
+struct AssetPackEntry {
+    // fnv1a64 of the name
+    uint64_t hash;
+    // ASSET_TEXTURE: textureContentHash() of the source, as TextureCache keys it
+    uint64_t contentHash;
+    uint64_t offset;
+    uint64_t size;
+    // last write time of the source when cooked, 0 for generated assets
+    int64_t sourceTime;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t type;
+    uint32_t flags;
+    // ASSET_TEXTURE: width, height, channels, vkFormat (0 = uncompressed)
+    // ASSET_MESH: vertex count, index count
+    uint32_t params[4];
+};
+
+static_assert(sizeof(AssetPackHeader) == 64, "AssetPackHeader is part of the file format");
+static_assert(sizeof(AssetPackEntry) == 72, "AssetPackEntry is part of the file format");
+
+// A view into the mapping; valid while the pack stays mounted.
+struct AssetSpan {
+    const unsigned char* data = NULL;
+    size_t size = 0;
+};
+
+std::string assetName(const std::string &path) {
+    return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+int64_t assetSourceTime(const std::string &path) {
+    std::error_code error;
+    auto time = std::filesystem::last_write_time(path, error);
+    return error ? 0 : (int64_t) time.time_since_epoch().count();
+}
+
+struct AssetPackStats {
+    int lookups = 0;
+    int hits = 0;
+    // entries skipped because their source changed after cooking
+    int stale = 0;
+    size_t bytesServed = 0;
+};
+
+class AssetPack {
+public:
+    AssetPackStats stats;
+
+    // Mounts OFS_ASSET_PACK or ./assets.pack on first use, if there is one.
+    static AssetPack& instance() {
+        static AssetPack pack;
+        return pack;
+    }
+
+    bool mount(const std::string &path) {
+        unmount();
+        if (!map(path)) {
+            return false;
+        }
+        const AssetPackHeader* header = (const AssetPackHeader*) base;
+        if (size < sizeof(AssetPackHeader) || memcmp(header->magic, ASSET_PACK_MAGIC, sizeof(ASSET_PACK_MAGIC)) != 0
+            || header->version != ASSET_PACK_VERSION || header->fileSize != size
+            || header->tocOffset > size || (uint64_t) header->entryCount * sizeof(AssetPackEntry) > size - header->tocOffset
+            || header->namesOffset > size || header->namesSize > size - header->namesOffset) {
+            std::cout << "Not an asset pack or written by another version: " << path << std::endl;
+            unmount();
+            return false;
+        }
+        entries = (const AssetPackEntry*) (base + header->tocOffset);
+        entryCount = header->entryCount;
+        names = (const char*) (base + header->namesOffset);
+        for (size_t i = 0; i < entryCount; i++) {
+            const AssetPackEntry &entry = entries[i];
+            if (entry.offset > size || entry.size > size - entry.offset || (uint64_t) entry.nameOffset + entry.nameLength > header->namesSize) {
+                std::cout << "Corrupt asset pack entry " << i << ": " << path << std::endl;
+                unmount();
+                return false;
+            }
+        }
+        mountedPath = path;
+        std::cout << "Asset pack: " << path << ", " << entryCount << " entries, " << size / 1024 << " KiB" << std::endl;
+        return true;
+    }
+
+    void unmount() {
+#ifndef _WIN32
+        if (base != NULL) {
+            munmap((void*) base, size);
+        }
+#endif
+        contents = std::vector<unsigned char>();
+        base = NULL;
+        size = 0;
+        entries = NULL;
+        entryCount = 0;
+        names = NULL;
+        mountedPath.clear();
+    }
+
+    bool mounted() const {
+        return base != NULL;
+    }
+
+    // The entry named path with the given type and flags, or NULL.
+    const AssetPackEntry* find(const std::string &path, AssetType type, uint32_t flags = 0) {
+        if (!mounted()) {
+            return NULL;
+        }
+        stats.lookups++;
+        std::string name = assetName(path);
+        uint64_t hash = fnv1a64(name);
+        const AssetPackEntry* end = entries + entryCount;
+        const AssetPackEntry* entry = std::lower_bound(entries, end, hash, [](const AssetPackEntry &e, uint64_t h) {
+            return e.hash < h;
+        });
+        for (; entry != end && entry->hash == hash; entry++) {
+            if (entry->type != type || entry->flags != flags || entry->nameLength != name.size()
+                || memcmp(names + entry->nameOffset, name.data(), name.size()) != 0) {
+                continue;
+            }
+            if (entry->sourceTime != 0) {
+                int64_t sourceTime = assetSourceTime(name);
+                if (sourceTime != 0 && sourceTime != entry->sourceTime) {
+                    if (stats.stale++ == 0) {
+                        std::cout << "Asset pack is older than " << name << ", cook it again; using the sources" << std::endl;
+                    }
+                    return NULL;
+                }
+            }
+            stats.hits++;
+            stats.bytesServed += entry->size;
+            return entry;
+        }
+        return NULL;
+    }
+
+    AssetSpan data(const AssetPackEntry &entry) const {
+        AssetSpan span;
+        span.data = base + entry.offset;
+        span.size = entry.size;
+        return span;
+    }
+
+    std::string name(const AssetPackEntry &entry) const {
+        return std::string(names + entry.nameOffset, entry.nameLength);
+    }
+
+    size_t count() const {
+        return entryCount;
+    }
+
+    const AssetPackEntry& entry(size_t i) const {
+        return entries[i];
+    }
+
+    size_t mappedBytes() const {
+        return size;
+    }
+
+    void report() const {
+        if (!mounted()) {
+            std::cout << "Asset pack: none mounted" << std::endl;
+            return;
+        }
+        std::cout << "Asset pack: " << mountedPath << ", " << stats.hits << " of " << stats.lookups << " lookups served ("
+                  << stats.stale << " stale), " << stats.bytesServed / 1024 << " of " << size / 1024 << " KiB" << std::endl;
+    }
+
+    ~AssetPack() {
+        unmount();
+    }
+
+private:
+    const unsigned char* base = NULL;
+    size_t size = 0;
+    // the whole file where there is no mmap
+    std::vector<unsigned char> contents;
+    const AssetPackEntry* entries = NULL;
+    size_t entryCount = 0;
+    const char* names = NULL;
+    std::string mountedPath;
+
+    bool map(const std::string &path) {
+#ifdef _WIN32
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return false;
+        }
+        contents.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        base = contents.data();
+        size = contents.size();
+        return !contents.empty();
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            close(fd);
+            return false;
+        }
+        void* mapping = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        // the mapping keeps the file alive
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            std::cout << "Failed to map asset pack: " << path << std::endl;
+            return false;
+        }
+        // no read-ahead: only the pages a scene asks for get loaded
+        madvise(mapping, (size_t) info.st_size, MADV_RANDOM);
+        base = (const unsigned char*) mapping;
+        size = (size_t) info.st_size;
+        return true;
+#endif
+    }
+
+    AssetPack() {
+        const char* path = getenv("OFS_ASSET_PACK");
+        std::string packPath = path != NULL ? path : "assets.pack";
+        if (std::filesystem::exists(packPath)) {
+            mount(packPath);
+        }
+    }
+};
+
+#endif //OPENGL_FROM_SCRATCH_OFS_ASSET_PACK_H
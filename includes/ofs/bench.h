@@ -0,0 +1,134 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_BENCH_H
+#define OPENGL_FROM_SCRATCH_OFS_BENCH_H
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "ofs/gl_state_cache.h"
+#include "ofs/context.h"
+
+// Shared helpers for the bench/ targets: a context without a visible window
+// (pass --headless to run without a display) and a tiny wall-clock timer.
+
+bool createBenchContext(Context &context, int width, int height, const char* title) {
+    context.hidden = true;
+    if (!context.create(width, height, title, 3, 3)) {
+        return false;
+    }
+    context.setSwapInterval(0);
+    return true;
+}
+
+// Positional numbers from the command line, in order; Context's options and
+// their values are skipped, as is any other -- option.
+std::vector<int> benchNumbers(const Context &context) {
+    std::vector<int> numbers;
+    for (const std::string &arg : context.arguments) {
+        if (arg.compare(0, 2, "--") != 0) {
+            numbers.push_back(atoi(arg.c_str()));
+        }
+    }
+    return numbers;
+}
+
+// Color + depth render target so GPU benchmarks do not depend on the window size.
+unsigned int createBenchFramebuffer(int width, int height) {
+    unsigned int fbo, color, depth;
+    glGenFramebuffers(1, &fbo);
+    GLStateCache::instance().bindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+    glGenRenderbuffers(1, &color);
+    glBindRenderbuffer(GL_RENDERBUFFER, color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+
+    glGenRenderbuffers(1, &depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "Failed to create bench framebuffer" << std::endl;
+    }
+    glViewport(0, 0, width, height);
+    return fbo;
+}
+
+// The RGBA8 pixels of the bound read framebuffer, bottom row first.
+std::vector<unsigned char> readBenchTarget(int width, int height) {
+    std::vector<unsigned char> pixels(width * height * 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    return pixels;
+}
+
+// 1x1 white texture, left bound to unit 0; as a diffuse map the lights'
+// colors are all there is to see.
+unsigned int createWhiteTexture() {
+    unsigned int white;
+    unsigned char texel[4] = {255, 255, 255, 255};
+    glGenTextures(1, &white);
+    GLStateCache::instance().bindTexture(0, GL_TEXTURE_2D, white);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    return white;
+}
+
+const int BENCH_BLOCK_SIDE = 16;
+
+// Layers of BENCH_BLOCK_SIDE x BENCH_BLOCK_SIDE / 2 cubes one behind the
+// other, the furthest layer first so the depth test rejects as little as
+// possible.
+std::vector<glm::mat4> benchBlock(int layers) {
+    std::vector<glm::mat4> models;
+    for (int layer = layers - 1; layer >= 0; layer--) {
+        for (int y = 0; y < BENCH_BLOCK_SIDE / 2; y++) {
+            for (int x = 0; x < BENCH_BLOCK_SIDE; x++) {
+                glm::vec3 position(1.6f * (x - BENCH_BLOCK_SIDE / 2) + 0.4f * (layer % 3), 1.6f * (y - BENCH_BLOCK_SIDE / 4), -4.0f - 1.6f * layer);
+                glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+                models.push_back(glm::rotate(model, glm::radians(10.0f * (x + y + layer)), glm::vec3(0.3f, 1.0f, 0.2f)));
+            }
+        }
+    }
+    return models;
+}
+
+class BenchTimer {
+public:
+    BenchTimer() : start(std::chrono::steady_clock::now()) {}
+
+    double elapsedMs() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void reset() {
+        start = std::chrono::steady_clock::now();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+// Runs frame() frames + 1 times, each up to glFinish(), and returns the mean
+// milliseconds per frame. Frame 0 warms up the driver and is not counted.
+template <typename Frame>
+double benchFrameMs(int frames, Frame frame) {
+    double total = 0.0;
+    for (int i = 0; i <= frames; i++) {
+        BenchTimer timer;
+        frame();
+        glFinish();
+        if (i > 0) {
+            total += timer.elapsedMs();
+        }
+    }
+    return total / frames;
+}
+
+#endif //OPENGL_FROM_SCRATCH_OFS_BENCH_H
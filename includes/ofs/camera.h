@@ -101,6 +101,20 @@ public:
         }
     }
 
+    // Scripted flight for frame captures in place of keyboard and mouse: a slow
+    // orbit around the origin, looking at it, that starts at the demos' default
+    // pose (0, 0, 3) and depends on nothing but the time.
+    void FollowPath(float seconds) {
+        float angle = 0.35f * seconds;
+        float radius = 3.0f + 0.5f * sin(0.5f * seconds);
+        Position = glm::vec3(radius * sin(angle), 0.4f * sin(0.3f * seconds), radius * cos(angle));
+        glm::vec3 direction = glm::normalize(-Position);
+        Yaw = glm::degrees(atan2(direction.z, direction.x));
+        Pitch = glm::degrees(asin(direction.y));
+        Zoom = ZOOM;
+        updateCameraVectors();
+    }
+
 private:
     void updateCameraVectors() {
         glm::vec3 front;
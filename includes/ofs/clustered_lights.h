@@ -0,0 +1,490 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_CLUSTERED_LIGHTS_H
+#define OPENGL_FROM_SCRATCH_OFS_CLUSTERED_LIGHTS_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "ofs/shader.h"
+#include "ofs/uniform_buffer.h"
+#include "ofs/light_bounds.h"
+#include "ofs/gl_state_cache.h"
+#include "ofs/profiler.h"
+
+// outerCutOff of a light without a cone
+const float CLUSTER_POINT_LIGHT = -2.0f;
+
+// A point or spot light of the clustered shaders, four RGBA32F texels of the
+// light texture buffer; mirrored by fetchClusterLight() in
+// shader/common/clusters.glsl.
+struct ClusterLight {
+    glm::vec3 position;
+    // lights nothing further away, see shadeClusterLight()
+    float radius;
+    glm::vec3 color;
+    // scale of the specular term
+    float specular;
+    // spot lights only, the cone's axis
+    glm::vec3 direction;
+    // cosines of the inner and outer cone angles
+    float cutOff;
+    float constant;
+    float linear;
+    float quadratic;
+    float outerCutOff;
+};
+
+static_assert(sizeof(ClusterLight) == 64, "ClusterLight must be four RGBA32F texels");
+
+// http://www.ogre3d.org/tikiwiki/tiki-index.php?page=-Point+Light+Attenuation
+ClusterLight pointLight(glm::vec3 position, glm::vec3 color, float radius) {
+    ClusterLight light;
+    light.position = position;
+    light.radius = radius;
+    light.color = color;
+    light.specular = 1.0f;
+    light.direction = glm::vec3(0.0f, -1.0f, 0.0f);
+    light.cutOff = CLUSTER_POINT_LIGHT;
+    light.constant = 1.0f;
+    light.linear = 0.045f;
+    light.quadratic = 0.0075f;
+    light.outerCutOff = CLUSTER_POINT_LIGHT;
+    return light;
+}
+
+// cutOff and outerCutOff are angles in degrees.
+ClusterLight spotLight(glm::vec3 position, glm::vec3 direction, glm::vec3 color, float radius, float cutOff, float outerCutOff) {
+    ClusterLight light = pointLight(position, color, radius);
+    light.direction = glm::normalize(direction);
+    light.cutOff = std::cos(glm::radians(cutOff));
+    light.outerCutOff = std::cos(glm::radians(outerCutOff));
+    return light;
+}
+
+// Clustered forward shading: the view frustum is cut into tilesX x tilesY
+// screen tiles and `slices` depth slices, spaced exponentially so clusters stay
+// roughly cube shaped, and every cluster gets the list of lights whose sphere,
+// or cone for spot lights (see LightVolume), touches it. A fragment finds its
+// cluster from gl_FragCoord and its view depth and shades only that cluster's
+// lights, so the cost per fragment follows the lights near it rather than the
+// lights in the scene.
+//
+//     ClusteredLights clusters;
+//     clusters.attach(shader);
+//     while (...) {
+//         clusters.setView(view, projection, 0.1f, 100.0f, width, height);
+//         clusters.assign(lights.data(), lights.size());
+//         clusters.upload();
+//         clusters.bind();
+//         shader.use();
+//         ... draw with shader/lighting/clustered.fs.glsl ...
+//     }
+//
+// Lights are assigned on the CPU: the bounds of every light are found in
+// parallel over the lights, then the clusters are filled in parallel over the
+// depth slices, so no two threads write to the same cluster. The results go
+// to the GPU in three texture buffers, the lights, an offset and count per
+// cluster, and the light indices of all clusters back to back.
+class ClusteredLights {
+public:
+    // texture units of the three texture buffers, after the material maps
+    static const unsigned int DEFAULT_UNIT = 4;
+
+    const int tilesX;
+    const int tilesY;
+    const int slices;
+    glm::vec3 ambient = glm::vec3(0.05f);
+
+    // of the last assign()
+    int visibleLights = 0;
+    int maxClusterLights = 0;
+    // light indices that did not fit into GL_MAX_TEXTURE_BUFFER_SIZE
+    size_t droppedIndices = 0;
+
+    explicit ClusteredLights(int tilesX = 16, int tilesY = 9, int slices = 24, int threads = defaultThreads())
+            : tilesX(tilesX), tilesY(tilesY), slices(slices), block(CLUSTER_BLOCK_BINDING),
+              clusterLists(tilesX * tilesY * slices), ranges(2 * tilesX * tilesY * slices) {
+        GLint maxTexels = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+        maxIndices = (size_t) maxTexels;
+
+        GLStateCache &state = GLStateCache::instance();
+        const GLenum formats[BUFFERS] = {GL_RGBA32F, GL_RG32UI, GL_R32UI};
+        glGenBuffers(BUFFERS, buffers);
+        glGenTextures(BUFFERS, textures);
+        for (int i = 0; i < BUFFERS; i++) {
+            state.bindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+            // a texture buffer needs a data store before it can be sampled
+            glBufferData(GL_TEXTURE_BUFFER, 64, NULL, GL_STREAM_DRAW);
+            state.bindTexture(GL_TEXTURE_BUFFER, textures[i]);
+            glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+        }
+
+        for (int i = 1; i < threads; i++) {
+            workers.emplace_back(&ClusteredLights::work, this, i);
+        }
+    }
+
+    ~ClusteredLights() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+        GLStateCache &state = GLStateCache::instance();
+        state.deleteTextures(BUFFERS, textures);
+        state.deleteBuffers(BUFFERS, buffers);
+    }
+
+    ClusteredLights(const ClusteredLights&) = delete;
+    ClusteredLights& operator=(const ClusteredLights&) = delete;
+
+    // The calling thread takes a share of the work too.
+    static int defaultThreads() {
+        return std::max(1, std::min(8, (int) std::thread::hardware_concurrency()));
+    }
+
+    int clusterCount() const {
+        return tilesX * tilesY * slices;
+    }
+
+    // Points the samplers of a program built with shader/common/clusters.glsl
+    // at the texture units bind() uses.
+    void attach(Shader &shader, unsigned int firstUnit = DEFAULT_UNIT) const {
+        shader.use();
+        shader.setInt("clusterLights", firstUnit);
+        shader.setInt("clusterRanges", firstUnit + 1);
+        shader.setInt("clusterIndices", firstUnit + 2);
+    }
+
+    // Once per frame before assign(). projection must be a perspective
+    // projection with the given near and far planes; the cluster bounds are
+    // only rebuilt when it or the viewport size changes.
+    void setView(const glm::mat4 &view, const glm::mat4 &projection, float zNear, float zFar, int width, int height) {
+        this->view = view;
+        if (projection == this->projection && zNear == this->zNear && zFar == this->zFar && width == this->width && height == this->height) {
+            return;
+        }
+        this->projection = projection;
+        this->zNear = zNear;
+        this->zFar = zFar;
+        this->width = width;
+        this->height = height;
+        tileWidth = (width + tilesX - 1) / tilesX;
+        tileHeight = (height + tilesY - 1) / tilesY;
+        sliceScale = slices / std::log(zFar / zNear);
+        sliceBias = -slices * std::log(zNear) / std::log(zFar / zNear);
+        buildClusterBounds();
+    }
+
+    // Builds the light list of every cluster from count lights.
+    void assign(const ClusterLight* lights, size_t count) {
+        OFS_PROFILE_ZONE("assign lights");
+        this->lights.assign(lights, lights + count);
+        bounds.resize(count);
+
+        std::function<void(int, int)> findBounds = [this](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                bounds[i] = lightBounds(this->lights[i]);
+            }
+        };
+        parallel((int) count, findBounds);
+
+        std::function<void(int, int)> fillSlices = [this](int begin, int end) {
+            for (int slice = begin; slice < end; slice++) {
+                fillSlice(slice);
+            }
+        };
+        parallel(slices, fillSlices);
+
+        // offsets are a prefix sum over all clusters, cheap enough for one thread
+        indices.clear();
+        visibleLights = 0;
+        maxClusterLights = 0;
+        droppedIndices = 0;
+        for (const LightBounds &light : bounds) {
+            visibleLights += light.visible;
+        }
+        for (int cluster = 0; cluster < clusterCount(); cluster++) {
+            const std::vector<uint32_t> &list = clusterLists[cluster];
+            size_t fits = std::min(list.size(), maxIndices - std::min(maxIndices, indices.size()));
+            droppedIndices += list.size() - fits;
+            ranges[2 * cluster] = (uint32_t) indices.size();
+            ranges[2 * cluster + 1] = (uint32_t) fits;
+            indices.insert(indices.end(), list.begin(), list.begin() + fits);
+            maxClusterLights = std::max(maxClusterLights, (int) list.size());
+        }
+    }
+
+    // Sends the last assign() to the GPU, orphaning the old buffer stores so
+    // frames still in flight keep theirs.
+    void upload() {
+        OFS_PROFILE_ZONE("upload clusters");
+        block.data.grid = glm::ivec4(tilesX, tilesY, slices, (int) lights.size());
+        block.data.slicing = glm::vec4(sliceScale, sliceBias, (float) tileWidth, (float) tileHeight);
+        block.data.ambient = ambient;
+        block.upload();
+        fill(LIGHTS, lights.data(), lights.size() * sizeof(ClusterLight));
+        fill(RANGES, ranges.data(), ranges.size() * sizeof(uint32_t));
+        fill(INDICES, indices.data(), indices.size() * sizeof(uint32_t));
+    }
+
+    // Also binds the block, in case another ClusteredLights took its binding point.
+    void bind(unsigned int firstUnit = DEFAULT_UNIT) const {
+        GLStateCache &state = GLStateCache::instance();
+        state.bindBufferBase(GL_UNIFORM_BUFFER, CLUSTER_BLOCK_BINDING, block.ID);
+        for (int i = 0; i < BUFFERS; i++) {
+            state.bindTexture(firstUnit + i, GL_TEXTURE_BUFFER, textures[i]);
+        }
+    }
+
+    // offset and count into indices() of every cluster
+    const std::vector<uint32_t>& clusterRanges() const {
+        return ranges;
+    }
+
+    const std::vector<uint32_t>& lightIndices() const {
+        return indices;
+    }
+
+private:
+    enum { LIGHTS, RANGES, INDICES, BUFFERS };
+
+    struct Aabb {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    // a light's view space sphere and the clusters its bounding box covers,
+    // inclusive; spot lights also their cone
+    struct LightBounds {
+        glm::vec3 center;
+        float radius;
+        LightVolume volume;
+        int x0, x1, y0, y1, z0, z1;
+        bool visible;
+    };
+
+    UniformBuffer<ClusterBlock> block;
+    unsigned int buffers[BUFFERS];
+    unsigned int textures[BUFFERS];
+    size_t maxIndices = 0;
+
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(0.0f);
+    float zNear = 0.0f;
+    float zFar = 0.0f;
+    int width = 0;
+    int height = 0;
+    int tileWidth = 1;
+    int tileHeight = 1;
+    float sliceScale = 0.0f;
+    float sliceBias = 0.0f;
+
+    std::vector<Aabb> clusterBounds;
+    std::vector<ClusterLight> lights;
+    std::vector<LightBounds> bounds;
+    // kept between frames so filling them does not allocate
+    std::vector<std::vector<uint32_t>> clusterLists;
+    std::vector<uint32_t> ranges;
+    std::vector<uint32_t> indices;
+
+    // workers; index 0 is the thread calling parallel()
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(int, int)>* job = NULL;
+    int jobSize = 0;
+    int jobParts = 0;
+    int pending = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+
+    int sliceOf(float depth) const {
+        int slice = (int) std::floor(std::log(depth) * sliceScale + sliceBias);
+        return std::max(0, std::min(slices - 1, slice));
+    }
+
+    float sliceDepth(int slice) const {
+        return zNear * std::pow(zFar / zNear, (float) slice / slices);
+    }
+
+    int tileOf(float ndc, int pixels, int tileSize, int tiles) const {
+        int tile = (int) std::floor((ndc * 0.5f + 0.5f) * pixels / tileSize);
+        return std::max(0, std::min(tiles - 1, tile));
+    }
+
+    // View space box of every cluster: the tile's corner rays cut at the
+    // slice's near and far depth.
+    void buildClusterBounds() {
+        clusterBounds.resize(clusterCount());
+        glm::mat4 inverseProjection = glm::inverse(projection);
+        for (int z = 0; z < slices; z++) {
+            float depths[2] = {sliceDepth(z), sliceDepth(z + 1)};
+            for (int y = 0; y < tilesY; y++) {
+                for (int x = 0; x < tilesX; x++) {
+                    Aabb box = {glm::vec3(INFINITY), glm::vec3(-INFINITY)};
+                    for (int corner = 0; corner < 4; corner++) {
+                        int px = std::min((x + (corner & 1)) * tileWidth, width);
+                        int py = std::min((y + (corner >> 1)) * tileHeight, height);
+                        glm::vec4 ndc(2.0f * px / width - 1.0f, 2.0f * py / height - 1.0f, -1.0f, 1.0f);
+                        glm::vec4 onNear = inverseProjection * ndc;
+                        glm::vec3 ray = glm::vec3(onNear) / onNear.w;
+                        for (float depth : depths) {
+                            glm::vec3 point = ray * (depth / -ray.z);
+                            box.min = glm::min(box.min, point);
+                            box.max = glm::max(box.max, point);
+                        }
+                    }
+                    clusterBounds[x + tilesX * (y + tilesY * z)] = box;
+                }
+            }
+        }
+    }
+
+    LightBounds lightBounds(const ClusterLight &light) const {
+        LightBounds result;
+        result.center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+        result.radius = light.radius;
+        result.visible = false;
+        if (light.outerCutOff >= -1.0f) {
+            result.volume = spotLightVolume(result.center, glm::mat3(view) * light.direction, light.radius, light.outerCutOff);
+        } else {
+            result.volume = pointLightVolume(result.center, light.radius);
+        }
+        float nearest = -result.center.z - light.radius;
+        float furthest = -result.center.z + light.radius;
+        if (furthest < zNear || nearest > zFar) {
+            return result;
+        }
+        result.z0 = sliceOf(std::max(zNear, nearest));
+        result.z1 = sliceOf(std::min(zFar, furthest));
+        result.x0 = 0;
+        result.x1 = tilesX - 1;
+        result.y0 = 0;
+        result.y1 = tilesY - 1;
+        // a sphere reaching past the near plane may cover any tile
+        if (nearest > zNear) {
+            glm::vec2 low(INFINITY);
+            glm::vec2 high(-INFINITY);
+            for (int corner = 0; corner < 8; corner++) {
+                glm::vec3 offset((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f);
+                glm::vec4 clip = projection * glm::vec4(result.center + light.radius * offset, 1.0f);
+                glm::vec2 ndc = glm::vec2(clip) / clip.w;
+                low = glm::min(low, ndc);
+                high = glm::max(high, ndc);
+            }
+            if (high.x < -1.0f || low.x > 1.0f || high.y < -1.0f || low.y > 1.0f) {
+                return result;
+            }
+            result.x0 = tileOf(low.x, width, tileWidth, tilesX);
+            result.x1 = tileOf(high.x, width, tileWidth, tilesX);
+            result.y0 = tileOf(low.y, height, tileHeight, tilesY);
+            result.y1 = tileOf(high.y, height, tileHeight, tilesY);
+        }
+        result.visible = true;
+        return result;
+    }
+
+    void fillSlice(int z) {
+        for (int cluster = tilesX * tilesY * z; cluster < tilesX * tilesY * (z + 1); cluster++) {
+            clusterLists[cluster].clear();
+        }
+        for (size_t i = 0; i < bounds.size(); i++) {
+            const LightBounds &light = bounds[i];
+            if (!light.visible || z < light.z0 || z > light.z1) {
+                continue;
+            }
+            float radius2 = light.radius * light.radius;
+            for (int y = light.y0; y <= light.y1; y++) {
+                for (int x = light.x0; x <= light.x1; x++) {
+                    int cluster = x + tilesX * (y + tilesY * z);
+                    const Aabb &box = clusterBounds[cluster];
+                    glm::vec3 closest = glm::clamp(light.center, box.min, box.max);
+                    glm::vec3 d = closest - light.center;
+                    if (glm::dot(d, d) > radius2) {
+                        continue;
+                    }
+                    // against the cluster's bounding sphere, cheaper than the box
+                    if (light.volume.isSpot() && !light.volume.intersectsSphere(0.5f * (box.min + box.max), 0.5f * glm::length(box.max - box.min))) {
+                        continue;
+                    }
+                    clusterLists[cluster].push_back((uint32_t) i);
+                }
+            }
+        }
+    }
+
+    void fill(int buffer, const void* data, size_t bytes) {
+        GLStateCache::instance().bindBuffer(GL_TEXTURE_BUFFER, buffers[buffer]);
+        // never empty, a texture buffer without storage reads as undefined
+        glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(bytes, 64), NULL, GL_STREAM_DRAW);
+        if (bytes > 0) {
+            glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+        }
+    }
+
+    // Runs job over [0, size) split evenly between this thread and the
+    // workers, and returns once every part is done.
+    void parallel(int size, const std::function<void(int, int)> &job) {
+        int parts = std::min((int) workers.size() + 1, size);
+        if (parts <= 1) {
+            if (size > 0) {
+                job(0, size);
+            }
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            this->job = &job;
+            jobSize = size;
+            jobParts = parts;
+            pending = parts - 1;
+            generation++;
+        }
+        wake.notify_all();
+        job(0, size / parts);
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pending == 0; });
+    }
+
+    void work(int index) {
+        OFS_PROFILE_THREAD("light clusters");
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this, seen] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            if (index >= jobParts) {
+                continue;
+            }
+            const std::function<void(int, int)> &current = *job;
+            int begin = (int) ((int64_t) jobSize * index / jobParts);
+            int end = (int) ((int64_t) jobSize * (index + 1) / jobParts);
+            lock.unlock();
+            current(begin, end);
+            lock.lock();
+            if (--pending == 0) {
+                done.notify_one();
+            }
+        }
+    }
+};
+
+#endif //OPENGL_FROM_SCRATCH_OFS_CLUSTERED_LIGHTS_H
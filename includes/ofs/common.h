@@ -1,8 +1,10 @@
 #ifndef OPENGL_FROM_SCRATCH_OFS_COMMON_H
 #define OPENGL_FROM_SCRATCH_OFS_COMMON_H
 
+#include "ofs/context.h"
 #include "ofs/shader.h"
 #include "ofs/camera.h"
+#include "ofs/texture_cache.h"
 
 const int WIDTH = 1920;
 const int HEIGHT = 1080;
@@ -22,38 +24,10 @@ void errorCallback(int error, const char* description) {
     std::cout << error << " " << description << std::endl;
 }
 
+// Shared through TextureCache: loading the same image twice returns the same texture.
 unsigned int loadTexture(const char* path) {
-    unsigned int texture;
-    glGenTextures(1, &texture);
-
-    int width, height, nrChannels;
-    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
-
-    GLenum format;
-    if (nrChannels == 1) {
-        format = GL_RED;
-    } else if (nrChannels == 3) {
-        format = GL_RGB;
-    } else if (nrChannels == 4) {
-        format = GL_RGBA;
-    }
-
-    if (data) {
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    } else {
-        std::cout << "Failed to load texture" << std::endl;
-    }
-
-    stbi_image_free(data);
-
-    return texture;
+    OFS_PROFILE_ZONE("loadTexture");
+    return TextureCache::instance().acquire(path);
 }
 
 
@@ -64,46 +38,51 @@ void frameBufferSizeCallback(GLFWwindow *window, int width, int height) {
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-void handleInput(GLFWwindow *window) {
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
-        glfwSetWindowShouldClose(window, true);
+void handleInput(Context &context) {
+    OFS_PROFILE_ZONE("input");
+    if (context.getKey(GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+        context.setShouldClose();
     }
 
-    if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_1) == GLFW_PRESS) {
-        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    if (context.getMouseButton(GLFW_MOUSE_BUTTON_1) == GLFW_PRESS) {
+        context.setInputMode(GLFW_CURSOR, GLFW_CURSOR_DISABLED);
         mouseClick = true;
     }
-    if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_1) == GLFW_RELEASE) {
-        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+    if (context.getMouseButton(GLFW_MOUSE_BUTTON_1) == GLFW_RELEASE) {
+        context.setInputMode(GLFW_CURSOR, GLFW_CURSOR_NORMAL);
         mouseClick = false;
     }
 
-    float currentFrame = glfwGetTime();
+    float currentFrame = context.time();
     deltaTime = currentFrame - lastFrame;
     lastFrame = currentFrame;
+    if (context.capturing()) {
+        camera.FollowPath(currentFrame);
+        return;
+    }
     float cameraSpeed = 2.5f * deltaTime; // adjust accordingly
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_W) == GLFW_PRESS)
         camera.ProcessKeyboard(FORWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_S) == GLFW_PRESS)
         camera.ProcessKeyboard(BACKWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_A) == GLFW_PRESS)
         camera.ProcessKeyboard(LEFT, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_Q) == GLFW_PRESS)
         camera.ProcessKeyboard(UP, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_E) == GLFW_PRESS)
         camera.ProcessKeyboard(DOWN, deltaTime);
 
     float LightMovementSpeed = 1;
     float velocity = LightMovementSpeed * deltaTime;
-    if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_UP) == GLFW_PRESS)
         lightPos.y += velocity;
-    if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_DOWN) == GLFW_PRESS)
         lightPos.y -= velocity;
-    if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_LEFT) == GLFW_PRESS)
         lightPos.x -= velocity;
-    if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_RIGHT) == GLFW_PRESS)
         lightPos.x += velocity;
 }
 
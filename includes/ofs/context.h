@@ -0,0 +1,492 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_CONTEXT_H
+#define OPENGL_FROM_SCRATCH_OFS_CONTEXT_H
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+#include "ofs/frame_capture.h"
+#include "ofs/profiler.h"
+#include "ofs/gl_intercept.h"
+#include "ofs/gl_state_cache.h"
+
+// The GL context a demo renders with, picked on the command line:
+//
+//   (default)     a GLFW window
+//   --headless    an EGL context without any surface (Mesa's surfaceless
+//                 platform), rendering into an FBO the size of the window;
+//                 needs no display server, so it runs on build machines
+//                 under llvmpipe
+//   --frames N    close after N frames; headless runs default to 60
+//   --capture N   render N frames and write each to a PNG (see FrameCapture);
+//   --out dir     into dir, ./capture by default. Time advances a fixed
+//                 1/60 s per frame and keyboard and mouse are ignored, so
+//                 demos that fly their camera along a path with
+//                 Camera::FollowPath() render the same frames on every run
+//   --trace file  record profiler zones and write them to file on exit (see
+//                 ofs/profiler.h)
+//
+// Everything else is left, in order, in Context::arguments for the demo's own
+// options.
+//
+// Builds with OFS_GL_INTERCEPT=1 also count the GL calls of every frame and
+// report redundant state changes on exit (see ofs/gl_intercept.h).
+//
+// libEGL is opened at runtime, so nothing extra is linked and builds without
+// it (Windows) only lose the headless backend.
+//
+//     int main(int argc, char** argv) {
+//         Context context(argc, argv);
+//         if (!context.create(WIDTH, HEIGHT, TITLE)) {
+//             return 1;
+//         }
+//         while (!context.shouldClose()) {
+//             ...
+//             context.swapBuffers();
+//             context.pollEvents();
+//         }
+//     }
+//
+// Input queries answer "released" headless and the callbacks are never called.
+
+const int HEADLESS_DEFAULT_FRAMES = 60;
+// time per frame while capturing, independent of how fast frames render
+const double CAPTURE_TIMESTEP = 1.0 / 60.0;
+
+#ifndef _WIN32
+// The few EGL types and entry points the headless backend needs.
+namespace egl {
+typedef void* Display;
+typedef void* Config;
+typedef void* Context;
+typedef void* Surface;
+typedef int32_t Int;
+typedef unsigned int Boolean;
+
+const Int NONE = 0x3038;
+const Int EXTENSIONS = 0x3055;
+const Int RENDERABLE_TYPE = 0x3040;
+const Int OPENGL_BIT = 0x0008;
+const unsigned int OPENGL_API = 0x30A2;
+const Int CONTEXT_MAJOR_VERSION = 0x3098;
+const Int CONTEXT_MINOR_VERSION = 0x30FB;
+const Int CONTEXT_OPENGL_PROFILE_MASK = 0x30FD;
+const Int CONTEXT_OPENGL_CORE_PROFILE_BIT = 0x0001;
+const unsigned int PLATFORM_SURFACELESS_MESA = 0x31DD;
+
+struct Api {
+    void* library = NULL;
+    void* (*getProcAddress)(const char*) = NULL;
+    Display (*getDisplay)(void*) = NULL;
+    Display (*getPlatformDisplayEXT)(unsigned int, void*, const Int*) = NULL;
+    Boolean (*initialize)(Display, Int*, Int*) = NULL;
+    Boolean (*terminate)(Display) = NULL;
+    const char* (*queryString)(Display, Int) = NULL;
+    Boolean (*bindAPI)(unsigned int) = NULL;
+    Boolean (*chooseConfig)(Display, const Int*, Config*, Int, Int*) = NULL;
+    Context (*createContext)(Display, Config, Context, const Int*) = NULL;
+    Boolean (*destroyContext)(Display, Context) = NULL;
+    Boolean (*makeCurrent)(Display, Surface, Surface, Context) = NULL;
+    Int (*getError)() = NULL;
+
+    bool load() {
+        library = dlopen("libEGL.so.1", RTLD_NOW | RTLD_LOCAL);
+        if (library == NULL) {
+            library = dlopen("libEGL.so", RTLD_NOW | RTLD_LOCAL);
+        }
+        if (library == NULL) {
+            return false;
+        }
+        getProcAddress = (void* (*)(const char*)) dlsym(library, "eglGetProcAddress");
+        getDisplay = (Display (*)(void*)) dlsym(library, "eglGetDisplay");
+        initialize = (Boolean (*)(Display, Int*, Int*)) dlsym(library, "eglInitialize");
+        terminate = (Boolean (*)(Display)) dlsym(library, "eglTerminate");
+        queryString = (const char* (*)(Display, Int)) dlsym(library, "eglQueryString");
+        bindAPI = (Boolean (*)(unsigned int)) dlsym(library, "eglBindAPI");
+        chooseConfig = (Boolean (*)(Display, const Int*, Config*, Int, Int*)) dlsym(library, "eglChooseConfig");
+        createContext = (Context (*)(Display, Config, Context, const Int*)) dlsym(library, "eglCreateContext");
+        destroyContext = (Boolean (*)(Display, Context)) dlsym(library, "eglDestroyContext");
+        makeCurrent = (Boolean (*)(Display, Surface, Surface, Context)) dlsym(library, "eglMakeCurrent");
+        getError = (Int (*)()) dlsym(library, "eglGetError");
+        if (getProcAddress == NULL || getDisplay == NULL || initialize == NULL || terminate == NULL || queryString == NULL
+            || bindAPI == NULL || chooseConfig == NULL || createContext == NULL || destroyContext == NULL
+            || makeCurrent == NULL || getError == NULL) {
+            return false;
+        }
+        getPlatformDisplayEXT = (Display (*)(unsigned int, void*, const Int*)) getProcAddress("eglGetPlatformDisplayEXT");
+        return true;
+    }
+};
+
+bool hasExtension(const char* extensions, const char* name) {
+    if (extensions == NULL) {
+        return false;
+    }
+    size_t length = strlen(name);
+    for (const char* found = strstr(extensions, name); found != NULL; found = strstr(found + length, name)) {
+        if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0')) {
+            return true;
+        }
+    }
+    return false;
+}
+}
+
+// glad wants a loader returning void*, eglGetProcAddress is reached through Api.
+egl::Api* eglApiForLoader = NULL;
+
+void* eglLoadGLProc(const char* name) {
+    return eglApiForLoader->getProcAddress(name);
+}
+#endif
+
+class Context {
+public:
+    enum Backend {
+        WINDOW,
+        HEADLESS,
+    };
+
+    Backend backend = WINDOW;
+    // NULL headless
+    GLFWwindow* window = NULL;
+    int width = 0;
+    int height = 0;
+    // the FBO every frame renders into headless; 0, the window, otherwise
+    unsigned int framebuffer = 0;
+    // create the window invisible, for benchmarks
+    bool hidden = false;
+    // close after this many frames, -1 for never
+    int frameLimit = -1;
+    int frame = 0;
+    // frames to write to captureDir, 0 when not capturing
+    int captureFrames = 0;
+    std::string captureDir = "capture";
+    std::string tracePath;
+    // the command line arguments none of the options above consumed, in order
+    std::vector<std::string> arguments;
+
+    Context(int argc, char** argv) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--headless") {
+                backend = HEADLESS;
+            } else if (arg == "--window") {
+                backend = WINDOW;
+            } else if (arg == "--frames" && i + 1 < argc) {
+                frameLimit = atoi(argv[++i]);
+            } else if (arg == "--capture" && i + 1 < argc) {
+                captureFrames = atoi(argv[++i]);
+            } else if (arg == "--out" && i + 1 < argc) {
+                captureDir = argv[++i];
+            } else if (arg == "--trace" && i + 1 < argc) {
+                tracePath = argv[++i];
+            } else {
+                arguments.push_back(arg);
+            }
+        }
+#if OFS_PROFILE
+        // also picks up OFS_TRACE
+        Profiler &profiler = Profiler::instance();
+        if (!tracePath.empty()) {
+            profiler.start(tracePath);
+        }
+#else
+        if (!tracePath.empty()) {
+            std::cout << "Built with OFS_PROFILE=0, --trace records nothing" << std::endl;
+        }
+#endif
+        if (capturing()) {
+            frameLimit = captureFrames;
+        } else if (backend == HEADLESS && frameLimit < 0) {
+            frameLimit = HEADLESS_DEFAULT_FRAMES;
+        }
+    }
+
+    ~Context() {
+        OFS_GL_INTERCEPT_REPORT();
+        if (capture) {
+            // the last frames are still being read back and encoded
+            capture->finish();
+            capture->report();
+            capture.reset();
+        }
+        if (window != NULL) {
+            glfwTerminate();
+        }
+#ifndef _WIN32
+        if (eglContext != NULL) {
+            glDeleteFramebuffers(1, &framebuffer);
+            glDeleteRenderbuffers(2, renderbuffers);
+            eglApi.makeCurrent(eglDisplay, NULL, NULL, NULL);
+            eglApi.destroyContext(eglDisplay, eglContext);
+        }
+        if (eglDisplay != NULL) {
+            eglApi.terminate(eglDisplay);
+        }
+        // libEGL stays loaded, drivers may still run exit handlers from it
+#endif
+    }
+
+    Context(const Context&) = delete;
+    Context& operator=(const Context&) = delete;
+
+    // Creates the context, makes it current and loads GL through glad.
+    bool create(int contextWidth, int contextHeight, const char* title, int majorVersion = 3, int minorVersion = 3) {
+        OFS_PROFILE_ZONE("create context");
+        width = contextWidth;
+        height = contextHeight;
+        bool created = backend == HEADLESS ? createHeadless(majorVersion, minorVersion)
+                                           : createWindow(title, majorVersion, minorVersion);
+        start = std::chrono::steady_clock::now();
+        if (created) {
+            // whatever the cache knew was about another context
+            GLStateCache::instance().invalidate();
+            OFS_GL_INTERCEPT_INSTALL();
+        }
+        if (created && capturing()) {
+            int captureWidth, captureHeight;
+            getFramebufferSize(&captureWidth, &captureHeight);
+            capture.reset(new FrameCapture(captureDir, captureWidth, captureHeight));
+        }
+        return created;
+    }
+
+    bool capturing() const {
+        return captureFrames > 0;
+    }
+
+    bool shouldClose() {
+        if (frameLimit >= 0 && frame >= frameLimit) {
+            return true;
+        }
+        return window != NULL ? glfwWindowShouldClose(window) : closeRequested;
+    }
+
+    void setShouldClose() {
+        closeRequested = true;
+        if (window != NULL) {
+            glfwSetWindowShouldClose(window, GL_TRUE);
+        }
+    }
+
+    void swapBuffers() {
+        OFS_PROFILE_ZONE("swap");
+        if (capture) {
+            capture->capture(framebuffer);
+        }
+        OFS_GL_INTERCEPT_FRAME();
+        frame++;
+        if (window != NULL) {
+            glfwSwapBuffers(window);
+        } else {
+            // nothing presents the frame, make sure it is at least submitted
+            glFlush();
+        }
+    }
+
+    void pollEvents() {
+        OFS_PROFILE_ZONE("poll events");
+        if (window != NULL) {
+            glfwPollEvents();
+        }
+    }
+
+    void setSwapInterval(int interval) {
+        if (window != NULL) {
+            glfwSwapInterval(interval);
+        }
+    }
+
+    // Seconds since create(); frames times the fixed step when capturing.
+    double time() const {
+        if (capturing()) {
+            return frame * CAPTURE_TIMESTEP;
+        }
+        if (window != NULL) {
+            return glfwGetTime();
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // What glad loaded GL with, for entry points it does not know about.
+    GLADloadproc loader() const {
+#ifndef _WIN32
+        if (backend == HEADLESS) {
+            return (GLADloadproc) eglLoadGLProc;
+        }
+#endif
+        return (GLADloadproc) glfwGetProcAddress;
+    }
+
+    // Input reads as idle headless and while capturing.
+    int getKey(int key) const {
+        return window != NULL && !capturing() ? glfwGetKey(window, key) : GLFW_RELEASE;
+    }
+
+    int getMouseButton(int button) const {
+        return window != NULL && !capturing() ? glfwGetMouseButton(window, button) : GLFW_RELEASE;
+    }
+
+    void setInputMode(int mode, int value) {
+        if (window != NULL && !capturing()) {
+            glfwSetInputMode(window, mode, value);
+        }
+    }
+
+    // The size of what the demo renders into: the window's framebuffer, which
+    // follows resizes and HiDPI scaling, or the headless FBO.
+    void getFramebufferSize(int* framebufferWidth, int* framebufferHeight) const {
+        *framebufferWidth = width;
+        *framebufferHeight = height;
+        if (window != NULL) {
+            glfwGetFramebufferSize(window, framebufferWidth, framebufferHeight);
+        }
+    }
+
+    void setFramebufferSizeCallback(GLFWframebuffersizefun callback) {
+        if (window != NULL) {
+            glfwSetFramebufferSizeCallback(window, callback);
+        }
+    }
+
+    void setCursorPosCallback(GLFWcursorposfun callback) {
+        if (window != NULL && !capturing()) {
+            glfwSetCursorPosCallback(window, callback);
+        }
+    }
+
+    void setScrollCallback(GLFWscrollfun callback) {
+        if (window != NULL && !capturing()) {
+            glfwSetScrollCallback(window, callback);
+        }
+    }
+
+private:
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool closeRequested = false;
+    std::unique_ptr<FrameCapture> capture;
+#ifndef _WIN32
+    egl::Api eglApi;
+    egl::Display eglDisplay = NULL;
+    egl::Context eglContext = NULL;
+    unsigned int renderbuffers[2] = {0, 0};
+#endif
+
+    bool createWindow(const char* title, int majorVersion, int minorVersion) {
+        if (!glfwInit()) {
+            std::cout << "Failed to init GLFW; without a display, run with --headless" << std::endl;
+            return false;
+        }
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, majorVersion);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minorVersion);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        if (hidden) {
+            glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+        }
+
+        GLFWwindow* created = glfwCreateWindow(width, height, title, NULL, NULL);
+        if (created == NULL) {
+            std::cout << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return false;
+        }
+        window = created;
+        glfwMakeContextCurrent(window);
+
+        if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
+            std::cout << "Failed to init GLAD" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool createHeadless(int majorVersion, int minorVersion) {
+#ifdef _WIN32
+        std::cout << "The headless backend needs EGL, which this build does not have" << std::endl;
+        return false;
+#else
+        if (!eglApi.load()) {
+            std::cout << "Failed to load libEGL for the headless backend" << std::endl;
+            return false;
+        }
+        const char* clientExtensions = eglApi.queryString(NULL, egl::EXTENSIONS);
+        if (eglApi.getPlatformDisplayEXT != NULL && egl::hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+            eglDisplay = eglApi.getPlatformDisplayEXT(egl::PLATFORM_SURFACELESS_MESA, NULL, NULL);
+        } else {
+            eglDisplay = eglApi.getDisplay(NULL);
+        }
+        egl::Int major, minor;
+        if (eglDisplay == NULL || !eglApi.initialize(eglDisplay, &major, &minor)) {
+            std::cout << "Failed to init EGL: 0x" << std::hex << eglApi.getError() << std::dec << std::endl;
+            eglDisplay = NULL;
+            return false;
+        }
+        const char* extensions = eglApi.queryString(eglDisplay, egl::EXTENSIONS);
+        if (!egl::hasExtension(extensions, "EGL_KHR_surfaceless_context")) {
+            std::cout << "EGL has no surfaceless contexts (EGL_KHR_surfaceless_context)" << std::endl;
+            return false;
+        }
+        eglApi.bindAPI(egl::OPENGL_API);
+
+        // no surface is ever created, so any config will do, or none at all
+        egl::Config config = NULL;
+        egl::Int configCount = 0;
+        const egl::Int configAttributes[] = {egl::RENDERABLE_TYPE, egl::OPENGL_BIT, egl::NONE};
+        eglApi.chooseConfig(eglDisplay, configAttributes, &config, 1, &configCount);
+        if (configCount == 0 && !egl::hasExtension(extensions, "EGL_KHR_no_config_context")) {
+            std::cout << "EGL has no config for desktop GL" << std::endl;
+            return false;
+        }
+        const egl::Int contextAttributes[] = {
+            egl::CONTEXT_MAJOR_VERSION, majorVersion,
+            egl::CONTEXT_MINOR_VERSION, minorVersion,
+            egl::CONTEXT_OPENGL_PROFILE_MASK, egl::CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            egl::NONE,
+        };
+        eglContext = eglApi.createContext(eglDisplay, configCount > 0 ? config : NULL, NULL, contextAttributes);
+        if (eglContext == NULL || !eglApi.makeCurrent(eglDisplay, NULL, NULL, eglContext)) {
+            std::cout << "Failed to create a headless GL " << majorVersion << "." << minorVersion
+                      << " core context: 0x" << std::hex << eglApi.getError() << std::dec << std::endl;
+            return false;
+        }
+
+        eglApiForLoader = &eglApi;
+        if (!gladLoadGLLoader((GLADloadproc) eglLoadGLProc)) {
+            std::cout << "Failed to init GLAD" << std::endl;
+            return false;
+        }
+
+        // stands in for the window's default framebuffer
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glGenRenderbuffers(2, renderbuffers);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cout << "Failed to create the headless framebuffer" << std::endl;
+            return false;
+        }
+        glViewport(0, 0, width, height);
+        return true;
+#endif
+    }
+};
+
+#endif //OPENGL_FROM_SCRATCH_OFS_CONTEXT_H
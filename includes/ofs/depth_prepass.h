@@ -0,0 +1,131 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_DEPTH_PREPASS_H
+#define OPENGL_FROM_SCRATCH_OFS_DEPTH_PREPASS_H
+
+#include <string>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "ofs/context.h"
+#include "ofs/shader.h"
+#include "ofs/gl_state_cache.h"
+
+// Optional depth-only pass in front of a lighting pass. The geometry is
+// drawn twice: first with a position-only shader and color writes off, which
+// fills the depth buffer with the nearest surface; then with the lighting
+// shader under GL_EQUAL and depth writes off, so every pixel runs the costly
+// fragment shader once however many surfaces cover it.
+//
+//   --prepass    start with the pre-pass on; P toggles it
+//   --overdraw   draw the shading pass with shader/lighting/overdraw.fs.glsl
+//                and additive blending instead, so brightness counts the
+//                fragments shaded per pixel; O toggles it
+//
+//     DepthPrepass prepass(argc, argv);
+//     while (...) {
+//         prepass.handleInput(context);
+//         if (prepass.enabled) {
+//             prepass.beginDepth();
+//             ... draw the geometry ...
+//             prepass.endDepth();
+//         }
+//         prepass.beginShading(lightShader);
+//         ... draw the same geometry ...
+//         prepass.endShading();
+//     }
+//
+// Both passes must rasterize the same depths: shader/lighting/depth.vs.glsl
+// and light.vs.glsl compute gl_Position with the same expression and declare
+// it invariant. Whatever the shading pass draws must have been drawn in the
+// pre-pass too, or GL_EQUAL rejects it; passes after endShading() are depth
+// tested as before.
+class DepthPrepass {
+public:
+    bool enabled = false;
+    bool overdraw = false;
+
+    // permutationKey picks the depth shader's INSTANCED variant, matching how
+    // the lighting shader reads its model matrices.
+    DepthPrepass(int argc, char** argv, const std::string &permutationKey = "INSTANCED")
+            : depthShader("../shader/lighting/depth.vs.glsl", "../shader/lighting/depth.fs.glsl", permutationKey),
+              overdrawShader("../shader/lighting/depth.vs.glsl", "../shader/lighting/overdraw.fs.glsl", permutationKey) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--prepass") {
+                enabled = true;
+            } else if (arg == "--overdraw") {
+                overdraw = true;
+            }
+        }
+    }
+
+    DepthPrepass(const DepthPrepass&) = delete;
+    DepthPrepass& operator=(const DepthPrepass&) = delete;
+
+    // P toggles the pre-pass, O the overdraw view; once per key press.
+    void handleInput(const Context &context) {
+        bool prepassDown = context.getKey(GLFW_KEY_P) == GLFW_PRESS;
+        bool overdrawDown = context.getKey(GLFW_KEY_O) == GLFW_PRESS;
+        if (prepassDown && !prepassWasDown) {
+            enabled = !enabled;
+        }
+        if (overdrawDown && !overdrawWasDown) {
+            overdraw = !overdraw;
+        }
+        prepassWasDown = prepassDown;
+        overdrawWasDown = overdrawDown;
+    }
+
+    // The name to give the shading pass's profiler zones, so that frames with
+    // and without the pre-pass are reported apart.
+    const char* shadingPass(const char* withoutPrepass, const char* withPrepass) const {
+        return enabled ? withPrepass : withoutPrepass;
+    }
+
+    void beginDepth() {
+        GLStateCache &state = GLStateCache::instance();
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        state.depthFunc(GL_LESS);
+        state.depthMask(true);
+        depthShader.use();
+    }
+
+    void endDepth() {
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    }
+
+    // Sets up the depth test for the shading pass and uses shader, or the
+    // overdraw shader in its place.
+    void beginShading(Shader &shader) {
+        GLStateCache &state = GLStateCache::instance();
+        if (enabled) {
+            // the depth buffer already holds the answer
+            state.depthFunc(GL_EQUAL);
+            state.depthMask(false);
+        }
+        if (overdraw) {
+            state.enable(GL_BLEND);
+            state.blendFunc(GL_ONE, GL_ONE);
+            overdrawShader.use();
+        } else {
+            shader.use();
+        }
+    }
+
+    void endShading() {
+        GLStateCache &state = GLStateCache::instance();
+        state.depthFunc(GL_LESS);
+        state.depthMask(true);
+        if (overdraw) {
+            state.disable(GL_BLEND);
+        }
+    }
+
+private:
+    Shader depthShader;
+    Shader overdrawShader;
+    bool prepassWasDown = false;
+    bool overdrawWasDown = false;
+};
+
+#endif //OPENGL_FROM_SCRATCH_OFS_DEPTH_PREPASS_H
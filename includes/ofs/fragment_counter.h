@@ -0,0 +1,188 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_FRAGMENT_COUNTER_H
+#define OPENGL_FROM_SCRATCH_OFS_FRAGMENT_COUNTER_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <cstdint>
+#include <algorithm>
+
+#include <glad/glad.h>
+
+#include "ofs/profiler.h"
+
+struct FragmentPassStats {
+    int samples = 0;
+    double averageFragments = 0.0;
+    uint64_t maxFragments = 0;
+};
+
+// Fragments that passed the depth test in named render passes, from
+// GL_SAMPLES_PASSED occlusion queries; the measure of what a depth pre-pass
+// saves (see ofs/depth_prepass.h).
+//
+//     FragmentCounter fragmentCounter;
+//     while (...) {
+//         fragmentCounter.frame();
+//         {
+//             OFS_FRAGMENT_ZONE(fragmentCounter, "lit cubes");
+//             ... draw ...
+//         }
+//         swap
+//     }
+//     fragmentCounter.report(WIDTH * HEIGHT);
+//
+// Unlike GpuProfiler's timestamps only one occlusion query can be active at a
+// time, so zones must not nest. Results are read back framesInFlight frames
+// later, and a frame whose queries have not finished by then is dropped
+// rather than waited for.
+class FragmentCounter {
+public:
+    // frames whose counts could not be read back in time
+    int droppedFrames = 0;
+
+    explicit FragmentCounter(int framesInFlight = 3) : frames(framesInFlight) {}
+
+    ~FragmentCounter() {
+        for (Frame &frame : frames) {
+            if (!frame.queries.empty()) {
+                glDeleteQueries((GLsizei) frame.queries.size(), frame.queries.data());
+            }
+        }
+    }
+
+    FragmentCounter(const FragmentCounter&) = delete;
+    FragmentCounter& operator=(const FragmentCounter&) = delete;
+
+    // Once per frame, before its first zone.
+    void frame() {
+        frameCount++;
+        current = (current + 1) % (int) frames.size();
+        collect(frames[current]);
+    }
+
+    void begin(const char* name) {
+        Frame &frame = frames[current];
+        if (frame.used == (int) frame.queries.size()) {
+            unsigned int id;
+            glGenQueries(1, &id);
+            frame.queries.push_back(id);
+        }
+        frame.names.push_back(name);
+        glBeginQuery(GL_SAMPLES_PASSED, frame.queries[frame.used++]);
+    }
+
+    void end() {
+        glEndQuery(GL_SAMPLES_PASSED);
+    }
+
+    FragmentPassStats stats(const std::string &name) const {
+        for (const Totals &totals : passes) {
+            if (totals.name == name) {
+                FragmentPassStats result;
+                result.samples = totals.samples;
+                result.averageFragments = totals.samples > 0 ? (double) totals.fragments / totals.samples : 0.0;
+                result.maxFragments = totals.maxFragments;
+                return result;
+            }
+        }
+        return FragmentPassStats();
+    }
+
+    // Per pass, the fragments of an average frame and how many that is per
+    // pixel of the target: a pass shading each visible pixel once is at or
+    // below 1.0, anything above is overdraw.
+    void report(long pixels) const {
+        std::cout << "Fragments (" << droppedFrames << " of " << frameCount << " frames dropped):" << std::endl;
+        for (const Totals &totals : passes) {
+            FragmentPassStats s = stats(totals.name);
+            std::cout << "  " << totals.name << ", " << s.samples << " frames: " << (uint64_t) s.averageFragments
+                      << " fragments average, " << std::fixed << std::setprecision(2) << s.averageFragments / pixels
+                      << " per pixel, max " << s.maxFragments << std::defaultfloat << std::endl;
+        }
+    }
+
+private:
+    struct Frame {
+        std::vector<unsigned int> queries;
+        std::vector<const char*> names;
+        int used = 0;
+    };
+
+    struct Totals {
+        std::string name;
+        int samples = 0;
+        uint64_t fragments = 0;
+        uint64_t maxFragments = 0;
+    };
+
+    std::vector<Frame> frames;
+    int current = 0;
+    int frameCount = 0;
+    std::vector<Totals> passes;
+
+    void collect(Frame &frame) {
+        if (frame.used == 0) {
+            return;
+        }
+        GLint available = 0;
+        glGetQueryObjectiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            droppedFrames++;
+        } else {
+            for (int i = 0; i < frame.used; i++) {
+                GLuint fragments = 0;
+                glGetQueryObjectuiv(frame.queries[i], GL_QUERY_RESULT, &fragments);
+                record(frame.names[i], fragments);
+            }
+        }
+        frame.names.clear();
+        frame.used = 0;
+    }
+
+    void record(const char* name, uint64_t fragments) {
+        Totals* totals = NULL;
+        for (Totals &known : passes) {
+            if (known.name == name) {
+                totals = &known;
+                break;
+            }
+        }
+        if (totals == NULL) {
+            passes.emplace_back();
+            totals = &passes.back();
+            totals->name = name;
+        }
+        totals->samples++;
+        totals->fragments += fragments;
+        totals->maxFragments = std::max(totals->maxFragments, fragments);
+    }
+};
+
+class FragmentZone {
+public:
+    FragmentZone(FragmentCounter &counter, const char* name) : counter(counter) {
+        counter.begin(name);
+    }
+
+    ~FragmentZone() {
+        counter.end();
+    }
+
+    FragmentZone(const FragmentZone&) = delete;
+    FragmentZone& operator=(const FragmentZone&) = delete;
+
+private:
+    FragmentCounter &counter;
+};
+
+// On unless built with OFS_GPU_PROFILE=0, release builds included; OFS_PROFILE
+// only switches the CPU zones (see ofs/profiler.h).
+#if OFS_GPU_PROFILE
+#define OFS_FRAGMENT_ZONE(counter, name) FragmentZone OFS_PROFILE_CONCAT(fragmentZone, __LINE__)(counter, name)
+#else
+#define OFS_FRAGMENT_ZONE(counter, name) ((void) 0)
+#endif
+
+#endif //OPENGL_FROM_SCRATCH_OFS_FRAGMENT_COUNTER_H
@@ -0,0 +1,299 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_FRAME_CAPTURE_H
+#define OPENGL_FROM_SCRATCH_OFS_FRAME_CAPTURE_H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <iostream>
+#include <cstdio>
+#include <fstream>
+#include <cstring>
+#include <filesystem>
+
+#include <glad/glad.h>
+
+#include "ofs/png_writer.h"
+#include "ofs/profiler.h"
+#include "ofs/gl_state_cache.h"
+
+struct FrameCaptureStats {
+    int frames = 0;
+    int written = 0;
+    size_t bytes = 0;
+    // frames whose readback had not finished when their buffer came round again
+    int readbackStalls = 0;
+    // frames that waited for the encoders to catch up
+    int encodeStalls = 0;
+    // GL thread time spent issuing readbacks and copying out finished ones
+    double readbackMs = 0.0;
+    // worker time spent encoding and writing, summed over workers
+    double encodeMs = 0.0;
+};
+
+// Writes every rendered frame to dir/frame_NNNNN.png without stalling the GL
+// thread on the copy.
+//
+// capture() reads the frame with glReadPixels into one of a ring of pixel
+// pack buffers, which returns at once, and puts a fence behind it. Later
+// frames map the buffers whose fence has signalled and hand the pixels to
+// encoder threads, which flip, filter and deflate them into PNGs. Only when
+// the ring comes round to a buffer whose copy is still running does the GL
+// thread wait, and finish() drains everything at the end.
+//
+//     FrameCapture capture("out", width, height);
+//     while (...) {
+//         ... render ...
+//         capture.capture(framebuffer);
+//         swap
+//     }
+//     capture.finish();
+class FrameCapture {
+public:
+    FrameCaptureStats stats;
+    const std::string dir;
+    const int width;
+    const int height;
+    const int threads;
+
+    FrameCapture(const std::string &dir, int width, int height, int ringSize = 3, int threads = defaultThreads())
+            : dir(dir), width(width), height(height), threads(threads) {
+        std::error_code error;
+        std::filesystem::create_directories(dir, error);
+        GLStateCache &state = GLStateCache::instance();
+        slots.resize(ringSize);
+        for (Slot &slot : slots) {
+            glGenBuffers(1, &slot.buffer);
+            state.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+            glBufferData(GL_PIXEL_PACK_BUFFER, frameSize(), NULL, GL_STREAM_READ);
+        }
+        state.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        for (int i = 0; i < threads; i++) {
+            workers.emplace_back(&FrameCapture::work, this);
+        }
+    }
+
+    ~FrameCapture() {
+        finish();
+        for (Slot &slot : slots) {
+            if (slot.fence != NULL) {
+                glDeleteSync(slot.fence);
+            }
+            GLStateCache::instance().deleteBuffers(1, &slot.buffer);
+        }
+    }
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    static int defaultThreads() {
+        int cores = (int) std::thread::hardware_concurrency();
+        // the GL thread and the driver keep a core or two busy already
+        return cores > 3 ? 2 : 1;
+    }
+
+    // GL thread, before the swap. Starts reading the color buffer of
+    // framebuffer, 0 meaning the window's back buffer.
+    void capture(unsigned int framebuffer) {
+        OFS_PROFILE_ZONE("capture readback");
+        auto start = std::chrono::steady_clock::now();
+        collect();
+        Slot &slot = slots[next];
+        if (slot.fence != NULL) {
+            stats.readbackStalls++;
+            collectSlot(slot, true);
+        }
+
+        GLStateCache &state = GLStateCache::instance();
+        unsigned int previousRead = state.boundReadFramebuffer();
+        state.bindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        if (framebuffer == 0) {
+            glReadBuffer(GL_BACK);
+        }
+        state.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        // RGBA rows are 4-byte aligned and the format drivers copy fastest
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        state.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        state.bindFramebuffer(GL_READ_FRAMEBUFFER, previousRead);
+
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot.frame = stats.frames++;
+        next = (next + 1) % (int) slots.size();
+        stats.readbackMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // GL thread. Waits for the outstanding readbacks and for every frame to be
+    // written. Capturing after this is not possible.
+    void finish() {
+        if (finished) {
+            return;
+        }
+        finished = true;
+        auto start = std::chrono::steady_clock::now();
+        // oldest first, so the encoders see the frames in order
+        for (size_t i = 0; i < slots.size(); i++) {
+            Slot &slot = slots[(next + i) % slots.size()];
+            if (slot.fence != NULL) {
+                collectSlot(slot, true);
+            }
+        }
+        stats.readbackMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            stopping = true;
+        }
+        jobsReady.notify_all();
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+    }
+
+    void report() const {
+        std::cout << "Frame capture: " << stats.written << " of " << stats.frames << " frames to " << dir << ", "
+                  << stats.bytes / 1024 << " KiB, " << stats.readbackMs << " ms on the GL thread, "
+                  << stats.readbackStalls << " readback stalls, " << stats.encodeStalls << " encode stalls, "
+                  << stats.encodeMs << " ms encoding on " << threads << " threads" << std::endl;
+    }
+
+    std::string framePath(int frame) const {
+        char name[32];
+        snprintf(name, sizeof(name), "frame_%05d.png", frame);
+        return (std::filesystem::path(dir) / name).string();
+    }
+
+private:
+    // frames waiting for an encoder; 1080p RGBA is 8 MiB each
+    static const size_t MAX_QUEUED = 8;
+
+    struct Slot {
+        unsigned int buffer = 0;
+        GLsync fence = NULL;
+        int frame = 0;
+    };
+
+    struct Job {
+        int frame = 0;
+        std::vector<unsigned char> pixels;
+    };
+
+    std::vector<Slot> slots;
+    int next = 0;
+    bool finished = false;
+    std::vector<std::thread> workers;
+    std::deque<Job> jobs;
+    std::mutex jobsMutex;
+    std::condition_variable jobsReady;
+    std::condition_variable jobsTaken;
+    bool stopping = false;
+
+    size_t frameSize() const {
+        return (size_t) width * height * 4;
+    }
+
+    // Hands finished readbacks to the encoders, oldest first, without waiting.
+    void collect() {
+        for (size_t i = 0; i < slots.size(); i++) {
+            Slot &slot = slots[(next + i) % slots.size()];
+            if (slot.fence == NULL) {
+                continue;
+            }
+            if (!collectSlot(slot, false)) {
+                // later readbacks finish later; keep the order
+                break;
+            }
+        }
+    }
+
+    bool collectSlot(Slot &slot, bool wait) {
+        GLuint64 timeout = wait ? 1000000000ull : 0;
+        GLenum status;
+        do {
+            status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        } while (wait && status == GL_TIMEOUT_EXPIRED);
+        if (wait && status == GL_WAIT_FAILED) {
+            // the slot is about to be reused, so the frame cannot be saved
+            std::cout << "Failed to wait for the readback of frame " << slot.frame << std::endl;
+            glDeleteSync(slot.fence);
+            slot.fence = NULL;
+            return false;
+        }
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            return false;
+        }
+        glDeleteSync(slot.fence);
+        slot.fence = NULL;
+
+        Job job;
+        job.frame = slot.frame;
+        job.pixels.resize(frameSize());
+        GLStateCache &state = GLStateCache::instance();
+        state.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        void* memory = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameSize(), GL_MAP_READ_BIT);
+        if (memory != NULL) {
+            memcpy(job.pixels.data(), memory, frameSize());
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        state.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        if (memory == NULL) {
+            std::cout << "Failed to map the readback of frame " << job.frame << std::endl;
+            return true;
+        }
+
+        std::unique_lock<std::mutex> lock(jobsMutex);
+        if (jobs.size() >= MAX_QUEUED) {
+            stats.encodeStalls++;
+            jobsTaken.wait(lock, [this] { return jobs.size() < MAX_QUEUED; });
+        }
+        jobs.push_back(std::move(job));
+        lock.unlock();
+        jobsReady.notify_one();
+        return true;
+    }
+
+    void work() {
+        OFS_PROFILE_THREAD("frame encoder");
+        std::unique_lock<std::mutex> lock(jobsMutex);
+        while (true) {
+            jobsReady.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (jobs.empty()) {
+                break;
+            }
+            Job job = std::move(jobs.front());
+            jobs.pop_front();
+            lock.unlock();
+            jobsTaken.notify_one();
+
+            OFS_PROFILE_ZONE("encode frame");
+            auto start = std::chrono::steady_clock::now();
+            // alpha is whatever blending left behind, the image is opaque
+            size_t count = (size_t) width * height;
+            for (size_t i = 0; i < count; i++) {
+                memmove(job.pixels.data() + i * 3, job.pixels.data() + i * 4, 3);
+            }
+            std::vector<unsigned char> png = encodePng(job.pixels.data(), width, height, 3, true);
+            std::string path = framePath(job.frame);
+            std::ofstream file(path, std::ios::binary);
+            file.write((const char*) png.data(), png.size());
+            bool written = (bool) file;
+            file.close();
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            lock.lock();
+            stats.encodeMs += ms;
+            if (written) {
+                stats.written++;
+                stats.bytes += png.size();
+            } else {
+                std::cout << "Failed to write " << path << std::endl;
+            }
+        }
+        lock.unlock();
+    }
+};
+
+#endif //OPENGL_FROM_SCRATCH_OFS_FRAME_CAPTURE_H
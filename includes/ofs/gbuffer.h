@@ -0,0 +1,160 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_GBUFFER_H
+#define OPENGL_FROM_SCRATCH_OFS_GBUFFER_H
+
+#include <cstddef>
+#include <iostream>
+
+#include <glad/glad.h>
+
+#include "ofs/shader.h"
+#include "ofs/gl_state_cache.h"
+
+// Render target of the deferred geometry pass, 8 bytes of color per pixel:
+//
+//   attachment 0  RG16F             normal, octahedral encoded (see
+//                                   shader/common/octahedral.glsl)
+//   attachment 1  RGBA8             albedo, specular intensity in alpha
+//   depth         DEPTH24_STENCIL8  sampled by the lighting pass to rebuild
+//                                   positions, so there is no position buffer
+//
+//     GBuffer gbuffer(width, height);
+//     gbuffer.attach(lightingShader);
+//     while (...) {
+//         ... gbuffer.resize() when the framebuffer size changed ...
+//         gbuffer.bindForGeometry();
+//         ... draw with shader/deferred/gbuffer.fs.glsl ...
+//         state.bindFramebuffer(GL_FRAMEBUFFER, context.framebuffer);
+//         glViewport(0, 0, framebufferWidth, framebufferHeight);
+//         gbuffer.bindTextures();
+//         ... FullscreenTriangle with shader/deferred/lighting.fs.glsl ...
+//         gbuffer.blitDepth(context.framebuffer);
+//         ... forward passes depth tested against the scene ...
+//     }
+class GBuffer {
+public:
+    // texture units of the three attachments, after the material maps and
+    // ClusteredLights
+    static const unsigned int DEFAULT_UNIT = 8;
+
+    unsigned int ID = 0;
+    unsigned int normal = 0;
+    unsigned int albedoSpecular = 0;
+    unsigned int depth = 0;
+    int width = 0;
+    int height = 0;
+
+    GBuffer(int width, int height) {
+        glGenFramebuffers(1, &ID);
+        glGenTextures(1, &normal);
+        glGenTextures(1, &albedoSpecular);
+        glGenTextures(1, &depth);
+        resize(width, height);
+
+        GLStateCache &state = GLStateCache::instance();
+        unsigned int previous = state.boundReadFramebuffer();
+        state.bindFramebuffer(GL_FRAMEBUFFER, ID);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, normal, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, albedoSpecular, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+        const GLenum drawBuffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+        glDrawBuffers(2, drawBuffers);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cout << "Failed to create the G-buffer" << std::endl;
+        }
+        state.bindFramebuffer(GL_FRAMEBUFFER, previous);
+    }
+
+    ~GBuffer() {
+        GLStateCache &state = GLStateCache::instance();
+        state.deleteFramebuffers(1, &ID);
+        unsigned int textures[] = {normal, albedoSpecular, depth};
+        state.deleteTextures(3, textures);
+    }
+
+    GBuffer(const GBuffer&) = delete;
+    GBuffer& operator=(const GBuffer&) = delete;
+
+    // Reallocates the attachments; the framebuffer keeps pointing at them.
+    void resize(int width, int height) {
+        this->width = width;
+        this->height = height;
+        allocate(normal, GL_RG16F, GL_RG, GL_FLOAT);
+        allocate(albedoSpecular, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+        allocate(depth, GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8);
+    }
+
+    size_t bytes() const {
+        // RG16F + RGBA8 + DEPTH24_STENCIL8
+        return (size_t) width * height * (4 + 4 + 4);
+    }
+
+    // Binds the G-buffer, sets the viewport to it and clears it. Whatever
+    // draws next into another framebuffer sets its own viewport back.
+    void bindForGeometry() const {
+        GLStateCache::instance().bindFramebuffer(GL_FRAMEBUFFER, ID);
+        glViewport(0, 0, width, height);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+
+    // Points the samplers of a program built from shader/deferred/lighting.fs.glsl
+    // at the texture units bindTextures() uses.
+    void attach(Shader &shader, unsigned int firstUnit = DEFAULT_UNIT) const {
+        shader.use();
+        shader.setInt("gNormal", firstUnit);
+        shader.setInt("gAlbedoSpecular", firstUnit + 1);
+        shader.setInt("gDepth", firstUnit + 2);
+    }
+
+    void bindTextures(unsigned int firstUnit = DEFAULT_UNIT) const {
+        GLStateCache &state = GLStateCache::instance();
+        state.bindTexture(firstUnit, GL_TEXTURE_2D, normal);
+        state.bindTexture(firstUnit + 1, GL_TEXTURE_2D, albedoSpecular);
+        state.bindTexture(firstUnit + 2, GL_TEXTURE_2D, depth);
+    }
+
+    // Copies the scene's depth into target, which must have a
+    // DEPTH24_STENCIL8 depth buffer of the same size, and leaves target bound.
+    void blitDepth(unsigned int target) const {
+        GLStateCache &state = GLStateCache::instance();
+        state.bindFramebuffer(GL_READ_FRAMEBUFFER, ID);
+        state.bindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        state.bindFramebuffer(GL_FRAMEBUFFER, target);
+    }
+
+private:
+    void allocate(unsigned int texture, GLint internalFormat, GLenum format, GLenum type) {
+        GLStateCache::instance().bindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+};
+
+// One triangle covering the viewport, for passes that shade every pixel.
+// shader/deferred/fullscreen.vs.glsl makes its corners from gl_VertexID; the
+// core profile still wants a vertex array bound, an empty one does.
+class FullscreenTriangle {
+public:
+    unsigned int VAO = 0;
+
+    FullscreenTriangle() {
+        glGenVertexArrays(1, &VAO);
+    }
+
+    ~FullscreenTriangle() {
+        GLStateCache::instance().deleteVertexArrays(1, &VAO);
+    }
+
+    FullscreenTriangle(const FullscreenTriangle&) = delete;
+    FullscreenTriangle& operator=(const FullscreenTriangle&) = delete;
+
+    void draw() const {
+        GLStateCache::instance().bindVertexArray(VAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+};
+
+#endif //OPENGL_FROM_SCRATCH_OFS_GBUFFER_H
@@ -0,0 +1,21 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_GL_EXTENSIONS_H
+#define OPENGL_FROM_SCRATCH_OFS_GL_EXTENSIONS_H
+
+#include <cstring>
+
+#include <glad/glad.h>
+
+// glad was generated without extensions, so they are looked up by name.
+bool hasGLExtension(const char* name) {
+    int count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (int i = 0; i < count; i++) {
+        const char* extension = (const char*) glGetStringi(GL_EXTENSIONS, i);
+        if (extension != NULL && strcmp(extension, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif //OPENGL_FROM_SCRATCH_OFS_GL_EXTENSIONS_H
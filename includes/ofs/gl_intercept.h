@@ -0,0 +1,616 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_GL_INTERCEPT_H
+#define OPENGL_FROM_SCRATCH_OFS_GL_INTERCEPT_H
+
+// Counts the GL calls every frame makes and finds redundant state changes.
+//
+// glad reaches every entry point through a function pointer (glUseProgram is
+// glad_glUseProgram), so after gladLoadGLLoader() the pointers of the entry
+// points below are swapped for hooks that record the call and forward it to
+// the driver. Context does this in create(), closes a frame in swapBuffers()
+// and prints the report on exit:
+//
+//     GL calls, 59 frames: 31.0 per frame, 2.0 draws, 9.0 redundant (29.0%); 412 in the first frame, loading included
+//       per frame  redundant  entry point
+//            4.0        3.0  glBindTexture
+//       ...
+//     worst redundant calls:
+//          177  glBindTexture(0xde1, 1) on unit 0
+//
+// A state change is redundant when it sets what the last call already set:
+// the same program, the same VAO, the same texture on the same unit, the same
+// uniform value in the same program. Objects being deleted or programs
+// relinked forget everything known so far, so a redundant call is always
+// really one; calls this layer does not see (anything not listed in install())
+// can make it miss some.
+//
+// Only built with OFS_GL_INTERCEPT=1 (cmake -DOFS_GL_INTERCEPT=ON). Otherwise
+// the macros at the end compile to nothing and glad's pointers are never
+// touched. GL is only ever called from the thread owning the context, and so
+// is the interceptor.
+
+#ifndef OFS_GL_INTERCEPT
+#define OFS_GL_INTERCEPT 0
+#endif
+
+#if OFS_GL_INTERCEPT
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+enum GLCallKind {
+    // only counted
+    GL_CALL_COUNT,
+    GL_CALL_DRAW,
+    // sets state, checked for redundancy
+    GL_CALL_STATE,
+    // deletes objects or relinks programs, forgets the known state
+    GL_CALL_RESET,
+};
+
+// What a state call's value belongs to, besides its key arguments.
+enum GLStateScope {
+    GL_SCOPE_GLOBAL,
+    // the active texture unit
+    GL_SCOPE_UNIT,
+    // the program in use, for glUniform*
+    GL_SCOPE_PROGRAM,
+    // the bound VAO, for GL_ELEMENT_ARRAY_BUFFER
+    GL_SCOPE_ELEMENTS,
+};
+
+// State a call changes for the calls after it.
+enum GLTracked {
+    GL_TRACK_NOTHING,
+    GL_TRACK_PROGRAM,
+    GL_TRACK_UNIT,
+    GL_TRACK_VAO,
+    // glBindBufferBase/Range also bind the buffer to the target itself
+    GL_TRACK_INDEXED_BUFFER,
+    // GL_FRAMEBUFFER binds both the read and the draw framebuffer
+    GL_TRACK_FRAMEBUFFER,
+};
+
+struct GLCallRule {
+    GLCallKind kind = GL_CALL_COUNT;
+    GLStateScope scope = GL_SCOPE_GLOBAL;
+    GLTracked tracks = GL_TRACK_NOTHING;
+    // leading arguments naming what is set (a target, a capability, a
+    // location); the rest are the value
+    int keyArgs = 0;
+    // entry points setting the same state share a slot, glEnable/glDisable
+    const char* slot = NULL;
+    // arguments from here on print as floats
+    int floatsFrom = -1;
+    // a pointer argument whose data is part of the value: count * dataBytes
+    // bytes, count being argument countArg
+    int dataArg = -1;
+    int countArg = -1;
+    int dataBytes = 0;
+
+    GLCallRule withScope(GLStateScope value) const {
+        GLCallRule rule = *this;
+        rule.scope = value;
+        return rule;
+    }
+
+    GLCallRule withTracks(GLTracked value) const {
+        GLCallRule rule = *this;
+        rule.tracks = value;
+        return rule;
+    }
+
+    GLCallRule withSlot(const char* value) const {
+        GLCallRule rule = *this;
+        rule.slot = value;
+        return rule;
+    }
+
+    GLCallRule withFloats(int from) const {
+        GLCallRule rule = *this;
+        rule.floatsFrom = from;
+        return rule;
+    }
+
+    GLCallRule withData(int count, int data, int bytes) const {
+        GLCallRule rule = *this;
+        rule.countArg = count;
+        rule.dataArg = data;
+        rule.dataBytes = bytes;
+        return rule;
+    }
+};
+
+inline GLCallRule countCall() {
+    return GLCallRule();
+}
+
+inline GLCallRule drawCall() {
+    GLCallRule rule;
+    rule.kind = GL_CALL_DRAW;
+    return rule;
+}
+
+inline GLCallRule resetCall() {
+    GLCallRule rule;
+    rule.kind = GL_CALL_RESET;
+    return rule;
+}
+
+inline GLCallRule stateCall(int keyArgs = 0) {
+    GLCallRule rule;
+    rule.kind = GL_CALL_STATE;
+    rule.keyArgs = keyArgs;
+    return rule;
+}
+
+// glUniform* with values or a pointer to `components` values per element.
+inline GLCallRule uniformCall(int components = 0, int dataArg = 2) {
+    GLCallRule rule = stateCall(1).withScope(GL_SCOPE_PROGRAM);
+    return components > 0 ? rule.withData(1, dataArg, components * 4) : rule;
+}
+
+struct GLFrameCalls {
+    int calls = 0;
+    int draws = 0;
+    int redundant = 0;
+};
+
+class GLInterceptor {
+public:
+    static const int MAX_HOOKS = 160;
+
+    static GLInterceptor& instance() {
+        static GLInterceptor interceptor;
+        return interceptor;
+    }
+
+    GLInterceptor(const GLInterceptor&) = delete;
+    GLInterceptor& operator=(const GLInterceptor&) = delete;
+
+    // Hooks glad's pointers; once, after gladLoadGLLoader().
+    void install();
+
+    // Closes a frame: its counts go into the totals and lastFrame(). The first
+    // frame also made every loading call, it is only kept as setupCalls().
+    void frame() {
+        GLFrameCalls calls;
+        for (Entry &entry : entries) {
+            calls.calls += entry.frameCalls;
+            calls.redundant += entry.frameRedundant;
+            if (entry.rule.kind == GL_CALL_DRAW) {
+                calls.draws += entry.frameCalls;
+            }
+            if (setupDone) {
+                entry.calls += entry.frameCalls;
+                entry.redundant += entry.frameRedundant;
+            }
+            entry.frameCalls = 0;
+            entry.frameRedundant = 0;
+        }
+        last = calls;
+        if (!setupDone) {
+            setup = calls;
+            setupDone = true;
+        } else {
+            frames++;
+        }
+    }
+
+    // Calls of the last frame closed.
+    const GLFrameCalls& lastFrame() const {
+        return last;
+    }
+
+    int frameCount() const {
+        return frames;
+    }
+
+    const GLFrameCalls& setupCalls() const {
+        return setup;
+    }
+
+    // Calls of one entry point per frame so far, -1 if it is not hooked.
+    double perFrame(const char* name) const {
+        for (const Entry &entry : entries) {
+            if (entry.name != NULL && strcmp(entry.name, name) == 0) {
+                return frames > 0 ? (double) entry.calls / frames : 0.0;
+            }
+        }
+        return -1.0;
+    }
+
+    void report(int worst = 10) const {
+        if (!installed || frames == 0) {
+            return;
+        }
+        long long calls = 0, draws = 0, redundant = 0;
+        std::vector<const Entry*> called;
+        for (const Entry &entry : entries) {
+            calls += entry.calls;
+            redundant += entry.redundant;
+            if (entry.rule.kind == GL_CALL_DRAW) {
+                draws += entry.calls;
+            }
+            if (entry.calls > 0) {
+                called.push_back(&entry);
+            }
+        }
+        std::sort(called.begin(), called.end(), [](const Entry* a, const Entry* b) {
+            return a->redundant != b->redundant ? a->redundant > b->redundant : a->calls > b->calls;
+        });
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "GL calls, " << frames << " frames: " << (double) calls / frames << " per frame, "
+                  << (double) draws / frames << " draws, " << (double) redundant / frames << " redundant ("
+                  << (calls > 0 ? 100.0 * redundant / calls : 0.0) << "%); " << setup.calls
+                  << " in the first frame, loading included" << std::endl;
+        std::cout << "  per frame  redundant  entry point" << std::endl;
+        for (const Entry* entry : called) {
+            std::cout << std::setw(11) << (double) entry->calls / frames << std::setw(11)
+                      << (double) entry->redundant / frames << "  " << entry->name << std::endl;
+        }
+
+        std::vector<const Offender*> sorted;
+        for (const auto &offender : offenders) {
+            sorted.push_back(&offender.second);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](const Offender* a, const Offender* b) {
+            return a->count != b->count ? a->count > b->count : a->description < b->description;
+        });
+        if (!sorted.empty()) {
+            std::cout << "worst redundant calls:" << std::endl;
+        }
+        for (int i = 0; i < (int) sorted.size() && i < worst; i++) {
+            std::cout << std::setw(9) << sorted[i]->count << "  " << sorted[i]->description << std::endl;
+        }
+        std::cout << std::defaultfloat << std::setprecision(6);
+    }
+
+    // Called by the hooks.
+    void record(int id, const uint64_t* args, int argc) {
+        Entry &entry = entries[id];
+        entry.frameCalls++;
+        const GLCallRule &rule = entry.rule;
+        if (rule.kind == GL_CALL_RESET) {
+            shadow.clear();
+        } else if (rule.kind == GL_CALL_STATE) {
+            uint64_t scope = 0;
+            if (rule.scope == GL_SCOPE_UNIT) {
+                scope = unit;
+            } else if (rule.scope == GL_SCOPE_PROGRAM) {
+                scope = program;
+            } else if (rule.scope == GL_SCOPE_ELEMENTS && args[0] == GL_ELEMENT_ARRAY_BUFFER) {
+                scope = vao;
+            }
+            uint64_t value = valueHash(entry.tag, rule, args, argc);
+            bool redundant;
+            if (rule.tracks == GL_TRACK_FRAMEBUFFER && args[0] == GL_FRAMEBUFFER) {
+                // redundant only if it changes neither binding
+                uint64_t targets[2] = {GL_READ_FRAMEBUFFER, GL_DRAW_FRAMEBUFFER};
+                redundant = true;
+                for (uint64_t target : targets) {
+                    redundant = set(stateKey(entry.slot, 0, &target, 1), value) && redundant;
+                }
+            } else {
+                redundant = set(stateKey(entry.slot, scope, args, rule.keyArgs), value);
+            }
+            if (rule.tracks == GL_TRACK_INDEXED_BUFFER) {
+                // same key and value glBindBuffer(target, buffer) has
+                uint64_t bind[2] = {args[0], args[2]};
+                set(stateKey(bindBufferSlot, 0, bind, 1), valueHash(bindBufferSlot, bindBufferRule, bind, 2));
+            }
+            if (redundant) {
+                entry.frameRedundant++;
+            }
+            if (redundant && setupDone) {
+                uint64_t offenderKey = mix(stateKey(entry.slot, scope, args, rule.keyArgs), value);
+                Offender &offender = offenders[offenderKey];
+                if (offender.count++ == 0) {
+                    offender.description = describe(entry, args, argc);
+                }
+            }
+        }
+
+        if (rule.tracks == GL_TRACK_PROGRAM) {
+            program = args[0];
+        } else if (rule.tracks == GL_TRACK_UNIT) {
+            unit = args[0] - GL_TEXTURE0;
+        } else if (rule.tracks == GL_TRACK_VAO) {
+            vao = args[0];
+        }
+    }
+
+private:
+    struct Entry {
+        const char* name = NULL;
+        GLCallRule rule;
+        uint64_t slot = 0;
+        uint64_t tag = 0;
+        int frameCalls = 0;
+        int frameRedundant = 0;
+        long long calls = 0;
+        long long redundant = 0;
+    };
+
+    struct Offender {
+        std::string description;
+        long long count = 0;
+    };
+
+    std::vector<Entry> entries;
+    bool installed = false;
+    bool setupDone = false;
+    int frames = 0;
+    GLFrameCalls last;
+    GLFrameCalls setup;
+    // state key to the hash of the value last set
+    std::unordered_map<uint64_t, uint64_t> shadow;
+    std::unordered_map<uint64_t, Offender> offenders;
+    uint64_t program = 0;
+    uint64_t unit = 0;
+    uint64_t vao = 0;
+    uint64_t bindBufferSlot = 0;
+    GLCallRule bindBufferRule = stateCall(1).withScope(GL_SCOPE_ELEMENTS);
+
+    GLInterceptor() : entries(MAX_HOOKS) {
+        bindBufferSlot = nameHash("glBindBuffer");
+    }
+
+    template <int Id, typename R, typename... Args>
+    void hook(R (APIENTRY *&pointer)(Args...), const char* name, const GLCallRule &rule);
+
+    // Sets key to value, returns whether it already was.
+    bool set(uint64_t key, uint64_t value) {
+        auto found = shadow.find(key);
+        if (found != shadow.end() && found->second == value) {
+            return true;
+        }
+        shadow[key] = value;
+        return false;
+    }
+
+    static uint64_t mix(uint64_t hash, uint64_t value) {
+        hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+        return hash;
+    }
+
+    static uint64_t nameHash(const char* name) {
+        uint64_t hash = 14695981039346656037ull;
+        for (const char* c = name; *c != '\0'; c++) {
+            hash = (hash ^ (unsigned char) *c) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    static uint64_t stateKey(uint64_t slot, uint64_t scope, const uint64_t* args, int keyArgs) {
+        uint64_t key = mix(slot, scope);
+        for (int i = 0; i < keyArgs; i++) {
+            key = mix(key, args[i]);
+        }
+        return key;
+    }
+
+    // The entry point (glEnable and glDisable share a slot), its value
+    // arguments and the data they point to.
+    static uint64_t valueHash(uint64_t tag, const GLCallRule &rule, const uint64_t* args, int argc) {
+        uint64_t value = tag;
+        for (int i = rule.keyArgs; i < argc; i++) {
+            if (i != rule.dataArg) {
+                value = mix(value, args[i]);
+            }
+        }
+        if (rule.dataArg >= 0 && args[rule.dataArg] != 0) {
+            const unsigned char* data = (const unsigned char*) (uintptr_t) args[rule.dataArg];
+            size_t bytes = (size_t) std::max(0, (int) (int32_t) args[rule.countArg]) * rule.dataBytes;
+            uint64_t hash = 14695981039346656037ull;
+            for (size_t i = 0; i < bytes; i++) {
+                hash = (hash ^ data[i]) * 1099511628211ull;
+            }
+            value = mix(value, hash);
+        }
+        return value;
+    }
+
+    std::string describe(const Entry &entry, const uint64_t* args, int argc) const {
+        const GLCallRule &rule = entry.rule;
+        std::ostringstream text;
+        text << entry.name << "(";
+        for (int i = 0; i < argc; i++) {
+            text << (i > 0 ? ", " : "");
+            if (i == rule.dataArg) {
+                text << "...";
+            } else if (rule.floatsFrom >= 0 && i >= rule.floatsFrom) {
+                float value;
+                uint32_t bits = (uint32_t) args[i];
+                memcpy(&value, &bits, sizeof(value));
+                text << value;
+            } else if (args[i] >= 0x100 && args[i] <= 0xFFFF && i < rule.keyArgs) {
+                // enums
+                text << "0x" << std::hex << args[i] << std::dec;
+            } else {
+                text << (int64_t) (int32_t) args[i];
+            }
+        }
+        text << ")";
+        if (rule.scope == GL_SCOPE_UNIT) {
+            text << " on unit " << unit;
+        } else if (rule.scope == GL_SCOPE_PROGRAM) {
+            text << " in program " << program;
+        } else if (rule.scope == GL_SCOPE_ELEMENTS && args[0] == GL_ELEMENT_ARRAY_BUFFER) {
+            text << " in VAO " << vao;
+        }
+        return text.str();
+    }
+};
+
+// The argument's bits, zero-extended.
+template <typename T>
+uint64_t interceptBits(T value) {
+    uint64_t bits = 0;
+    memcpy(&bits, &value, sizeof(T) < sizeof(bits) ? sizeof(T) : sizeof(bits));
+    return bits;
+}
+
+template <int Id, typename R, typename... Args>
+struct GLHook {
+    inline static R (APIENTRY *original)(Args...) = NULL;
+
+    static R APIENTRY call(Args... args) {
+        const uint64_t bits[] = {interceptBits(args)..., 0};
+        GLInterceptor::instance().record(Id, bits, (int) sizeof...(Args));
+        return original(args...);
+    }
+};
+
+template <int Id, typename R, typename... Args>
+void GLInterceptor::hook(R (APIENTRY *&pointer)(Args...), const char* name, const GLCallRule &rule) {
+    static_assert(Id < MAX_HOOKS, "raise GLInterceptor::MAX_HOOKS");
+    // not every entry point exists in every context
+    if (pointer == NULL) {
+        return;
+    }
+    Entry &entry = entries[Id];
+    entry.name = name;
+    entry.rule = rule;
+    entry.slot = nameHash(rule.slot != NULL ? rule.slot : name);
+    entry.tag = nameHash(name);
+    GLHook<Id, R, Args...>::original = pointer;
+    pointer = &GLHook<Id, R, Args...>::call;
+}
+
+// Every hook needs its own instantiation, numbered by __COUNTER__.
+#define OFS_GL_HOOK(function, rule) hook<__COUNTER__ - hookBase - 1>(glad_##function, #function, rule)
+
+void GLInterceptor::install() {
+    if (installed) {
+        return;
+    }
+    installed = true;
+    const int hookBase = __COUNTER__;
+
+    OFS_GL_HOOK(glUseProgram, stateCall().withTracks(GL_TRACK_PROGRAM));
+    OFS_GL_HOOK(glBindVertexArray, stateCall().withTracks(GL_TRACK_VAO));
+    OFS_GL_HOOK(glActiveTexture, stateCall().withTracks(GL_TRACK_UNIT));
+    OFS_GL_HOOK(glBindTexture, stateCall(1).withScope(GL_SCOPE_UNIT));
+    OFS_GL_HOOK(glBindSampler, stateCall(1));
+    OFS_GL_HOOK(glBindBuffer, stateCall(1).withScope(GL_SCOPE_ELEMENTS));
+    OFS_GL_HOOK(glBindBufferBase, stateCall(2).withTracks(GL_TRACK_INDEXED_BUFFER));
+    OFS_GL_HOOK(glBindBufferRange, stateCall(2).withTracks(GL_TRACK_INDEXED_BUFFER));
+    OFS_GL_HOOK(glBindFramebuffer, stateCall(1).withTracks(GL_TRACK_FRAMEBUFFER));
+    OFS_GL_HOOK(glBindRenderbuffer, stateCall(1));
+    OFS_GL_HOOK(glEnable, stateCall(1).withSlot("glEnable"));
+    OFS_GL_HOOK(glDisable, stateCall(1).withSlot("glEnable"));
+    OFS_GL_HOOK(glBlendFunc, stateCall().withSlot("glBlendFuncSeparate"));
+    OFS_GL_HOOK(glBlendFuncSeparate, stateCall());
+    OFS_GL_HOOK(glBlendEquation, stateCall());
+    OFS_GL_HOOK(glDepthFunc, stateCall());
+    OFS_GL_HOOK(glDepthMask, stateCall());
+    OFS_GL_HOOK(glColorMask, stateCall());
+    OFS_GL_HOOK(glCullFace, stateCall());
+    OFS_GL_HOOK(glFrontFace, stateCall());
+    OFS_GL_HOOK(glPolygonMode, stateCall(1));
+    OFS_GL_HOOK(glViewport, stateCall());
+    OFS_GL_HOOK(glScissor, stateCall());
+    OFS_GL_HOOK(glClearColor, stateCall().withFloats(0));
+    OFS_GL_HOOK(glClearDepth, stateCall());
+    OFS_GL_HOOK(glPixelStorei, stateCall(1));
+    OFS_GL_HOOK(glReadBuffer, stateCall());
+    OFS_GL_HOOK(glDrawBuffer, stateCall());
+    OFS_GL_HOOK(glUniformBlockBinding, stateCall(2));
+
+    OFS_GL_HOOK(glUniform1f, uniformCall().withFloats(1));
+    OFS_GL_HOOK(glUniform2f, uniformCall().withFloats(1));
+    OFS_GL_HOOK(glUniform3f, uniformCall().withFloats(1));
+    OFS_GL_HOOK(glUniform4f, uniformCall().withFloats(1));
+    OFS_GL_HOOK(glUniform1i, uniformCall());
+    OFS_GL_HOOK(glUniform2i, uniformCall());
+    OFS_GL_HOOK(glUniform3i, uniformCall());
+    OFS_GL_HOOK(glUniform4i, uniformCall());
+    OFS_GL_HOOK(glUniform1ui, uniformCall());
+    OFS_GL_HOOK(glUniform1fv, uniformCall(1));
+    OFS_GL_HOOK(glUniform2fv, uniformCall(2));
+    OFS_GL_HOOK(glUniform3fv, uniformCall(3));
+    OFS_GL_HOOK(glUniform4fv, uniformCall(4));
+    OFS_GL_HOOK(glUniform1iv, uniformCall(1));
+    OFS_GL_HOOK(glUniform2iv, uniformCall(2));
+    OFS_GL_HOOK(glUniform3iv, uniformCall(3));
+    OFS_GL_HOOK(glUniform4iv, uniformCall(4));
+    OFS_GL_HOOK(glUniformMatrix2fv, uniformCall(4, 3));
+    OFS_GL_HOOK(glUniformMatrix3fv, uniformCall(9, 3));
+    OFS_GL_HOOK(glUniformMatrix4fv, uniformCall(16, 3));
+
+    OFS_GL_HOOK(glDrawArrays, drawCall());
+    OFS_GL_HOOK(glDrawElements, drawCall());
+    OFS_GL_HOOK(glDrawRangeElements, drawCall());
+    OFS_GL_HOOK(glDrawArraysInstanced, drawCall());
+    OFS_GL_HOOK(glDrawElementsInstanced, drawCall());
+    OFS_GL_HOOK(glDrawElementsBaseVertex, drawCall());
+    OFS_GL_HOOK(glDrawElementsInstancedBaseVertex, drawCall());
+    OFS_GL_HOOK(glDrawArraysInstancedBaseInstance, drawCall());
+    OFS_GL_HOOK(glDrawElementsInstancedBaseVertexBaseInstance, drawCall());
+    OFS_GL_HOOK(glMultiDrawArrays, drawCall());
+    OFS_GL_HOOK(glMultiDrawElements, drawCall());
+    OFS_GL_HOOK(glDrawArraysIndirect, drawCall());
+    OFS_GL_HOOK(glDrawElementsIndirect, drawCall());
+    OFS_GL_HOOK(glMultiDrawArraysIndirect, drawCall());
+    OFS_GL_HOOK(glMultiDrawElementsIndirect, drawCall());
+
+    OFS_GL_HOOK(glLinkProgram, resetCall());
+    OFS_GL_HOOK(glProgramBinary, resetCall());
+    OFS_GL_HOOK(glDeleteProgram, resetCall());
+    OFS_GL_HOOK(glDeleteBuffers, resetCall());
+    OFS_GL_HOOK(glDeleteTextures, resetCall());
+    OFS_GL_HOOK(glDeleteSamplers, resetCall());
+    OFS_GL_HOOK(glDeleteVertexArrays, resetCall());
+    OFS_GL_HOOK(glDeleteFramebuffers, resetCall());
+    OFS_GL_HOOK(glDeleteRenderbuffers, resetCall());
+
+    OFS_GL_HOOK(glClear, countCall());
+    OFS_GL_HOOK(glBufferData, countCall());
+    OFS_GL_HOOK(glBufferSubData, countCall());
+    OFS_GL_HOOK(glBufferStorage, countCall());
+    OFS_GL_HOOK(glMapBufferRange, countCall());
+    OFS_GL_HOOK(glUnmapBuffer, countCall());
+    OFS_GL_HOOK(glTexImage2D, countCall());
+    OFS_GL_HOOK(glTexSubImage2D, countCall());
+    OFS_GL_HOOK(glTexStorage2D, countCall());
+    OFS_GL_HOOK(glCompressedTexImage2D, countCall());
+    OFS_GL_HOOK(glCompressedTexSubImage2D, countCall());
+    OFS_GL_HOOK(glTexParameteri, countCall());
+    OFS_GL_HOOK(glGenerateMipmap, countCall());
+    OFS_GL_HOOK(glVertexAttribPointer, countCall());
+    OFS_GL_HOOK(glEnableVertexAttribArray, countCall());
+    OFS_GL_HOOK(glVertexAttribDivisor, countCall());
+    OFS_GL_HOOK(glGetUniformLocation, countCall());
+    OFS_GL_HOOK(glGetIntegerv, countCall());
+    OFS_GL_HOOK(glReadPixels, countCall());
+    OFS_GL_HOOK(glFenceSync, countCall());
+    OFS_GL_HOOK(glClientWaitSync, countCall());
+    OFS_GL_HOOK(glDeleteSync, countCall());
+    OFS_GL_HOOK(glQueryCounter, countCall());
+    OFS_GL_HOOK(glGetQueryObjectiv, countCall());
+    OFS_GL_HOOK(glGetQueryObjectui64v, countCall());
+    OFS_GL_HOOK(glFlush, countCall());
+    OFS_GL_HOOK(glFinish, countCall());
+}
+
+#undef OFS_GL_HOOK
+
+#define OFS_GL_INTERCEPT_INSTALL() GLInterceptor::instance().install()
+#define OFS_GL_INTERCEPT_FRAME() GLInterceptor::instance().frame()
+#define OFS_GL_INTERCEPT_REPORT() GLInterceptor::instance().report()
+#else
+#define OFS_GL_INTERCEPT_INSTALL() ((void) 0)
+#define OFS_GL_INTERCEPT_FRAME() ((void) 0)
+#define OFS_GL_INTERCEPT_REPORT() ((void) 0)
+#endif
+
+#endif //OPENGL_FROM_SCRATCH_OFS_GL_INTERCEPT_H
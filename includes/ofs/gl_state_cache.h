@@ -0,0 +1,422 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_GL_STATE_CACHE_H
+#define OPENGL_FROM_SCRATCH_OFS_GL_STATE_CACHE_H
+
+#include <vector>
+#include <unordered_map>
+#include <iostream>
+#include <iomanip>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+enum GLStateKind {
+    GL_STATE_PROGRAM,
+    GL_STATE_VAO,
+    GL_STATE_ACTIVE_TEXTURE,
+    GL_STATE_TEXTURE,
+    GL_STATE_BUFFER,
+    GL_STATE_FRAMEBUFFER,
+    GL_STATE_CAPABILITY,
+    GL_STATE_BLEND,
+    GL_STATE_DEPTH,
+    GL_STATE_KINDS,
+};
+
+const char* const GL_STATE_NAMES[GL_STATE_KINDS] = {
+    "program", "vertex array", "active texture", "texture", "buffer", "framebuffer", "enable/disable", "blend", "depth",
+};
+
+struct GLStateCounter {
+    // calls that reached the driver
+    long long issued = 0;
+    // calls skipped because they would not have changed anything
+    long long elided = 0;
+};
+
+// Shadows the bound program, VAO, textures per unit, buffer and framebuffer
+// bindings, enabled capabilities, blend and depth state, and only calls GL
+// when a value changes.
+//
+//     GLStateCache &state = GLStateCache::instance();
+//     lightShader.use();                                // goes through the cache
+//     state.bindTexture(0, GL_TEXTURE_2D, diffuseMap);  // unit 0
+//     state.bindVertexArray(cubeVAO);
+//
+// Render loops can then say what they need every frame and pay for what
+// changed. Everything starts out unknown, so the first call of each is always
+// made; Context forgets everything when it creates a context.
+//
+// The shadow is only right as long as the state it covers changes through
+// here: the ofs/ headers bind and delete through the cache, and code that
+// does it with raw GL calls has to call invalidate() afterwards. Deleting goes
+// through the cache too, since GL unbinds deleted objects and reuses their
+// names. GL thread only.
+class GLStateCache {
+public:
+    static GLStateCache& instance() {
+        static GLStateCache cache;
+        return cache;
+    }
+
+    GLStateCache(const GLStateCache&) = delete;
+    GLStateCache& operator=(const GLStateCache&) = delete;
+
+    // Forgets everything, after state changed behind the cache's back.
+    void invalidate() {
+        program = UNKNOWN;
+        vao = UNKNOWN;
+        activeUnit = UNKNOWN;
+        drawFramebuffer = UNKNOWN;
+        readFramebuffer = UNKNOWN;
+        units.clear();
+        buffers.clear();
+        elementBuffers.clear();
+        indexedBuffers.clear();
+        capabilities.clear();
+        for (GLenum &value : blendFactors) {
+            value = UNKNOWN;
+        }
+        for (GLenum &value : blendEquations) {
+            value = UNKNOWN;
+        }
+        depthFunction = UNKNOWN;
+        depthWrites = UNKNOWN;
+    }
+
+    void resetCounters() {
+        for (GLStateCounter &counter : counters) {
+            counter = GLStateCounter();
+        }
+    }
+
+    const GLStateCounter& counter(GLStateKind kind) const {
+        return counters[kind];
+    }
+
+    GLStateCounter total() const {
+        GLStateCounter sum;
+        for (const GLStateCounter &counter : counters) {
+            sum.issued += counter.issued;
+            sum.elided += counter.elided;
+        }
+        return sum;
+    }
+
+    // Issued and elided calls per kind, per frame when given the frame count.
+    void report(int frames = 1) const {
+        frames = frames > 0 ? frames : 1;
+        GLStateCounter sum = total();
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "GL state cache: " << (double) sum.elided / frames << " of " << (double) (sum.issued + sum.elided) / frames
+                  << " calls elided" << (frames > 1 ? " per frame" : "") << std::endl;
+        for (int kind = 0; kind < GL_STATE_KINDS; kind++) {
+            const GLStateCounter &counter = counters[kind];
+            if (counter.issued + counter.elided > 0) {
+                std::cout << "  " << std::left << std::setw(15) << GL_STATE_NAMES[kind] << std::right << std::setw(9)
+                          << (double) counter.issued / frames << " issued" << std::setw(9)
+                          << (double) counter.elided / frames << " elided" << std::endl;
+            }
+        }
+        std::cout << std::defaultfloat << std::setprecision(6);
+    }
+
+    void useProgram(unsigned int id) {
+        if (changed(GL_STATE_PROGRAM, program, id)) {
+            glUseProgram(id);
+        }
+    }
+
+    void bindVertexArray(unsigned int id) {
+        if (changed(GL_STATE_VAO, vao, id)) {
+            glBindVertexArray(id);
+        }
+    }
+
+    // unit is an index, not GL_TEXTURE0 + index
+    void activeTexture(unsigned int unit) {
+        if (changed(GL_STATE_ACTIVE_TEXTURE, activeUnit, unit)) {
+            glActiveTexture(GL_TEXTURE0 + unit);
+        }
+    }
+
+    // Binds to the active unit.
+    void bindTexture(GLenum target, unsigned int texture) {
+        int slot = textureSlot(target);
+        if (activeUnit == UNKNOWN || slot < 0) {
+            count(GL_STATE_TEXTURE, true);
+            glBindTexture(target, texture);
+            return;
+        }
+        if (changed(GL_STATE_TEXTURE, unitTextures(activeUnit)[slot], texture)) {
+            glBindTexture(target, texture);
+        }
+    }
+
+    // Makes unit active only if its binding has to change.
+    void bindTexture(unsigned int unit, GLenum target, unsigned int texture) {
+        int slot = textureSlot(target);
+        if (slot >= 0 && unitTextures(unit)[slot] == texture) {
+            counters[GL_STATE_TEXTURE].elided++;
+            return;
+        }
+        activeTexture(unit);
+        bindTexture(target, texture);
+    }
+
+    void bindBuffer(GLenum target, unsigned int buffer) {
+        if (target == GL_ELEMENT_ARRAY_BUFFER && vao == UNKNOWN) {
+            // part of a VAO nobody knows
+            count(GL_STATE_BUFFER, true);
+            glBindBuffer(target, buffer);
+            return;
+        }
+        unsigned int &bound = target == GL_ELEMENT_ARRAY_BUFFER ? elementBuffers.emplace(vao, UNKNOWN).first->second : generic(target);
+        if (changed(GL_STATE_BUFFER, bound, buffer)) {
+            glBindBuffer(target, buffer);
+        }
+    }
+
+    // Also binds buffer to target itself, as GL does.
+    void bindBufferBase(GLenum target, unsigned int index, unsigned int buffer) {
+        IndexedBinding &bound = indexedBuffers[indexedKey(target, index)];
+        if (bound.buffer == buffer && bound.whole && generic(target) == buffer) {
+            counters[GL_STATE_BUFFER].elided++;
+            return;
+        }
+        counters[GL_STATE_BUFFER].issued++;
+        glBindBufferBase(target, index, buffer);
+        bound.buffer = buffer;
+        bound.whole = true;
+        generic(target) = buffer;
+    }
+
+    // Ranges are always bound; the cache only keeps track of them.
+    void bindBufferRange(GLenum target, unsigned int index, unsigned int buffer, GLintptr offset, GLsizeiptr size) {
+        counters[GL_STATE_BUFFER].issued++;
+        glBindBufferRange(target, index, buffer, offset, size);
+        IndexedBinding &bound = indexedBuffers[indexedKey(target, index)];
+        bound.buffer = buffer;
+        bound.whole = false;
+        generic(target) = buffer;
+    }
+
+    void bindFramebuffer(GLenum target, unsigned int framebuffer) {
+        bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+        bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+        if ((!read || readFramebuffer == framebuffer) && (!draw || drawFramebuffer == framebuffer)) {
+            counters[GL_STATE_FRAMEBUFFER].elided++;
+            return;
+        }
+        counters[GL_STATE_FRAMEBUFFER].issued++;
+        glBindFramebuffer(target, framebuffer);
+        if (read) {
+            readFramebuffer = framebuffer;
+        }
+        if (draw) {
+            drawFramebuffer = framebuffer;
+        }
+    }
+
+    // The framebuffer bound for reading, queried if unknown.
+    unsigned int boundReadFramebuffer() {
+        if (readFramebuffer == UNKNOWN) {
+            GLint bound = 0;
+            glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &bound);
+            readFramebuffer = (unsigned int) bound;
+        }
+        return readFramebuffer;
+    }
+
+    void enable(GLenum capability) {
+        setEnabled(capability, true);
+    }
+
+    void disable(GLenum capability) {
+        setEnabled(capability, false);
+    }
+
+    void setEnabled(GLenum capability, bool enabled) {
+        if (changed(GL_STATE_CAPABILITY, capabilities.emplace(capability, UNKNOWN).first->second, enabled ? 1u : 0u)) {
+            if (enabled) {
+                glEnable(capability);
+            } else {
+                glDisable(capability);
+            }
+        }
+    }
+
+    void blendFunc(GLenum source, GLenum destination) {
+        if (blendFactors[0] == source && blendFactors[1] == destination && blendFactors[2] == source && blendFactors[3] == destination) {
+            counters[GL_STATE_BLEND].elided++;
+            return;
+        }
+        counters[GL_STATE_BLEND].issued++;
+        glBlendFunc(source, destination);
+        blendFactors[0] = blendFactors[2] = source;
+        blendFactors[1] = blendFactors[3] = destination;
+    }
+
+    void blendFuncSeparate(GLenum sourceRgb, GLenum destinationRgb, GLenum sourceAlpha, GLenum destinationAlpha) {
+        if (blendFactors[0] == sourceRgb && blendFactors[1] == destinationRgb && blendFactors[2] == sourceAlpha
+            && blendFactors[3] == destinationAlpha) {
+            counters[GL_STATE_BLEND].elided++;
+            return;
+        }
+        counters[GL_STATE_BLEND].issued++;
+        glBlendFuncSeparate(sourceRgb, destinationRgb, sourceAlpha, destinationAlpha);
+        blendFactors[0] = sourceRgb;
+        blendFactors[1] = destinationRgb;
+        blendFactors[2] = sourceAlpha;
+        blendFactors[3] = destinationAlpha;
+    }
+
+    void blendEquation(GLenum mode) {
+        if (blendEquations[0] == mode && blendEquations[1] == mode) {
+            counters[GL_STATE_BLEND].elided++;
+            return;
+        }
+        counters[GL_STATE_BLEND].issued++;
+        glBlendEquation(mode);
+        blendEquations[0] = blendEquations[1] = mode;
+    }
+
+    void depthFunc(GLenum function) {
+        if (changed(GL_STATE_DEPTH, depthFunction, function)) {
+            glDepthFunc(function);
+        }
+    }
+
+    void depthMask(bool writes) {
+        if (changed(GL_STATE_DEPTH, depthWrites, writes ? 1u : 0u)) {
+            glDepthMask(writes ? GL_TRUE : GL_FALSE);
+        }
+    }
+
+    void deleteTextures(int n, const unsigned int* textures) {
+        for (int i = 0; i < n; i++) {
+            for (std::vector<unsigned int> &bound : units) {
+                for (unsigned int &texture : bound) {
+                    if (texture == textures[i]) {
+                        texture = UNKNOWN;
+                    }
+                }
+            }
+        }
+        glDeleteTextures(n, textures);
+    }
+
+    void deleteBuffers(int n, const unsigned int* deleted) {
+        for (int i = 0; i < n; i++) {
+            for (auto &bound : buffers) {
+                forget(bound.second, deleted[i]);
+            }
+            for (auto &bound : elementBuffers) {
+                forget(bound.second, deleted[i]);
+            }
+            for (auto &bound : indexedBuffers) {
+                forget(bound.second.buffer, deleted[i]);
+            }
+        }
+        glDeleteBuffers(n, deleted);
+    }
+
+    void deleteVertexArrays(int n, const unsigned int* arrays) {
+        for (int i = 0; i < n; i++) {
+            forget(vao, arrays[i]);
+            elementBuffers.erase(arrays[i]);
+        }
+        glDeleteVertexArrays(n, arrays);
+    }
+
+    void deleteFramebuffers(int n, const unsigned int* framebuffers) {
+        for (int i = 0; i < n; i++) {
+            forget(readFramebuffer, framebuffers[i]);
+            forget(drawFramebuffer, framebuffers[i]);
+        }
+        glDeleteFramebuffers(n, framebuffers);
+    }
+
+private:
+    static constexpr unsigned int UNKNOWN = 0xFFFFFFFFu;
+    // GL_TEXTURE_1D ... GL_TEXTURE_2D_MULTISAMPLE, see textureSlot()
+    static constexpr int TEXTURE_SLOTS = 8;
+
+    struct IndexedBinding {
+        unsigned int buffer = UNKNOWN;
+        bool whole = false;
+    };
+
+    GLStateCounter counters[GL_STATE_KINDS];
+    unsigned int program = UNKNOWN;
+    unsigned int vao = UNKNOWN;
+    unsigned int activeUnit = UNKNOWN;
+    unsigned int drawFramebuffer = UNKNOWN;
+    unsigned int readFramebuffer = UNKNOWN;
+    // per unit, per textureSlot()
+    std::vector<std::vector<unsigned int>> units;
+    std::unordered_map<GLenum, unsigned int> buffers;
+    // GL_ELEMENT_ARRAY_BUFFER is part of the VAO
+    std::unordered_map<unsigned int, unsigned int> elementBuffers;
+    std::unordered_map<uint64_t, IndexedBinding> indexedBuffers;
+    std::unordered_map<GLenum, unsigned int> capabilities;
+    GLenum blendFactors[4] = {UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN};
+    GLenum blendEquations[2] = {UNKNOWN, UNKNOWN};
+    GLenum depthFunction = UNKNOWN;
+    unsigned int depthWrites = UNKNOWN;
+
+    GLStateCache() = default;
+
+    // Sets bound to value, returns whether that takes a GL call.
+    bool changed(GLStateKind kind, unsigned int &bound, unsigned int value) {
+        bool different = bound != value || value == UNKNOWN;
+        count(kind, different);
+        bound = value;
+        return different;
+    }
+
+    void count(GLStateKind kind, bool issued) {
+        if (issued) {
+            counters[kind].issued++;
+        } else {
+            counters[kind].elided++;
+        }
+    }
+
+    static void forget(unsigned int &bound, unsigned int deleted) {
+        if (bound == deleted) {
+            bound = UNKNOWN;
+        }
+    }
+
+    std::vector<unsigned int>& unitTextures(unsigned int unit) {
+        if (unit >= units.size()) {
+            units.resize(unit + 1, std::vector<unsigned int>(TEXTURE_SLOTS, UNKNOWN));
+        }
+        return units[unit];
+    }
+
+    unsigned int& generic(GLenum target) {
+        return buffers.emplace(target, UNKNOWN).first->second;
+    }
+
+    static uint64_t indexedKey(GLenum target, unsigned int index) {
+        return (uint64_t) target << 32 | index;
+    }
+
+    // -1 for targets the cache does not shadow
+    static int textureSlot(GLenum target) {
+        switch (target) {
+            case GL_TEXTURE_2D: return 0;
+            case GL_TEXTURE_CUBE_MAP: return 1;
+            case GL_TEXTURE_2D_ARRAY: return 2;
+            case GL_TEXTURE_3D: return 3;
+            case GL_TEXTURE_BUFFER: return 4;
+            case GL_TEXTURE_2D_MULTISAMPLE: return 5;
+            case GL_TEXTURE_1D: return 6;
+            case GL_TEXTURE_CUBE_MAP_ARRAY: return 7;
+            default: return -1;
+        }
+    }
+};
+
+#endif //OPENGL_FROM_SCRATCH_OFS_GL_STATE_CACHE_H
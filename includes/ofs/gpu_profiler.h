@@ -0,0 +1,269 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_GPU_PROFILER_H
+#define OPENGL_FROM_SCRATCH_OFS_GPU_PROFILER_H
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+#include "ofs/profiler.h"
+
+struct GpuPassStats {
+    int samples = 0;
+    double averageMs = 0.0;
+    double p50Ms = 0.0;
+    double p95Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+};
+
+// GPU time of named render passes from timestamp queries.
+//
+//     GpuProfiler gpuProfiler;
+//     while (...) {
+//         gpuProfiler.frame();
+//         {
+//             OFS_GPU_ZONE(gpuProfiler, "lit cubes");
+//             ... draw ...
+//         }
+//         swap
+//     }
+//     gpuProfiler.report();
+//
+// A zone puts a glQueryCounter(GL_TIMESTAMP) before and after its commands;
+// timestamps rather than GL_TIME_ELAPSED so that zones can nest. Every frame
+// in flight has its own set of queries, and frame() reads back the oldest
+// set just before reusing it, framesInFlight frames after it was issued. If
+// the GPU still has not got that far, the frame's timings are dropped rather
+// than waited for, so reading them never stalls.
+//
+// Each pass keeps its last `window` timings for rolling averages and
+// percentiles (stats()). While the CPU profiler records, the passes also go to
+// a "GPU" track in its trace, moved onto the CPU clock by an offset taken
+// from GL_TIMESTAMP.
+class GpuProfiler {
+public:
+    // frames whose timings could not be read back in time
+    int droppedFrames = 0;
+
+    explicit GpuProfiler(int framesInFlight = 2, int window = 120) : frames(framesInFlight), window(window) {
+        synchronize();
+    }
+
+    ~GpuProfiler() {
+        for (Frame &frame : frames) {
+            if (!frame.queries.empty()) {
+                glDeleteQueries((GLsizei) frame.queries.size(), frame.queries.data());
+            }
+        }
+    }
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    // Once per frame, before its first zone: closes the previous frame and
+    // collects the oldest one.
+    void frame() {
+        frameCount++;
+        current = (current + 1) % (int) frames.size();
+        collect(frames[current]);
+        // GPU and CPU clocks drift apart slowly
+        if (frameCount % RESYNC_FRAMES == 0) {
+            synchronize();
+        }
+    }
+
+    // Returns the pass to give to end(); GpuZone does both.
+    int begin(const char* name) {
+        Frame &frame = frames[current];
+        Pass pass;
+        pass.name = name;
+        pass.begin = query(frame);
+        glQueryCounter(frame.queries[pass.begin], GL_TIMESTAMP);
+        frame.passes.push_back(pass);
+        return (int) frame.passes.size() - 1;
+    }
+
+    void end(int index) {
+        Frame &frame = frames[current];
+        Pass &pass = frame.passes[index];
+        pass.end = query(frame);
+        glQueryCounter(frame.queries[pass.end], GL_TIMESTAMP);
+    }
+
+    // Rolling statistics of the last window timings of a pass.
+    GpuPassStats stats(const std::string &name) const {
+        GpuPassStats result;
+        for (const History &history : histories) {
+            if (history.name != name) {
+                continue;
+            }
+            std::vector<double> sorted = history.samples;
+            std::sort(sorted.begin(), sorted.end());
+            result.samples = (int) sorted.size();
+            if (sorted.empty()) {
+                break;
+            }
+            double sum = 0.0;
+            for (double ms : sorted) {
+                sum += ms;
+            }
+            result.averageMs = sum / sorted.size();
+            result.p50Ms = percentile(sorted, 0.50);
+            result.p95Ms = percentile(sorted, 0.95);
+            result.p99Ms = percentile(sorted, 0.99);
+            result.maxMs = sorted.back();
+            break;
+        }
+        return result;
+    }
+
+    // Pass names in the order they first appeared.
+    std::vector<std::string> passes() const {
+        std::vector<std::string> names;
+        for (const History &history : histories) {
+            names.push_back(history.name);
+        }
+        return names;
+    }
+
+    void report() const {
+        std::cout << "GPU passes (" << droppedFrames << " of " << frameCount << " frames dropped):" << std::endl;
+        for (const History &history : histories) {
+            GpuPassStats s = stats(history.name);
+            std::cout << "  " << history.name << ", last " << s.samples << " frames: " << s.averageMs
+                      << " ms average, p50 " << s.p50Ms << ", p95 "
+                      << s.p95Ms << ", p99 " << s.p99Ms << ", max " << s.maxMs << " ms" << std::endl;
+        }
+    }
+
+private:
+    static const int RESYNC_FRAMES = 300;
+
+    struct Pass {
+        const char* name = NULL;
+        int begin = -1;
+        int end = -1;
+    };
+
+    struct Frame {
+        std::vector<unsigned int> queries;
+        int used = 0;
+        std::vector<Pass> passes;
+    };
+
+    struct History {
+        std::string name;
+        std::vector<double> samples;
+        size_t next = 0;
+    };
+
+    std::vector<Frame> frames;
+    const int window;
+    int current = 0;
+    int frameCount = 0;
+    std::vector<History> histories;
+    ProfileTrack* track = NULL;
+    // CPU profiler time minus GPU time, in nanoseconds
+    int64_t offsetNs = 0;
+
+    int query(Frame &frame) {
+        if (frame.used == (int) frame.queries.size()) {
+            unsigned int id;
+            glGenQueries(1, &id);
+            frame.queries.push_back(id);
+        }
+        return frame.used++;
+    }
+
+    void synchronize() {
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        offsetNs = (int64_t) Profiler::instance().now() - (int64_t) gpuNow;
+    }
+
+    void collect(Frame &frame) {
+        if (frame.passes.empty()) {
+            return;
+        }
+        GLint available = 0;
+        glGetQueryObjectiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            droppedFrames++;
+        } else {
+            if (track == NULL && Profiler::recording()) {
+                track = &Profiler::instance().createTrack("GPU");
+            }
+            for (const Pass &pass : frame.passes) {
+                if (pass.end < 0) {
+                    continue;
+                }
+                GLuint64 begin = 0, end = 0;
+                glGetQueryObjectui64v(frame.queries[pass.begin], GL_QUERY_RESULT, &begin);
+                glGetQueryObjectui64v(frame.queries[pass.end], GL_QUERY_RESULT, &end);
+                uint64_t duration = end > begin ? end - begin : 0;
+                record(pass.name, duration / 1e6);
+                if (track != NULL && Profiler::recording()) {
+                    track->append(pass.name, (uint64_t) std::max<int64_t>(0, (int64_t) begin + offsetNs), duration);
+                }
+            }
+        }
+        frame.passes.clear();
+        frame.used = 0;
+    }
+
+    void record(const char* name, double ms) {
+        History* history = NULL;
+        for (History &known : histories) {
+            if (known.name == name) {
+                history = &known;
+                break;
+            }
+        }
+        if (history == NULL) {
+            histories.emplace_back();
+            history = &histories.back();
+            history->name = name;
+        }
+        if ((int) history->samples.size() < window) {
+            history->samples.push_back(ms);
+        } else {
+            history->samples[history->next] = ms;
+            history->next = (history->next + 1) % window;
+        }
+    }
+
+    static double percentile(const std::vector<double> &sorted, double fraction) {
+        size_t index = (size_t) (fraction * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+};
+
+class GpuZone {
+public:
+    GpuZone(GpuProfiler &profiler, const char* name) : profiler(profiler), pass(profiler.begin(name)) {}
+
+    ~GpuZone() {
+        profiler.end(pass);
+    }
+
+    GpuZone(const GpuZone&) = delete;
+    GpuZone& operator=(const GpuZone&) = delete;
+
+private:
+    GpuProfiler &profiler;
+    int pass;
+};
+
+// On unless built with OFS_GPU_PROFILE=0, release builds included; OFS_PROFILE
+// only switches the CPU zones (see ofs/profiler.h).
+#if OFS_GPU_PROFILE
+#define OFS_GPU_ZONE(profiler, name) GpuZone OFS_PROFILE_CONCAT(gpuZone, __LINE__)(profiler, name)
+#else
+#define OFS_GPU_ZONE(profiler, name) ((void) 0)
+#endif
+
+#endif //OPENGL_FROM_SCRATCH_OFS_GPU_PROFILER_H
@@ -0,0 +1,143 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_IMAGE_DIFF_H
+#define OPENGL_FROM_SCRATCH_OFS_IMAGE_DIFF_H
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+
+// Perceptual comparison of a rendered frame against a golden image.
+//
+// Both images go from sRGB to CIELAB, where a Euclidean distance (delta E)
+// of about 2.3 is the smallest difference people notice. Before comparing,
+// each channel is blurred with a 3x3 binomial kernel: the eye does not resolve
+// single-pixel noise at normal viewing distances, so a dithering or rasterizer
+// rounding change that moves a few pixels by a few levels stays under the
+// threshold, while a wrong texture, a missing light or a shifted edge does
+// not. A frame passes when the fraction of pixels above the threshold is no
+// more than the tolerance.
+
+const float DIFF_DEFAULT_THRESHOLD = 3.0f;
+const double DIFF_DEFAULT_TOLERANCE = 0.001;
+
+struct ImageDiff {
+    int width = 0;
+    int height = 0;
+    // delta E after the blur
+    double maxDeltaE = 0.0;
+    double meanDeltaE = 0.0;
+    // pixels with a delta E above the threshold
+    size_t differing = 0;
+
+    double differingFraction() const {
+        return width * height > 0 ? (double) differing / ((double) width * height) : 0.0;
+    }
+
+    bool passes(double tolerance = DIFF_DEFAULT_TOLERANCE) const {
+        return differingFraction() <= tolerance;
+    }
+};
+
+float srgbToLinear(float value) {
+    return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+// CIELAB under D65 of 8-bit sRGB pixels with channels components, alpha ignored.
+std::vector<float> toLab(const unsigned char* pixels, int width, int height, int channels) {
+    static float linear[256];
+    static bool built = false;
+    if (!built) {
+        for (int i = 0; i < 256; i++) {
+            linear[i] = srgbToLinear(i / 255.0f);
+        }
+        built = true;
+    }
+    auto f = [](float t) {
+        return t > 0.008856f ? std::cbrt(t) : 7.787f * t + 16.0f / 116.0f;
+    };
+    size_t count = (size_t) width * height;
+    std::vector<float> lab(count * 3);
+    for (size_t i = 0; i < count; i++) {
+        const unsigned char* p = pixels + i * channels;
+        float r = linear[p[0]];
+        float g = linear[channels >= 3 ? p[1] : p[0]];
+        float b = linear[channels >= 3 ? p[2] : p[0]];
+        float x = (0.4124f * r + 0.3576f * g + 0.1805f * b) / 0.95047f;
+        float y = 0.2126f * r + 0.7152f * g + 0.0722f * b;
+        float z = (0.0193f * r + 0.1192f * g + 0.9505f * b) / 1.08883f;
+        float fx = f(x), fy = f(y), fz = f(z);
+        lab[i * 3 + 0] = 116.0f * fy - 16.0f;
+        lab[i * 3 + 1] = 500.0f * (fx - fy);
+        lab[i * 3 + 2] = 200.0f * (fy - fz);
+    }
+    return lab;
+}
+
+// 3x3 binomial blur of an image with three float channels, edges clamped.
+void blurLab(std::vector<float> &lab, int width, int height) {
+    std::vector<float> rows(lab.size());
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            size_t left = (size_t) y * width + (x > 0 ? x - 1 : x);
+            size_t center = (size_t) y * width + x;
+            size_t right = (size_t) y * width + (x + 1 < width ? x + 1 : x);
+            for (int c = 0; c < 3; c++) {
+                rows[center * 3 + c] = 0.25f * lab[left * 3 + c] + 0.5f * lab[center * 3 + c] + 0.25f * lab[right * 3 + c];
+            }
+        }
+    }
+    for (int y = 0; y < height; y++) {
+        size_t up = (size_t) (y > 0 ? y - 1 : y) * width;
+        size_t row = (size_t) y * width;
+        size_t down = (size_t) (y + 1 < height ? y + 1 : y) * width;
+        for (int x = 0; x < width; x++) {
+            for (int c = 0; c < 3; c++) {
+                lab[(row + x) * 3 + c] = 0.25f * rows[(up + x) * 3 + c] + 0.5f * rows[(row + x) * 3 + c]
+                                       + 0.25f * rows[(down + x) * 3 + c];
+            }
+        }
+    }
+}
+
+// Compares two images of the same size. When heatmap is given it receives an
+// RGB image: the expected frame in dim grey, pixels above the threshold in red.
+ImageDiff compareImages(const unsigned char* expected, const unsigned char* actual, int width, int height, int channels,
+                        float threshold = DIFF_DEFAULT_THRESHOLD, std::vector<unsigned char>* heatmap = NULL) {
+    ImageDiff diff;
+    diff.width = width;
+    diff.height = height;
+    std::vector<float> a = toLab(expected, width, height, channels);
+    std::vector<float> b = toLab(actual, width, height, channels);
+    blurLab(a, width, height);
+    blurLab(b, width, height);
+
+    size_t count = (size_t) width * height;
+    if (heatmap != NULL) {
+        heatmap->assign(count * 3, 0);
+    }
+    double sum = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        float dl = a[i * 3] - b[i * 3];
+        float da = a[i * 3 + 1] - b[i * 3 + 1];
+        float db = a[i * 3 + 2] - b[i * 3 + 2];
+        double deltaE = std::sqrt(dl * dl + da * da + db * db);
+        sum += deltaE;
+        if (deltaE > diff.maxDeltaE) {
+            diff.maxDeltaE = deltaE;
+        }
+        bool differs = deltaE > threshold;
+        if (differs) {
+            diff.differing++;
+        }
+        if (heatmap != NULL) {
+            unsigned char grey = (unsigned char) (a[i * 3] * 0.8f);
+            unsigned char* p = heatmap->data() + i * 3;
+            p[0] = differs ? 255 : grey;
+            p[1] = differs ? 0 : grey;
+            p[2] = differs ? 0 : grey;
+        }
+    }
+    diff.meanDeltaE = count > 0 ? sum / count : 0.0;
+    return diff;
+}
+
+#endif //OPENGL_FROM_SCRATCH_OFS_IMAGE_DIFF_H
@@ -0,0 +1,111 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_INSTANCING_H
+#define OPENGL_FROM_SCRATCH_OFS_INSTANCING_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "ofs/transform.h"
+#include "ofs/mesh.h"
+#include "ofs/gl_state_cache.h"
+
+// Per-instance vertex attributes for shaders built with the INSTANCED key.
+// A mat4 takes four consecutive locations and a mat3 three; they start at 8 so
+// per-vertex attributes (position, normal, uv, tangent...) keep 0-7.
+const unsigned int INSTANCE_MODEL_LOCATION = 8;
+const unsigned int INSTANCE_NORMAL_MATRIX_LOCATION = 12;
+
+struct InstanceData {
+    glm::mat4 model;
+    glm::mat3 normalMatrix;
+};
+
+static_assert(offsetof(InstanceData, normalMatrix) == 64, "InstanceData.normalMatrix must follow the model matrix");
+static_assert(sizeof(InstanceData) == 100, "InstanceData must be tightly packed");
+
+// One GL_ARRAY_BUFFER of InstanceData, fed to the vertex shader with a divisor
+// of 1 so a single instanced draw call draws every instance.
+//
+//     InstanceBuffer instances;
+//     instances.attach(cubeVAO);
+//     instances.upload(cubeModels, 10);
+//     ...
+//     GLStateCache::instance().bindVertexArray(cubeVAO);
+//     instances.draw(cube);
+class InstanceBuffer {
+public:
+    unsigned int ID;
+    size_t count;
+
+    InstanceBuffer() : count(0), capacity(0) {
+        glGenBuffers(1, &ID);
+    }
+
+    ~InstanceBuffer() {
+        GLStateCache::instance().deleteBuffers(1, &ID);
+    }
+
+    InstanceBuffer(const InstanceBuffer&) = delete;
+    InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+    // Points the instance attributes of vao at this buffer. The VAO keeps the
+    // binding, so this is done once per VAO, not per frame.
+    void attach(unsigned int vao) const {
+        GLStateCache &state = GLStateCache::instance();
+        state.bindVertexArray(vao);
+        state.bindBuffer(GL_ARRAY_BUFFER, ID);
+        for (unsigned int i = 0; i < 4; i++) {
+            unsigned int location = INSTANCE_MODEL_LOCATION + i;
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*) (offsetof(InstanceData, model) + i * sizeof(glm::vec4)));
+            glEnableVertexAttribArray(location);
+            glVertexAttribDivisor(location, 1);
+        }
+        for (unsigned int i = 0; i < 3; i++) {
+            unsigned int location = INSTANCE_NORMAL_MATRIX_LOCATION + i;
+            glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*) (offsetof(InstanceData, normalMatrix) + i * sizeof(glm::vec3)));
+            glEnableVertexAttribArray(location);
+            glVertexAttribDivisor(location, 1);
+        }
+    }
+
+    // Builds normal matrices for every model with the batch kernel and uploads both.
+    void upload(const glm::mat4* models, size_t n) {
+        std::vector<glm::mat3> normals(n);
+        normalMatrices(models, normals.data(), n);
+
+        staging.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            staging[i].model = models[i];
+            staging[i].normalMatrix = normals[i];
+        }
+        upload(staging.data(), n);
+    }
+
+    void upload(const InstanceData* instances, size_t n) {
+        GLStateCache::instance().bindBuffer(GL_ARRAY_BUFFER, ID);
+        if (n > capacity) {
+            glBufferData(GL_ARRAY_BUFFER, n * sizeof(InstanceData), instances, GL_DYNAMIC_DRAW);
+            capacity = n;
+        } else {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, n * sizeof(InstanceData), instances);
+        }
+        count = n;
+    }
+
+    // Draws every uploaded instance; the VAO that was attached must be bound.
+    void draw(GLenum mode, int first, int vertexCount) const {
+        glDrawArraysInstanced(mode, first, vertexCount, (GLsizei) count);
+    }
+
+    void draw(const Mesh &mesh) const {
+        mesh.drawInstanced((int) count);
+    }
+
+private:
+    size_t capacity;
+    std::vector<InstanceData> staging;
+};
+
+#endif //OPENGL_FROM_SCRATCH_OFS_INSTANCING_H
@@ -0,0 +1,432 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_KTX2_H
+#define OPENGL_FROM_SCRATCH_OFS_KTX2_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <algorithm>
+
+#include <glad/glad.h>
+
+#include "ofs/gl_extensions.h"
+#include "ofs/gl_state_cache.h"
+#include "ofs/mipmap.h"
+
+// Block-compressed textures in KTX 2.0 containers.
+//
+// Only what ofs_ktx2_encode writes is read back: one 2D image (no layers,
+// faces or depth), no supercompression, and one of the formats below. Levels
+// are stored smallest first as the spec requires; Ktx2Image keeps them level 0
+// first. KTXorientation "ru" means the first row is the bottom one, which is
+// what stbi_set_flip_vertically_on_load(true) gives for the uncompressed path.
+
+// S3TC is an extension, not core, so the loader leaves these out
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+const uint32_t VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131;
+const uint32_t VK_FORMAT_BC3_UNORM_BLOCK = 137;
+const uint32_t VK_FORMAT_BC5_UNORM_BLOCK = 141;
+const uint32_t VK_FORMAT_BC7_UNORM_BLOCK = 145;
+const uint32_t VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK = 147;
+const uint32_t VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK = 151;
+
+struct Ktx2Format {
+    uint32_t vkFormat;
+    GLenum glFormat;
+    // bytes per 4x4 block
+    int blockBytes;
+    const char* name;
+    // Khronos data format descriptor: color model and the channel of each 64-bit half
+    uint8_t colorModel;
+    int channelCount;
+    uint8_t channels[2];
+};
+
+const Ktx2Format KTX2_FORMATS[] = {
+    {VK_FORMAT_BC1_RGB_UNORM_BLOCK, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 8, "bc1", 128, 1, {0, 0}},
+    // alpha block first, then the color block
+    {VK_FORMAT_BC3_UNORM_BLOCK, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 16, "bc3", 130, 2, {15, 0}},
+    {VK_FORMAT_BC5_UNORM_BLOCK, GL_COMPRESSED_RG_RGTC2, 16, "bc5", 132, 2, {0, 1}},
+    {VK_FORMAT_BC7_UNORM_BLOCK, GL_COMPRESSED_RGBA_BPTC_UNORM, 16, "bc7", 134, 1, {0, 0}},
+    {VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, GL_COMPRESSED_RGB8_ETC2, 8, "etc2", 161, 1, {2, 0}},
+    {VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, GL_COMPRESSED_RGBA8_ETC2_EAC, 16, "etc2a", 161, 2, {15, 2}},
+};
+
+const Ktx2Format* ktx2Format(uint32_t vkFormat) {
+    for (const Ktx2Format &format : KTX2_FORMATS) {
+        if (format.vkFormat == vkFormat) {
+            return &format;
+        }
+    }
+    return NULL;
+}
+
+const Ktx2Format* ktx2Format(const std::string &name) {
+    for (const Ktx2Format &format : KTX2_FORMATS) {
+        if (name == format.name) {
+            return &format;
+        }
+    }
+    return NULL;
+}
+
+size_t compressedLevelSize(int width, int height, int blockBytes) {
+    return (size_t) ((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+}
+
+struct Ktx2Image {
+    uint32_t vkFormat = 0;
+    int width = 0;
+    int height = 0;
+    std::string orientation = "rd";
+    // level 0 first
+    std::vector<std::vector<unsigned char>> levels;
+
+    size_t byteSize() const {
+        size_t size = 0;
+        for (const std::vector<unsigned char> &level : levels) {
+            size += level.size();
+        }
+        return size;
+    }
+};
+
+const unsigned char KTX2_IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+bool isKtx2(const std::vector<unsigned char> &bytes) {
+    return bytes.size() >= sizeof(KTX2_IDENTIFIER) && memcmp(bytes.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0;
+}
+
+// Where ofs_ktx2_encode puts the compressed version of an image.
+std::string ktx2SiblingPath(const std::string &path) {
+    std::filesystem::path sibling(path);
+    if (sibling.extension() == ".ktx2") {
+        return "";
+    }
+    return sibling.replace_extension(".ktx2").string();
+}
+
+// The .ktx2 sibling of path if it exists and is not older than path, which
+// it was encoded from; empty otherwise. A missing path leaves the sibling as
+// the only copy, so it is used.
+std::string freshKtx2Sibling(const std::string &path) {
+    std::string sibling = ktx2SiblingPath(path);
+    std::error_code error;
+    if (sibling.empty() || !std::filesystem::exists(sibling, error)) {
+        return "";
+    }
+    auto sourceTime = std::filesystem::last_write_time(path, error);
+    if (error) {
+        return sibling;
+    }
+    auto siblingTime = std::filesystem::last_write_time(sibling, error);
+    if (error || siblingTime < sourceTime) {
+        std::cout << sibling << " is older than " << path << ", encode it again; using the image" << std::endl;
+        return "";
+    }
+    return sibling;
+}
+
+// Parses a file read into bytes. Errors are reported on stdout; returns false then.
+bool parseKtx2(const std::vector<unsigned char> &bytes, Ktx2Image &image, const std::string &path) {
+    auto u32 = [&bytes](size_t offset) {
+        uint32_t value;
+        memcpy(&value, bytes.data() + offset, sizeof(value));
+        return value;
+    };
+    auto u64 = [&bytes](size_t offset) {
+        uint64_t value;
+        memcpy(&value, bytes.data() + offset, sizeof(value));
+        return value;
+    };
+
+    if (!isKtx2(bytes) || bytes.size() < 80) {
+        std::cout << "Not a KTX2 file: " << path << std::endl;
+        return false;
+    }
+    image.vkFormat = u32(12);
+    image.width = (int) u32(20);
+    image.height = (int) u32(24);
+    uint32_t depth = u32(28);
+    uint32_t layers = u32(32);
+    uint32_t faces = u32(36);
+    uint32_t levelCount = u32(40);
+    uint32_t supercompression = u32(44);
+    uint32_t kvdOffset = u32(56);
+    uint32_t kvdLength = u32(60);
+
+    const Ktx2Format* format = ktx2Format(image.vkFormat);
+    if (format == NULL) {
+        std::cout << "Unsupported KTX2 format " << image.vkFormat << ": " << path << std::endl;
+        return false;
+    }
+    if (depth > 1 || layers > 1 || faces != 1 || supercompression != 0 || image.width <= 0 || image.height <= 0) {
+        std::cout << "Only plain 2D KTX2 textures are supported: " << path << std::endl;
+        return false;
+    }
+    levelCount = levelCount == 0 ? 1 : levelCount;
+    // also keeps the shifts below under the width of int
+    if (levelCount > (uint32_t) mipLevelCount(image.width, image.height)) {
+        std::cout << "Too many KTX2 levels (" << levelCount << ") for " << image.width << "x" << image.height << ": " << path << std::endl;
+        return false;
+    }
+    if (80 + (size_t) levelCount * 24 > bytes.size()) {
+        std::cout << "Truncated KTX2 file: " << path << std::endl;
+        return false;
+    }
+
+    image.levels.clear();
+    for (uint32_t level = 0; level < levelCount; level++) {
+        uint64_t offset = u64(80 + level * 24);
+        uint64_t length = u64(80 + level * 24 + 8);
+        int width = std::max(1, image.width >> level);
+        int height = std::max(1, image.height >> level);
+        if (offset > bytes.size() || length > bytes.size() - offset || length != compressedLevelSize(width, height, format->blockBytes)) {
+            std::cout << "Bad KTX2 level " << level << ": " << path << std::endl;
+            return false;
+        }
+        image.levels.emplace_back(bytes.begin() + offset, bytes.begin() + offset + length);
+    }
+
+    // key/value data: uint32 length, "key\0value", padded to 4 bytes
+    size_t kvd = kvdOffset;
+    size_t kvdEnd = std::min((size_t) kvdOffset + kvdLength, bytes.size());
+    while (kvd + 4 <= kvdEnd) {
+        uint32_t length = u32(kvd);
+        const char* pair = (const char*) bytes.data() + kvd + 4;
+        if (kvd + 4 + length > kvdEnd) {
+            break;
+        }
+        std::string key(pair, strnlen(pair, length));
+        if (key == "KTXorientation" && key.size() + 1 < length) {
+            image.orientation = std::string(pair + key.size() + 1, strnlen(pair + key.size() + 1, length - key.size() - 1));
+        }
+        kvd += 4 + ((length + 3) & ~3u);
+    }
+    return true;
+}
+
+bool readKtx2(const std::string &path, Ktx2Image &image) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cout << "Failed to open " << path << std::endl;
+        return false;
+    }
+    std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return parseKtx2(bytes, image, path);
+}
+
+bool writeKtx2(const std::string &path, const Ktx2Image &image) {
+    const Ktx2Format* format = ktx2Format(image.vkFormat);
+    if (format == NULL || image.levels.empty()) {
+        return false;
+    }
+    std::vector<unsigned char> out;
+    auto put32 = [&out](uint32_t value) {
+        out.insert(out.end(), (unsigned char*) &value, (unsigned char*) &value + 4);
+    };
+    auto put64 = [&out](uint64_t value) {
+        out.insert(out.end(), (unsigned char*) &value, (unsigned char*) &value + 8);
+    };
+    auto set64 = [&out](size_t offset, uint64_t value) {
+        memcpy(out.data() + offset, &value, 8);
+    };
+    auto pad = [&out](size_t alignment) {
+        while (out.size() % alignment != 0) {
+            out.push_back(0);
+        }
+    };
+
+    uint32_t levelCount = (uint32_t) image.levels.size();
+    uint32_t dfdOffset = 80 + 24 * levelCount;
+    uint32_t dfdBlockSize = 24 + 16 * format->channelCount;
+    uint32_t dfdLength = 4 + dfdBlockSize;
+
+    std::vector<std::pair<std::string, std::string>> keyValues = {
+            // sorted by key, as the spec requires
+            {"KTXorientation", image.orientation},
+            {"KTXwriter", "ofs_ktx2_encode"},
+    };
+    std::vector<unsigned char> kvd;
+    for (const auto &pair : keyValues) {
+        uint32_t length = (uint32_t) (pair.first.size() + 1 + pair.second.size() + 1);
+        kvd.insert(kvd.end(), (unsigned char*) &length, (unsigned char*) &length + 4);
+        kvd.insert(kvd.end(), pair.first.begin(), pair.first.end());
+        kvd.push_back(0);
+        kvd.insert(kvd.end(), pair.second.begin(), pair.second.end());
+        kvd.push_back(0);
+        while (kvd.size() % 4 != 0) {
+            kvd.push_back(0);
+        }
+    }
+
+    out.insert(out.end(), KTX2_IDENTIFIER, KTX2_IDENTIFIER + sizeof(KTX2_IDENTIFIER));
+    put32(image.vkFormat);
+    put32(1); // typeSize
+    put32((uint32_t) image.width);
+    put32((uint32_t) image.height);
+    put32(0); // pixelDepth
+    put32(0); // layerCount
+    put32(1); // faceCount
+    put32(levelCount);
+    put32(0); // supercompressionScheme
+    put32(dfdOffset);
+    put32(dfdLength);
+    put32(dfdOffset + dfdLength);
+    put32((uint32_t) kvd.size());
+    put64(0); // no supercompression global data
+    put64(0);
+    size_t levelIndex = out.size();
+    out.resize(out.size() + 24 * levelCount, 0);
+
+    // basic data format descriptor, one sample per 64-bit half of the block
+    put32(dfdLength);
+    put32(0); // vendor 0 (Khronos), descriptor type 0 (basic)
+    put32(2 | (dfdBlockSize << 16)); // version 2
+    out.push_back(format->colorModel);
+    out.push_back(1); // BT.709 primaries
+    out.push_back(1); // linear transfer
+    out.push_back(0); // alpha not premultiplied
+    const unsigned char blockDimensions[4] = {3, 3, 0, 0};
+    out.insert(out.end(), blockDimensions, blockDimensions + 4);
+    out.push_back((unsigned char) format->blockBytes);
+    out.resize(out.size() + 7, 0);
+    int sampleBits = format->blockBytes * 8 / format->channelCount;
+    for (int i = 0; i < format->channelCount; i++) {
+        uint32_t bitOffset = (uint32_t) (i * sampleBits);
+        uint32_t bitLength = (uint32_t) (sampleBits - 1);
+        put32(bitOffset | (bitLength << 16) | ((uint32_t) format->channels[i] << 24));
+        put32(0); // sample position
+        put32(0); // lower
+        put32(0xFFFFFFFFu); // upper
+    }
+    out.insert(out.end(), kvd.begin(), kvd.end());
+
+    // level data, smallest first, each aligned to the block size
+    for (int level = (int) levelCount - 1; level >= 0; level--) {
+        pad(format->blockBytes);
+        set64(levelIndex + level * 24, out.size());
+        set64(levelIndex + level * 24 + 8, image.levels[level].size());
+        set64(levelIndex + level * 24 + 16, image.levels[level].size());
+        out.insert(out.end(), image.levels[level].begin(), image.levels[level].end());
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    file.write((const char*) out.data(), (std::streamsize) out.size());
+    return (bool) file;
+}
+
+// Needs a current context on first call; the answer is cached per format, so
+// later calls are safe from any thread.
+bool compressedFormatSupported(uint32_t vkFormat) {
+    static int supported[sizeof(KTX2_FORMATS) / sizeof(KTX2_FORMATS[0])] = {};
+    static bool checked = false;
+    if (!checked) {
+        bool s3tc = hasGLExtension("GL_EXT_texture_compression_s3tc");
+        bool etc2 = GLAD_GL_VERSION_4_3 || hasGLExtension("GL_ARB_ES3_compatibility");
+        bool bptc = GLAD_GL_VERSION_4_2 || hasGLExtension("GL_ARB_texture_compression_bptc");
+        for (size_t i = 0; i < sizeof(KTX2_FORMATS) / sizeof(KTX2_FORMATS[0]); i++) {
+            switch (KTX2_FORMATS[i].vkFormat) {
+                case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+                case VK_FORMAT_BC3_UNORM_BLOCK:
+                    supported[i] = s3tc;
+                    break;
+                case VK_FORMAT_BC5_UNORM_BLOCK:
+                    // RGTC is core since 3.0
+                    supported[i] = true;
+                    break;
+                case VK_FORMAT_BC7_UNORM_BLOCK:
+                    supported[i] = bptc;
+                    break;
+                default:
+                    supported[i] = etc2;
+                    break;
+            }
+        }
+        checked = true;
+    }
+    for (size_t i = 0; i < sizeof(KTX2_FORMATS) / sizeof(KTX2_FORMATS[0]); i++) {
+        if (KTX2_FORMATS[i].vkFormat == vkFormat) {
+            return supported[i] != 0;
+        }
+    }
+    return false;
+}
+
+// True if image can be sampled here with the row order the caller expects.
+bool ktx2Usable(const Ktx2Image &image, bool flipVertically) {
+    return compressedFormatSupported(image.vkFormat) && (image.orientation == "ru") == flipVertically;
+}
+
+// Specifies texture from compressed levels, level 0 first, the same way
+// uploadMipChain() does for plain pixels.
+void uploadCompressedLevels(unsigned int texture, uint32_t vkFormat, int width, int height,
+                            const std::vector<const unsigned char*> &levels) {
+    const Ktx2Format* format = ktx2Format(vkFormat);
+    int levelCount = (int) levels.size();
+    GLStateCache::instance().bindTexture(GL_TEXTURE_2D, texture);
+    if (GLAD_GL_VERSION_4_2) {
+        glTexStorage2D(GL_TEXTURE_2D, levelCount, format->glFormat, width, height);
+    } else {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+    }
+    for (int level = 0; level < levelCount; level++) {
+        int levelWidth = std::max(1, width >> level);
+        int levelHeight = std::max(1, height >> level);
+        GLsizei size = (GLsizei) compressedLevelSize(levelWidth, levelHeight, format->blockBytes);
+        if (GLAD_GL_VERSION_4_2) {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, levelWidth, levelHeight, format->glFormat, size, levels[level]);
+        } else {
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, format->glFormat, levelWidth, levelHeight, 0, size, levels[level]);
+        }
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+// Bytes of every level of a width x height image stored back to back.
+size_t compressedChainSize(uint32_t vkFormat, int width, int height) {
+    const Ktx2Format* format = ktx2Format(vkFormat);
+    size_t size = 0;
+    for (int level = 0; level < mipLevelCount(width, height); level++) {
+        size += compressedLevelSize(std::max(1, width >> level), std::max(1, height >> level), format->blockBytes);
+    }
+    return size;
+}
+
+// Levels stored back to back, level 0 first, as the asset pack keeps them.
+void uploadCompressedChain(unsigned int texture, uint32_t vkFormat, const unsigned char* chain, int width, int height, int levelCount) {
+    const Ktx2Format* format = ktx2Format(vkFormat);
+    std::vector<const unsigned char*> levels;
+    for (int level = 0; level < levelCount; level++) {
+        levels.push_back(chain);
+        chain += compressedLevelSize(std::max(1, width >> level), std::max(1, height >> level), format->blockBytes);
+    }
+    uploadCompressedLevels(texture, vkFormat, width, height, levels);
+}
+
+// Specifies texture from every level of image, in immutable storage where
+// glTexStorage2D exists, with the same sampling as uploadMipChain().
+void uploadCompressedTexture(unsigned int texture, const Ktx2Image &image) {
+    std::vector<const unsigned char*> levels;
+    for (const std::vector<unsigned char> &level : image.levels) {
+        levels.push_back(level.data());
+    }
+    uploadCompressedLevels(texture, image.vkFormat, image.width, image.height, levels);
+}
+
+#endif //OPENGL_FROM_SCRATCH_OFS_KTX2_H
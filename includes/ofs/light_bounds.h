@@ -0,0 +1,166 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_LIGHT_BOUNDS_H
+#define OPENGL_FROM_SCRATCH_OFS_LIGHT_BOUNDS_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <cmath>
+#include <cfloat>
+#include <vector>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include "ofs/uniform_buffer.h"
+#include "ofs/instancing.h"
+
+// A light's attenuation 1 / (constant + linear d + quadratic d^2) never
+// reaches zero, so nothing bounds it until a brightness is picked below which
+// its contribution no longer shows. One step of an 8-bit framebuffer is the
+// default; for the Ogre terms (1.0, 0.045, 0.0075) and a white light that is
+// about 180 units, so the demos' scenes lie entirely inside it. A larger
+// threshold trades a visible edge for a shorter reach.
+const float LIGHT_CUTOFF_LUMINANCE = 1.0f / 256.0f;
+
+// half the diagonal of the builtin "cube" mesh, which spans -0.5 to 0.5
+const float UNIT_CUBE_BOUNDING_RADIUS = 0.8660254f;
+
+// --light-threshold x overrides LIGHT_CUTOFF_LUMINANCE.
+float luminanceThreshold(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(argv[i]) == "--light-threshold") {
+            return std::max(1e-6f, (float) atof(argv[i + 1]));
+        }
+    }
+    return LIGHT_CUTOFF_LUMINANCE;
+}
+
+// Rec. 709 luminance of a linear color.
+float luminance(const glm::vec3 &color) {
+    return glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+}
+
+// Distance at which a light of the given luminance attenuates to threshold:
+// the positive root of quadratic d^2 + linear d + constant - intensity / threshold.
+// 0 if the light never gets that bright, FLT_MAX if it does not attenuate.
+float attenuationRadius(float constant, float linear, float quadratic, float intensity, float threshold = LIGHT_CUTOFF_LUMINANCE) {
+    float c = constant - intensity / threshold;
+    if (c >= 0.0f) {
+        return 0.0f;
+    }
+    if (quadratic > 0.0f) {
+        return (-linear + std::sqrt(linear * linear - 4.0f * quadratic * c)) / (2.0f * quadratic);
+    }
+    if (linear > 0.0f) {
+        return -c / linear;
+    }
+    return FLT_MAX;
+}
+
+// The reach of a LightBlock light, its diffuse or specular color whichever is
+// brighter. Ambient light is everywhere and does not count.
+float attenuationRadius(const LightBlock &light, float threshold = LIGHT_CUTOFF_LUMINANCE) {
+    float intensity = std::max(luminance(light.diffuse), luminance(light.specular));
+    return attenuationRadius(light.constant, light.linear, light.quadratic, intensity, threshold);
+}
+
+// Space a point or spot light lights: a sphere of radius around position,
+// for a spot light cut down to the cone around direction whose half angle
+// has cosine cosAngle. Cones of 90 degrees or wider are left as spheres.
+struct LightVolume {
+    glm::vec3 position = glm::vec3(0.0f);
+    float radius = 0.0f;
+    glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+    float cosAngle = -1.0f;
+    float sinAngle = 0.0f;
+
+    bool isSpot() const {
+        return cosAngle > 0.0f;
+    }
+
+    // Conservative: a sphere near the cone's rim may pass without being lit.
+    // The cone test is "Cull that cone" (Bart Wronski, 2017): the distance
+    // from the sphere's center to the cone's side, and the cone's cap and
+    // apex planes.
+    bool intersectsSphere(const glm::vec3 &center, float sphereRadius) const {
+        glm::vec3 v = center - position;
+        float lengthSq = glm::dot(v, v);
+        float reach = radius + sphereRadius;
+        if (lengthSq > reach * reach) {
+            return false;
+        }
+        if (!isSpot()) {
+            return true;
+        }
+        float alongAxis = glm::dot(v, direction);
+        float fromAxis = std::sqrt(std::max(0.0f, lengthSq - alongAxis * alongAxis));
+        float toSide = cosAngle * fromAxis - alongAxis * sinAngle;
+        return toSide <= sphereRadius && alongAxis <= reach && alongAxis >= -sphereRadius;
+    }
+};
+
+LightVolume pointLightVolume(const glm::vec3 &position, float radius) {
+    LightVolume volume;
+    volume.position = position;
+    volume.radius = radius;
+    return volume;
+}
+
+// coneCos is the cosine the light's intensity drops to zero at: outerCutOff
+// of a soft edged spot light, cutOff of a hard edged one.
+LightVolume spotLightVolume(const glm::vec3 &position, const glm::vec3 &direction, float radius, float coneCos) {
+    LightVolume volume = pointLightVolume(position, radius);
+    volume.direction = glm::normalize(direction);
+    if (coneCos > 0.0f) {
+        volume.cosAngle = std::min(coneCos, 1.0f);
+        volume.sinAngle = std::sqrt(1.0f - volume.cosAngle * volume.cosAngle);
+    }
+    return volume;
+}
+
+// Instances split by whether a light reaches them, for forward passes with
+// one light: the lit ones are drawn with the lighting shader, the rest with
+// its AMBIENT_ONLY permutation, which skips the light entirely.
+//
+//     LightCulledInstances cubes;
+//     cubes.attach(litVAO, unlitVAO);
+//     while (...) {
+//         cubes.update(volume, models, count, CUBE_RADIUS);
+//         bind litVAO, lightShader.use(); cubes.lit.draw(cube);
+//         bind unlitVAO, ambientShader.use(); cubes.unlit.draw(cube);
+//     }
+//
+// Each instance is bounded by the sphere of localRadius around its model's
+// origin, scaled by the model's largest axis.
+class LightCulledInstances {
+public:
+    InstanceBuffer lit;
+    InstanceBuffer unlit;
+
+    void attach(unsigned int litVAO, unsigned int unlitVAO) {
+        lit.attach(litVAO);
+        unlit.attach(unlitVAO);
+    }
+
+    void update(const LightVolume &light, const glm::mat4* models, size_t count, float localRadius) {
+        litModels.clear();
+        unlitModels.clear();
+        for (size_t i = 0; i < count; i++) {
+            const glm::mat4 &model = models[i];
+            float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+            if (light.intersectsSphere(glm::vec3(model[3]), localRadius * scale)) {
+                litModels.push_back(model);
+            } else {
+                unlitModels.push_back(model);
+            }
+        }
+        lit.upload(litModels.data(), litModels.size());
+        unlit.upload(unlitModels.data(), unlitModels.size());
+    }
+
+private:
+    std::vector<glm::mat4> litModels;
+    std::vector<glm::mat4> unlitModels;
+};
+
+#endif //OPENGL_FROM_SCRATCH_OFS_LIGHT_BOUNDS_H
@@ -0,0 +1,102 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_LOCKFREE_QUEUE_H
+#define OPENGL_FROM_SCRATCH_OFS_LOCKFREE_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include <utility>
+
+// Bounded multi-producer multi-consumer queue (Dmitry Vyukov's design).
+//
+// Every slot carries a sequence number: a producer may write slot i once its
+// sequence equals the enqueue position, a consumer may read it once the
+// sequence is position + 1. push() and pop() never block; they return false
+// when the queue is full or empty, and a failed push() leaves its argument
+// untouched so it can be retried. Capacity is rounded up to a power of two.
+template <typename T>
+class LockFreeQueue {
+public:
+    explicit LockFreeQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask = size - 1;
+        slots = std::vector<Slot>(size);
+        for (size_t i = 0; i < size; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        enqueuePos.store(0, std::memory_order_relaxed);
+        dequeuePos.store(0, std::memory_order_relaxed);
+    }
+
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    bool push(const T &value) {
+        T copy(value);
+        return push(std::move(copy));
+    }
+
+    bool push(T &&value) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots[pos & mask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t) sequence - (intptr_t) pos;
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = std::move(value);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &value) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots[pos & mask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t) sequence - (intptr_t) (pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(slot->value);
+        slot->sequence.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+
+        Slot() : sequence(0), value() {}
+        // only needed to build the vector; slots are never copied once in use
+        Slot(const Slot &other) : sequence(other.sequence.load()), value(other.value) {}
+    };
+
+    std::vector<Slot> slots;
+    size_t mask;
+    // separate cache lines so producers and the consumer do not false-share
+    alignas(64) std::atomic<size_t> enqueuePos;
+    alignas(64) std::atomic<size_t> dequeuePos;
+};
+
+#endif //OPENGL_FROM_SCRATCH_OFS_LOCKFREE_QUEUE_H
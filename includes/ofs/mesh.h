@@ -0,0 +1,494 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_MESH_H
+#define OPENGL_FROM_SCRATCH_OFS_MESH_H
+
+#include <cstddef>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <iostream>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "ofs/asset_pack.h"
+#include "ofs/gl_state_cache.h"
+
+// Indexed primitives shared by every demo.
+//
+// Vertex layout, matching the attribute locations the shaders use:
+//   0 position, 1 normal, 2 texture coords, 3 tangent (xyz, w = bitangent sign)
+
+const unsigned int MESH_POSITION_LOCATION = 0;
+const unsigned int MESH_NORMAL_LOCATION = 1;
+const unsigned int MESH_TEXCOORDS_LOCATION = 2;
+const unsigned int MESH_TANGENT_LOCATION = 3;
+
+struct MeshVertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoords;
+    glm::vec4 tangent;
+};
+
+static_assert(sizeof(MeshVertex) == 48, "MeshVertex must be tightly packed");
+
+struct MeshData {
+    std::vector<MeshVertex> vertices;
+    std::vector<unsigned int> indices;
+};
+
+// Per-triangle tangents from the UV gradients, accumulated per vertex and
+// Gram-Schmidt orthogonalised against the normal.
+void computeTangents(MeshData &mesh) {
+    std::vector<glm::vec3> tangents(mesh.vertices.size(), glm::vec3(0.0f));
+    std::vector<glm::vec3> bitangents(mesh.vertices.size(), glm::vec3(0.0f));
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        unsigned int a = mesh.indices[i], b = mesh.indices[i + 1], c = mesh.indices[i + 2];
+        const MeshVertex &v0 = mesh.vertices[a];
+        const MeshVertex &v1 = mesh.vertices[b];
+        const MeshVertex &v2 = mesh.vertices[c];
+        glm::vec3 e1 = v1.position - v0.position;
+        glm::vec3 e2 = v2.position - v0.position;
+        glm::vec2 d1 = v1.texCoords - v0.texCoords;
+        glm::vec2 d2 = v2.texCoords - v0.texCoords;
+        float det = d1.x * d2.y - d2.x * d1.y;
+        if (std::fabs(det) < 1e-12f) {
+            continue;
+        }
+        float r = 1.0f / det;
+        glm::vec3 t = (e1 * d2.y - e2 * d1.y) * r;
+        glm::vec3 bt = (e2 * d1.x - e1 * d2.x) * r;
+        tangents[a] += t; tangents[b] += t; tangents[c] += t;
+        bitangents[a] += bt; bitangents[b] += bt; bitangents[c] += bt;
+    }
+    for (size_t i = 0; i < mesh.vertices.size(); i++) {
+        glm::vec3 n = mesh.vertices[i].normal;
+        glm::vec3 t = tangents[i] - n * glm::dot(n, tangents[i]);
+        if (glm::dot(t, t) < 1e-12f) {
+            // degenerate UVs (sphere poles): any vector perpendicular to the normal
+            t = std::fabs(n.x) < 0.9f ? glm::cross(n, glm::vec3(1.0f, 0.0f, 0.0f)) : glm::cross(n, glm::vec3(0.0f, 1.0f, 0.0f));
+        }
+        t = glm::normalize(t);
+        float w = glm::dot(glm::cross(n, t), bitangents[i]) < 0.0f ? -1.0f : 1.0f;
+        mesh.vertices[i].tangent = glm::vec4(t, w);
+    }
+}
+
+// Average cache miss ratio: transformed vertices per triangle for a FIFO
+// post-transform cache of cacheSize entries. 0.5 is the ideal for large
+// regular grids, 3.0 means no reuse at all.
+double averageCacheMissRatio(const std::vector<unsigned int> &indices, size_t vertexCount, int cacheSize = 32) {
+    if (indices.empty()) {
+        return 0.0;
+    }
+    std::vector<int> insertedAt(vertexCount, -1);
+    int misses = 0;
+    for (unsigned int index : indices) {
+        if (insertedAt[index] < 0 || misses - insertedAt[index] >= cacheSize) {
+            insertedAt[index] = misses;
+            misses++;
+        }
+    }
+    return (double) misses / (indices.size() / 3);
+}
+
+// Reorders triangles for the post-transform vertex cache with Tom Forsyth's
+// linear-speed greedy algorithm: every step emits the triangle whose vertices
+// score highest for being recently used and having few triangles left.
+void optimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount) {
+    const int CACHE_SIZE = 32;
+    const float CACHE_DECAY_POWER = 1.5f;
+    const float LAST_TRIANGLE_SCORE = 0.75f;
+    const float VALENCE_BOOST_SCALE = 2.0f;
+    const float VALENCE_BOOST_POWER = 0.5f;
+
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // vertex -> triangles that still use it
+    std::vector<unsigned int> triangleStart(vertexCount + 1, 0);
+    for (unsigned int index : indices) {
+        triangleStart[index + 1]++;
+    }
+    for (size_t v = 0; v < vertexCount; v++) {
+        triangleStart[v + 1] += triangleStart[v];
+    }
+    std::vector<unsigned int> vertexTriangles(indices.size());
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = indices[t * 3 + k];
+            vertexTriangles[triangleStart[v] + remaining[v]++] = (unsigned int) t;
+        }
+    }
+
+    auto vertexScore = [&](int cachePosition, unsigned int remainingTriangles) {
+        if (remainingTriangles == 0) {
+            return -1.0f;
+        }
+        float score = 0.0f;
+        if (cachePosition >= 0) {
+            if (cachePosition < 3) {
+                score = LAST_TRIANGLE_SCORE;
+            } else {
+                float scaler = 1.0f / (CACHE_SIZE - 3);
+                score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+            }
+        }
+        return score + VALENCE_BOOST_SCALE * std::pow((float) remainingTriangles, -VALENCE_BOOST_POWER);
+    };
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) {
+        vertexScores[v] = vertexScore(-1, remaining[v]);
+    }
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (size_t t = 0; t < triangleCount; t++) {
+        triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+    }
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    std::vector<unsigned int> cache;
+    cache.reserve(CACHE_SIZE + 3);
+    size_t scanFrom = 0;
+    long best = -1;
+
+    while (output.size() < indices.size()) {
+        if (best < 0) {
+            // nothing in the cache touches an open triangle, take the best remaining one
+            float bestScore = -1.0f;
+            while (scanFrom < triangleCount && emitted[scanFrom]) {
+                scanFrom++;
+            }
+            for (size_t t = scanFrom; t < triangleCount; t++) {
+                if (!emitted[t] && triangleScores[t] > bestScore) {
+                    bestScore = triangleScores[t];
+                    best = (long) t;
+                }
+            }
+        }
+
+        emitted[best] = true;
+        std::vector<unsigned int> nextCache;
+        nextCache.reserve(CACHE_SIZE + 3);
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = indices[best * 3 + k];
+            output.push_back(v);
+            nextCache.push_back(v);
+
+            // drop the emitted triangle from the vertex's list
+            unsigned int* begin = &vertexTriangles[triangleStart[v]];
+            unsigned int* end = begin + remaining[v];
+            *std::find(begin, end, (unsigned int) best) = *(end - 1);
+            remaining[v]--;
+        }
+        for (unsigned int v : cache) {
+            if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end()) {
+                nextCache.push_back(v);
+            }
+        }
+        // vertices pushed out of the cache lose their cache bonus
+        for (size_t i = CACHE_SIZE; i < nextCache.size(); i++) {
+            cachePosition[nextCache[i]] = -1;
+            vertexScores[nextCache[i]] = vertexScore(-1, remaining[nextCache[i]]);
+        }
+        if (nextCache.size() > (size_t) CACHE_SIZE) {
+            nextCache.resize(CACHE_SIZE);
+        }
+        cache.swap(nextCache);
+
+        for (size_t i = 0; i < cache.size(); i++) {
+            cachePosition[cache[i]] = (int) i;
+            vertexScores[cache[i]] = vertexScore((int) i, remaining[cache[i]]);
+        }
+
+        // rescore the open triangles touching the cache and pick the next one among them
+        best = -1;
+        float bestScore = -1.0f;
+        for (unsigned int v : cache) {
+            for (unsigned int i = 0; i < remaining[v]; i++) {
+                unsigned int t = vertexTriangles[triangleStart[v] + i];
+                float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+                triangleScores[t] = score;
+                if (score > bestScore) {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+        }
+    }
+    indices.swap(output);
+}
+
+// Tangents plus cache ordering; every generator below ends with this.
+void finishMesh(MeshData &mesh) {
+    computeTangents(mesh);
+    optimizeVertexCache(mesh.indices, mesh.vertices.size());
+}
+
+// Unit cube centred on the origin: 4 vertices per face, 24 in total, with the
+// same per-face UVs as the old 36-vertex arrays.
+MeshData createCube() {
+    struct Face {
+        glm::vec3 normal, u, v;
+    };
+    const Face faces[] = {
+            {glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f,  0.0f)},
+            {glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f,  0.0f)},
+            {glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f)},
+            {glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f)},
+            {glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f)},
+            {glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f)},
+    };
+    const glm::vec2 corners[] = {glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec2(0.0f, 1.0f)};
+
+    MeshData mesh;
+    for (const Face &face : faces) {
+        unsigned int base = (unsigned int) mesh.vertices.size();
+        for (const glm::vec2 &uv : corners) {
+            MeshVertex vertex;
+            vertex.position = 0.5f * face.normal + (uv.x - 0.5f) * face.u + (uv.y - 0.5f) * face.v;
+            vertex.normal = face.normal;
+            vertex.texCoords = uv;
+            mesh.vertices.push_back(vertex);
+        }
+        // counter-clockwise seen from outside
+        if (glm::dot(glm::cross(face.u, face.v), face.normal) > 0.0f) {
+            mesh.indices.insert(mesh.indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+        } else {
+            mesh.indices.insert(mesh.indices.end(), {base, base + 2, base + 1, base, base + 3, base + 2});
+        }
+    }
+    finishMesh(mesh);
+    return mesh;
+}
+
+// UV sphere of the given radius; the seam column and the pole rows are
+// duplicated so UVs stay continuous.
+MeshData createSphere(int segments, int rings, float radius = 0.5f) {
+    MeshData mesh;
+    for (int y = 0; y <= rings; y++) {
+        float v = (float) y / rings;
+        float phi = v * glm::pi<float>();
+        for (int x = 0; x <= segments; x++) {
+            float u = (float) x / segments;
+            float theta = u * 2.0f * glm::pi<float>();
+            MeshVertex vertex;
+            vertex.normal = glm::vec3(-std::cos(theta) * std::sin(phi), -std::cos(phi), std::sin(theta) * std::sin(phi));
+            vertex.position = vertex.normal * radius;
+            vertex.texCoords = glm::vec2(u, v);
+            mesh.vertices.push_back(vertex);
+        }
+    }
+    for (int y = 0; y < rings; y++) {
+        for (int x = 0; x < segments; x++) {
+            unsigned int a = y * (segments + 1) + x;
+            unsigned int b = a + segments + 1;
+            mesh.indices.insert(mesh.indices.end(), {a, a + 1, b, a + 1, b + 1, b});
+        }
+    }
+    finishMesh(mesh);
+    return mesh;
+}
+
+// Square in the XZ plane facing +Y, size units across, UVs 0..1.
+MeshData createPlane(int xSegments, int zSegments, float size = 1.0f) {
+    MeshData mesh;
+    for (int z = 0; z <= zSegments; z++) {
+        for (int x = 0; x <= xSegments; x++) {
+            float u = (float) x / xSegments;
+            float v = (float) z / zSegments;
+            MeshVertex vertex;
+            vertex.position = glm::vec3((u - 0.5f) * size, 0.0f, (0.5f - v) * size);
+            vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+            vertex.texCoords = glm::vec2(u, v);
+            mesh.vertices.push_back(vertex);
+        }
+    }
+    for (int z = 0; z < zSegments; z++) {
+        for (int x = 0; x < xSegments; x++) {
+            unsigned int a = z * (xSegments + 1) + x;
+            unsigned int b = a + xSegments + 1;
+            mesh.indices.insert(mesh.indices.end(), {a, a + 1, b + 1, a, b + 1, b});
+        }
+    }
+    finishMesh(mesh);
+    return mesh;
+}
+
+// Torus around the Y axis.
+MeshData createTorus(int majorSegments, int minorSegments, float majorRadius = 0.35f, float minorRadius = 0.15f) {
+    MeshData mesh;
+    for (int i = 0; i <= majorSegments; i++) {
+        float u = (float) i / majorSegments;
+        float theta = u * 2.0f * glm::pi<float>();
+        glm::vec3 ring(std::cos(theta), 0.0f, -std::sin(theta));
+        for (int j = 0; j <= minorSegments; j++) {
+            float v = (float) j / minorSegments;
+            float phi = v * 2.0f * glm::pi<float>();
+            MeshVertex vertex;
+            vertex.normal = ring * std::cos(phi) + glm::vec3(0.0f, std::sin(phi), 0.0f);
+            vertex.position = ring * majorRadius + vertex.normal * minorRadius;
+            vertex.texCoords = glm::vec2(u, v);
+            mesh.vertices.push_back(vertex);
+        }
+    }
+    for (int i = 0; i < majorSegments; i++) {
+        for (int j = 0; j < minorSegments; j++) {
+            unsigned int a = i * (minorSegments + 1) + j;
+            unsigned int b = a + minorSegments + 1;
+            mesh.indices.insert(mesh.indices.end(), {a, b, b + 1, a, b + 1, a + 1});
+        }
+    }
+    finishMesh(mesh);
+    return mesh;
+}
+
+// Primitives that ofs_cook bakes into the asset pack, by the name
+// MeshBuffer::addBuiltin() takes.
+struct BuiltinMesh {
+    const char* name;
+    MeshData (*build)();
+};
+
+const BuiltinMesh BUILTIN_MESHES[] = {
+    {"cube", createCube},
+    {"sphere", [] { return createSphere(64, 32); }},
+    {"plane", [] { return createPlane(1, 1); }},
+    {"torus", [] { return createTorus(64, 32); }},
+};
+
+// A range of a MeshBuffer. Draw with the buffer's VAO bound.
+struct Mesh {
+    unsigned int baseVertex = 0;
+    unsigned int firstIndex = 0;
+    unsigned int indexCount = 0;
+
+    void draw() const {
+        glDrawElementsBaseVertex(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (void*) (firstIndex * sizeof(unsigned int)), baseVertex);
+    }
+
+    void drawInstanced(int instanceCount) const {
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (void*) (firstIndex * sizeof(unsigned int)), instanceCount, baseVertex);
+    }
+};
+
+// Every primitive a demo needs in one vertex buffer and one index buffer, so
+// switching between them never rebinds buffers.
+//
+//     MeshBuffer meshes;
+//     Mesh cube = meshes.addBuiltin("cube");
+//     meshes.upload();
+//     unsigned int cubeVAO = meshes.createVAO();
+//     ...
+//     GLStateCache::instance().bindVertexArray(cubeVAO);
+//     cube.draw();
+class MeshBuffer {
+public:
+    unsigned int VBO;
+    unsigned int EBO;
+
+    MeshBuffer() {
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+    }
+
+    ~MeshBuffer() {
+        GLStateCache &state = GLStateCache::instance();
+        state.deleteVertexArrays((int) vaos.size(), vaos.data());
+        state.deleteBuffers(1, &VBO);
+        state.deleteBuffers(1, &EBO);
+    }
+
+    MeshBuffer(const MeshBuffer&) = delete;
+    MeshBuffer& operator=(const MeshBuffer&) = delete;
+
+    Mesh add(const MeshData &data) {
+        return add(data.vertices.data(), data.vertices.size(), data.indices.data(), data.indices.size());
+    }
+
+    Mesh add(const MeshVertex* meshVertices, size_t vertexCount, const unsigned int* meshIndices, size_t indexCount) {
+        Mesh mesh;
+        mesh.baseVertex = (unsigned int) vertices.size();
+        mesh.firstIndex = (unsigned int) indices.size();
+        mesh.indexCount = (unsigned int) indexCount;
+        vertices.insert(vertices.end(), meshVertices, meshVertices + vertexCount);
+        indices.insert(indices.end(), meshIndices, meshIndices + indexCount);
+        return mesh;
+    }
+
+    // One of BUILTIN_MESHES, copied out of the asset pack when it has it,
+    // built and optimised here otherwise.
+    Mesh addBuiltin(const std::string &name) {
+        const AssetPackEntry* packed = AssetPack::instance().find("mesh/" + name, ASSET_MESH);
+        if (packed != NULL && (uint64_t) packed->params[0] * sizeof(MeshVertex) + (uint64_t) packed->params[1] * sizeof(unsigned int) > packed->size) {
+            std::cout << "Asset pack entry for mesh " << name << " is smaller than its counts, building it instead" << std::endl;
+            packed = NULL;
+        }
+        if (packed != NULL) {
+            AssetSpan span = AssetPack::instance().data(*packed);
+            size_t vertexCount = packed->params[0];
+            const MeshVertex* packedVertices = (const MeshVertex*) span.data;
+            const unsigned int* packedIndices = (const unsigned int*) (span.data + vertexCount * sizeof(MeshVertex));
+            return add(packedVertices, vertexCount, packedIndices, packed->params[1]);
+        }
+        for (const BuiltinMesh &builtin : BUILTIN_MESHES) {
+            if (name == builtin.name) {
+                return add(builtin.build());
+            }
+        }
+        std::cout << "Unknown mesh: " << name << std::endl;
+        return Mesh();
+    }
+
+    void upload() {
+        GLStateCache &state = GLStateCache::instance();
+        state.bindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(MeshVertex), vertices.data(), GL_STATIC_DRAW);
+        state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    }
+
+    // A VAO reading this buffer with the standard layout. Demos that need
+    // extra per-instance attributes attach them to the returned VAO.
+    unsigned int createVAO() {
+        unsigned int vao;
+        glGenVertexArrays(1, &vao);
+        GLStateCache &state = GLStateCache::instance();
+        state.bindVertexArray(vao);
+        state.bindBuffer(GL_ARRAY_BUFFER, VBO);
+        state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glVertexAttribPointer(MESH_POSITION_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*) offsetof(MeshVertex, position));
+        glEnableVertexAttribArray(MESH_POSITION_LOCATION);
+        glVertexAttribPointer(MESH_NORMAL_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*) offsetof(MeshVertex, normal));
+        glEnableVertexAttribArray(MESH_NORMAL_LOCATION);
+        glVertexAttribPointer(MESH_TEXCOORDS_LOCATION, 2, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*) offsetof(MeshVertex, texCoords));
+        glEnableVertexAttribArray(MESH_TEXCOORDS_LOCATION);
+        glVertexAttribPointer(MESH_TANGENT_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*) offsetof(MeshVertex, tangent));
+        glEnableVertexAttribArray(MESH_TANGENT_LOCATION);
+        vaos.push_back(vao);
+        return vao;
+    }
+
+    size_t vertexBytes() const {
+        return vertices.size() * sizeof(MeshVertex);
+    }
+
+    size_t indexBytes() const {
+        return indices.size() * sizeof(unsigned int);
+    }
+
+private:
+    std::vector<MeshVertex> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<unsigned int> vaos;
+};
+
+#endif //OPENGL_FROM_SCRATCH_OFS_MESH_H
@@ -0,0 +1,196 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_MIPMAP_H
+#define OPENGL_FROM_SCRATCH_OFS_MIPMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OFS_MIPMAP_SSE 1
+#endif
+
+// Mip chains built on the CPU so textures can be uploaded level by level into
+// immutable storage instead of calling glGenerateMipmap at load time.
+//
+// A chain is level 0 followed by every smaller level, tightly packed 8-bit
+// pixels. Each level is floor(size / 2) of the previous one, at least 1, and
+// every texel is the rounded average of a 2x2 box: (a + b + c + d + 2) / 4. On
+// odd sizes the last row or column is dropped; on a size of 1 it is repeated.
+
+int mipLevelCount(int width, int height) {
+    int levels = 1;
+    while (width > 1 || height > 1) {
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        levels++;
+    }
+    return levels;
+}
+
+size_t mipChainSize(int width, int height, int channels) {
+    size_t size = 0;
+    for (;;) {
+        size += (size_t) width * height * channels;
+        if (width == 1 && height == 1) {
+            return size;
+        }
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+}
+
+// Reference implementation, one texel at a time.
+void downsampleBoxScalar(const unsigned char* src, int width, int height, int channels, unsigned char* dst) {
+    int dstWidth = width > 1 ? width / 2 : 1;
+    int dstHeight = height > 1 ? height / 2 : 1;
+    size_t pitch = (size_t) width * channels;
+    for (int y = 0; y < dstHeight; y++) {
+        const unsigned char* row0 = src + (size_t) (2 * y) * pitch;
+        const unsigned char* row1 = height > 1 ? row0 + pitch : row0;
+        unsigned char* out = dst + (size_t) y * dstWidth * channels;
+        for (int x = 0; x < dstWidth; x++) {
+            size_t left = (size_t) (2 * x) * channels;
+            size_t right = width > 1 ? left + channels : left;
+            for (int c = 0; c < channels; c++) {
+                out[x * channels + c] = (unsigned char) ((row0[left + c] + row0[right + c] + row1[left + c] + row1[right + c] + 2) >> 2);
+            }
+        }
+    }
+}
+
+#ifdef OFS_MIPMAP_SSE
+
+// One destination row. Rows are summed vertically 16 bytes at a time in 16-bit
+// lanes, then horizontal neighbours are added: for 4 channels by pairing the
+// 64-bit halves (one pixel each), for 1 channel with a multiply-add against 1.
+// Other channel counts (RGB, RG) go through two scratch rows of
+// 2 * (width / 2) * channels entries: the vertical sums, then every byte's
+// average with the byte one pixel to its right, of which each even pixel is
+// kept. The tail of the row takes the scalar loop.
+inline void downsampleBoxRow(const unsigned char* row0, const unsigned char* row1, int width, int channels, unsigned char* out,
+                             uint16_t* sums, unsigned char* averages) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+    int dstWidth = width / 2;
+    int x = 0;
+
+    if (channels == 4) {
+        // 4 destination pixels from 8 source pixels (32 bytes) per iteration
+        for (; x + 4 <= dstWidth; x += 4) {
+            const unsigned char* a = row0 + x * 8;
+            const unsigned char* b = row1 + x * 8;
+            __m128i a0 = _mm_loadu_si128((const __m128i*) a);
+            __m128i a1 = _mm_loadu_si128((const __m128i*) (a + 16));
+            __m128i b0 = _mm_loadu_si128((const __m128i*) b);
+            __m128i b1 = _mm_loadu_si128((const __m128i*) (b + 16));
+            // source pixels 0-1, 2-3, 4-5, 6-7 summed over both rows
+            __m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+            __m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+            __m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+            __m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+            // even pixels + odd pixels: destination pixels 0-1 and 2-3
+            __m128i d0 = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+            __m128i d1 = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+            d0 = _mm_srli_epi16(_mm_add_epi16(d0, two), 2);
+            d1 = _mm_srli_epi16(_mm_add_epi16(d1, two), 2);
+            _mm_storeu_si128((__m128i*) (out + x * 4), _mm_packus_epi16(d0, d1));
+        }
+    } else if (channels == 1) {
+        const __m128i ones = _mm_set1_epi16(1);
+        const __m128i twos = _mm_set1_epi32(2);
+        // 8 destination pixels from 16 source pixels per iteration
+        for (; x + 8 <= dstWidth; x += 8) {
+            __m128i a = _mm_loadu_si128((const __m128i*) (row0 + x * 2));
+            __m128i b = _mm_loadu_si128((const __m128i*) (row1 + x * 2));
+            __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+            __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+            __m128i d0 = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(lo, ones), twos), 2);
+            __m128i d1 = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(hi, ones), twos), 2);
+            __m128i d = _mm_packs_epi32(d0, d1);
+            _mm_storel_epi64((__m128i*) (out + x), _mm_packus_epi16(d, d));
+        }
+    } else {
+        int bytes = 2 * dstWidth * channels;
+        int i = 0;
+        for (; i + 16 <= bytes; i += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i*) (row0 + i));
+            __m128i b = _mm_loadu_si128((const __m128i*) (row1 + i));
+            _mm_storeu_si128((__m128i*) (sums + i), _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)));
+            _mm_storeu_si128((__m128i*) (sums + i + 8), _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)));
+        }
+        for (; i < bytes; i++) {
+            sums[i] = (uint16_t) (row0[i] + row1[i]);
+        }
+
+        // the last pixel has no right neighbour, and is never kept
+        int count = bytes - channels;
+        i = 0;
+        for (; i + 16 <= count; i += 16) {
+            __m128i h0 = _mm_add_epi16(_mm_loadu_si128((const __m128i*) (sums + i)), _mm_loadu_si128((const __m128i*) (sums + i + channels)));
+            __m128i h1 = _mm_add_epi16(_mm_loadu_si128((const __m128i*) (sums + i + 8)), _mm_loadu_si128((const __m128i*) (sums + i + 8 + channels)));
+            h0 = _mm_srli_epi16(_mm_add_epi16(h0, two), 2);
+            h1 = _mm_srli_epi16(_mm_add_epi16(h1, two), 2);
+            _mm_storeu_si128((__m128i*) (averages + i), _mm_packus_epi16(h0, h1));
+        }
+        for (; i < count; i++) {
+            averages[i] = (unsigned char) ((sums[i] + sums[i + channels] + 2) >> 2);
+        }
+
+        if (channels == 3) {
+            // 4 bytes at a time; the spare one is overwritten by the next pixel
+            for (; x + 1 < dstWidth; x++) {
+                memcpy(out + x * 3, averages + x * 6, 4);
+            }
+        }
+        for (; x < dstWidth; x++) {
+            for (int c = 0; c < channels; c++) {
+                out[x * channels + c] = averages[(size_t) (2 * x) * channels + c];
+            }
+        }
+        return;
+    }
+
+    for (; x < dstWidth; x++) {
+        size_t left = (size_t) (2 * x) * channels;
+        for (int c = 0; c < channels; c++) {
+            out[x * channels + c] = (unsigned char) ((row0[left + c] + row0[left + channels + c] + row1[left + c] + row1[left + channels + c] + 2) >> 2);
+        }
+    }
+}
+
+#endif
+
+void downsampleBox(const unsigned char* src, int width, int height, int channels, unsigned char* dst) {
+#ifdef OFS_MIPMAP_SSE
+    // a single column or row needs the clamped reads of the scalar path
+    if (width > 1 && height > 1) {
+        int dstWidth = width / 2;
+        int dstHeight = height / 2;
+        size_t pitch = (size_t) width * channels;
+        size_t scratch = channels == 1 || channels == 4 ? 0 : (size_t) 2 * dstWidth * channels;
+        std::vector<uint16_t> sums(scratch);
+        std::vector<unsigned char> averages(scratch);
+        for (int y = 0; y < dstHeight; y++) {
+            const unsigned char* row0 = src + (size_t) (2 * y) * pitch;
+            downsampleBoxRow(row0, row0 + pitch, width, channels, dst + (size_t) y * dstWidth * channels, sums.data(), averages.data());
+        }
+        return;
+    }
+#endif
+    downsampleBoxScalar(src, width, height, channels, dst);
+}
+
+// Fills every level after level 0, which the caller has already written to chain.
+void buildMipChain(unsigned char* chain, int width, int height, int channels) {
+    while (width > 1 || height > 1) {
+        unsigned char* next = chain + (size_t) width * height * channels;
+        downsampleBox(chain, width, height, channels, next);
+        chain = next;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+}
+
+#endif //OPENGL_FROM_SCRATCH_OFS_MIPMAP_H
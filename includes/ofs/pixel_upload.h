@@ -0,0 +1,214 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_PIXEL_UPLOAD_H
+#define OPENGL_FROM_SCRATCH_OFS_PIXEL_UPLOAD_H
+
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <cstddef>
+
+#include <glad/glad.h>
+
+#include "ofs/texture_cache.h"
+#include "ofs/lockfree_queue.h"
+#include "ofs/gl_state_cache.h"
+
+// A texture upload whose transfer has completed on the GPU.
+struct PixelUpload {
+    unsigned int texture = 0;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+};
+
+struct PixelUploadStats {
+    int uploads = 0;
+    size_t bytes = 0;
+    // GL thread time spent issuing uploads and recycling slots
+    double submitMs = 0.0;
+    // submit to fence signalled, summed over uploads
+    double transferMs = 0.0;
+};
+
+// Ring of pixel unpack buffers for streaming texture uploads.
+//
+// Slots are handed out mapped, so any thread can write a mip chain straight
+// into buffer memory with acquire()/memory(). The GL thread then submit()s the
+// slot: glTexSubImage2D reads every level from the buffer and returns without
+// waiting for the copy, and a fence marks when the slot may be written again.
+// poll() recycles slots whose fence has signalled and reports the uploads that
+// completed.
+//  - PERSISTENT: glBufferStorage with a coherent persistent mapping (GL 4.4)
+//  - ORPHAN: glBufferData(NULL) gives the slot fresh storage, then it is mapped
+//    again; works on any GL 3.x context
+//
+//     PixelUploadRing ring;
+//     int slot = ring.acquire();           // any thread, -1 if all are in use
+//     memcpy(ring.memory(slot), chain.data(), chain.size());
+//     ring.submit(slot, texture, width, height, channels);   // GL thread
+//     ...
+//     for (const PixelUpload &done : ring.poll()) { ... }
+class PixelUploadRing {
+public:
+    enum Mode {
+        PERSISTENT,
+        ORPHAN,
+    };
+
+    PixelUploadStats stats;
+    const Mode mode;
+    const size_t slotSize;
+
+    explicit PixelUploadRing(int slotCount = 4, size_t slotSize = 4 << 20, Mode mode = bestMode())
+            : mode(mode), slotSize(slotSize), freeSlots(slotCount) {
+        GLStateCache &state = GLStateCache::instance();
+        slots.resize(slotCount);
+        for (int i = 0; i < slotCount; i++) {
+            Slot &slot = slots[i];
+            glGenBuffers(1, &slot.buffer);
+            state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+            if (mode == PERSISTENT) {
+                GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+                glBufferStorage(GL_PIXEL_UNPACK_BUFFER, slotSize, NULL, flags);
+                slot.memory = (unsigned char*) glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, slotSize, flags);
+            } else {
+                map(slot);
+            }
+            freeSlots.push(i);
+        }
+        state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    ~PixelUploadRing() {
+        GLStateCache &state = GLStateCache::instance();
+        for (Slot &slot : slots) {
+            if (slot.fence != NULL) {
+                glDeleteSync(slot.fence);
+            }
+            // submit() already unmapped the orphaned slots in flight
+            if (slot.memory != NULL) {
+                state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            }
+            state.deleteBuffers(1, &slot.buffer);
+        }
+        state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    PixelUploadRing(const PixelUploadRing&) = delete;
+    PixelUploadRing& operator=(const PixelUploadRing&) = delete;
+
+    static Mode bestMode() {
+        return GLAD_GL_VERSION_4_4 ? PERSISTENT : ORPHAN;
+    }
+
+    // Any thread. Returns a writable slot or -1 if every slot is in flight.
+    int acquire() {
+        int slot;
+        return freeSlots.pop(slot) ? slot : -1;
+    }
+
+    unsigned char* memory(int slot) const {
+        return slots[slot].memory;
+    }
+
+    // GL thread. Specifies texture from the mip chain (see ofs/mipmap.h) written
+    // at the start of the slot.
+    void submit(int index, unsigned int texture, int width, int height, int channels) {
+        auto start = std::chrono::steady_clock::now();
+        Slot &slot = slots[index];
+
+        GLStateCache &state = GLStateCache::instance();
+        state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+        if (mode == ORPHAN) {
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            slot.memory = NULL;
+        }
+        // a null chain is offset 0 in the bound unpack buffer
+        uploadMipChain(texture, NULL, width, height, channels);
+        state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot.upload.texture = texture;
+        slot.upload.width = width;
+        slot.upload.height = height;
+        slot.upload.channels = channels;
+        slot.submitted = start;
+        inFlight.push_back(index);
+
+        stats.uploads++;
+        stats.bytes += mipChainSize(width, height, channels);
+        stats.submitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // GL thread. Never blocks: returns the uploads whose fence has signalled
+    // and puts their slots back in the ring.
+    std::vector<PixelUpload> poll() {
+        std::vector<PixelUpload> done;
+        if (inFlight.empty()) {
+            return done;
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < inFlight.size();) {
+            Slot &slot = slots[inFlight[i]];
+            GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+                i++;
+                continue;
+            }
+            glDeleteSync(slot.fence);
+            slot.fence = NULL;
+            stats.transferMs += std::chrono::duration<double, std::milli>(start - slot.submitted).count();
+            done.push_back(slot.upload);
+            if (mode == ORPHAN) {
+                GLStateCache &state = GLStateCache::instance();
+                state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+                map(slot);
+                state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            }
+            freeSlots.push(inFlight[i]);
+            inFlight[i] = inFlight.back();
+            inFlight.pop_back();
+        }
+        stats.submitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return done;
+    }
+
+    bool idle() const {
+        return inFlight.empty();
+    }
+
+    // MB/s of pixels per millisecond the GL thread spent on them.
+    double submitThroughput() const {
+        return stats.submitMs > 0.0 ? stats.bytes / 1e3 / stats.submitMs : 0.0;
+    }
+
+    void report() const {
+        std::cout << "Pixel upload ring (" << (mode == PERSISTENT ? "persistent" : "orphan") << ", "
+                  << slots.size() << " x " << slotSize / 1024 << " KiB): " << stats.uploads << " uploads, "
+                  << stats.bytes / (1024 * 1024) << " MiB, " << submitThroughput() << " MB/s on the GL thread, "
+                  << (stats.uploads > 0 ? stats.transferMs / stats.uploads : 0.0) << " ms average latency" << std::endl;
+    }
+
+private:
+    struct Slot {
+        unsigned int buffer = 0;
+        unsigned char* memory = NULL;
+        GLsync fence = NULL;
+        PixelUpload upload;
+        std::chrono::steady_clock::time_point submitted;
+    };
+
+    std::vector<Slot> slots;
+    LockFreeQueue<int> freeSlots;
+    // GL thread only
+    std::vector<int> inFlight;
+
+    void map(Slot &slot) {
+        // orphan the old storage; the driver keeps it alive for pending transfers
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, slotSize, NULL, GL_STREAM_DRAW);
+        slot.memory = (unsigned char*) glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, slotSize,
+                                                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    }
+};
+
+#endif //OPENGL_FROM_SCRATCH_OFS_PIXEL_UPLOAD_H
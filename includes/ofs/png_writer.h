@@ -0,0 +1,302 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_PNG_WRITER_H
+#define OPENGL_FROM_SCRATCH_OFS_PNG_WRITER_H
+
+#include <vector>
+#include <array>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+// PNG encoding for frame captures and diff images. stb only decodes, so this
+// is a small encoder of its own: every row gets the filter with the smallest
+// sum of absolute differences, then one deflate block with the fixed Huffman
+// codes and a hash-chain LZ77 matcher. Rendered frames are mostly flat or
+// smooth, which that compresses well enough without dynamic Huffman tables.
+
+const int PNG_WINDOW = 32768;
+const int PNG_MIN_MATCH = 3;
+const int PNG_MAX_MATCH = 258;
+const int PNG_HASH_BITS = 15;
+// longer chains compress a little better and much slower
+const int PNG_MAX_CHAIN = 32;
+
+// The CRC-32 table, built on first use; a function-local static, so the
+// encoder threads can race to it safely.
+const uint32_t* pngCrcTable() {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> entries;
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            entries[i] = c;
+        }
+        return entries;
+    }();
+    return table.data();
+}
+
+uint32_t pngCrc32(const unsigned char* data, size_t size, uint32_t crc = 0) {
+    const uint32_t* table = pngCrcTable();
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+uint32_t pngAdler32(const unsigned char* data, size_t size) {
+    uint32_t a = 1, b = 0;
+    while (size > 0) {
+        // the largest run that cannot overflow before the modulo
+        size_t run = size < 5552 ? size : 5552;
+        size -= run;
+        while (run-- > 0) {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+// Writes bits least significant first, as deflate wants them.
+struct PngBitWriter {
+    std::vector<unsigned char> &out;
+    uint32_t buffer = 0;
+    int count = 0;
+
+    explicit PngBitWriter(std::vector<unsigned char> &out) : out(out) {}
+
+    void bits(uint32_t value, int length) {
+        buffer |= value << count;
+        count += length;
+        while (count >= 8) {
+            out.push_back((unsigned char) buffer);
+            buffer >>= 8;
+            count -= 8;
+        }
+    }
+
+    // Huffman codes are defined most significant bit first.
+    void code(uint32_t value, int length) {
+        uint32_t reversed = 0;
+        for (int i = 0; i < length; i++) {
+            reversed = (reversed << 1) | ((value >> i) & 1);
+        }
+        bits(reversed, length);
+    }
+
+    void flush() {
+        if (count > 0) {
+            out.push_back((unsigned char) buffer);
+        }
+        buffer = 0;
+        count = 0;
+    }
+};
+
+void pngLiteral(PngBitWriter &writer, int symbol) {
+    if (symbol < 144) {
+        writer.code(0x30 + symbol, 8);
+    } else if (symbol < 256) {
+        writer.code(0x190 + symbol - 144, 9);
+    } else if (symbol < 280) {
+        writer.code(symbol - 256, 7);
+    } else {
+        writer.code(0xC0 + symbol - 280, 8);
+    }
+}
+
+void pngMatch(PngBitWriter &writer, int length, int distance) {
+    static const int lengthBase[] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                     35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static const int lengthExtra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                      3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    static const int distanceBase[] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                       257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    static const int distanceExtra[] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+    int l = 28;
+    while (lengthBase[l] > length) {
+        l--;
+    }
+    pngLiteral(writer, 257 + l);
+    writer.bits(length - lengthBase[l], lengthExtra[l]);
+    int d = 29;
+    while (distanceBase[d] > distance) {
+        d--;
+    }
+    writer.code(d, 5);
+    writer.bits(distance - distanceBase[d], distanceExtra[d]);
+}
+
+// zlib stream of data in one fixed-Huffman deflate block.
+std::vector<unsigned char> pngDeflate(const unsigned char* data, size_t size) {
+    std::vector<unsigned char> out = {0x78, 0x01};
+    PngBitWriter writer(out);
+    // final block, fixed Huffman codes
+    writer.bits(1, 1);
+    writer.bits(1, 2);
+
+    std::vector<int> head(1 << PNG_HASH_BITS, -1);
+    std::vector<int> previous(PNG_WINDOW, -1);
+    auto hash = [&](size_t i) {
+        uint32_t key = data[i] | (data[i + 1] << 8) | (data[i + 2] << 16);
+        return (key * 2654435761u) >> (32 - PNG_HASH_BITS);
+    };
+    auto insert = [&](size_t i) {
+        if (i + PNG_MIN_MATCH <= size) {
+            uint32_t h = hash(i);
+            previous[i % PNG_WINDOW] = head[h];
+            head[h] = (int) i;
+        }
+    };
+
+    size_t i = 0;
+    while (i < size) {
+        int bestLength = 0, bestDistance = 0;
+        if (i + PNG_MIN_MATCH <= size) {
+            int maxLength = (int) std::min<size_t>(PNG_MAX_MATCH, size - i);
+            int candidate = head[hash(i)];
+            for (int chain = 0; candidate >= 0 && chain < PNG_MAX_CHAIN; chain++) {
+                int distance = (int) i - candidate;
+                if (distance > PNG_WINDOW) {
+                    break;
+                }
+                int length = 0;
+                while (length < maxLength && data[candidate + length] == data[i + length]) {
+                    length++;
+                }
+                if (length > bestLength) {
+                    bestLength = length;
+                    bestDistance = distance;
+                    if (length == maxLength) {
+                        break;
+                    }
+                }
+                int next = previous[candidate % PNG_WINDOW];
+                // the slot was reused by a newer position, the chain ends here
+                if (next >= candidate) {
+                    break;
+                }
+                candidate = next;
+            }
+        }
+        if (bestLength >= PNG_MIN_MATCH) {
+            pngMatch(writer, bestLength, bestDistance);
+            for (int k = 0; k < bestLength; k++) {
+                insert(i + k);
+            }
+            i += bestLength;
+        } else {
+            pngLiteral(writer, data[i]);
+            insert(i);
+            i++;
+        }
+    }
+    pngLiteral(writer, 256);
+    writer.flush();
+
+    uint32_t adler = pngAdler32(data, size);
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back((unsigned char) (adler >> shift));
+    }
+    return out;
+}
+
+inline int pngPaeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    return pb <= pc ? b : c;
+}
+
+// Each row prefixed with the filter that leaves the smallest residuals.
+std::vector<unsigned char> pngFilter(const unsigned char* pixels, int width, int height, int channels, bool flipVertically) {
+    size_t stride = (size_t) width * channels;
+    std::vector<unsigned char> filtered((stride + 1) * height);
+    std::vector<unsigned char> candidate(stride);
+    std::vector<unsigned char> zero(stride, 0);
+    for (int y = 0; y < height; y++) {
+        const unsigned char* row = pixels + stride * (flipVertically ? height - 1 - y : y);
+        const unsigned char* above = y == 0 ? zero.data()
+                                            : pixels + stride * (flipVertically ? height - y : y - 1);
+        unsigned char* out = filtered.data() + (stride + 1) * y;
+        long bestScore = -1;
+        for (int filter = 0; filter < 5; filter++) {
+            long score = 0;
+            for (size_t x = 0; x < stride; x++) {
+                int left = x >= (size_t) channels ? row[x - channels] : 0;
+                int upLeft = x >= (size_t) channels ? above[x - channels] : 0;
+                int predicted = 0;
+                switch (filter) {
+                    case 1: predicted = left; break;
+                    case 2: predicted = above[x]; break;
+                    case 3: predicted = (left + above[x]) / 2; break;
+                    case 4: predicted = pngPaeth(left, above[x], upLeft); break;
+                }
+                candidate[x] = (unsigned char) (row[x] - predicted);
+                score += (signed char) candidate[x] < 0 ? -(signed char) candidate[x] : candidate[x];
+            }
+            if (bestScore < 0 || score < bestScore) {
+                bestScore = score;
+                out[0] = (unsigned char) filter;
+                memcpy(out + 1, candidate.data(), stride);
+            }
+        }
+    }
+    return filtered;
+}
+
+void pngChunk(std::vector<unsigned char> &png, const char* type, const std::vector<unsigned char> &data) {
+    uint32_t size = (uint32_t) data.size();
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        png.push_back((unsigned char) (size >> shift));
+    }
+    size_t start = png.size();
+    png.insert(png.end(), type, type + 4);
+    png.insert(png.end(), data.begin(), data.end());
+    uint32_t crc = pngCrc32(png.data() + start, png.size() - start);
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        png.push_back((unsigned char) (crc >> shift));
+    }
+}
+
+// 8-bit grey, grey + alpha, RGB or RGBA pixels, rows top to bottom unless
+// flipVertically says they come bottom up as glReadPixels returns them.
+std::vector<unsigned char> encodePng(const unsigned char* pixels, int width, int height, int channels,
+                                     bool flipVertically = false) {
+    static const unsigned char colorTypes[] = {0, 0, 4, 2, 6};
+    std::vector<unsigned char> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::vector<unsigned char> header;
+    for (uint32_t value : {(uint32_t) width, (uint32_t) height}) {
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            header.push_back((unsigned char) (value >> shift));
+        }
+    }
+    // bit depth, color type, compression, filter method, no interlacing
+    header.insert(header.end(), {8, colorTypes[channels], 0, 0, 0});
+    pngChunk(png, "IHDR", header);
+    std::vector<unsigned char> filtered = pngFilter(pixels, width, height, channels, flipVertically);
+    pngChunk(png, "IDAT", pngDeflate(filtered.data(), filtered.size()));
+    pngChunk(png, "IEND", {});
+    return png;
+}
+
+bool writePng(const std::string &path, const unsigned char* pixels, int width, int height, int channels,
+              bool flipVertically = false) {
+    std::vector<unsigned char> png = encodePng(pixels, width, height, channels, flipVertically);
+    std::ofstream file(path, std::ios::binary);
+    file.write((const char*) png.data(), png.size());
+    return (bool) file;
+}
+
+#endif //OPENGL_FROM_SCRATCH_OFS_PNG_WRITER_H
@@ -0,0 +1,296 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_PROFILER_H
+#define OPENGL_FROM_SCRATCH_OFS_PROFILER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <cstdint>
+#include <cstdlib>
+
+// Scoped CPU profiler writing Chrome trace_event JSON (chrome://tracing,
+// https://ui.perfetto.dev).
+//
+//     OFS_PROFILE_THREAD("texture loader");   // optional, names the track
+//     {
+//         OFS_PROFILE_ZONE("draw");
+//         ...
+//     }
+//
+// A zone reads the clock when it opens and appends one complete event to its
+// thread's track when it closes. Each thread owns its track, so appending
+// takes no lock: events go into fixed-size chunks and the event count is
+// published with a release store, which is all the writer needs to read them.
+//
+// Recording starts with Profiler::start(path), which the demos call for
+// --trace <file> (see Context) or the OFS_TRACE environment variable; the
+// trace is written when the program exits. Until then a zone costs a relaxed
+// load and a branch. Builds with OFS_PROFILE=0, the default with NDEBUG,
+// compile zones out entirely.
+//
+// OFS_GPU_PROFILE switches the GPU zones of GpuProfiler and FragmentCounter
+// (OFS_GPU_ZONE, OFS_FRAGMENT_ZONE) separately. GPU timings matter most in
+// release builds, so it defaults to 1 whatever NDEBUG says.
+
+#ifndef OFS_PROFILE
+#ifdef NDEBUG
+#define OFS_PROFILE 0
+#else
+#define OFS_PROFILE 1
+#endif
+#endif
+
+#ifndef OFS_GPU_PROFILE
+#define OFS_GPU_PROFILE 1
+#endif
+
+#define OFS_PROFILE_CONCAT_(a, b) a##b
+#define OFS_PROFILE_CONCAT(a, b) OFS_PROFILE_CONCAT_(a, b)
+
+struct ProfileEvent {
+    // a string literal, or anything else that lives as long as the program
+    const char* name;
+    // nanoseconds since the profiler started
+    uint64_t start;
+    uint64_t duration;
+};
+
+// Events of one thread, or of one timeline like the GPU's. Only one thread
+// appends; any thread may read what has been published.
+class ProfileTrack {
+public:
+    static const size_t CHUNK_EVENTS = 8192;
+    // 8M events, about 190 MiB, before events are dropped
+    static const size_t MAX_CHUNKS = 1024;
+
+    // renamed under the profiler's lock only
+    std::string name;
+    const int id;
+    std::atomic<size_t> dropped{0};
+
+    ProfileTrack(const std::string &name, int id) : name(name), id(id) {
+        for (std::atomic<ProfileEvent*> &chunk : chunks) {
+            chunk.store(NULL, std::memory_order_relaxed);
+        }
+    }
+
+    ~ProfileTrack() {
+        for (std::atomic<ProfileEvent*> &chunk : chunks) {
+            delete[] chunk.load(std::memory_order_relaxed);
+        }
+    }
+
+    ProfileTrack(const ProfileTrack&) = delete;
+    ProfileTrack& operator=(const ProfileTrack&) = delete;
+
+    void append(const char* eventName, uint64_t start, uint64_t duration) {
+        size_t index = count.load(std::memory_order_relaxed);
+        size_t chunkIndex = index / CHUNK_EVENTS;
+        if (chunkIndex >= MAX_CHUNKS) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ProfileEvent* chunk = chunks[chunkIndex].load(std::memory_order_relaxed);
+        if (chunk == NULL) {
+            chunk = new ProfileEvent[CHUNK_EVENTS];
+            chunks[chunkIndex].store(chunk, std::memory_order_relaxed);
+        }
+        chunk[index % CHUNK_EVENTS] = {eventName, start, duration};
+        count.store(index + 1, std::memory_order_release);
+    }
+
+    size_t size() const {
+        return count.load(std::memory_order_acquire);
+    }
+
+    // Calls f for every event published so far, oldest first.
+    template <typename F>
+    void forEach(F f) const {
+        size_t published = size();
+        for (size_t i = 0; i < published; i++) {
+            f(chunks[i / CHUNK_EVENTS].load(std::memory_order_relaxed)[i % CHUNK_EVENTS]);
+        }
+    }
+
+private:
+    std::atomic<size_t> count{0};
+    std::atomic<ProfileEvent*> chunks[MAX_CHUNKS];
+};
+
+// set by Profiler::start(), read by every zone
+std::atomic<bool> profilerRecording(false);
+
+class Profiler {
+public:
+    static Profiler& instance() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    ~Profiler() {
+        if (profilerRecording.load() && !tracePath.empty()) {
+            write(tracePath);
+        }
+    }
+
+    // Starts recording; the trace goes to path on exit.
+    void start(const std::string &path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        tracePath = path;
+        profilerRecording.store(true);
+    }
+
+    // Stops recording. What was recorded stays until write(), but nothing is
+    // written on exit.
+    void stop() {
+        std::lock_guard<std::mutex> lock(mutex);
+        tracePath.clear();
+        profilerRecording.store(false);
+    }
+
+    static bool recording() {
+        return profilerRecording.load(std::memory_order_relaxed);
+    }
+
+    uint64_t now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    // The calling thread's track, created on first use.
+    ProfileTrack& threadTrack() {
+        thread_local ProfileTrack* track = NULL;
+        if (track == NULL) {
+            track = &createTrack(std::this_thread::get_id() == mainThread ? "main" : "");
+        }
+        return *track;
+    }
+
+    // Names the calling thread's track in the trace.
+    void nameThread(const char* name) {
+        if (recording()) {
+            ProfileTrack &track = threadTrack();
+            std::lock_guard<std::mutex> lock(mutex);
+            track.name = name;
+        }
+    }
+
+    // A timeline that is not a thread, filled by whoever owns it.
+    ProfileTrack& createTrack(const std::string &name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        int id = (int) tracks.size() + 1;
+        tracks.emplace_back(new ProfileTrack(name.empty() ? "thread " + std::to_string(id) : name, id));
+        return *tracks.back();
+    }
+
+    size_t eventCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t total = 0;
+        for (const std::unique_ptr<ProfileTrack> &track : tracks) {
+            total += track->size();
+        }
+        return total;
+    }
+
+    bool write(const std::string &path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::ofstream file(path);
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool first = true;
+        size_t total = 0, dropped = 0;
+        for (const std::unique_ptr<ProfileTrack> &track : tracks) {
+            file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track->id
+                 << ",\"args\":{\"name\":\"" << escape(track->name) << "\"}}";
+            first = false;
+            size_t events = 0;
+            track->forEach([&](const ProfileEvent &event) {
+                events++;
+                // microseconds, with the nanoseconds kept as decimals
+                file << ",\n{\"name\":\"" << escape(event.name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << track->id
+                     << ",\"ts\":" << event.start / 1000 << "." << pad3(event.start % 1000)
+                     << ",\"dur\":" << event.duration / 1000 << "." << pad3(event.duration % 1000) << "}";
+            });
+            total += events;
+            dropped += track->dropped.load();
+        }
+        file << "\n]}\n";
+        bool written = (bool) file;
+        std::cout << "Trace: " << total << " events on " << tracks.size() << " tracks";
+        if (dropped > 0) {
+            std::cout << ", " << dropped << " dropped";
+        }
+        std::cout << (written ? " written to " : " FAILED to write to ") << path << std::endl;
+        return written;
+    }
+
+private:
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    const std::thread::id mainThread = std::this_thread::get_id();
+    std::mutex mutex;
+    std::string tracePath;
+    std::vector<std::unique_ptr<ProfileTrack>> tracks;
+
+    Profiler() {
+        const char* path = getenv("OFS_TRACE");
+        if (OFS_PROFILE && path != NULL && path[0] != '\0') {
+            start(path);
+        }
+    }
+
+    static std::string escape(const std::string &text) {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+            }
+            escaped += (unsigned char) c < 0x20 ? ' ' : c;
+        }
+        return escaped;
+    }
+
+    static std::string pad3(uint64_t value) {
+        std::string digits = std::to_string(value);
+        return std::string(3 - digits.size(), '0') + digits;
+    }
+};
+
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name) : name(name), active(Profiler::recording()) {
+        if (active) {
+            start = Profiler::instance().now();
+        }
+    }
+
+    ~ProfileZone() {
+        if (active) {
+            Profiler &profiler = Profiler::instance();
+            profiler.threadTrack().append(name, start, profiler.now() - start);
+        }
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* name;
+    bool active;
+    uint64_t start = 0;
+};
+
+#if OFS_PROFILE
+#define OFS_PROFILE_ZONE(name) ProfileZone OFS_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define OFS_PROFILE_THREAD(name) Profiler::instance().nameThread(name)
+#else
+#define OFS_PROFILE_ZONE(name) ((void) 0)
+#define OFS_PROFILE_THREAD(name) ((void) 0)
+#endif
+
+#endif //OPENGL_FROM_SCRATCH_OFS_PROFILER_H
@@ -5,6 +5,9 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
 
 #include <glad/glad.h>
 #include <glm/vec3.hpp> // glm::vec3
@@ -13,6 +16,12 @@
 #include <glm/gtc/matrix_transform.hpp> // glm::translate, glm::rotate, glm::scale, glm::perspective
 #include <glm/gtc/type_ptr.hpp>
 
+#include "ofs/shader_cache.h"
+#include "ofs/shader_preprocessor.h"
+#include "ofs/uniform_buffer.h"
+#include "ofs/profiler.h"
+#include "ofs/gl_state_cache.h"
+
 unsigned int getVertexShader(const char* vertexShaderSource) {
     unsigned int vertexShader;
     vertexShader = glCreateShader(GL_VERTEX_SHADER);
@@ -57,6 +66,10 @@ unsigned int createShaderProgram(unsigned int vertexShader, unsigned int fragmen
 
     glAttachShader(shaderProgram, vertexShader);
     glAttachShader(shaderProgram, fragmentShader);
+    if (glad_glProgramParameteri != NULL) {
+        // keep the binary around so ShaderCache can store it
+        glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     glLinkProgram(shaderProgram);
 
     int success;
@@ -72,85 +85,231 @@ unsigned int createShaderProgram(unsigned int vertexShader, unsigned int fragmen
     return shaderProgram;
 }
 
-class Shader {
-public:
-    unsigned int ID;
-
-    Shader(const char* vertexPath, const char* fragmentPath) {
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-
-        vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-
-        try {
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
+// Location of an active uniform, resolved once after linking.
+// Setters taking a handle skip the name lookup entirely.
+struct UniformHandle {
+    int location = -1;
+    GLenum type = 0;
 
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();
+    bool valid() const {
+        return location >= 0;
+    }
+};
 
-            vShaderFile.close();
-            fShaderFile.close();
+struct UniformInfo {
+    std::string name;
+    int location;
+    GLenum type;
+    int size;
+};
 
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
-        } catch (std::ifstream::failure& e) {
+class Shader {
+public:
+    unsigned int ID;
+    // Active uniforms sorted by name, filled by reflectUniforms() after linking.
+    std::vector<UniformInfo> uniforms;
+
+    Shader() : ID(-1) {}
+
+    // permutationKey is a "|" separated define list, see ShaderPreprocessor.
+    Shader(const char* vertexPath, const char* fragmentPath, const std::string &permutationKey = "") {
+        OFS_PROFILE_ZONE("Shader");
+        ShaderPreprocessor preprocessor;
+        ShaderSource vertexSource;
+        ShaderSource fragmentSource;
+        if (!preprocessor.process(vertexPath, permutationKey, vertexSource) || !preprocessor.process(fragmentPath, permutationKey, fragmentSource)) {
             std::cout << "Failed to init shader, FILE NOT SUCCESSFULLY READ" << std::endl;
         }
-        const char* vShaderCode = vertexCode.c_str();
-        const char* fShaderCode = fragmentCode.c_str();
+        build(vertexSource.code, fragmentSource.code);
+    }
 
-        unsigned int vertex, fragment;
-        vertex = getVertexShader(vShaderCode);
-        if (vertex == -1) {
-            std::cout << "Failed to init shader, vertex shader failed" << std::endl;
+    // Links a program from in-memory sources, going through ShaderCache first.
+    void build(const std::string &vertexCode, const std::string &fragmentCode) {
+        auto start = std::chrono::steady_clock::now();
+        ShaderCache &cache = ShaderCache::instance();
+        uint64_t key = cache.key(vertexCode, fragmentCode);
+
+        ID = glCreateProgram();
+        bool hit = cache.load(key, ID);
+        if (!hit) {
+            glDeleteProgram(ID);
+            ID = compile(vertexCode.c_str(), fragmentCode.c_str());
+            if (ID != (unsigned int) -1) {
+                cache.store(key, ID);
+            }
         }
-        fragment = getFragmentShader(fShaderCode);
-        if (fragment == -1) {
-            std::cout << "Failed to init shader, fragment shader failed" << std::endl;
-        }
-        ID = createShaderProgram(vertex, fragment);
-        if (ID == -1) {
-            std::cout << "Failed to init shader, create shader program failed" << std::endl;
-        }
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
+        cache.record(hit, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+        reflectUniforms();
+        bindUniformBlocks();
+    }
+
+    // Takes over a program that was linked elsewhere (see ShaderBatch).
+    void setProgram(unsigned int program) {
+        ID = program;
+        reflectUniforms();
+        bindUniformBlocks();
     }
 
     void use() {
-        glUseProgram(ID);
+        GLStateCache::instance().useProgram(ID);
+    }
+
+    // Looks up the name in the precomputed table, no driver call involved.
+    // Unknown names give an invalid handle, which glUniform* silently ignores.
+    UniformHandle uniform(const std::string &name) const {
+        auto it = std::lower_bound(uniforms.begin(), uniforms.end(), name, [](const UniformInfo &info, const std::string &key) {
+            return info.name < key;
+        });
+        if (it == uniforms.end() || it->name != name) {
+            return UniformHandle();
+        }
+        return UniformHandle{it->location, it->type};
     }
 
     void setBool(const std::string &name, bool value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int) value);
+        setBool(uniform(name), value);
     }
 
     void setInt(const std::string &name, int value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int) value);
+        setInt(uniform(name), value);
     }
 
     void setFloat(const std::string &name, float value) const {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), (int) value);
+        setFloat(uniform(name), value);
     }
 
     void setVec3(const std::string &name, float x, float y, float z) const {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        setVec3(uniform(name), x, y, z);
     }
 
     void setVec3(const std::string &name, glm::vec3 vec) const {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), vec.x, vec.y, vec.z);
+        setVec3(uniform(name), vec);
     }
 
     void setVec4(const std::string &name, float x, float y, float z, float w) const {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+        setVec4(uniform(name), x, y, z, w);
     }
 
     void setMat4fv(const std::string &name, glm::mat4 trans) const {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(trans));
+        setMat4fv(uniform(name), trans);
+    }
+
+    void setMat3fv(const std::string &name, const glm::mat3 &mat) const {
+        setMat3fv(uniform(name), mat);
+    }
+
+    void setBool(UniformHandle handle, bool value) const {
+        glUniform1i(handle.location, (int) value);
+    }
+
+    void setInt(UniformHandle handle, int value) const {
+        glUniform1i(handle.location, value);
+    }
+
+    void setFloat(UniformHandle handle, float value) const {
+        glUniform1f(handle.location, value);
+    }
+
+    void setVec3(UniformHandle handle, float x, float y, float z) const {
+        glUniform3f(handle.location, x, y, z);
+    }
+
+    void setVec3(UniformHandle handle, glm::vec3 vec) const {
+        glUniform3f(handle.location, vec.x, vec.y, vec.z);
+    }
+
+    void setVec4(UniformHandle handle, float x, float y, float z, float w) const {
+        glUniform4f(handle.location, x, y, z, w);
+    }
+
+    void setMat4fv(UniformHandle handle, const glm::mat4 &trans) const {
+        glUniformMatrix4fv(handle.location, 1, GL_FALSE, glm::value_ptr(trans));
+    }
+
+    void setMat3fv(UniformHandle handle, const glm::mat3 &mat) const {
+        glUniformMatrix3fv(handle.location, 1, GL_FALSE, glm::value_ptr(mat));
+    }
+
+private:
+    unsigned int compile(const char* vShaderCode, const char* fShaderCode) {
+        unsigned int vertex, fragment, program;
+        vertex = getVertexShader(vShaderCode);
+        if (vertex == -1) {
+            std::cout << "Failed to init shader, vertex shader failed" << std::endl;
+        }
+        fragment = getFragmentShader(fShaderCode);
+        if (fragment == -1) {
+            std::cout << "Failed to init shader, fragment shader failed" << std::endl;
+        }
+        program = createShaderProgram(vertex, fragment);
+        if (program == -1) {
+            std::cout << "Failed to init shader, create shader program failed" << std::endl;
+        }
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        return program;
+    }
+
+    // Attaches every active block we know about to its shared binding point.
+    void bindUniformBlocks() {
+        if (ID == (unsigned int) -1) {
+            return;
+        }
+        int count = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+        for (int i = 0; i < count; i++) {
+            char name[256];
+            glGetActiveUniformBlockName(ID, i, sizeof(name), NULL, name);
+            int binding = uniformBlockBinding(name);
+            if (binding >= 0) {
+                glUniformBlockBinding(ID, i, binding);
+            }
+        }
+    }
+
+    // Walks GL_ACTIVE_UNIFORMS once so that setters never need glGetUniformLocation.
+    // Arrays are registered both as "name" and "name[i]" for every element.
+    void reflectUniforms() {
+        uniforms.clear();
+        if (ID == (unsigned int) -1) {
+            return;
+        }
+
+        int count = 0;
+        int maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+        std::vector<char> buffer(maxLength + 1);
+        for (int i = 0; i < count; i++) {
+            int length = 0;
+            int size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, i, (GLsizei) buffer.size(), &length, &size, &type, buffer.data());
+            std::string name(buffer.data(), length);
+
+            int location = glGetUniformLocation(ID, name.c_str());
+            if (location < 0) {
+                // members of uniform blocks have no location
+                continue;
+            }
+
+            if (size > 1 || (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)) {
+                std::string base = name.substr(0, name.rfind('['));
+                uniforms.push_back({base, location, type, size});
+                for (int element = 0; element < size; element++) {
+                    std::string elementName = base + "[" + std::to_string(element) + "]";
+                    uniforms.push_back({elementName, glGetUniformLocation(ID, elementName.c_str()), type, 1});
+                }
+            } else {
+                uniforms.push_back({name, location, type, size});
+            }
+        }
+
+        std::sort(uniforms.begin(), uniforms.end(), [](const UniformInfo &a, const UniformInfo &b) {
+            return a.name < b.name;
+        });
     }
 };
 
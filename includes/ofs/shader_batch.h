@@ -0,0 +1,212 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_SHADER_BATCH_H
+#define OPENGL_FROM_SCRATCH_OFS_SHADER_BATCH_H
+
+#include <string>
+#include <deque>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include <glad/glad.h>
+
+#include "ofs/shader.h"
+#include "ofs/shader_cache.h"
+#include "ofs/shader_preprocessor.h"
+#include "ofs/gl_extensions.h"
+
+// glad was generated without extensions, so GL_KHR_parallel_shader_compile is
+// declared here by hand.
+#ifndef GL_KHR_parallel_shader_compile
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+class ShaderBatch;
+
+// Handle to a program submitted to a ShaderBatch.
+struct PendingShader {
+    ShaderBatch* batch = NULL;
+    size_t index = 0;
+
+    bool ready() const;
+    Shader& get() const;
+};
+
+// Submits every compile and link up front and only asks for the results later.
+//
+// glCompileShader/glLinkProgram return immediately; it is the status queries
+// that block. With GL_KHR_parallel_shader_compile the driver compiles on its own
+// threads and ready() polls GL_COMPLETION_STATUS_KHR without stalling, so a
+// render loop can keep drawing until get() has nothing left to wait for.
+// Without the extension ready() always reports true and get() blocks as usual.
+//
+//     ShaderBatch batch(context.loader());
+//     PendingShader light = batch.add("light.vs.glsl", "light.fs.glsl");
+//     ... load textures, build buffers ...
+//     Shader &lightShader = light.get();
+class ShaderBatch {
+public:
+    bool parallel;
+
+    explicit ShaderBatch(GLADloadproc load = NULL) {
+        parallel = hasGLExtension("GL_KHR_parallel_shader_compile");
+        if (parallel && load != NULL) {
+            PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC) load("glMaxShaderCompilerThreadsKHR");
+            if (maxThreads != NULL) {
+                // let the driver pick as many threads as it likes
+                maxThreads(0xFFFFFFFF);
+            }
+        }
+    }
+
+    PendingShader add(const char* vertexPath, const char* fragmentPath, const std::string &permutationKey = "") {
+        ShaderPreprocessor preprocessor;
+        ShaderSource vertexSource;
+        ShaderSource fragmentSource;
+        if (!preprocessor.process(vertexPath, permutationKey, vertexSource) || !preprocessor.process(fragmentPath, permutationKey, fragmentSource)) {
+            std::cout << "Failed to init shader, FILE NOT SUCCESSFULLY READ: " << vertexPath << ", " << fragmentPath << std::endl;
+        }
+        return addSource(vertexSource.code, fragmentSource.code);
+    }
+
+    PendingShader addSource(const std::string &vertexCode, const std::string &fragmentCode) {
+        entries.emplace_back();
+        Entry &entry = entries.back();
+        entry.start = std::chrono::steady_clock::now();
+
+        ShaderCache &cache = ShaderCache::instance();
+        entry.key = cache.key(vertexCode, fragmentCode);
+        entry.program = glCreateProgram();
+        if (cache.load(entry.key, entry.program)) {
+            entry.cached = true;
+        } else {
+            glDeleteProgram(entry.program);
+            entry.program = glCreateProgram();
+            entry.vertex = submitShader(GL_VERTEX_SHADER, vertexCode.c_str());
+            entry.fragment = submitShader(GL_FRAGMENT_SHADER, fragmentCode.c_str());
+            glAttachShader(entry.program, entry.vertex);
+            glAttachShader(entry.program, entry.fragment);
+            if (glad_glProgramParameteri != NULL) {
+                glProgramParameteri(entry.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            }
+            glLinkProgram(entry.program);
+        }
+
+        PendingShader handle;
+        handle.batch = this;
+        handle.index = entries.size() - 1;
+        return handle;
+    }
+
+    bool ready(size_t index) const {
+        const Entry &entry = entries[index];
+        if (entry.finished || entry.cached || !parallel) {
+            return true;
+        }
+        int complete = 0;
+        glGetProgramiv(entry.program, GL_COMPLETION_STATUS_KHR, &complete);
+        return complete != 0;
+    }
+
+    Shader& get(size_t index) {
+        Entry &entry = entries[index];
+        if (!entry.finished) {
+            finish(entry);
+        }
+        return entry.shader;
+    }
+
+    // Finishes whatever the driver is done with. Returns true once nothing is pending.
+    bool poll() {
+        bool done = true;
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (entries[i].finished) {
+                continue;
+            }
+            if (ready(i)) {
+                finish(entries[i]);
+            } else {
+                done = false;
+            }
+        }
+        return done;
+    }
+
+    void wait() {
+        for (Entry &entry : entries) {
+            if (!entry.finished) {
+                finish(entry);
+            }
+        }
+    }
+
+private:
+    struct Entry {
+        Shader shader;
+        uint64_t key = 0;
+        unsigned int program = 0;
+        unsigned int vertex = 0;
+        unsigned int fragment = 0;
+        bool cached = false;
+        bool finished = false;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    // deque keeps Shader references returned by get() stable while adding
+    std::deque<Entry> entries;
+
+    unsigned int submitShader(GLenum type, const char* source) {
+        unsigned int shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, NULL);
+        glCompileShader(shader);
+        return shader;
+    }
+
+    void reportShaderLog(unsigned int shader, const char* stage) {
+        int success;
+        char infoLog[1024];
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+            std::cout << "Failed to compile " << stage << " shader: " << infoLog << std::endl;
+        }
+    }
+
+    void finish(Entry &entry) {
+        ShaderCache &cache = ShaderCache::instance();
+        unsigned int program = entry.program;
+
+        if (!entry.cached) {
+            int success;
+            char infoLog[1024];
+            glGetProgramiv(program, GL_LINK_STATUS, &success);
+            if (!success) {
+                reportShaderLog(entry.vertex, "vertex");
+                reportShaderLog(entry.fragment, "fragment");
+                glGetProgramInfoLog(program, 1024, NULL, infoLog);
+                std::cout << "Failed to link shader program: " << infoLog << std::endl;
+                glDeleteProgram(program);
+                program = -1;
+            } else {
+                cache.store(entry.key, program);
+            }
+            glDeleteShader(entry.vertex);
+            glDeleteShader(entry.fragment);
+        }
+
+        entry.shader.setProgram(program);
+        entry.finished = true;
+        cache.record(entry.cached, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - entry.start).count());
+    }
+};
+
+bool PendingShader::ready() const {
+    return batch->ready(index);
+}
+
+Shader& PendingShader::get() const {
+    return batch->get(index);
+}
+
+#endif //OPENGL_FROM_SCRATCH_OFS_SHADER_BATCH_H
@@ -0,0 +1,208 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_SHADER_CACHE_H
+#define OPENGL_FROM_SCRATCH_OFS_SHADER_CACHE_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <filesystem>
+
+#include <glad/glad.h>
+
+// On-disk cache of linked programs (glGetProgramBinary blobs).
+//
+// Entries are keyed by a hash of the final shader sources together with the
+// GL vendor, renderer and version strings, so a driver update simply misses.
+// Anything that does not load back cleanly falls back to compiling from source.
+//
+// Entries go to ./shader_cache, relative to the working directory. The demos
+// load their shaders from ../shader and so run from the build directory, which
+// puts the cache next to the binaries. OFS_SHADER_CACHE_DIR overrides the
+// directory, OFS_SHADER_CACHE=0 disables it.
+
+const uint32_t SHADER_CACHE_MAGIC = 0x4253464f; // "OFSB"
+const uint32_t SHADER_CACHE_VERSION = 1;
+
+uint64_t fnv1a64(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    const unsigned char* bytes = (const unsigned char*) data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t fnv1a64(const std::string &text, uint64_t hash = 14695981039346656037ull) {
+    // hash the terminator too so that ("ab", "c") and ("a", "bc") differ
+    return fnv1a64(text.c_str(), text.size() + 1, hash);
+}
+
+struct ShaderCacheStats {
+    int hits = 0;
+    int misses = 0;
+    double hitMs = 0.0;
+    double missMs = 0.0;
+};
+
+class ShaderCache {
+public:
+    std::string directory;
+    bool enabled;
+    ShaderCacheStats stats;
+
+    static ShaderCache& instance() {
+        static ShaderCache cache;
+        return cache;
+    }
+
+    // Program binaries need GL 4.1 or ARB_get_program_binary, and at least one
+    // binary format; llvmpipe reports none when Mesa's own disk cache is off.
+    bool supported() {
+        if (!enabled || glad_glGetProgramBinary == NULL || glad_glProgramBinary == NULL) {
+            return false;
+        }
+        if (formatCount < 0) {
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+        }
+        return formatCount > 0;
+    }
+
+    uint64_t key(const std::string &vertexCode, const std::string &fragmentCode) {
+        uint64_t hash = fnv1a64(driverString());
+        hash = fnv1a64(vertexCode, hash);
+        return fnv1a64(fragmentCode, hash);
+    }
+
+    // Loads the cached binary into an already created program object.
+    // Returns false on any mismatch, leaving the program ready for a source build.
+    bool load(uint64_t key, unsigned int program) {
+        if (!supported()) {
+            return false;
+        }
+        std::ifstream file(entryPath(key), std::ios::binary);
+        if (!file) {
+            return false;
+        }
+
+        uint32_t magic = 0, version = 0, format = 0, length = 0;
+        uint64_t storedKey = 0;
+        file.read((char*) &magic, sizeof(magic));
+        file.read((char*) &version, sizeof(version));
+        file.read((char*) &storedKey, sizeof(storedKey));
+        file.read((char*) &format, sizeof(format));
+        file.read((char*) &length, sizeof(length));
+        if (!file || magic != SHADER_CACHE_MAGIC || version != SHADER_CACHE_VERSION || storedKey != key || length == 0) {
+            return false;
+        }
+
+        std::vector<char> binary(length);
+        file.read(binary.data(), length);
+        if (!file) {
+            return false;
+        }
+
+        glProgramBinary(program, format, binary.data(), (GLsizei) length);
+        int success = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        return success != 0;
+    }
+
+    void store(uint64_t key, unsigned int program) {
+        if (!supported()) {
+            return;
+        }
+        int length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) {
+            return;
+        }
+
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, &length, &format, binary.data());
+
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        // written aside and renamed over the entry, so a crash or another
+        // process never sees a half-written binary
+        std::string path = entryPath(key);
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file) {
+                std::cout << "Failed to write shader cache entry in " << directory << std::endl;
+                return;
+            }
+
+            uint32_t format32 = format;
+            uint32_t length32 = length;
+            file.write((const char*) &SHADER_CACHE_MAGIC, sizeof(SHADER_CACHE_MAGIC));
+            file.write((const char*) &SHADER_CACHE_VERSION, sizeof(SHADER_CACHE_VERSION));
+            file.write((const char*) &key, sizeof(key));
+            file.write((const char*) &format32, sizeof(format32));
+            file.write((const char*) &length32, sizeof(length32));
+            file.write(binary.data(), length);
+            file.close();
+            if (!file) {
+                std::cout << "Failed to write shader cache entry in " << directory << std::endl;
+                std::filesystem::remove(tempPath, error);
+                return;
+            }
+        }
+        std::filesystem::rename(tempPath, path, error);
+        if (error) {
+            std::filesystem::remove(tempPath, error);
+        }
+    }
+
+    void record(bool hit, double ms) {
+        if (hit) {
+            stats.hits++;
+            stats.hitMs += ms;
+        } else {
+            stats.misses++;
+            stats.missMs += ms;
+        }
+    }
+
+    void report() const {
+        std::cout << "Shader cache: " << stats.hits << " hits (" << stats.hitMs << " ms), "
+                  << stats.misses << " misses (" << stats.missMs << " ms)" << std::endl;
+    }
+
+private:
+    std::string driver;
+    int formatCount = -1;
+
+    ShaderCache() : directory("shader_cache"), enabled(true) {
+        const char* dir = std::getenv("OFS_SHADER_CACHE_DIR");
+        if (dir != NULL && dir[0] != '\0') {
+            directory = dir;
+        }
+        const char* toggle = std::getenv("OFS_SHADER_CACHE");
+        if (toggle != NULL && std::string(toggle) == "0") {
+            enabled = false;
+        }
+    }
+
+    const std::string& driverString() {
+        if (driver.empty()) {
+            const char* vendor = (const char*) glGetString(GL_VENDOR);
+            const char* renderer = (const char*) glGetString(GL_RENDERER);
+            const char* version = (const char*) glGetString(GL_VERSION);
+            driver = std::string(vendor ? vendor : "") + "|" + (renderer ? renderer : "") + "|" + (version ? version : "");
+        }
+        return driver;
+    }
+
+    std::string entryPath(uint64_t key) const {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long) key);
+        return directory + "/" + name;
+    }
+};
+
+#endif //OPENGL_FROM_SCRATCH_OFS_SHADER_CACHE_H
@@ -0,0 +1,59 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_SHADER_PERMUTATIONS_H
+#define OPENGL_FROM_SCRATCH_OFS_SHADER_PERMUTATIONS_H
+
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <iostream>
+
+#include "ofs/shader.h"
+#include "ofs/shader_cache.h"
+#include "ofs/shader_preprocessor.h"
+
+// One compiled Shader per distinct preprocessed source.
+//
+//     ShaderPermutations permutations;
+//     Shader &spot = permutations.get("light.vs.glsl", "light.fs.glsl", "SPOT_LIGHT|SPOT_SOFT|SPECULAR_MAP");
+//
+// Keys are normalised (order and duplicates do not matter) and variants are
+// deduplicated by a hash of the final vertex + fragment source.
+class ShaderPermutations {
+public:
+    Shader& get(const char* vertexPath, const char* fragmentPath, const std::string &permutationKey = "") {
+        std::string request = std::string(vertexPath) + "\n" + fragmentPath + "\n" + joinPermutationKey(parsePermutationKey(permutationKey));
+        auto known = requests.find(request);
+        if (known != requests.end()) {
+            return *variants[known->second];
+        }
+
+        ShaderPreprocessor preprocessor;
+        ShaderSource vertexSource;
+        ShaderSource fragmentSource;
+        if (!preprocessor.process(vertexPath, permutationKey, vertexSource) || !preprocessor.process(fragmentPath, permutationKey, fragmentSource)) {
+            std::cout << "Failed to init shader, FILE NOT SUCCESSFULLY READ: " << vertexPath << ", " << fragmentPath << std::endl;
+        }
+
+        uint64_t hash = fnv1a64(fragmentSource.code, fnv1a64(vertexSource.code));
+        requests[request] = hash;
+        std::unique_ptr<Shader> &variant = variants[hash];
+        if (!variant) {
+            variant.reset(new Shader());
+            variant->build(vertexSource.code, fragmentSource.code);
+        }
+        return *variant;
+    }
+
+    size_t variantCount() const {
+        return variants.size();
+    }
+
+    size_t requestCount() const {
+        return requests.size();
+    }
+
+private:
+    std::unordered_map<std::string, uint64_t> requests;
+    std::unordered_map<uint64_t, std::unique_ptr<Shader>> variants;
+};
+
+#endif //OPENGL_FROM_SCRATCH_OFS_SHADER_PERMUTATIONS_H
@@ -0,0 +1,190 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_SHADER_PREPROCESSOR_H
+#define OPENGL_FROM_SCRATCH_OFS_SHADER_PREPROCESSOR_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+
+#include "ofs/asset_pack.h"
+
+// Source-level preprocessing done before GLSL ever reaches the driver:
+//
+//   #include "relative/path.glsl"   resolved against the including file, each
+//                                   file is pulled in at most once
+//   permutation keys                "POINT_LIGHT|SPOT_SOFT|SPECULAR_MAP" become
+//                                   #define lines right after #version
+//
+// Every define of the key is injected, including ones only used as values
+// (N=64 in "const int count = N;"), whether or not the source tests them.
+//
+// #line directives keep driver error messages pointing at the right line; the
+// source-string number is the index into ShaderSource::files.
+
+// Served from the mounted asset pack when it has path.
+bool readShaderFile(const char* path, std::string &code) {
+    const AssetPackEntry* packed = AssetPack::instance().find(path, ASSET_SHADER);
+    if (packed != NULL) {
+        AssetSpan span = AssetPack::instance().data(*packed);
+        code.assign((const char*) span.data, span.size);
+        return true;
+    }
+    std::ifstream file;
+    file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    try {
+        file.open(path);
+        std::stringstream stream;
+        stream << file.rdbuf();
+        file.close();
+        code = stream.str();
+    } catch (std::ifstream::failure& e) {
+        return false;
+    }
+    return true;
+}
+
+// Splits "A|B=2|A" into the sorted, de-duplicated list {"A", "B=2"}.
+std::vector<std::string> parsePermutationKey(const std::string &key) {
+    std::vector<std::string> defines;
+    std::stringstream stream(key);
+    std::string token;
+    while (std::getline(stream, token, '|')) {
+        token.erase(0, token.find_first_not_of(" \t"));
+        token.erase(token.find_last_not_of(" \t") + 1);
+        if (!token.empty()) {
+            defines.push_back(token);
+        }
+    }
+    std::sort(defines.begin(), defines.end());
+    defines.erase(std::unique(defines.begin(), defines.end()), defines.end());
+    return defines;
+}
+
+std::string joinPermutationKey(const std::vector<std::string> &defines) {
+    std::string key;
+    for (const std::string &define : defines) {
+        if (!key.empty()) {
+            key += "|";
+        }
+        key += define;
+    }
+    return key;
+}
+
+struct ShaderSource {
+    std::string code;
+    std::vector<std::string> files;
+    // defines from the key, sorted and de-duplicated
+    std::vector<std::string> defines;
+};
+
+class ShaderPreprocessor {
+public:
+    bool process(const std::string &path, const std::string &permutationKey, ShaderSource &source) {
+        source = ShaderSource();
+        std::vector<std::string> lines;
+        if (!expand(std::filesystem::path(path).lexically_normal(), source.files, lines)) {
+            return false;
+        }
+
+        source.defines = parsePermutationKey(permutationKey);
+
+        size_t versionLine = lines.size();
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (directive(lines[i]) == "version") {
+                versionLine = i;
+                break;
+            }
+        }
+
+        std::string code;
+        for (size_t i = 0; i < lines.size(); i++) {
+            code += lines[i];
+            code += '\n';
+            if (i == versionLine) {
+                for (const std::string &define : source.defines) {
+                    size_t equals = define.find('=');
+                    if (equals == std::string::npos) {
+                        code += "#define " + define + " 1\n";
+                    } else {
+                        code += "#define " + define.substr(0, equals) + " " + define.substr(equals + 1) + "\n";
+                    }
+                }
+                if (!source.defines.empty()) {
+                    code += "#line " + std::to_string(i + 2) + " 0\n";
+                }
+            }
+        }
+        source.code = code;
+        return true;
+    }
+
+private:
+    // Returns the directive name of a preprocessor line ("include", "version", ...).
+    static std::string directive(const std::string &line) {
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line[start] != '#') {
+            return "";
+        }
+        start = line.find_first_not_of(" \t", start + 1);
+        if (start == std::string::npos) {
+            return "";
+        }
+        size_t end = start;
+        while (end < line.size() && (isalnum((unsigned char) line[end]) || line[end] == '_')) {
+            end++;
+        }
+        return line.substr(start, end - start);
+    }
+
+    bool expand(const std::filesystem::path &path, std::vector<std::string> &files, std::vector<std::string> &out) {
+        std::string text;
+        if (!readShaderFile(path.string().c_str(), text)) {
+            std::cout << "Failed to read shader source: " << path.string() << std::endl;
+            return false;
+        }
+        int fileIndex = (int) files.size();
+        files.push_back(path.string());
+
+        std::stringstream stream(text);
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(stream, line)) {
+            lineNumber++;
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            std::string name = directive(line);
+            if (name == "version" && fileIndex != 0) {
+                // only the top level file decides the version
+                out.push_back("");
+                continue;
+            }
+            if (name != "include") {
+                out.push_back(line);
+                continue;
+            }
+
+            size_t open = line.find_first_of("\"<");
+            size_t close = open == std::string::npos ? std::string::npos : line.find_first_of("\">", open + 1);
+            if (close == std::string::npos) {
+                std::cout << path.string() << ":" << lineNumber << ": malformed #include" << std::endl;
+                return false;
+            }
+            std::filesystem::path included = (path.parent_path() / line.substr(open + 1, close - open - 1)).lexically_normal();
+            if (std::find(files.begin(), files.end(), included.string()) == files.end()) {
+                out.push_back("#line 1 " + std::to_string(files.size()));
+                if (!expand(included, files, out)) {
+                    return false;
+                }
+            }
+            out.push_back("#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex));
+        }
+        return true;
+    }
+};
+
+#endif //OPENGL_FROM_SCRATCH_OFS_SHADER_PREPROCESSOR_H
@@ -0,0 +1,589 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_SHADOWS_H
+#define OPENGL_FROM_SCRATCH_OFS_SHADOWS_H
+
+#include <cstddef>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "ofs/shader.h"
+#include "ofs/camera.h"
+#include "ofs/uniform_buffer.h"
+#include "ofs/gl_state_cache.h"
+
+// The light caster demos cast shadows unless given --no-shadows.
+bool shadowsEnabled(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--no-shadows") {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A square region of the ShadowAtlas, in texels; size 0 when none was free.
+struct ShadowPage {
+    int x = 0;
+    int y = 0;
+    int size = 0;
+
+    bool valid() const {
+        return size > 0;
+    }
+};
+
+// One DEPTH_COMPONENT24 texture holding the shadow maps of every light, so
+// the lighting shaders sample a single texture however many lights cast.
+// Pages are power of two squares handed out buddy style: a free page of the
+// level above is split in four when a level runs out, and four free buddies
+// merge again when released. The texture compares depths when sampled
+// (sampler2DShadow) and filters them linearly.
+//
+// The static cache is a second texture of the same layout, created on first
+// use, for lights that also have dynamic casters: the static casters are
+// rendered there once and each frame starts by copying them over.
+class ShadowAtlas {
+public:
+    // after the material maps, ClusteredLights and the GBuffer
+    static const unsigned int DEFAULT_UNIT = 11;
+
+    // framebuffer with the atlas as its depth attachment
+    unsigned int ID = 0;
+    unsigned int depth = 0;
+    int size;
+    int minPageSize;
+
+    explicit ShadowAtlas(int size = 4096, int minPageSize = 128) : size(size), minPageSize(minPageSize) {
+        createTarget(ID, depth);
+        for (int pageSize = size; pageSize >= minPageSize; pageSize /= 2) {
+            freePages.emplace_back();
+        }
+        freePages[0].push_back(glm::ivec2(0, 0));
+    }
+
+    ~ShadowAtlas() {
+        GLStateCache &state = GLStateCache::instance();
+        state.deleteFramebuffers(1, &ID);
+        state.deleteTextures(1, &depth);
+        if (cacheID != 0) {
+            state.deleteFramebuffers(1, &cacheID);
+            state.deleteTextures(1, &cacheDepth);
+        }
+    }
+
+    ShadowAtlas(const ShadowAtlas&) = delete;
+    ShadowAtlas& operator=(const ShadowAtlas&) = delete;
+
+    // A page of at least pageSize texels, rounded up to a power of two and
+    // clamped to [minPageSize, size], or an invalid one if none is free.
+    ShadowPage allocate(int pageSize) {
+        int level = levelOf(pageSize);
+        int from = level;
+        while (from >= 0 && freePages[from].empty()) {
+            from--;
+        }
+        if (from < 0) {
+            return ShadowPage();
+        }
+        glm::ivec2 origin = freePages[from].back();
+        freePages[from].pop_back();
+        // keep the first quarter of every split, free the other three
+        while (from < level) {
+            from++;
+            int half = size >> from;
+            freePages[from].push_back(origin + glm::ivec2(half, half));
+            freePages[from].push_back(origin + glm::ivec2(0, half));
+            freePages[from].push_back(origin + glm::ivec2(half, 0));
+        }
+        ShadowPage page;
+        page.x = origin.x;
+        page.y = origin.y;
+        page.size = size >> level;
+        return page;
+    }
+
+    void release(const ShadowPage &page) {
+        if (!page.valid()) {
+            return;
+        }
+        int level = levelOf(page.size);
+        glm::ivec2 origin(page.x, page.y);
+        while (level > 0) {
+            int parentSize = size >> (level - 1);
+            int half = parentSize / 2;
+            glm::ivec2 parent = origin / parentSize * parentSize;
+            std::vector<glm::ivec2> &free = freePages[level];
+            std::vector<glm::ivec2> buddies;
+            for (const glm::ivec2 &offset : {glm::ivec2(0, 0), glm::ivec2(half, 0), glm::ivec2(0, half), glm::ivec2(half, half)}) {
+                if (parent + offset != origin) {
+                    buddies.push_back(parent + offset);
+                }
+            }
+            bool merge = true;
+            for (const glm::ivec2 &buddy : buddies) {
+                merge = merge && std::find(free.begin(), free.end(), buddy) != free.end();
+            }
+            if (!merge) {
+                break;
+            }
+            for (const glm::ivec2 &buddy : buddies) {
+                free.erase(std::find(free.begin(), free.end(), buddy));
+            }
+            origin = parent;
+            level--;
+        }
+        freePages[level].push_back(origin);
+    }
+
+    int freeTexels() const {
+        int texels = 0;
+        for (size_t level = 0; level < freePages.size(); level++) {
+            int pageSize = size >> level;
+            texels += (int) freePages[level].size() * pageSize * pageSize;
+        }
+        return texels;
+    }
+
+    size_t bytes() const {
+        // DEPTH_COMPONENT24 is padded to 4 bytes, twice with the static cache
+        return (size_t) size * size * 4 * (cacheID != 0 ? 2 : 1);
+    }
+
+    // Where page lies in uv: offset in xy, scale in zw.
+    glm::vec4 uvRect(const ShadowPage &page) const {
+        return glm::vec4(page.x, page.y, page.size, page.size) / (float) size;
+    }
+
+    // Binds the atlas, or the static cache, and clears page for rendering
+    // into. Leaves the scissor test on.
+    void beginPage(const ShadowPage &page, bool staticCache = false) {
+        GLStateCache &state = GLStateCache::instance();
+        if (staticCache && cacheID == 0) {
+            createTarget(cacheID, cacheDepth);
+        }
+        state.bindFramebuffer(GL_FRAMEBUFFER, staticCache ? cacheID : ID);
+        glViewport(page.x, page.y, page.size, page.size);
+        glScissor(page.x, page.y, page.size, page.size);
+        state.enable(GL_SCISSOR_TEST);
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+
+    // Copies page from the static cache into the atlas and leaves the atlas
+    // bound, with viewport and scissor on the page.
+    void copyFromCache(const ShadowPage &page) {
+        GLStateCache &state = GLStateCache::instance();
+        state.bindFramebuffer(GL_READ_FRAMEBUFFER, cacheID);
+        state.bindFramebuffer(GL_DRAW_FRAMEBUFFER, ID);
+        glViewport(page.x, page.y, page.size, page.size);
+        glScissor(page.x, page.y, page.size, page.size);
+        state.enable(GL_SCISSOR_TEST);
+        int x1 = page.x + page.size;
+        int y1 = page.y + page.size;
+        glBlitFramebuffer(page.x, page.y, x1, y1, page.x, page.y, x1, y1, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        state.bindFramebuffer(GL_FRAMEBUFFER, ID);
+    }
+
+    // Points the shadowAtlas sampler of shader/common/shadows.glsl at unit.
+    void attach(Shader &shader, unsigned int unit = DEFAULT_UNIT) const {
+        shader.use();
+        shader.setInt("shadowAtlas", unit);
+    }
+
+    void bindTexture(unsigned int unit = DEFAULT_UNIT) const {
+        GLStateCache::instance().bindTexture(unit, GL_TEXTURE_2D, depth);
+    }
+
+private:
+    unsigned int cacheID = 0;
+    unsigned int cacheDepth = 0;
+    // free page origins per level, level 0 being the whole atlas
+    std::vector<std::vector<glm::ivec2>> freePages;
+
+    int levelOf(int pageSize) const {
+        int level = 0;
+        for (int levelSize = size; levelSize / 2 >= std::max(pageSize, minPageSize); levelSize /= 2) {
+            level++;
+        }
+        return level;
+    }
+
+    void createTarget(unsigned int &framebuffer, unsigned int &texture) {
+        GLStateCache &state = GLStateCache::instance();
+        glGenTextures(1, &texture);
+        // on the atlas's own unit, the material maps may be bound already
+        state.bindTexture(DEFAULT_UNIT, GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, size, size, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+        glGenFramebuffers(1, &framebuffer);
+        unsigned int previous = state.boundReadFramebuffer();
+        state.bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cout << "Failed to create the shadow atlas" << std::endl;
+        }
+        // a fresh page compares as lit everywhere
+        glClear(GL_DEPTH_BUFFER_BIT);
+        state.bindFramebuffer(GL_FRAMEBUFFER, previous);
+    }
+};
+
+// ShadowType values match the SHADOW_ constants of shader/common/shadows.glsl.
+enum ShadowType {
+    SHADOW_NONE = 0,
+    SHADOW_DIRECTIONAL = 1,
+    SHADOW_POINT = 2,
+    SHADOW_SPOT = 3,
+};
+
+struct ShadowLight {
+    ShadowType type = SHADOW_DIRECTIONAL;
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 direction = glm::vec3(0.0f, -1.0f, 0.0f);
+    // point and spot lights: near and far plane of the maps; the light's
+    // attenuationRadius() (ofs/light_bounds.h) is a natural far plane
+    float zNear = 0.1f;
+    float range = 25.0f;
+    // spot lights: cosine of the cone's half angle, cutOff of a hard edged
+    // light, outerCutOff of a soft edged one
+    float coneCos = 0.9f;
+    // texels along the edge of each of the light's pages; halved while the
+    // atlas has no room for them
+    int resolution = 1024;
+};
+
+// Shadow maps for directional, point and spot lights in one ShadowAtlas:
+//
+//   directional  cascades, up to 4 orthographic maps covering slices of the
+//                camera's frustum out to shadowDistance
+//   point        the six faces of a cube map, each a 90 degree perspective
+//                map on a page of its own
+//   spot         one perspective map over the cone
+//
+// Each light gets its pages once, from its resolution budget, when added.
+// A page is rendered again only when its view has changed or the static
+// casters have (invalidateStatic()), so lights and cameras that keep still
+// cost nothing per frame. The cascades are fitted stably for the same
+// reason: each covers the bounding sphere of its slice of the frustum, whose
+// size does not change as the camera turns, in a light space that only
+// moves in whole texels.
+//
+//     Shadows shadows;
+//     int sun = shadows.add(light);
+//     shadows.attach(lightShader);
+//     while (...) {
+//         shadows.setCamera(camera, aspect, zNear, zFar);
+//         shadows.render([&](const glm::mat4&) { ... draw the casters ... });
+//         ... rebind the scene's framebuffer ...
+//         shadows.bind(sun);
+//         ... draw with the SHADOWS permutation of shader/lighting/light.fs.glsl ...
+//     }
+//
+// Casters draw with shader/lighting/shadow.vs.glsl, already in use when the
+// callback runs; its INSTANCED permutation unless permutationKey says
+// otherwise.
+class Shadows {
+public:
+    typedef std::function<void(const glm::mat4 &lightViewProjection)> DrawCasters;
+
+    ShadowAtlas atlas;
+    // cascades per directional light, at most 4, set before add()
+    int cascades = 4;
+    // 0 splits the frustum evenly, 1 logarithmically
+    float cascadeSplitLambda = 0.75f;
+    // how far from the camera the cascades reach
+    float shadowDistance = 40.0f;
+    // how far towards the light of a cascade casters are looked for
+    float casterDistance = 30.0f;
+    // receivers are looked up this many texels along their normal
+    float normalOffset = 1.5f;
+    // glPolygonOffset of the casters
+    float slopeBias = 2.0f;
+    float constantBias = 4.0f;
+
+    // pages of the last render(), and totals since construction
+    int pagesRendered = 0;
+    int pagesCached = 0;
+    long totalRendered = 0;
+    long totalCached = 0;
+    int frames = 0;
+
+    explicit Shadows(int atlasSize = 4096, const std::string &permutationKey = "INSTANCED")
+            : atlas(atlasSize),
+              casterShader("../shader/lighting/shadow.vs.glsl", "../shader/lighting/depth.fs.glsl", permutationKey),
+              block(SHADOW_BLOCK_BINDING) {
+        lightViewProjectionUniform = casterShader.uniform("lightViewProjection");
+    }
+
+    Shadows(const Shadows&) = delete;
+    Shadows& operator=(const Shadows&) = delete;
+
+    // Allocates the light's pages and returns its handle. If the atlas has no
+    // room at light.resolution the budget is halved until it does; a light
+    // that fits nowhere is kept but casts no shadows.
+    int add(const ShadowLight &light) {
+        Entry entry;
+        entry.light = light;
+        entry.views = light.type == SHADOW_DIRECTIONAL ? std::min(std::max(cascades, 1), 4) : light.type == SHADOW_POINT ? 6 : 1;
+        for (int resolution = light.resolution; resolution >= atlas.minPageSize; resolution /= 2) {
+            bool fits = true;
+            for (int i = 0; i < entry.views && fits; i++) {
+                entry.pages[i] = atlas.allocate(resolution);
+                fits = entry.pages[i].valid();
+            }
+            if (fits) {
+                entry.resolution = entry.pages[0].size;
+                break;
+            }
+            for (int i = 0; i < entry.views; i++) {
+                atlas.release(entry.pages[i]);
+                entry.pages[i] = ShadowPage();
+            }
+        }
+        if (entry.resolution == 0) {
+            std::cout << "No room in the shadow atlas for " << entry.views << " pages of " << atlas.minPageSize << " texels" << std::endl;
+        } else if (entry.resolution < light.resolution) {
+            std::cout << "Shadow pages of " << light.resolution << " texels reduced to " << entry.resolution << std::endl;
+        }
+        entries.push_back(entry);
+        return (int) entries.size() - 1;
+    }
+
+    // The light's pages go back to the atlas.
+    void remove(int handle) {
+        Entry &entry = entries[handle];
+        for (int i = 0; i < entry.views; i++) {
+            atlas.release(entry.pages[i]);
+            entry.pages[i] = ShadowPage();
+        }
+        entry.resolution = 0;
+    }
+
+    // Move or turn the light through here; its pages follow on render().
+    ShadowLight& light(int handle) {
+        return entries[handle].light;
+    }
+
+    // Texels along the edge of the light's pages, 0 if it got none.
+    int resolution(int handle) const {
+        return entries[handle].resolution;
+    }
+
+    // The frustum the cascades of directional lights cover, out to the
+    // nearer of zFar and shadowDistance.
+    void setCamera(const glm::mat4 &view, float fovY, float aspect, float zNear, float zFar) {
+        cameraView = view;
+        cameraFovY = fovY;
+        cameraAspect = aspect;
+        cameraNear = zNear;
+        cameraFar = std::min(zFar, shadowDistance);
+    }
+
+    void setCamera(const Camera &camera, float aspect, float zNear, float zFar) {
+        glm::mat4 view = glm::lookAt(camera.Position, camera.Position + camera.Front, camera.Up);
+        setCamera(view, glm::radians(camera.Zoom), aspect, zNear, zFar);
+    }
+
+    // Something static casters draw has changed; every page renders again.
+    void invalidateStatic() {
+        staticVersion++;
+    }
+
+    // Brings every light's pages up to date. drawStatic draws the casters
+    // that do not move, drawDynamic (if any) those that do: the pages then
+    // keep the static casters in the atlas's static cache, and every frame
+    // copies them over and adds the dynamic ones. The scene's framebuffer is
+    // left unbound, the viewport as it was.
+    void render(const DrawCasters &drawStatic, const DrawCasters &drawDynamic = DrawCasters()) {
+        GLStateCache &state = GLStateCache::instance();
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        pagesRendered = 0;
+        pagesCached = 0;
+        frames++;
+
+        state.enable(GL_DEPTH_TEST);
+        state.depthFunc(GL_LESS);
+        state.depthMask(true);
+        state.enable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(slopeBias, constantBias);
+        casterShader.use();
+        for (Entry &entry : entries) {
+            if (entry.resolution == 0) {
+                continue;
+            }
+            updateViews(entry);
+            for (int i = 0; i < entry.views; i++) {
+                const glm::mat4 &viewProjection = entry.block.viewProjection[i];
+                bool stale = entry.version[i] != staticVersion || entry.rendered[i] != viewProjection
+                             || entry.inStaticCache[i] != (bool) drawDynamic;
+                if (stale) {
+                    atlas.beginPage(entry.pages[i], (bool) drawDynamic);
+                    casterShader.setMat4fv(lightViewProjectionUniform, viewProjection);
+                    drawStatic(viewProjection);
+                    entry.rendered[i] = viewProjection;
+                    entry.version[i] = staticVersion;
+                    entry.inStaticCache[i] = (bool) drawDynamic;
+                    pagesRendered++;
+                } else {
+                    pagesCached++;
+                }
+                if (drawDynamic) {
+                    atlas.copyFromCache(entry.pages[i]);
+                    casterShader.setMat4fv(lightViewProjectionUniform, viewProjection);
+                    drawDynamic(viewProjection);
+                }
+            }
+        }
+        state.disable(GL_POLYGON_OFFSET_FILL);
+        state.disable(GL_SCISSOR_TEST);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        totalRendered += pagesRendered;
+        totalCached += pagesCached;
+    }
+
+    // Points shader's shadowAtlas sampler at unit.
+    void attach(Shader &shader, unsigned int unit = ShadowAtlas::DEFAULT_UNIT) const {
+        atlas.attach(shader, unit);
+    }
+
+    // Uploads the light's ShadowBlock and binds the atlas, for shading with
+    // that light; the block is as of the last render().
+    void bind(int handle, unsigned int unit = ShadowAtlas::DEFAULT_UNIT) {
+        block.data = entries[handle].block;
+        block.upload();
+        atlas.bindTexture(unit);
+    }
+
+    void report() const {
+        long pages = totalRendered + totalCached;
+        std::cout << "Shadows: " << entries.size() << " lights, atlas " << atlas.size << "x" << atlas.size << " ("
+                  << atlas.bytes() / (1024 * 1024) << " MB, " << (100 - 100L * atlas.freeTexels() / ((long) atlas.size * atlas.size))
+                  << "% allocated), " << totalRendered << " of " << pages << " pages rendered over " << frames << " frames, "
+                  << totalCached << " cached" << std::endl;
+    }
+
+private:
+    struct Entry {
+        ShadowLight light;
+        int views = 0;
+        int resolution = 0;
+        ShadowPage pages[6];
+        // the views the pages were last rendered with, and for which static
+        // casters
+        glm::mat4 rendered[6];
+        unsigned int version[6] = {0, 0, 0, 0, 0, 0};
+        // rendered into the static cache rather than the atlas
+        bool inStaticCache[6] = {false, false, false, false, false, false};
+        ShadowBlock block = ShadowBlock();
+    };
+
+    Shader casterShader;
+    UniformHandle lightViewProjectionUniform;
+    UniformBuffer<ShadowBlock> block;
+    std::vector<Entry> entries;
+    // pages start out stale
+    unsigned int staticVersion = 1;
+
+    glm::mat4 cameraView = glm::mat4(1.0f);
+    float cameraFovY = glm::radians(45.0f);
+    float cameraAspect = 1.0f;
+    float cameraNear = 0.1f;
+    float cameraFar = 40.0f;
+
+    static glm::vec3 upFor(const glm::vec3 &direction) {
+        return std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+
+    void updateViews(Entry &entry) {
+        const ShadowLight &light = entry.light;
+        ShadowBlock &data = entry.block;
+        data.info = glm::ivec4(light.type, entry.views, 0, 0);
+        data.params = glm::vec4(normalOffset, 1.0f / atlas.size, 0.0f, 0.0f);
+        data.lightPosition = glm::vec4(light.position, 1.0f);
+        for (int i = 0; i < entry.views; i++) {
+            data.pages[i] = atlas.uvRect(entry.pages[i]);
+        }
+        if (light.type == SHADOW_DIRECTIONAL) {
+            fitCascades(entry);
+        } else if (light.type == SHADOW_POINT) {
+            // cube map faces in the usual order, the ups are the cube map
+            // convention though any would do
+            static const glm::vec3 faces[6][2] = {
+                    {glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)},
+                    {glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)},
+                    {glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)},
+                    {glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)},
+                    {glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)},
+                    {glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f)},
+            };
+            glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, light.zNear, light.range);
+            for (int i = 0; i < 6; i++) {
+                data.viewProjection[i] = projection * glm::lookAt(light.position, light.position + faces[i][0], faces[i][1]);
+            }
+            // a face spans twice its distance from the light
+            data.texelSizes = glm::vec4(2.0f / entry.resolution);
+        } else if (light.type == SHADOW_SPOT) {
+            glm::vec3 direction = glm::normalize(light.direction);
+            // the cone plus a little, for the filter's taps along its edge
+            float fov = std::min(2.0f * std::acos(glm::clamp(light.coneCos, 0.0f, 1.0f)) + glm::radians(2.0f), glm::radians(170.0f));
+            glm::mat4 projection = glm::perspective(fov, 1.0f, light.zNear, light.range);
+            data.viewProjection[0] = projection * glm::lookAt(light.position, light.position + direction, upFor(direction));
+            data.texelSizes = glm::vec4(2.0f * std::tan(fov / 2.0f) / entry.resolution);
+        }
+    }
+
+    void fitCascades(Entry &entry) {
+        ShadowBlock &data = entry.block;
+        glm::vec3 direction = glm::normalize(entry.light.direction);
+        // turns only, so a texel step in light space is one in the world too
+        glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), direction, upFor(direction));
+        glm::mat4 inverseCameraView = glm::inverse(cameraView);
+        float tanY = std::tan(cameraFovY / 2.0f);
+        float tanX = tanY * cameraAspect;
+        // squared distance from the view axis of a corner, per unit of depth
+        float corner = tanX * tanX + tanY * tanY;
+
+        float splitNear = cameraNear;
+        for (int i = 0; i < entry.views; i++) {
+            // "practical split scheme", a blend of even and logarithmic splits
+            float t = (float) (i + 1) / entry.views;
+            float logarithmic = cameraNear * std::pow(cameraFar / cameraNear, t);
+            float uniform = cameraNear + (cameraFar - cameraNear) * t;
+            float splitFar = cascadeSplitLambda * logarithmic + (1.0f - cascadeSplitLambda) * uniform;
+
+            // smallest sphere through the slice's corners, centered on the
+            // view axis where near and far corners are equally far away
+            float center = std::min((splitNear + splitFar) * (1.0f + corner) / 2.0f, splitFar);
+            float radius = std::sqrt((splitFar - center) * (splitFar - center) + splitFar * splitFar * corner);
+            // rounded up so float noise does not change it from frame to frame
+            radius = std::ceil(radius * 16.0f) / 16.0f;
+
+            glm::vec3 lightCenter = glm::vec3(lightView * inverseCameraView * glm::vec4(0.0f, 0.0f, -center, 1.0f));
+            float texel = 2.0f * radius / entry.resolution;
+            lightCenter = glm::floor(lightCenter / texel) * texel;
+            glm::mat4 projection = glm::ortho(lightCenter.x - radius, lightCenter.x + radius, lightCenter.y - radius, lightCenter.y + radius,
+                                              -lightCenter.z - radius - casterDistance, -lightCenter.z + radius);
+            data.viewProjection[i] = projection * lightView;
+            data.cascadeSplits[i] = splitFar;
+            data.texelSizes[i] = texel;
+            splitNear = splitFar;
+        }
+    }
+};
+
+#endif //OPENGL_FROM_SCRATCH_OFS_SHADOWS_H
@@ -0,0 +1,425 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_TEXTURE_CACHE_H
+#define OPENGL_FROM_SCRATCH_OFS_TEXTURE_CACHE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <algorithm>
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include "ofs/shader_cache.h"
+#include "ofs/mipmap.h"
+#include "ofs/ktx2.h"
+#include "ofs/asset_pack.h"
+#include "ofs/profiler.h"
+#include "ofs/gl_state_cache.h"
+
+// Pixel format of an 8-bit image with channels components, or GL_NONE for
+// channel counts outside 1-4.
+GLenum textureFormat(int channels) {
+    switch (channels) {
+        case 1: return GL_RED;
+        case 2: return GL_RG;
+        case 3: return GL_RGB;
+        case 4: return GL_RGBA;
+        default: return GL_NONE;
+    }
+}
+
+GLenum textureInternalFormat(int channels) {
+    switch (channels) {
+        case 1: return GL_R8;
+        case 2: return GL_RG8;
+        case 3: return GL_RGB8;
+        case 4: return GL_RGBA8;
+        default: return GL_NONE;
+    }
+}
+
+// Specifies texture as a repeating, trilinear 2D texture from a mip chain built
+// by buildMipChain(). Storage is immutable where glTexStorage2D exists (GL 4.2);
+// older contexts get every level with glTexImage2D and a clamped max level.
+// chain may be an offset into the bound GL_PIXEL_UNPACK_BUFFER. Does nothing
+// for channel counts textureFormat() has no format for; callers reject those.
+void uploadMipChain(unsigned int texture, const unsigned char* chain, int width, int height, int channels) {
+    GLenum format = textureFormat(channels);
+    if (format == GL_NONE) {
+        return;
+    }
+    int levels = mipLevelCount(width, height);
+    GLStateCache::instance().bindTexture(GL_TEXTURE_2D, texture);
+    if (GLAD_GL_VERSION_4_2) {
+        glTexStorage2D(GL_TEXTURE_2D, levels, textureInternalFormat(channels), width, height);
+    } else {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    }
+    // rows of 1- and 3-channel images are not always 4-byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int level = 0; level < levels; level++) {
+        if (GLAD_GL_VERSION_4_2) {
+            glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, format, GL_UNSIGNED_BYTE, chain);
+        } else {
+            glTexImage2D(GL_TEXTURE_2D, level, textureInternalFormat(channels), width, height, 0, format, GL_UNSIGNED_BYTE, chain);
+        }
+        chain += (size_t) width * height * channels;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+// Copies decoded level 0 pixels into a new mip chain.
+std::vector<unsigned char> createMipChain(const unsigned char* data, int width, int height, int channels) {
+    std::vector<unsigned char> chain(mipChainSize(width, height, channels));
+    std::copy(data, data + (size_t) width * height * channels, chain.begin());
+    buildMipChain(chain.data(), width, height, channels);
+    return chain;
+}
+
+// Specifies texture as a mipmapped, repeating 2D texture from decoded 8-bit
+// pixels; the smaller levels are built on the CPU.
+void uploadTexture2D(unsigned int texture, const unsigned char* data, int width, int height, int channels) {
+    std::vector<unsigned char> chain = createMipChain(data, width, height, channels);
+    uploadMipChain(texture, chain.data(), width, height, channels);
+}
+
+unsigned int createTexture2D(const unsigned char* data, int width, int height, int channels) {
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    uploadTexture2D(texture, data, width, height, channels);
+    return texture;
+}
+
+// Hash the cache keys decoded images by: the file bytes plus the flip flag.
+uint64_t textureContentHash(const std::vector<unsigned char> &bytes, bool flipVertically) {
+    uint64_t hash = fnv1a64(bytes.data(), bytes.size());
+    return fnv1a64(&flipVertically, sizeof(flipVertically), hash);
+}
+
+// estimate: RGB is stored as RGBA by most drivers, plus a third for mips
+size_t textureResidentBytes(int width, int height, int channels) {
+    return (size_t) width * height * (channels == 3 ? 4 : channels) * 4 / 3;
+}
+
+// A texture ofs_cook put into the asset pack: its whole mip chain, ready to
+// upload straight from the mapping.
+struct PackedTexture {
+    AssetSpan chain;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    // 0 for 8-bit pixels, otherwise the KTX2 block format
+    uint32_t vkFormat = 0;
+    uint64_t hash = 0;
+};
+
+// False unless the mounted pack has path cooked with this flip in a format
+// the GPU can sample.
+bool findPackedTexture(const std::string &path, bool flipVertically, PackedTexture &packed) {
+    const AssetPackEntry* entry = AssetPack::instance().find(path, ASSET_TEXTURE, flipVertically ? ASSET_FLIP_VERTICALLY : 0);
+    if (entry == NULL || (entry->params[3] != 0 && !compressedFormatSupported(entry->params[3]))) {
+        return false;
+    }
+    if (entry->params[3] == 0 && textureFormat((int) entry->params[2]) == GL_NONE) {
+        return false;
+    }
+    int width = (int) entry->params[0];
+    int height = (int) entry->params[1];
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+    size_t chainSize = entry->params[3] == 0 ? mipChainSize(width, height, (int) entry->params[2])
+                                             : compressedChainSize(entry->params[3], width, height);
+    if (chainSize > entry->size) {
+        std::cout << "Asset pack entry for " << path << " is smaller than its mip chain, loading the source instead" << std::endl;
+        return false;
+    }
+    packed.chain = AssetPack::instance().data(*entry);
+    packed.width = width;
+    packed.height = height;
+    packed.channels = (int) entry->params[2];
+    packed.vkFormat = entry->params[3];
+    packed.hash = entry->contentHash;
+    return true;
+}
+
+void uploadPackedTexture(unsigned int texture, const PackedTexture &packed) {
+    if (packed.vkFormat == 0) {
+        uploadMipChain(texture, packed.chain.data, packed.width, packed.height, packed.channels);
+    } else {
+        uploadCompressedChain(texture, packed.vkFormat, packed.chain.data, packed.width, packed.height,
+                              mipLevelCount(packed.width, packed.height));
+    }
+}
+
+size_t packedResidentBytes(const PackedTexture &packed) {
+    return packed.vkFormat == 0 ? textureResidentBytes(packed.width, packed.height, packed.channels) : packed.chain.size;
+}
+
+struct TextureCacheStats {
+    int hits = 0;
+    // hits found by content hash under a different path
+    int contentHits = 0;
+    int misses = 0;
+    // misses served from a block-compressed KTX2 file
+    int compressed = 0;
+    // misses served from the asset pack without decoding
+    int packed = 0;
+    double decodeMs = 0.0;
+    size_t residentBytes = 0;
+};
+
+// Reference-counted registry of image textures.
+//
+// acquire() first looks the canonical path up, then the hash of the file
+// bytes, so the same image reached through another path or copied under a
+// different name still maps to one GL texture and is decoded once. Every
+// acquire() needs a matching release(); the texture is deleted with the last one.
+//
+// KTX2 files are uploaded block-compressed. When an image has a .ktx2 sibling
+// written by ofs_ktx2_encode, that one is used instead as long as it is not
+// older than the image, the GPU supports its format and its row order matches
+// flipVertically. Images cooked into the mounted asset pack come from there
+// ahead of both.
+//
+//     unsigned int diffuse = TextureCache::instance().acquire("../resources/wood_container.png");
+//     ...
+//     TextureCache::instance().release(diffuse);
+class TextureCache {
+public:
+    TextureCacheStats stats;
+
+    static TextureCache& instance() {
+        static TextureCache cache;
+        return cache;
+    }
+
+    // Returns 0 if the file cannot be read or decoded.
+    unsigned int acquire(const std::string &path, bool flipVertically = true) {
+        OFS_PROFILE_ZONE("acquire texture");
+        PackedTexture packed;
+        if (findPackedTexture(path, flipVertically, packed)) {
+            return loadPacked(path, flipVertically, packed);
+        }
+        std::string sibling = freshKtx2Sibling(path);
+        if (!sibling.empty()) {
+            unsigned int texture = load(sibling, flipVertically, true);
+            if (texture != 0) {
+                return texture;
+            }
+        }
+        return load(path, flipVertically, false);
+    }
+
+    // Cache key of path: canonical form plus the flip, which changes the pixels.
+    static std::string keyFor(const std::string &path, bool flipVertically) {
+        std::error_code error;
+        std::string canonical = std::filesystem::weakly_canonical(path, error).string();
+        if (error) {
+            canonical = path;
+        }
+        return canonical + (flipVertically ? "|flip" : "");
+    }
+
+    // Returns the texture already registered under pathKey with one more
+    // reference, or 0. Used by loaders that decode outside acquire().
+    unsigned int lookup(const std::string &pathKey) {
+        auto known = byPath.find(pathKey);
+        if (known == byPath.end()) {
+            return 0;
+        }
+        stats.hits++;
+        entries[known->second].refs++;
+        return known->second;
+    }
+
+    // Registers a texture created outside acquire() with one reference.
+    // hash may be 0 while the content is still unknown; see setContent().
+    void insert(unsigned int texture, const std::string &pathKey, uint64_t hash, size_t bytes) {
+        Entry entry;
+        entry.refs = 1;
+        entry.paths.push_back(pathKey);
+        entries[texture] = entry;
+        byPath[pathKey] = texture;
+        setContent(texture, hash, bytes);
+    }
+
+    // Records what texture holds once its pixels are known.
+    void setContent(unsigned int texture, uint64_t hash, size_t bytes) {
+        auto found = entries.find(texture);
+        if (found == entries.end()) {
+            return;
+        }
+        Entry &entry = found->second;
+        stats.residentBytes = stats.residentBytes - entry.bytes + bytes;
+        entry.bytes = bytes;
+        entry.hash = hash;
+        if (hash != 0) {
+            byContent.emplace(hash, texture);
+        }
+    }
+
+    void release(unsigned int texture) {
+        auto found = entries.find(texture);
+        if (found == entries.end()) {
+            return;
+        }
+        Entry &entry = found->second;
+        if (--entry.refs > 0) {
+            return;
+        }
+        for (const std::string &pathKey : entry.paths) {
+            byPath.erase(pathKey);
+        }
+        auto content = byContent.find(entry.hash);
+        if (content != byContent.end() && content->second == texture) {
+            byContent.erase(content);
+        }
+        stats.residentBytes -= entry.bytes;
+        GLStateCache::instance().deleteTextures(1, &texture);
+        entries.erase(found);
+    }
+
+    int refCount(unsigned int texture) const {
+        auto found = entries.find(texture);
+        return found == entries.end() ? 0 : found->second.refs;
+    }
+
+    size_t textureCount() const {
+        return entries.size();
+    }
+
+    void report() const {
+        std::cout << "Texture cache: " << stats.hits << " hits (" << stats.contentHits << " by content), "
+                  << stats.misses << " misses (" << stats.compressed << " compressed, " << stats.packed << " from the asset pack, " << stats.decodeMs << " ms decoding), "
+                  << entries.size() << " textures, " << stats.residentBytes / 1024 << " KiB resident" << std::endl;
+    }
+
+private:
+    struct Entry {
+        uint64_t hash = 0;
+        int refs = 0;
+        size_t bytes = 0;
+        std::vector<std::string> paths;
+    };
+
+    std::unordered_map<std::string, unsigned int> byPath;
+    std::unordered_map<uint64_t, unsigned int> byContent;
+    std::unordered_map<unsigned int, Entry> entries;
+
+    // Adds pathKey to the texture already holding hash and returns it, or 0.
+    unsigned int shareContent(const std::string &pathKey, uint64_t hash) {
+        auto same = byContent.find(hash);
+        if (same == byContent.end()) {
+            return 0;
+        }
+        stats.hits++;
+        stats.contentHits++;
+        byPath[pathKey] = same->second;
+        Entry &entry = entries[same->second];
+        entry.paths.push_back(pathKey);
+        entry.refs++;
+        return same->second;
+    }
+
+    unsigned int loadPacked(const std::string &path, bool flipVertically, const PackedTexture &packed) {
+        std::string pathKey = keyFor(path, flipVertically);
+        unsigned int known = lookup(pathKey);
+        if (known == 0) {
+            known = shareContent(pathKey, packed.hash);
+        }
+        if (known != 0) {
+            return known;
+        }
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        uploadPackedTexture(texture, packed);
+        stats.misses++;
+        stats.packed++;
+        insert(texture, pathKey, packed.hash, packedResidentBytes(packed));
+        return texture;
+    }
+
+    // quiet: a missing or unusable file is expected, do not report it
+    unsigned int load(const std::string &path, bool flipVertically, bool quiet) {
+        std::string pathKey = keyFor(path, flipVertically);
+        unsigned int known = lookup(pathKey);
+        if (known != 0) {
+            return known;
+        }
+
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            if (!quiet) {
+                std::cout << "Failed to load texture: " << path << std::endl;
+            }
+            return 0;
+        }
+        std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        uint64_t hash = textureContentHash(bytes, flipVertically);
+        unsigned int same = shareContent(pathKey, hash);
+        if (same != 0) {
+            return same;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        unsigned int texture;
+        size_t residentBytes;
+        if (isKtx2(bytes)) {
+            Ktx2Image image;
+            if (!parseKtx2(bytes, image, path)) {
+                return 0;
+            }
+            if (!ktx2Usable(image, flipVertically)) {
+                if (!quiet) {
+                    std::cout << "Failed to load texture, format or orientation not usable here: " << path << std::endl;
+                }
+                return 0;
+            }
+            glGenTextures(1, &texture);
+            uploadCompressedTexture(texture, image);
+            residentBytes = image.byteSize();
+            stats.compressed++;
+        } else {
+            int width, height, channels;
+            // the global flip flag belongs to whoever else calls stb_image
+            stbi_set_flip_vertically_on_load_thread(flipVertically);
+            unsigned char* data = stbi_load_from_memory(bytes.data(), (int) bytes.size(), &width, &height, &channels, 0);
+            if (data == NULL) {
+                std::cout << "Failed to load texture: " << path << std::endl;
+                return 0;
+            }
+            if (textureFormat(channels) == GL_NONE) {
+                std::cout << "Failed to load texture, " << channels << " channels: " << path << std::endl;
+                stbi_image_free(data);
+                return 0;
+            }
+            texture = createTexture2D(data, width, height, channels);
+            stbi_image_free(data);
+            residentBytes = textureResidentBytes(width, height, channels);
+        }
+        stats.decodeMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        stats.misses++;
+
+        insert(texture, pathKey, hash, residentBytes);
+        return texture;
+    }
+
+    TextureCache() {}
+};
+
+#endif //OPENGL_FROM_SCRATCH_OFS_TEXTURE_CACHE_H
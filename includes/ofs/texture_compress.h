@@ -0,0 +1,639 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_TEXTURE_COMPRESS_H
+#define OPENGL_FROM_SCRATCH_OFS_TEXTURE_COMPRESS_H
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#include "ofs/ktx2.h"
+#include "ofs/mipmap.h"
+
+// CPU block encoders for the formats in ofs/ktx2.h, used offline by
+// ofs_ktx2_encode. They favour simplicity over the last dB of quality:
+//  - BC1: endpoints from the principal axis of the block, refined once by
+//    least squares, always in 4-color mode
+//  - BC3 / BC5: BC4 blocks (min/max endpoints, 8 interpolated values)
+//  - BC7: mode 6 only (one subset, RGBA endpoints with p-bits, 4-bit indices)
+//  - ETC2: the ETC1-compatible individual and differential modes, plus EAC
+//    for alpha; the T, H and planar modes are never emitted
+//
+// Every encoder takes a 4x4 block of RGBA texels in row-major order.
+
+typedef unsigned char RGBABlock[16][4];
+
+namespace texture_compress {
+
+inline int clamp255(int value) {
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+inline void put64BigEndian(uint64_t bits, unsigned char* out) {
+    for (int i = 0; i < 8; i++) {
+        out[i] = (unsigned char) (bits >> (56 - 8 * i));
+    }
+}
+
+inline void put64LittleEndian(uint64_t bits, unsigned char* out) {
+    for (int i = 0; i < 8; i++) {
+        out[i] = (unsigned char) (bits >> (8 * i));
+    }
+}
+
+// Principal axis of the first `channels` components by power iteration on the
+// covariance matrix; falls back to the bounding box diagonal for flat blocks.
+inline void principalAxis(const RGBABlock block, int channels, float mean[4], float axis[4]) {
+    for (int c = 0; c < 4; c++) {
+        mean[c] = 0.0f;
+        axis[c] = 0.0f;
+    }
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < channels; c++) {
+            mean[c] += block[i][c] / 16.0f;
+        }
+    }
+    float covariance[4][4] = {};
+    float low[4] = {255, 255, 255, 255};
+    float high[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 16; i++) {
+        float d[4] = {};
+        for (int c = 0; c < channels; c++) {
+            d[c] = block[i][c] - mean[c];
+            low[c] = std::min(low[c], (float) block[i][c]);
+            high[c] = std::max(high[c], (float) block[i][c]);
+        }
+        for (int a = 0; a < channels; a++) {
+            for (int b = 0; b < channels; b++) {
+                covariance[a][b] += d[a] * d[b];
+            }
+        }
+    }
+    for (int c = 0; c < channels; c++) {
+        axis[c] = high[c] - low[c];
+    }
+    for (int iteration = 0; iteration < 8; iteration++) {
+        float next[4] = {};
+        for (int a = 0; a < channels; a++) {
+            for (int b = 0; b < channels; b++) {
+                next[a] += covariance[a][b] * axis[b];
+            }
+        }
+        float length = 0.0f;
+        for (int c = 0; c < channels; c++) {
+            length = std::max(length, std::fabs(next[c]));
+        }
+        if (length < 1e-6f) {
+            break;
+        }
+        for (int c = 0; c < channels; c++) {
+            axis[c] = next[c] / length;
+        }
+    }
+    float length = 0.0f;
+    for (int c = 0; c < channels; c++) {
+        length += axis[c] * axis[c];
+    }
+    length = std::sqrt(length);
+    for (int c = 0; c < channels; c++) {
+        axis[c] = length > 1e-6f ? axis[c] / length : 0.0f;
+    }
+}
+
+inline uint16_t packRGB565(const float color[3]) {
+    int r = (int) std::lround(std::min(std::max(color[0], 0.0f), 255.0f) * 31.0f / 255.0f);
+    int g = (int) std::lround(std::min(std::max(color[1], 0.0f), 255.0f) * 63.0f / 255.0f);
+    int b = (int) std::lround(std::min(std::max(color[2], 0.0f), 255.0f) * 31.0f / 255.0f);
+    return (uint16_t) ((r << 11) | (g << 5) | b);
+}
+
+inline void unpackRGB565(uint16_t packed, int color[3]) {
+    int r = (packed >> 11) & 31;
+    int g = (packed >> 5) & 63;
+    int b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// Picks the closest of the four BC1 colors for every texel; returns the error.
+inline int bc1Indices(const RGBABlock block, uint16_t c0, uint16_t c1, uint32_t &indices) {
+    int palette[4][3];
+    unpackRGB565(c0, palette[0]);
+    unpackRGB565(c1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+    indices = 0;
+    int total = 0;
+    for (int i = 0; i < 16; i++) {
+        int best = 0;
+        int bestError = 1 << 30;
+        for (int p = 0; p < 4; p++) {
+            int error = 0;
+            for (int c = 0; c < 3; c++) {
+                int d = block[i][c] - palette[p][c];
+                error += d * d;
+            }
+            if (error < bestError) {
+                bestError = error;
+                best = p;
+            }
+        }
+        indices |= (uint32_t) best << (2 * i);
+        total += bestError;
+    }
+    return total;
+}
+
+inline void orderBC1(uint16_t &c0, uint16_t &c1) {
+    // c0 > c1 selects the 4-color mode
+    if (c0 < c1) {
+        std::swap(c0, c1);
+    }
+}
+
+}
+
+void compressBC1(const RGBABlock block, unsigned char* out) {
+    using namespace texture_compress;
+    float mean[4], axis[4];
+    principalAxis(block, 3, mean, axis);
+    float lowest = 0.0f, highest = 0.0f;
+    for (int i = 0; i < 16; i++) {
+        float t = 0.0f;
+        for (int c = 0; c < 3; c++) {
+            t += (block[i][c] - mean[c]) * axis[c];
+        }
+        lowest = std::min(lowest, t);
+        highest = std::max(highest, t);
+    }
+    // inset the extremes a little, the interpolated colors then cover more texels
+    float inset = (highest - lowest) / 16.0f;
+    float end0[3], end1[3];
+    for (int c = 0; c < 3; c++) {
+        end0[c] = mean[c] + axis[c] * (highest - inset);
+        end1[c] = mean[c] + axis[c] * (lowest + inset);
+    }
+    uint16_t c0 = packRGB565(end0);
+    uint16_t c1 = packRGB565(end1);
+    orderBC1(c0, c1);
+    uint32_t indices;
+    int error = bc1Indices(block, c0, c1, indices);
+
+    // least squares fit of both endpoints to the chosen indices
+    if (c0 != c1) {
+        const float weights[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+        float aa = 0, bb = 0, ab = 0;
+        float ax[3] = {}, bx[3] = {};
+        for (int i = 0; i < 16; i++) {
+            float a = weights[(indices >> (2 * i)) & 3];
+            float b = 1.0f - a;
+            aa += a * a;
+            bb += b * b;
+            ab += a * b;
+            for (int c = 0; c < 3; c++) {
+                ax[c] += a * block[i][c];
+                bx[c] += b * block[i][c];
+            }
+        }
+        float determinant = aa * bb - ab * ab;
+        if (std::fabs(determinant) > 1e-6f) {
+            float fit0[3], fit1[3];
+            for (int c = 0; c < 3; c++) {
+                fit0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+                fit1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+            }
+            uint16_t f0 = packRGB565(fit0);
+            uint16_t f1 = packRGB565(fit1);
+            orderBC1(f0, f1);
+            uint32_t fitIndices;
+            int fitError = bc1Indices(block, f0, f1, fitIndices);
+            if (fitError < error) {
+                c0 = f0;
+                c1 = f1;
+                indices = fitIndices;
+            }
+        }
+    }
+    if (c0 == c1) {
+        indices = 0;
+    }
+    out[0] = (unsigned char) (c0 & 0xFF);
+    out[1] = (unsigned char) (c0 >> 8);
+    out[2] = (unsigned char) (c1 & 0xFF);
+    out[3] = (unsigned char) (c1 >> 8);
+    for (int i = 0; i < 4; i++) {
+        out[4 + i] = (unsigned char) (indices >> (8 * i));
+    }
+}
+
+// One channel of the block, as used by BC3 alpha and both halves of BC5.
+void compressBC4(const RGBABlock block, int channel, unsigned char* out) {
+    int low = 255, high = 0;
+    for (int i = 0; i < 16; i++) {
+        low = std::min(low, (int) block[i][channel]);
+        high = std::max(high, (int) block[i][channel]);
+    }
+    uint64_t bits = (uint64_t) high | ((uint64_t) low << 8);
+    if (high > low) {
+        // high > low selects 8 values: high, low, then 6 steps between them
+        int palette[8] = {high, low};
+        for (int step = 1; step < 7; step++) {
+            palette[step + 1] = ((7 - step) * high + step * low) / 7;
+        }
+        for (int i = 0; i < 16; i++) {
+            int best = 0;
+            int bestError = 1 << 30;
+            for (int p = 0; p < 8; p++) {
+                int error = std::abs(block[i][channel] - palette[p]);
+                if (error < bestError) {
+                    bestError = error;
+                    best = p;
+                }
+            }
+            bits |= (uint64_t) best << (16 + 3 * i);
+        }
+    }
+    texture_compress::put64LittleEndian(bits, out);
+}
+
+void compressBC3(const RGBABlock block, unsigned char* out) {
+    compressBC4(block, 3, out);
+    // the color half of BC3 is always decoded in 4-color mode
+    compressBC1(block, out + 8);
+}
+
+void compressBC5(const RGBABlock block, unsigned char* out) {
+    compressBC4(block, 0, out);
+    compressBC4(block, 1, out + 8);
+}
+
+void compressBC7(const RGBABlock block, unsigned char* out) {
+    using namespace texture_compress;
+    static const int weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+    float mean[4], axis[4];
+    principalAxis(block, 4, mean, axis);
+    float lowest = 0.0f, highest = 0.0f;
+    for (int i = 0; i < 16; i++) {
+        float t = 0.0f;
+        for (int c = 0; c < 4; c++) {
+            t += (block[i][c] - mean[c]) * axis[c];
+        }
+        lowest = std::min(lowest, t);
+        highest = std::max(highest, t);
+    }
+
+    // 7-bit endpoints plus a shared low bit (p-bit) per endpoint
+    int endpoints[2][4];
+    int pbits[2];
+    for (int e = 0; e < 2; e++) {
+        float t = e == 0 ? lowest : highest;
+        int bestError = 1 << 30;
+        for (int p = 0; p < 2; p++) {
+            int candidate[4];
+            int error = 0;
+            for (int c = 0; c < 4; c++) {
+                float target = std::min(std::max(mean[c] + axis[c] * t, 0.0f), 255.0f);
+                int q = std::min(std::max((int) std::lround((target - p) / 2.0f), 0), 127);
+                candidate[c] = (q << 1) | p;
+                error += (int) ((candidate[c] - target) * (candidate[c] - target));
+            }
+            if (error < bestError) {
+                bestError = error;
+                pbits[e] = p;
+                memcpy(endpoints[e], candidate, sizeof(candidate));
+            }
+        }
+    }
+
+    int palette[16][4];
+    for (int w = 0; w < 16; w++) {
+        for (int c = 0; c < 4; c++) {
+            palette[w][c] = ((64 - weights[w]) * endpoints[0][c] + weights[w] * endpoints[1][c] + 32) >> 6;
+        }
+    }
+    int indices[16];
+    for (int i = 0; i < 16; i++) {
+        int bestError = 1 << 30;
+        for (int w = 0; w < 16; w++) {
+            int error = 0;
+            for (int c = 0; c < 4; c++) {
+                int d = block[i][c] - palette[w][c];
+                error += d * d;
+            }
+            if (error < bestError) {
+                bestError = error;
+                indices[i] = w;
+            }
+        }
+    }
+    // the first index is stored with 3 bits, so its top bit must be 0
+    if (indices[0] & 8) {
+        std::swap(endpoints[0], endpoints[1]);
+        std::swap(pbits[0], pbits[1]);
+        for (int &index : indices) {
+            index = 15 - index;
+        }
+    }
+
+    uint64_t low = 0, high = 0;
+    int position = 0;
+    auto write = [&low, &high, &position](uint64_t value, int bits) {
+        for (int b = 0; b < bits; b++, position++) {
+            uint64_t bit = (value >> b) & 1;
+            if (position < 64) {
+                low |= bit << position;
+            } else {
+                high |= bit << (position - 64);
+            }
+        }
+    };
+    write(1 << 6, 7); // mode 6
+    for (int c = 0; c < 4; c++) {
+        write(endpoints[0][c] >> 1, 7);
+        write(endpoints[1][c] >> 1, 7);
+    }
+    write(pbits[0], 1);
+    write(pbits[1], 1);
+    write(indices[0], 3);
+    for (int i = 1; i < 16; i++) {
+        write(indices[i], 4);
+    }
+    put64LittleEndian(low, out);
+    put64LittleEndian(high, out + 8);
+}
+
+namespace texture_compress {
+
+const int ETC1_MODIFIERS[8][2] = {
+        {2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183},
+};
+
+// Best table for one half-block around base; writes each texel's 2-bit index.
+inline int etc1SubBlock(const RGBABlock block, const int* texels, const int base[3], int &table, int indices[8]) {
+    int bestTotal = 1 << 30;
+    for (int t = 0; t < 8; t++) {
+        const int modifiers[4] = {ETC1_MODIFIERS[t][0], ETC1_MODIFIERS[t][1], -ETC1_MODIFIERS[t][0], -ETC1_MODIFIERS[t][1]};
+        int total = 0;
+        int chosen[8];
+        for (int i = 0; i < 8; i++) {
+            const unsigned char* texel = block[texels[i]];
+            int bestError = 1 << 30;
+            for (int m = 0; m < 4; m++) {
+                int error = 0;
+                for (int c = 0; c < 3; c++) {
+                    int d = texel[c] - clamp255(base[c] + modifiers[m]);
+                    error += d * d;
+                }
+                if (error < bestError) {
+                    bestError = error;
+                    chosen[i] = m;
+                }
+            }
+            total += bestError;
+        }
+        if (total < bestTotal) {
+            bestTotal = total;
+            table = t;
+            memcpy(indices, chosen, sizeof(chosen));
+        }
+    }
+    return bestTotal;
+}
+
+inline int expand4(int value) {
+    return (value << 4) | value;
+}
+
+inline int expand5(int value) {
+    return (value << 3) | (value >> 2);
+}
+
+}
+
+void compressETC2(const RGBABlock block, unsigned char* out) {
+    using namespace texture_compress;
+    uint64_t bestBits = 0;
+    int bestError = 1 << 30;
+    for (int flip = 0; flip < 2; flip++) {
+        // texels of each half: two columns side by side, or two rows on top of each other
+        int halves[2][8];
+        for (int half = 0; half < 2; half++) {
+            int n = 0;
+            for (int y = 0; y < 4; y++) {
+                for (int x = 0; x < 4; x++) {
+                    int inHalf = flip ? y / 2 : x / 2;
+                    if (inHalf == half) {
+                        halves[half][n++] = y * 4 + x;
+                    }
+                }
+            }
+        }
+        float average[2][3] = {};
+        for (int half = 0; half < 2; half++) {
+            for (int i = 0; i < 8; i++) {
+                for (int c = 0; c < 3; c++) {
+                    average[half][c] += block[halves[half][i]][c] / 8.0f;
+                }
+            }
+        }
+
+        // differential mode when the second color is within [-4, 3] of the first
+        // in 5 bits, otherwise two independent 4-bit colors
+        int q5[2][3], q4[2][3];
+        bool differential = true;
+        for (int c = 0; c < 3; c++) {
+            for (int half = 0; half < 2; half++) {
+                q5[half][c] = (int) std::lround(average[half][c] * 31.0f / 255.0f);
+                q4[half][c] = (int) std::lround(average[half][c] * 15.0f / 255.0f);
+            }
+            int delta = q5[1][c] - q5[0][c];
+            differential = differential && delta >= -4 && delta <= 3;
+        }
+        int bases[2][3];
+        for (int half = 0; half < 2; half++) {
+            for (int c = 0; c < 3; c++) {
+                bases[half][c] = differential ? expand5(q5[half][c]) : expand4(q4[half][c]);
+            }
+        }
+
+        int tables[2] = {0, 0};
+        int indices[2][8];
+        int error = etc1SubBlock(block, halves[0], bases[0], tables[0], indices[0])
+                + etc1SubBlock(block, halves[1], bases[1], tables[1], indices[1]);
+        if (error >= bestError) {
+            continue;
+        }
+        bestError = error;
+
+        uint64_t bits = 0;
+        if (differential) {
+            for (int c = 0; c < 3; c++) {
+                int delta = q5[1][c] - q5[0][c];
+                bits |= (uint64_t) q5[0][c] << (59 - 8 * c);
+                bits |= (uint64_t) (delta & 7) << (56 - 8 * c);
+            }
+            bits |= (uint64_t) 1 << 33;
+        } else {
+            for (int c = 0; c < 3; c++) {
+                bits |= (uint64_t) q4[0][c] << (60 - 8 * c);
+                bits |= (uint64_t) q4[1][c] << (56 - 8 * c);
+            }
+        }
+        bits |= (uint64_t) tables[0] << 37;
+        bits |= (uint64_t) tables[1] << 34;
+        bits |= (uint64_t) flip << 32;
+        // index 0..3 picks +a, +b, -a, -b and is stored as (msb, lsb) = (index >> 1, index & 1);
+        // texel (x, y) owns bit x * 4 + y of each plane
+        for (int half = 0; half < 2; half++) {
+            for (int i = 0; i < 8; i++) {
+                int texel = halves[half][i];
+                int bit = (texel % 4) * 4 + texel / 4;
+                int index = indices[half][i];
+                bits |= (uint64_t) (index >> 1) << (16 + bit);
+                bits |= (uint64_t) (index & 1) << bit;
+            }
+        }
+        bestBits = bits;
+    }
+    put64BigEndian(bestBits, out);
+}
+
+// EAC alpha block followed by an ETC2 color block.
+void compressETC2A(const RGBABlock block, unsigned char* out) {
+    using namespace texture_compress;
+    static const int modifiers[16][8] = {
+            {-3, -6, -9, -15, 2, 5, 8, 14}, {-3, -7, -10, -13, 2, 6, 9, 12},
+            {-2, -5, -8, -13, 1, 4, 7, 12}, {-2, -4, -6, -13, 1, 3, 5, 12},
+            {-3, -6, -8, -12, 2, 5, 7, 11}, {-3, -7, -9, -11, 2, 6, 8, 10},
+            {-4, -7, -8, -11, 3, 6, 7, 10}, {-3, -5, -8, -11, 2, 4, 7, 10},
+            {-2, -6, -8, -10, 1, 5, 7, 9}, {-2, -5, -8, -10, 1, 4, 7, 9},
+            {-2, -4, -8, -10, 1, 3, 7, 9}, {-2, -5, -7, -10, 1, 4, 6, 9},
+            {-3, -4, -7, -10, 2, 3, 6, 9}, {-1, -2, -3, -10, 0, 1, 2, 9},
+            {-4, -6, -8, -9, 3, 5, 7, 8}, {-3, -5, -7, -9, 2, 4, 6, 8},
+    };
+    int low = 255, high = 0;
+    for (int i = 0; i < 16; i++) {
+        low = std::min(low, (int) block[i][3]);
+        high = std::max(high, (int) block[i][3]);
+    }
+
+    // table 13 has a modifier of 0, which reproduces a flat block exactly
+    int bestBase = low, bestMultiplier = 1, bestTable = 13;
+    int bestIndices[16] = {4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4};
+    if (high > low) {
+        int bestError = 1 << 30;
+        int middle = (low + high + 1) / 2;
+        for (int table = 0; table < 16; table++) {
+            int span = modifiers[table][7] - modifiers[table][3];
+            int guess = std::max(1, (int) std::lround((high - low) / (float) span));
+            for (int multiplier = std::max(1, guess - 1); multiplier <= std::min(15, guess + 1); multiplier++) {
+                for (int base = std::max(0, middle - 4); base <= std::min(255, middle + 4); base++) {
+                    int error = 0;
+                    int indices[16];
+                    for (int i = 0; i < 16 && error < bestError; i++) {
+                        int texelError = 1 << 30;
+                        for (int m = 0; m < 8; m++) {
+                            int d = block[i][3] - clamp255(base + modifiers[table][m] * multiplier);
+                            if (d * d < texelError) {
+                                texelError = d * d;
+                                indices[i] = m;
+                            }
+                        }
+                        error += texelError;
+                    }
+                    if (error < bestError) {
+                        bestError = error;
+                        bestBase = base;
+                        bestMultiplier = multiplier;
+                        bestTable = table;
+                        memcpy(bestIndices, indices, sizeof(indices));
+                    }
+                }
+            }
+        }
+    }
+
+    uint64_t bits = (uint64_t) bestBase << 56 | (uint64_t) bestMultiplier << 52 | (uint64_t) bestTable << 48;
+    // 3-bit indices in column-major texel order, first texel in the top bits
+    for (int x = 0; x < 4; x++) {
+        for (int y = 0; y < 4; y++) {
+            int slot = x * 4 + y;
+            bits |= (uint64_t) bestIndices[y * 4 + x] << (45 - 3 * slot);
+        }
+    }
+    put64BigEndian(bits, out);
+    compressETC2(block, out + 8);
+}
+
+// Compresses one level of RGBA8 texels. Blocks past the right or bottom edge
+// repeat the last column or row.
+std::vector<unsigned char> compressImage(const unsigned char* rgba, int width, int height, uint32_t vkFormat) {
+    const Ktx2Format* format = ktx2Format(vkFormat);
+    std::vector<unsigned char> out(compressedLevelSize(width, height, format->blockBytes));
+    unsigned char* block = out.data();
+    for (int by = 0; by < height; by += 4) {
+        for (int bx = 0; bx < width; bx += 4) {
+            RGBABlock texels;
+            for (int y = 0; y < 4; y++) {
+                for (int x = 0; x < 4; x++) {
+                    int sx = std::min(bx + x, width - 1);
+                    int sy = std::min(by + y, height - 1);
+                    memcpy(texels[y * 4 + x], rgba + ((size_t) sy * width + sx) * 4, 4);
+                }
+            }
+            switch (vkFormat) {
+                case VK_FORMAT_BC1_RGB_UNORM_BLOCK: compressBC1(texels, block); break;
+                case VK_FORMAT_BC3_UNORM_BLOCK: compressBC3(texels, block); break;
+                case VK_FORMAT_BC5_UNORM_BLOCK: compressBC5(texels, block); break;
+                case VK_FORMAT_BC7_UNORM_BLOCK: compressBC7(texels, block); break;
+                case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK: compressETC2(texels, block); break;
+                case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK: compressETC2A(texels, block); break;
+            }
+            block += format->blockBytes;
+        }
+    }
+    return out;
+}
+
+// Expands 8-bit pixels with 1-4 channels to RGBA: gray stays gray, missing alpha is opaque.
+std::vector<unsigned char> expandToRGBA(const unsigned char* pixels, int width, int height, int channels) {
+    std::vector<unsigned char> rgba((size_t) width * height * 4);
+    for (size_t i = 0; i < (size_t) width * height; i++) {
+        const unsigned char* in = pixels + i * channels;
+        unsigned char* texel = rgba.data() + i * 4;
+        texel[0] = in[0];
+        texel[1] = channels >= 3 ? in[1] : (channels == 2 ? in[1] : in[0]);
+        texel[2] = channels >= 3 ? in[2] : (channels == 2 ? 0 : in[0]);
+        texel[3] = channels == 4 ? in[3] : 255;
+    }
+    return rgba;
+}
+
+// Builds the mip chain with the box filter of ofs/mipmap.h and compresses every level.
+Ktx2Image compressTexture(const unsigned char* pixels, int width, int height, int channels, uint32_t vkFormat) {
+    std::vector<unsigned char> chain(mipChainSize(width, height, 4));
+    std::vector<unsigned char> rgba = expandToRGBA(pixels, width, height, channels);
+    std::copy(rgba.begin(), rgba.end(), chain.begin());
+    buildMipChain(chain.data(), width, height, 4);
+
+    Ktx2Image image;
+    image.vkFormat = vkFormat;
+    image.width = width;
+    image.height = height;
+    const unsigned char* level = chain.data();
+    for (;;) {
+        image.levels.push_back(compressImage(level, width, height, vkFormat));
+        if (width == 1 && height == 1) {
+            break;
+        }
+        level += (size_t) width * height * 4;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return image;
+}
+
+#endif //OPENGL_FROM_SCRATCH_OFS_TEXTURE_COMPRESS_H
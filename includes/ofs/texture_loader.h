@@ -0,0 +1,393 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_TEXTURE_LOADER_H
+#define OPENGL_FROM_SCRATCH_OFS_TEXTURE_LOADER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <filesystem>
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include "ofs/texture_cache.h"
+#include "ofs/lockfree_queue.h"
+#include "ofs/pixel_upload.h"
+#include "ofs/ktx2.h"
+#include "ofs/profiler.h"
+#include "ofs/gl_state_cache.h"
+
+struct TextureLoaderStats {
+    int requested = 0;
+    int uploaded = 0;
+    int failed = 0;
+    // uploaded through the PixelUploadRing rather than from client memory
+    int streamed = 0;
+    // summed over workers, so it can exceed the wall time
+    double decodeMs = 0.0;
+    double uploadMs = 0.0;
+    // frames in which update() ran out of budget with work left
+    int budgetStalls = 0;
+};
+
+// Decodes images on a pool of worker threads and uploads them on the GL thread.
+//
+// request() returns a texture name at once; it samples as a small checker
+// until the decoded pixels arrive. Workers hand results back through a
+// LockFreeQueue and update(), called once per frame, uploads as many of them
+// as fit in its time budget (always at least one, so loading cannot starve).
+// Textures are registered in TextureCache, so release them there.
+//
+// Given a PixelUploadRing (which must outlive the loader), workers write the
+// decoded pixels into mapped unpack buffer memory and the GL thread only issues
+// the transfer; images larger than a slot still go through client memory.
+//
+// Images cooked into the mounted asset pack skip decoding: workers copy their
+// chain out of the mapping into a ring slot, or fault its pages in so the GL
+// thread can upload straight from the mapping.
+//
+//     AsyncTextureLoader loader;
+//     unsigned int diffuse = loader.request("../resources/wood_container.png");
+//     while (!glfwWindowShouldClose(window)) {
+//         loader.update(2.0);
+//         ...
+//     }
+class AsyncTextureLoader {
+public:
+    TextureLoaderStats stats;
+
+    explicit AsyncTextureLoader(int threads = defaultThreads(), size_t queueCapacity = 64, PixelUploadRing* ring = NULL)
+            : results(queueCapacity), ring(ring), inFlight(0), stopping(false) {
+        // answered on this thread with the context current, read by the workers later
+        compressedFormatSupported(0);
+        for (int i = 0; i < threads; i++) {
+            workers.emplace_back(&AsyncTextureLoader::work, this);
+        }
+    }
+
+    ~AsyncTextureLoader() {
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            stopping = true;
+        }
+        jobsReady.notify_all();
+        // workers may be waiting for room in the result queue, keep draining it
+        while (workersDone.load() < (int) workers.size()) {
+            discardResults();
+            std::this_thread::yield();
+        }
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+        discardResults();
+    }
+
+    AsyncTextureLoader(const AsyncTextureLoader&) = delete;
+    AsyncTextureLoader& operator=(const AsyncTextureLoader&) = delete;
+
+    unsigned int request(const std::string &path, bool flipVertically = true) {
+        TextureCache &cache = TextureCache::instance();
+        std::string pathKey = TextureCache::keyFor(path, flipVertically);
+        unsigned int known = cache.lookup(pathKey);
+        if (known != 0) {
+            return known;
+        }
+
+        Job job;
+        job.path = path;
+        job.flipVertically = flipVertically;
+        // looked up here, the pack is not shared with the workers
+        job.isPacked = findPackedTexture(path, flipVertically, job.packed);
+
+        unsigned int texture = createPlaceholder();
+        job.texture = texture;
+        cache.insert(texture, pathKey, 0, 0);
+        stats.requested++;
+        inFlight++;
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            jobs.push_back(job);
+        }
+        jobsReady.notify_one();
+        return texture;
+    }
+
+    // Uploads decoded images until budgetMs is spent. Returns the number uploaded.
+    int update(double budgetMs) {
+        OFS_PROFILE_ZONE("texture uploads");
+        auto start = std::chrono::steady_clock::now();
+        int count = 0;
+        if (ring != NULL) {
+            for (const PixelUpload &done : ring->poll()) {
+                finishStreamed(done);
+            }
+        }
+        Result result;
+        while (results.pop(result)) {
+            upload(result);
+            count++;
+            double spent = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (spent >= budgetMs) {
+                if (inFlight > 0) {
+                    stats.budgetStalls++;
+                }
+                break;
+            }
+        }
+        if (count > 0) {
+            stats.uploadMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        return count;
+    }
+
+    // Requests that are not uploaded yet.
+    int pending() const {
+        return inFlight;
+    }
+
+    // Blocks until every request so far is uploaded.
+    void finish() {
+        while (inFlight > 0) {
+            if (update(1e9) == 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void report() const {
+        std::cout << "Texture loader: " << workers.size() << " threads, " << stats.uploaded << " uploaded, "
+                  << stats.failed << " failed, " << stats.decodeMs << " ms decoding, "
+                  << stats.uploadMs << " ms uploading, " << stats.budgetStalls << " budget stalls" << std::endl;
+    }
+
+    static int defaultThreads() {
+        int cores = (int) std::thread::hardware_concurrency();
+        // leave a core to the GL thread
+        return cores > 2 ? cores - 1 : 1;
+    }
+
+private:
+    struct Job {
+        unsigned int texture = 0;
+        std::string path;
+        bool flipVertically = true;
+        bool isPacked = false;
+        PackedTexture packed;
+    };
+
+    struct Result {
+        unsigned int texture = 0;
+        // mip chain, empty if the image could not be read or decoded
+        std::vector<unsigned char> chain;
+        // levels of a KTX2 file, uploaded as they are
+        Ktx2Image compressed;
+        // chain in the asset pack mapping, uploaded from there
+        PackedTexture packed;
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+        uint64_t hash = 0;
+        // PixelUploadRing slot holding the chain, -1 if it is in chain
+        int slot = -1;
+        double decodeMs = 0.0;
+        std::string path;
+    };
+
+    std::vector<std::thread> workers;
+    std::deque<Job> jobs;
+    std::mutex jobsMutex;
+    std::condition_variable jobsReady;
+    LockFreeQueue<Result> results;
+    PixelUploadRing* ring;
+    // touched by the GL thread only
+    int inFlight;
+    std::unordered_map<unsigned int, uint64_t> streaming;
+    // written under jobsMutex, read by workers waiting for a ring slot
+    std::atomic<bool> stopping;
+    std::atomic<int> workersDone{0};
+
+    static unsigned int createPlaceholder() {
+        static const unsigned char checker[] = {
+            255, 0, 255, 255,   32, 32, 32, 255,
+            32, 32, 32, 255,    255, 0, 255, 255,
+        };
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        GLStateCache::instance().bindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, checker);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        return texture;
+    }
+
+    void upload(Result &result) {
+        stats.decodeMs += result.decodeMs;
+        if (result.slot >= 0) {
+            // the transfer runs asynchronously; the texture counts as loaded once poll() reports it
+            ring->submit(result.slot, result.texture, result.width, result.height, result.channels);
+            streaming[result.texture] = result.hash;
+            return;
+        }
+        inFlight--;
+        if (result.packed.chain.data != NULL) {
+            uploadPackedTexture(result.texture, result.packed);
+            TextureCache::instance().setContent(result.texture, result.hash, packedResidentBytes(result.packed));
+            stats.uploaded++;
+            return;
+        }
+        if (!result.compressed.levels.empty()) {
+            uploadCompressedTexture(result.texture, result.compressed);
+            TextureCache::instance().setContent(result.texture, result.hash, result.compressed.byteSize());
+            stats.uploaded++;
+            return;
+        }
+        if (result.chain.empty()) {
+            // the checker stays, which makes the missing file easy to spot
+            std::cout << "Failed to load texture: " << result.path << std::endl;
+            stats.failed++;
+            return;
+        }
+        uploadMipChain(result.texture, result.chain.data(), result.width, result.height, result.channels);
+        TextureCache::instance().setContent(result.texture, result.hash,
+                                            textureResidentBytes(result.width, result.height, result.channels));
+        stats.uploaded++;
+    }
+
+    void finishStreamed(const PixelUpload &done) {
+        TextureCache::instance().setContent(done.texture, streaming[done.texture],
+                                            textureResidentBytes(done.width, done.height, done.channels));
+        streaming.erase(done.texture);
+        inFlight--;
+        stats.uploaded++;
+        stats.streamed++;
+    }
+
+    void discardResults() {
+        Result result;
+        while (results.pop(result)) {
+            // the chain frees itself
+        }
+    }
+
+    // Fills result.compressed if path is a KTX2 file usable here.
+    static bool readCompressed(const std::string &path, bool flipVertically, Result &result) {
+        std::ifstream file(path, std::ios::binary);
+        std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        return useCompressed(bytes, path, flipVertically, result);
+    }
+
+    static bool useCompressed(const std::vector<unsigned char> &bytes, const std::string &path, bool flipVertically, Result &result) {
+        if (!parseKtx2(bytes, result.compressed, path) || !ktx2Usable(result.compressed, flipVertically)) {
+            result.compressed = Ktx2Image();
+            return false;
+        }
+        result.hash = textureContentHash(bytes, flipVertically);
+        return true;
+    }
+
+    static void decode(const std::string &path, bool flipVertically, Result &result) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return;
+        }
+        std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (isKtx2(bytes)) {
+            useCompressed(bytes, path, flipVertically, result);
+            return;
+        }
+        result.hash = textureContentHash(bytes, flipVertically);
+        // the global flip flag is shared by all threads, the thread-local one is not
+        stbi_set_flip_vertically_on_load_thread(flipVertically);
+        unsigned char* pixels = stbi_load_from_memory(bytes.data(), (int) bytes.size(),
+                                                       &result.width, &result.height, &result.channels, 0);
+        if (pixels != NULL && textureFormat(result.channels) == GL_NONE) {
+            stbi_image_free(pixels);
+        } else if (pixels != NULL) {
+            // the smaller levels are built here too, off the GL thread
+            result.chain = createMipChain(pixels, result.width, result.height, result.channels);
+            stbi_image_free(pixels);
+        }
+    }
+
+    // Reads one byte per page so the page faults happen here, not in the upload.
+    static void prefault(const AssetSpan &span) {
+        volatile unsigned char sink = 0;
+        for (size_t offset = 0; offset < span.size; offset += ASSET_PACK_PAGE) {
+            sink = sink + span.data[offset];
+        }
+    }
+
+    void work() {
+        OFS_PROFILE_THREAD("texture loader");
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(jobsMutex);
+                jobsReady.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping) {
+                    break;
+                }
+                job = jobs.front();
+                jobs.pop_front();
+            }
+
+            OFS_PROFILE_ZONE("decode texture");
+            auto start = std::chrono::steady_clock::now();
+            Result result;
+            result.texture = job.texture;
+            result.path = job.path;
+            if (job.isPacked) {
+                result.width = job.packed.width;
+                result.height = job.packed.height;
+                result.channels = job.packed.channels;
+                result.hash = job.packed.hash;
+            } else {
+                // a usable .ktx2 sibling replaces the image, as in TextureCache::acquire()
+                std::string sibling = freshKtx2Sibling(job.path);
+                if (sibling.empty() || !readCompressed(sibling, job.flipVertically, result)) {
+                    decode(job.path, job.flipVertically, result);
+                }
+            }
+            const unsigned char* pixels = job.isPacked ? job.packed.chain.data : result.chain.data();
+            size_t size = job.isPacked ? job.packed.chain.size : result.chain.size();
+            bool streamable = job.isPacked ? job.packed.vkFormat == 0 : !result.chain.empty();
+            if (ring != NULL && streamable && size <= ring->slotSize) {
+                int slot;
+                while ((slot = ring->acquire()) < 0 && !stopping) {
+                    // every slot is in flight; the GL thread recycles them in update()
+                    std::this_thread::yield();
+                }
+                if (slot >= 0) {
+                    memcpy(ring->memory(slot), pixels, size);
+                    result.chain = std::vector<unsigned char>();
+                    result.slot = slot;
+                }
+            }
+            if (job.isPacked && result.slot < 0) {
+                prefault(job.packed.chain);
+                result.packed = job.packed;
+            }
+            result.decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            while (!results.push(std::move(result))) {
+                // the GL thread is behind its budget; wait for room
+                std::this_thread::yield();
+            }
+        }
+        workersDone++;
+    }
+};
+
+#endif //OPENGL_FROM_SCRATCH_OFS_TEXTURE_LOADER_H
@@ -0,0 +1,109 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_TRANSFORM_H
+#define OPENGL_FROM_SCRATCH_OFS_TRANSFORM_H
+
+#include <cstddef>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define OFS_TRANSFORM_SSE 1
+#endif
+
+// Normal matrices computed once per object on the CPU instead of running
+// mat3(transpose(inverse(model))) for every vertex.
+//
+// For the upper 3x3 of the model matrix with columns c0, c1, c2 the
+// inverse-transpose is [c1 x c2, c2 x c0, c0 x c1] / dot(c0, c1 x c2), which
+// is what both the scalar and the SIMD path evaluate.
+
+glm::mat3 normalMatrix(const glm::mat4 &model) {
+    glm::vec3 c0(model[0]);
+    glm::vec3 c1(model[1]);
+    glm::vec3 c2(model[2]);
+    glm::vec3 r0 = glm::cross(c1, c2);
+    glm::vec3 r1 = glm::cross(c2, c0);
+    glm::vec3 r2 = glm::cross(c0, c1);
+    float invDet = 1.0f / glm::dot(c0, r0);
+    return glm::mat3(r0 * invDet, r1 * invDet, r2 * invDet);
+}
+
+#ifdef OFS_TRANSFORM_SSE
+// Loads column c of four mat4s and transposes it so x, y and z each hold one
+// row across the four matrices.
+inline void loadColumns4(const glm::mat4* models, int c, __m128 &x, __m128 &y, __m128 &z) {
+    __m128 w;
+    x = _mm_loadu_ps(&models[0][c][0]);
+    y = _mm_loadu_ps(&models[1][c][0]);
+    z = _mm_loadu_ps(&models[2][c][0]);
+    w = _mm_loadu_ps(&models[3][c][0]);
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+}
+
+inline void cross4(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz, __m128 &x, __m128 &y, __m128 &z) {
+    x = _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by));
+    y = _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz));
+    z = _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx));
+}
+
+// Four matrices per call in structure-of-arrays form: lane k of every register
+// belongs to models[k].
+inline void normalMatrices4(const glm::mat4* models, glm::mat3* out) {
+    __m128 c0x, c0y, c0z, c1x, c1y, c1z, c2x, c2y, c2z;
+    loadColumns4(models, 0, c0x, c0y, c0z);
+    loadColumns4(models, 1, c1x, c1y, c1z);
+    loadColumns4(models, 2, c2x, c2y, c2z);
+
+    __m128 n0x, n0y, n0z, n1x, n1y, n1z, n2x, n2y, n2z;
+    cross4(c1x, c1y, c1z, c2x, c2y, c2z, n0x, n0y, n0z);
+    cross4(c2x, c2y, c2z, c0x, c0y, c0z, n1x, n1y, n1z);
+    cross4(c0x, c0y, c0z, c1x, c1y, c1z, n2x, n2y, n2z);
+
+    __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0x, n0x), _mm_mul_ps(c0y, n0y)), _mm_mul_ps(c0z, n0z));
+    __m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+    // four mat3s are 36 contiguous floats: component j of matrix k lives at
+    // 9k + j, so transpose components 0-3 and 4-7 and scatter the 9th
+    __m128 v0 = _mm_mul_ps(n0x, invDet);
+    __m128 v1 = _mm_mul_ps(n0y, invDet);
+    __m128 v2 = _mm_mul_ps(n0z, invDet);
+    __m128 v3 = _mm_mul_ps(n1x, invDet);
+    __m128 v4 = _mm_mul_ps(n1y, invDet);
+    __m128 v5 = _mm_mul_ps(n1z, invDet);
+    __m128 v6 = _mm_mul_ps(n2x, invDet);
+    __m128 v7 = _mm_mul_ps(n2y, invDet);
+    __m128 v8 = _mm_mul_ps(n2z, invDet);
+    _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+    _MM_TRANSPOSE4_PS(v4, v5, v6, v7);
+
+    float* dst = &out[0][0][0];
+    _mm_storeu_ps(dst, v0);
+    _mm_storeu_ps(dst + 4, v4);
+    _mm_store_ss(dst + 8, v8);
+    _mm_storeu_ps(dst + 9, v1);
+    _mm_storeu_ps(dst + 13, v5);
+    _mm_store_ss(dst + 17, _mm_shuffle_ps(v8, v8, _MM_SHUFFLE(1, 1, 1, 1)));
+    _mm_storeu_ps(dst + 18, v2);
+    _mm_storeu_ps(dst + 22, v6);
+    _mm_store_ss(dst + 26, _mm_shuffle_ps(v8, v8, _MM_SHUFFLE(2, 2, 2, 2)));
+    _mm_storeu_ps(dst + 27, v3);
+    _mm_storeu_ps(dst + 31, v7);
+    _mm_store_ss(dst + 35, _mm_shuffle_ps(v8, v8, _MM_SHUFFLE(3, 3, 3, 3)));
+}
+#endif
+
+// Batch inverse-transpose of the upper 3x3 of every model matrix.
+void normalMatrices(const glm::mat4* models, glm::mat3* out, size_t count) {
+    size_t i = 0;
+#ifdef OFS_TRANSFORM_SSE
+    for (; i + 4 <= count; i += 4) {
+        normalMatrices4(models + i, out + i);
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = normalMatrix(models[i]);
+    }
+}
+
+#endif //OPENGL_FROM_SCRATCH_OFS_TRANSFORM_H
@@ -0,0 +1,160 @@
+#ifndef OPENGL_FROM_SCRATCH_OFS_UNIFORM_BUFFER_H
+#define OPENGL_FROM_SCRATCH_OFS_UNIFORM_BUFFER_H
+
+#include <string>
+#include <cstddef>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "ofs/gl_state_cache.h"
+
+// std140 uniform blocks shared by every program.
+//
+// Each block lives at a fixed binding point; Shader binds any active block it
+// recognises by name right after linking (GLSL 330 has no layout(binding = N)),
+// so one buffer update per frame reaches every program that declares the block.
+// The structs below mirror shader/common/camera.glsl and shader/common/phong.glsl
+// and the static_asserts pin them to the std140 offsets.
+
+const unsigned int CAMERA_BLOCK_BINDING = 0;
+const unsigned int LIGHT_BLOCK_BINDING = 1;
+const unsigned int CLUSTER_BLOCK_BINDING = 2;
+const unsigned int SHADOW_BLOCK_BINDING = 3;
+
+// Binding point for a block name, or -1 if the block is not one of ours.
+int uniformBlockBinding(const std::string &name) {
+    if (name == "CameraBlock") {
+        return CAMERA_BLOCK_BINDING;
+    }
+    if (name == "LightBlock") {
+        return LIGHT_BLOCK_BINDING;
+    }
+    if (name == "ClusterBlock") {
+        return CLUSTER_BLOCK_BINDING;
+    }
+    if (name == "ShadowBlock") {
+        return SHADOW_BLOCK_BINDING;
+    }
+    return -1;
+}
+
+struct CameraBlock {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec3 viewPos;
+    float padding0;
+};
+
+static_assert(offsetof(CameraBlock, view) == 0, "CameraBlock.view must match std140");
+static_assert(offsetof(CameraBlock, projection) == 64, "CameraBlock.projection must match std140");
+static_assert(offsetof(CameraBlock, viewPos) == 128, "CameraBlock.viewPos must match std140");
+static_assert(sizeof(CameraBlock) == 144, "CameraBlock size must match std140");
+
+// A vec3 followed by a float packs into one 16 byte slot under std140.
+struct LightBlock {
+    glm::vec3 position;
+    float constant;
+    glm::vec3 direction;
+    float linear;
+    glm::vec3 ambient;
+    float quadratic;
+    glm::vec3 diffuse;
+    float cutOff;
+    glm::vec3 specular;
+    float outerCutOff;
+    // lights nothing further away, 0 for no limit; see ofs/light_bounds.h
+    float radius;
+    float padding0[3];
+};
+
+static_assert(offsetof(LightBlock, position) == 0, "LightBlock.position must match std140");
+static_assert(offsetof(LightBlock, constant) == 12, "LightBlock.constant must match std140");
+static_assert(offsetof(LightBlock, direction) == 16, "LightBlock.direction must match std140");
+static_assert(offsetof(LightBlock, linear) == 28, "LightBlock.linear must match std140");
+static_assert(offsetof(LightBlock, ambient) == 32, "LightBlock.ambient must match std140");
+static_assert(offsetof(LightBlock, quadratic) == 44, "LightBlock.quadratic must match std140");
+static_assert(offsetof(LightBlock, diffuse) == 48, "LightBlock.diffuse must match std140");
+static_assert(offsetof(LightBlock, cutOff) == 60, "LightBlock.cutOff must match std140");
+static_assert(offsetof(LightBlock, specular) == 64, "LightBlock.specular must match std140");
+static_assert(offsetof(LightBlock, outerCutOff) == 76, "LightBlock.outerCutOff must match std140");
+static_assert(offsetof(LightBlock, radius) == 80, "LightBlock.radius must match std140");
+static_assert(sizeof(LightBlock) == 96, "LightBlock size must match std140");
+
+// Layout of the light grid of ClusteredLights, mirrored by
+// shader/common/clusters.glsl.
+struct ClusterBlock {
+    // tiles across, tiles down, depth slices, lights
+    glm::ivec4 grid;
+    // log depth scale and bias, tile width and height in pixels
+    glm::vec4 slicing;
+    glm::vec3 ambient;
+    float padding0;
+};
+
+static_assert(offsetof(ClusterBlock, grid) == 0, "ClusterBlock.grid must match std140");
+static_assert(offsetof(ClusterBlock, slicing) == 16, "ClusterBlock.slicing must match std140");
+static_assert(offsetof(ClusterBlock, ambient) == 32, "ClusterBlock.ambient must match std140");
+static_assert(sizeof(ClusterBlock) == 48, "ClusterBlock size must match std140");
+
+// The shadow maps of one light in the atlas of ofs/shadows.h, mirrored by
+// shader/common/shadows.glsl.
+struct ShadowBlock {
+    // world to light clip space per view: a directional light's cascades, a
+    // point light's cube faces (+X, -X, +Y, -Y, +Z, -Z), a spot light's one view
+    glm::mat4 viewProjection[6];
+    // each view's page in the atlas, uv offset in xy and scale in zw
+    glm::vec4 pages[6];
+    // view depth each cascade ends at
+    glm::vec4 cascadeSplits;
+    // world size of a texel per cascade; for point and spot lights at a
+    // distance of 1, in x
+    glm::vec4 texelSizes;
+    // xyz position of a point light
+    glm::vec4 lightPosition;
+    // ShadowType, views
+    glm::ivec4 info;
+    // normal offset in texels, size of an atlas texel in uv
+    glm::vec4 params;
+};
+
+static_assert(offsetof(ShadowBlock, viewProjection) == 0, "ShadowBlock.viewProjection must match std140");
+static_assert(offsetof(ShadowBlock, pages) == 384, "ShadowBlock.pages must match std140");
+static_assert(offsetof(ShadowBlock, cascadeSplits) == 480, "ShadowBlock.cascadeSplits must match std140");
+static_assert(offsetof(ShadowBlock, texelSizes) == 496, "ShadowBlock.texelSizes must match std140");
+static_assert(offsetof(ShadowBlock, lightPosition) == 512, "ShadowBlock.lightPosition must match std140");
+static_assert(offsetof(ShadowBlock, info) == 528, "ShadowBlock.info must match std140");
+static_assert(offsetof(ShadowBlock, params) == 544, "ShadowBlock.params must match std140");
+static_assert(sizeof(ShadowBlock) == 560, "ShadowBlock size must match std140");
+
+// Owns one GL_UNIFORM_BUFFER holding a T, permanently bound to its binding point.
+// Fill `data` and call upload() once per frame.
+template <typename T>
+class UniformBuffer {
+public:
+    unsigned int ID;
+    unsigned int binding;
+    T data;
+
+    explicit UniformBuffer(unsigned int binding) : binding(binding), data() {
+        glGenBuffers(1, &ID);
+        GLStateCache &state = GLStateCache::instance();
+        state.bindBuffer(GL_UNIFORM_BUFFER, ID);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(T), NULL, GL_DYNAMIC_DRAW);
+        state.bindBufferBase(GL_UNIFORM_BUFFER, binding, ID);
+    }
+
+    ~UniformBuffer() {
+        GLStateCache::instance().deleteBuffers(1, &ID);
+    }
+
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    void upload() {
+        GLStateCache::instance().bindBuffer(GL_UNIFORM_BUFFER, ID);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &data);
+    }
+};
+
+#endif //OPENGL_FROM_SCRATCH_OFS_UNIFORM_BUFFER_H
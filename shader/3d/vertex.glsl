@@ -1,7 +1,7 @@
 #version 330 core
 
 layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec2 aTex;
+layout (location = 2) in vec2 aTex;
 
 out vec3 outColor;
 out vec2 outTex;
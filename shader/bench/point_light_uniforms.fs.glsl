@@ -1,5 +1,8 @@
 #version 330 core
 
+// The point light with every parameter a plain uniform, as it was before the
+// light moved into a uniform block, kept for ofs_bench_uniforms.
+
 in vec3 Normal;
 in vec3 FragPos;
 in vec2 TexCoords;
@@ -7,8 +10,6 @@ in vec2 TexCoords;
 out vec4 FragColor;
 
 struct Material {
-//    sampler2D diffuse;    // !!! THIS CASE SEGMENTATION FAULT
-//    sampler2D specular;    // !!! THIS CASE SEGMENTATION FAULT
     float shininess;
 };
 
@@ -31,29 +32,21 @@ uniform vec3 viewPos;
 uniform Material material;
 uniform Light light;
 
-// http://devernay.free.fr/cours/opengl/materials.html
 void main() {
-    // ambient, the reflect color of surface under ambient lighting
-    // vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));   // !!! THIS CAUSE SEGMENTATION FAULT
     vec3 ambient = light.ambient * vec3(texture(diffuseTexture, TexCoords));
 
     vec3 norm = normalize(Normal);
     vec3 lightDir = normalize(light.position - FragPos);
     float diff = max(dot(norm, lightDir), 0.0);
-    // diffuse, the color of surface under diffuse lighting, set to the desired surface's color
-
-    // vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));   // !!! THIS CAUSE SEGMENTATION FAULt
     vec3 diffuse = light.diffuse * diff * vec3(texture(diffuseTexture, TexCoords));
 
     vec3 viewDir = normalize(viewPos - FragPos);
     vec3 reflectDir = reflect(-lightDir, norm);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    // the color of highlight
     vec3 specular = light.specular * (spec * vec3(texture(specularTexture, TexCoords)));
 
     float distance = length(light.position - FragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
 
-    vec3 result = (ambient + diffuse + specular) * attenuation;
-    FragColor = vec4(result, 1.0);
+    FragColor = vec4(ambient + (diffuse + specular) * attenuation, 1.0);
 }
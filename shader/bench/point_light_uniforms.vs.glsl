@@ -1,5 +1,8 @@
 #version 330 core
 
+// lighting/light.vs.glsl as it was before the camera moved into a uniform
+// block, kept for ofs_bench_uniforms.
+
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
@@ -14,8 +17,6 @@ uniform mat4 projection;
 
 void main() {
     FragPos = vec3(model * vec4(aPos, 1.0));
-    // In the vertex shader we can generate the normal matrix by using the inverse and transpose functions
-    // in the vertex shader that work on any matrix type
     Normal = mat3(transpose(inverse(model))) * aNormal;
     TexCoords = aTexCoords;
 
@@ -0,0 +1,6 @@
+// Per-frame camera data, mirrored by CameraBlock in includes/ofs/uniform_buffer.h.
+layout (std140) uniform CameraBlock {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
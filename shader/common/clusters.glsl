@@ -0,0 +1,76 @@
+// Light grid of ClusteredLights (includes/ofs/clustered_lights.h); the block is
+// mirrored by ClusterBlock in includes/ofs/uniform_buffer.h. Needs phong.glsl.
+
+layout (std140) uniform ClusterBlock {
+    // tiles across, tiles down, depth slices, lights
+    ivec4 clusterGrid;
+    // log depth scale and bias, tile width and height in pixels
+    vec4 clusterSlicing;
+    vec3 clusterAmbient;
+};
+
+// four texels per light, see ClusterLight
+uniform samplerBuffer clusterLights;
+// offset into clusterIndices and light count of every cluster
+uniform usamplerBuffer clusterRanges;
+uniform usamplerBuffer clusterIndices;
+
+struct ClusterLight {
+    vec3 position;
+    float radius;
+    vec3 color;
+    float specular;
+    vec3 direction;
+    float cutOff;
+    float constant;
+    float linear;
+    float quadratic;
+    float outerCutOff;
+};
+
+ClusterLight fetchClusterLight(int index) {
+    vec4 texel0 = texelFetch(clusterLights, 4 * index);
+    vec4 texel1 = texelFetch(clusterLights, 4 * index + 1);
+    vec4 texel2 = texelFetch(clusterLights, 4 * index + 2);
+    vec4 texel3 = texelFetch(clusterLights, 4 * index + 3);
+    return ClusterLight(texel0.xyz, texel0.w, texel1.xyz, texel1.w, texel2.xyz, texel2.w,
+                        texel3.x, texel3.y, texel3.z, texel3.w);
+}
+
+// viewDepth is the positive distance along the view axis.
+int clusterIndex(vec2 fragCoord, float viewDepth) {
+    ivec2 tile = min(ivec2(fragCoord / clusterSlicing.zw), clusterGrid.xy - 1);
+    int slice = clamp(int(floor(log(viewDepth) * clusterSlicing.x + clusterSlicing.y)), 0, clusterGrid.z - 1);
+    return tile.x + clusterGrid.x * (tile.y + clusterGrid.y * slice);
+}
+
+// Phong with the usual attenuation, times a window that takes it smoothly to
+// zero at the light's radius so cutting the light off there leaves no edge.
+vec3 shadeClusterLight(ClusterLight light, vec3 fragPos, vec3 norm, vec3 viewDir, vec3 albedo, vec3 specularColor, float shininess) {
+    vec3 toLight = light.position - fragPos;
+    float distance = length(toLight);
+    if (distance >= light.radius) {
+        return vec3(0.0);
+    }
+    vec3 lightDir = toLight / distance;
+
+    float intensity = 1.0;
+    // point lights have an outerCutOff below any cosine
+    if (light.outerCutOff >= -1.0) {
+        float theta = dot(lightDir, normalize(-light.direction));
+        intensity = clamp((theta - light.outerCutOff) / max(light.cutOff - light.outerCutOff, 1e-4), 0.0, 1.0);
+        // outside the cone; its cluster only overlaps the cone's bounds
+        if (intensity == 0.0) {
+            return vec3(0.0);
+        }
+    }
+
+    float window = distance / light.radius;
+    window *= window;
+    window = 1.0 - window * window;
+    float lightAttenuation = window * window / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+
+    vec3 diffuse = light.color * phongDiffuse(norm, lightDir) * albedo;
+    vec3 specular = light.color * light.specular * phongSpecular(norm, lightDir, viewDir, shininess) * specularColor;
+    return (diffuse + specular) * (intensity * lightAttenuation);
+}
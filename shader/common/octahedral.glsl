@@ -0,0 +1,22 @@
+// Unit vectors in two components: the normal is projected onto the octahedron
+// |x| + |y| + |z| = 1 and the lower half is folded over the upper one, which
+// spreads the precision far more evenly than storing x and y alone.
+// http://jcgt.org/published/0003/02/01/
+
+vec2 octWrap(vec2 v) {
+    return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// n must be normalized; the result is in [-1, 1].
+vec2 octEncode(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    return n.z >= 0.0 ? n.xy : octWrap(n.xy);
+}
+
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) {
+        n.xy = octWrap(n.xy);
+    }
+    return normalize(n);
+}
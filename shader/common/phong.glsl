@@ -0,0 +1,55 @@
+// Material/Light definitions and Phong terms shared by the lighting shaders.
+// Which light model is compiled in is chosen by the including shader's defines.
+
+struct Material {
+//    sampler2D diffuse;    // !!! THIS CASE SEGMENTATION FAULT
+//    sampler2D specular;    // !!! THIS CASE SEGMENTATION FAULT
+    vec3 specular;
+    float shininess;
+};
+
+// Member order packs each vec3 with a float under std140, mirrored by
+// LightBlock in includes/ofs/uniform_buffer.h.
+struct Light {
+    vec3 position;
+    float constant;
+    vec3 direction;
+    float linear;
+    vec3 ambient;
+    float quadratic;
+    vec3 diffuse;
+    float cutOff;
+    vec3 specular;
+    float outerCutOff;
+    // lights nothing further away, 0 for no limit
+    float radius;
+};
+
+layout (std140) uniform LightBlock {
+    Light light;
+};
+
+float phongDiffuse(vec3 norm, vec3 lightDir) {
+    return max(dot(norm, lightDir), 0.0);
+}
+
+float phongSpecular(vec3 norm, vec3 lightDir, vec3 viewDir, float shininess) {
+    vec3 reflectDir = reflect(-lightDir, norm);
+    return pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+}
+
+// http://www.ogre3d.org/tikiwiki/tiki-index.php?page=-Point+Light+Attenuation
+float attenuation(Light light, float distance) {
+    return 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+}
+
+// theta is the cosine between the light direction and the fragment direction.
+// Without SPOT_SOFT the cone has a hard edge at cutOff.
+float spotIntensity(Light light, float theta) {
+#ifdef SPOT_SOFT
+    float epsilon = light.cutOff - light.outerCutOff;
+    return clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+#else
+    return theta > light.cutOff ? 1.0 : 0.0;
+#endif
+}
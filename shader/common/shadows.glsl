@@ -0,0 +1,90 @@
+// Shadow maps of one light in the atlas of Shadows (includes/ofs/shadows.h);
+// the block is mirrored by ShadowBlock in includes/ofs/uniform_buffer.h.
+// Needs camera.glsl.
+
+layout (std140) uniform ShadowBlock {
+    // a directional light's cascades, a point light's cube faces
+    // (+X, -X, +Y, -Y, +Z, -Z) or a spot light's one view
+    mat4 shadowViewProjection[6];
+    // uv offset in xy, scale in zw
+    vec4 shadowPages[6];
+    vec4 shadowCascadeSplits;
+    vec4 shadowTexelSizes;
+    vec4 shadowLightPosition;
+    // ShadowType, views
+    ivec4 shadowInfo;
+    // normal offset in texels, size of an atlas texel in uv
+    vec4 shadowParams;
+};
+
+// depth comparison on, so each tap returns how much of a 2x2 footprint is lit
+uniform sampler2DShadow shadowAtlas;
+
+const int SHADOW_NONE = 0;
+const int SHADOW_DIRECTIONAL = 1;
+const int SHADOW_POINT = 2;
+const int SHADOW_SPOT = 3;
+
+// The view of the light fragPos falls in, -1 for none.
+int shadowView(vec3 fragPos) {
+    if (shadowInfo.x == SHADOW_DIRECTIONAL) {
+        float viewDepth = -(view * vec4(fragPos, 1.0)).z;
+        for (int i = 0; i < shadowInfo.y; i++) {
+            if (viewDepth < shadowCascadeSplits[i]) {
+                return i;
+            }
+        }
+        return -1;
+    }
+    if (shadowInfo.x == SHADOW_POINT) {
+        // the cube face of the major axis
+        vec3 toFragment = fragPos - shadowLightPosition.xyz;
+        vec3 axis = abs(toFragment);
+        if (axis.x >= axis.y && axis.x >= axis.z) {
+            return toFragment.x > 0.0 ? 0 : 1;
+        }
+        if (axis.y >= axis.z) {
+            return toFragment.y > 0.0 ? 2 : 3;
+        }
+        return toFragment.z > 0.0 ? 4 : 5;
+    }
+    return shadowInfo.x == SHADOW_SPOT ? 0 : -1;
+}
+
+// 1.0 where the light reaches fragPos, 0.0 in shadow, in between along the
+// edges. normal is the surface's, fragPos is moved along it by a texel or so
+// before the lookup so surfaces facing the light do not shadow themselves.
+float shadowFactor(vec3 fragPos, vec3 normal) {
+    int shadowViewIndex = shadowView(fragPos);
+    if (shadowViewIndex < 0) {
+        return 1.0;
+    }
+    mat4 viewProjection = shadowViewProjection[shadowViewIndex];
+    // clip w is 1 for the cascades' orthographic views and the distance from
+    // the light for the perspective ones, where texels grow with it
+    float texelSize = shadowTexelSizes[min(shadowViewIndex, 3)] * (viewProjection * vec4(fragPos, 1.0)).w;
+    vec4 clip = viewProjection * vec4(fragPos + normal * texelSize * shadowParams.x, 1.0);
+    vec3 coords = clip.xyz / clip.w * 0.5 + 0.5;
+    if (coords.z >= 1.0) {
+        // past the far plane, nothing in the map to compare with
+        return 1.0;
+    }
+
+    // 3x3 taps, each kept half a texel inside the page so the filter does not
+    // read the neighbouring one
+    vec4 page = shadowPages[shadowViewIndex];
+    float texel = shadowParams.y;
+    vec2 low = page.xy + 0.5 * texel;
+    vec2 high = page.xy + page.zw - 0.5 * texel;
+    vec2 center = page.xy + coords.xy * page.zw;
+    float lit = 0.0;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            vec2 uv = clamp(center + vec2(x, y) * texel, low, high);
+            // no mips, and no derivatives needed after the lighting shader's
+            // early returns
+            lit += textureLod(shadowAtlas, vec3(uv, coords.z), 0.0);
+        }
+    }
+    return lit / 9.0;
+}
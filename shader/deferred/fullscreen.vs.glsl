@@ -0,0 +1,11 @@
+#version 330 core
+
+// One triangle over the whole viewport, drawn by FullscreenTriangle without
+// any vertex data: vertices 0, 1, 2 land on (-1, -1), (3, -1) and (-1, 3).
+
+out vec2 TexCoords;
+
+void main() {
+    TexCoords = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(TexCoords * 2.0 - 1.0, 0.0, 1.0);
+}
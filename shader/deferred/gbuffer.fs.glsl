@@ -0,0 +1,32 @@
+#version 330 core
+
+// Geometry pass of the deferred path, into the G-buffer of includes/ofs/gbuffer.h.
+// Runs after shader/lighting/light.vs.glsl. Permutations: SPECULAR_MAP.
+
+#include "../common/phong.glsl"
+#include "../common/octahedral.glsl"
+
+in vec3 Normal;
+in vec3 FragPos;
+in vec2 TexCoords;
+
+layout (location = 0) out vec2 gNormal;
+layout (location = 1) out vec4 gAlbedoSpecular;
+
+uniform sampler2D diffuseTexture;
+#ifdef SPECULAR_MAP
+uniform sampler2D specularTexture;
+#endif
+
+uniform Material material;
+
+void main() {
+    gNormal = octEncode(normalize(Normal));
+    gAlbedoSpecular.rgb = texture(diffuseTexture, TexCoords).rgb;
+    // one channel is left for the specular color, keep its intensity
+#ifdef SPECULAR_MAP
+    gAlbedoSpecular.a = dot(texture(specularTexture, TexCoords).rgb, vec3(1.0 / 3.0));
+#else
+    gAlbedoSpecular.a = dot(material.specular, vec3(1.0 / 3.0));
+#endif
+}
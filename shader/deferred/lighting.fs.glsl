@@ -0,0 +1,49 @@
+#version 330 core
+
+// Lighting pass of the deferred path: shades each visible pixel of the
+// G-buffer once, with the lights ClusteredLights put in its cluster. The
+// position comes back from the depth buffer rather than a position target.
+
+#include "../common/camera.glsl"
+#include "../common/phong.glsl"
+#include "../common/clusters.glsl"
+#include "../common/octahedral.glsl"
+
+in vec2 TexCoords;
+
+out vec4 FragColor;
+
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedoSpecular;
+uniform sampler2D gDepth;
+
+// inverse(projection * view), once per frame on the CPU
+uniform mat4 inverseViewProjection;
+uniform Material material;
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    // nothing was drawn here, keep the clear color
+    if (depth == 1.0) {
+        discard;
+    }
+    vec4 position = inverseViewProjection * vec4(vec3(TexCoords, depth) * 2.0 - 1.0, 1.0);
+    vec3 fragPos = position.xyz / position.w;
+
+    vec3 norm = octDecode(texelFetch(gNormal, pixel, 0).rg);
+    vec4 albedoSpecular = texelFetch(gAlbedoSpecular, pixel, 0);
+    vec3 albedo = albedoSpecular.rgb;
+    vec3 specularColor = vec3(albedoSpecular.a);
+    vec3 viewDir = normalize(viewPos - fragPos);
+
+    vec3 color = clusterAmbient * albedo;
+    float viewDepth = -(view * vec4(fragPos, 1.0)).z;
+    uvec2 range = texelFetch(clusterRanges, clusterIndex(gl_FragCoord.xy, viewDepth)).xy;
+    for (uint i = 0u; i < range.y; i++) {
+        int index = int(texelFetch(clusterIndices, int(range.x + i)).x);
+        color += shadeClusterLight(fetchClusterLight(index), fragPos, norm, viewDir, albedo, specularColor, material.shininess);
+    }
+
+    FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,50 @@
+#version 330 core
+
+// Any number of point and spot lights, see includes/ofs/clustered_lights.h.
+// Permutations: SPECULAR_MAP; ALL_LIGHTS shades every light instead of the
+// fragment's cluster, the reference the clustering is measured against.
+
+#include "../common/camera.glsl"
+#include "../common/phong.glsl"
+#include "../common/clusters.glsl"
+
+in vec3 Normal;
+in vec3 FragPos;
+in vec2 TexCoords;
+
+out vec4 FragColor;
+
+uniform sampler2D diffuseTexture;
+#ifdef SPECULAR_MAP
+uniform sampler2D specularTexture;
+#endif
+
+uniform Material material;
+
+void main() {
+    vec3 albedo = texture(diffuseTexture, TexCoords).rgb;
+#ifdef SPECULAR_MAP
+    vec3 specularColor = texture(specularTexture, TexCoords).rgb;
+#else
+    vec3 specularColor = material.specular;
+#endif
+
+    vec3 norm = normalize(Normal);
+    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 color = clusterAmbient * albedo;
+
+#ifdef ALL_LIGHTS
+    for (int i = 0; i < clusterGrid.w; i++) {
+        color += shadeClusterLight(fetchClusterLight(i), FragPos, norm, viewDir, albedo, specularColor, material.shininess);
+    }
+#else
+    float viewDepth = -(view * vec4(FragPos, 1.0)).z;
+    uvec2 range = texelFetch(clusterRanges, clusterIndex(gl_FragCoord.xy, viewDepth)).xy;
+    for (uint i = 0u; i < range.y; i++) {
+        int index = int(texelFetch(clusterIndices, int(range.x + i)).x);
+        color += shadeClusterLight(fetchClusterLight(index), FragPos, norm, viewDir, albedo, specularColor, material.shininess);
+    }
+#endif
+
+    FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,21 @@
+#version 330 core
+
+// Position-only vertex shader of the depth pre-pass (see ofs/depth_prepass.h).
+// gl_Position is computed exactly as in light.vs.glsl and both declare it
+// invariant, so the shading pass's GL_EQUAL test sees bit-identical depths.
+layout (location = 0) in vec3 aPos;
+
+#include "../common/camera.glsl"
+
+#ifdef INSTANCED
+layout (location = 8) in mat4 model;
+#else
+uniform mat4 model;
+#endif
+
+invariant gl_Position;
+
+void main() {
+    vec3 fragPos = vec3(model * vec4(aPos, 1.0));
+    gl_Position = projection * view * vec4(fragPos, 1.0);
+}
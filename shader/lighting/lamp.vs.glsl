@@ -2,9 +2,13 @@
 
 layout (location = 0) in vec3 aPos;
 
+#include "../common/camera.glsl"
+
+#ifdef INSTANCED
+layout (location = 8) in mat4 model;
+#else
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#endif
 
 void main() {
     gl_Position = projection * view * model * vec4(aPos, 1.0);
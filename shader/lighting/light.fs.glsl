@@ -0,0 +1,97 @@
+#version 330 core
+
+// Permutations: one of DIRECTIONAL_LIGHT, POINT_LIGHT or SPOT_LIGHT (+ SPOT_SOFT),
+// optionally SPECULAR_MAP. Unused light models are compiled out. AMBIENT_ONLY
+// is for objects the light does not reach (LightCulledInstances in
+// includes/ofs/light_bounds.h). SHADOWS looks the light up in the shadow atlas
+// of includes/ofs/shadows.h.
+
+#include "../common/camera.glsl"
+#include "../common/phong.glsl"
+#ifdef SHADOWS
+#include "../common/shadows.glsl"
+#endif
+
+in vec3 Normal;
+in vec3 FragPos;
+in vec2 TexCoords;
+
+out vec4 FragColor;
+
+uniform sampler2D diffuseTexture;
+#ifdef SPECULAR_MAP
+uniform sampler2D specularTexture;
+#endif
+
+uniform Material material;
+
+// http://devernay.free.fr/cours/opengl/materials.html
+void main() {
+    vec3 albedo = texture(diffuseTexture, TexCoords).rgb;
+#ifdef SPECULAR_MAP
+    // taken while every fragment of the quad is still running, the
+    // early-outs below would leave the specular map's mip level undefined
+    vec2 texCoordsDx = dFdx(TexCoords);
+    vec2 texCoordsDy = dFdy(TexCoords);
+#endif
+    // ambient, the reflect color of surface under ambient lighting
+    vec3 ambient = light.ambient * albedo;
+    FragColor = vec4(ambient, 1.0);
+
+#ifndef AMBIENT_ONLY
+#if defined(POINT_LIGHT) || defined(SPOT_LIGHT)
+    // past the light's reach (see ofs/light_bounds.h) only ambient is left
+    float lightDistance = length(light.position - FragPos);
+    if (light.radius > 0.0 && lightDistance >= light.radius) {
+        return;
+    }
+#endif
+
+#ifdef DIRECTIONAL_LIGHT
+    vec3 lightDir = normalize(-light.direction);
+#else
+    vec3 lightDir = normalize(light.position - FragPos);
+#endif
+
+#ifdef SPOT_LIGHT
+    // and outside the cone
+    float intensity = spotIntensity(light, dot(lightDir, normalize(-light.direction)));
+    if (intensity == 0.0) {
+        return;
+    }
+#endif
+
+#ifdef SPECULAR_MAP
+    vec3 specularColor = textureGrad(specularTexture, TexCoords, texCoordsDx, texCoordsDy).rgb;
+#else
+    vec3 specularColor = material.specular;
+#endif
+
+    vec3 norm = normalize(Normal);
+    // diffuse, the color of surface under diffuse lighting, set to the desired surface's color
+    vec3 diffuse = light.diffuse * phongDiffuse(norm, lightDir) * albedo;
+
+    vec3 viewDir = normalize(viewPos - FragPos);
+    // the color of highlight
+    vec3 specular = light.specular * phongSpecular(norm, lightDir, viewDir, material.shininess) * specularColor;
+
+#ifdef SPOT_LIGHT
+    diffuse *= intensity;
+    specular *= intensity;
+#endif
+
+#ifdef SHADOWS
+    float shadow = shadowFactor(FragPos, norm);
+    diffuse *= shadow;
+    specular *= shadow;
+#endif
+
+#if defined(POINT_LIGHT) || defined(SPOT_LIGHT)
+    float lightAttenuation = attenuation(light, lightDistance);
+    diffuse *= lightAttenuation;
+    specular *= lightAttenuation;
+#endif
+
+    FragColor = vec4(ambient + diffuse + specular, 1.0);
+#endif
+}
@@ -0,0 +1,32 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+out vec3 Normal;
+out vec3 FragPos;
+out vec2 TexCoords;
+
+#include "../common/camera.glsl"
+
+#ifdef INSTANCED
+// per-instance attributes from InstanceBuffer, see ofs/instancing.h
+layout (location = 8) in mat4 model;
+layout (location = 12) in mat3 normalMatrix;
+#else
+uniform mat4 model;
+// inverse-transpose of model's upper 3x3, computed once per object on the CPU
+uniform mat3 normalMatrix;
+#endif
+
+// the depth pre-pass (depth.vs.glsl) must produce the same depths bit for bit
+invariant gl_Position;
+
+void main() {
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    Normal = normalMatrix * aNormal;
+    TexCoords = aTexCoords;
+
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
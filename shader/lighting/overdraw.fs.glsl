@@ -0,0 +1,9 @@
+#version 330 core
+out vec4 FragColor;
+
+// Drawn with additive blending in place of a lighting shader, so each pixel
+// ends up as bright as the number of fragments shaded there: one layer is a
+// dark red, four are orange, ten or more saturate to yellow-white.
+void main() {
+    FragColor = vec4(0.25, 0.1, 0.03, 1.0);
+}
@@ -0,0 +1,18 @@
+#version 330 core
+
+// Shadow casters of Shadows (see ofs/shadows.h), drawn into one page of the
+// shadow atlas at a time with shader/lighting/depth.fs.glsl.
+layout (location = 0) in vec3 aPos;
+
+#ifdef INSTANCED
+layout (location = 8) in mat4 model;
+#else
+uniform mat4 model;
+#endif
+
+// the page's view: a cascade, a cube face or a spot light's cone
+uniform mat4 lightViewProjection;
+
+void main() {
+    gl_Position = lightViewProjection * model * vec4(aPos, 1.0);
+}
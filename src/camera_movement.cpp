@@ -9,14 +9,16 @@
 #include <iostream>
 #include <cmath>
 
+#include "ofs/context.h"
 #include "ofs/shader.h"
+#include "ofs/mesh.h"
 
 const int WIDTH = 1920;
 const int HEIGHT = 1080;
 const char* TITLE = "OpenGL - 3D";
 
 void frameBufferSizeCallback(GLFWwindow* window, int width, int height);
-void handleInput(GLFWwindow* window);
+void handleInput(Context &context);
 void updateUniformColor(int shaderProgram);
 glm::vec3 cameraPos = glm::vec3(0.0f, 0.0f, 3.0f);;
 glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
@@ -52,118 +54,27 @@ unsigned int loadTexture(const char* path, GLenum format) {
     return texture;
 }
 
-int main() {
+int main(int argc, char** argv) {
     glfwSetErrorCallback(errorCallback);
 
-    int initOk = glfwInit();
-    if (!initOk) {
+    Context context(argc, argv);
+    if (!context.create(WIDTH, HEIGHT, TITLE, 3, 2)) {
         return 1;
     }
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, TITLE, NULL, NULL);
-    if (window == NULL) {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-    }
-
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, frameBufferSizeCallback);
 
-    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
-        std::cout << "Failed to init GLAD" << std::endl;
-        return 1;
-    }
+    context.setFramebufferSizeCallback(frameBufferSizeCallback);
 
     stbi_set_flip_vertically_on_load(true);
 
     unsigned int texture1 = loadTexture("../resources/wood.jpg", GL_RGB);
     unsigned int texture2 = loadTexture("../resources/awesomeface.png", GL_RGBA);
 
-    // position(x, y, z), texture(s, t)
-    float vertices[] = {
-            -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
-            0.5f, -0.5f, -0.5f,  1.0f, 0.0f,
-            0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-            0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-            -0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
-            -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
-
-            -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-            0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-            0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
-            0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
-            -0.5f,  0.5f,  0.5f,  0.0f, 1.0f,
-            -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-
-            -0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-            -0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-            -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-            -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-            -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-            -0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-
-            0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-            0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-            0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-            0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-            0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-            0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-
-            -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-            0.5f, -0.5f, -0.5f,  1.0f, 1.0f,
-            0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-            0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-            -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-            -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-
-            -0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
-            0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-            0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-            0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-            -0.5f,  0.5f,  0.5f,  0.0f, 0.0f,
-            -0.5f,  0.5f, -0.5f,  0.0f, 1.0f
-    };
-    float texCoords[] = {
-            0.0f, 0.0f, // lower-left
-            1.0, 0.0f, // lower-right
-            0.5f, 1.0f // top-center
-    };
-    unsigned int indices[] = {
-            0, 1, 3,
-            1, 2, 3
-    };
-
     Shader shader("../shader/3d/vertex.glsl", "../shader/3d/fragment.glsl");
 
-    unsigned int VAO, VBO;
-//    unsigned int EBO;
-    // vertex array object
-    glGenVertexArrays(1, &VAO);
-    // vertex buffer objects
-    glGenBuffers(1, &VBO);
-    // Element buffer object
-//    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    // Any buffer call will be used to VBO from this point.
-    // GL_STATIC_DRAW: data is set once, used many times.
-    // GL_DYNAMIC_DRAW: data is changed a lot, used many times.
-    // GL_STREAM_DRAW: data is set only once, used by the GPU at most a few times.
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-//    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*) 0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*) (3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    MeshBuffer meshes;
+    Mesh cube = meshes.addBuiltin("cube");
+    meshes.upload();
+    unsigned int VAO = meshes.createVAO();
 
 //    glBindBuffer(GL_ARRAY_BUFFER, 0);
 //    glBindVertexArray(0);
@@ -183,7 +94,7 @@ int main() {
             glm::vec3(-1.3f,  1.0f, -1.5f)
     };
 
-    while(!glfwWindowShouldClose(window)) {
+    while(!context.shouldClose()) {
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -192,16 +103,16 @@ int main() {
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_2D, texture2);
 
-        handleInput(window);
+        handleInput(context);
 
-        float timeValue = glfwGetTime();
+        float timeValue = context.time();
         float greenValue = (sin(timeValue) / 2.0f) + 0.5f;
         shader.use();
         shader.setVec4("color", 0.0f, greenValue, 0.0f, 1.0f);
         shader.setInt("texture1", 0);
         shader.setInt("texture2", 1);
         glm::mat4 trans = glm::mat4(1.0f);
-        trans = glm::rotate(trans, (float) glfwGetTime(), glm::vec3(0.0f, 0.0f, 1.0f));
+        trans = glm::rotate(trans, (float) context.time(), glm::vec3(0.0f, 0.0f, 1.0f));
         shader.setMat4fv("transform", trans);
 
         // V[clip] = M[projection] * M[view] * M[model] * V[local]
@@ -223,23 +134,19 @@ int main() {
             model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
             shader.setMat4fv("model", model);
 
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            cube.draw();
         }
 
 //        glBindVertexArray(VAO);
 //        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 //        glDrawArrays(GL_TRIANGLES, 0, 36);
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        context.swapBuffers();
+        context.pollEvents();
     }
 
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-//    glDeleteBuffers(1, &EBO);
     glDeleteProgram(shader.ID);
 
-    glfwTerminate();
     return 0;
 }
 
@@ -250,20 +157,20 @@ void frameBufferSizeCallback(GLFWwindow *window, int width, int height) {
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-void handleInput(GLFWwindow *window) {
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
-        glfwSetWindowShouldClose(window, true);
+void handleInput(Context &context) {
+    if (context.getKey(GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+        context.setShouldClose();
     }
-    float currentFrame = glfwGetTime();
+    float currentFrame = context.time();
     deltaTime = currentFrame - lastFrame;
     lastFrame = currentFrame;
     float cameraSpeed = 2.5f * deltaTime; // adjust accordingly
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_W) == GLFW_PRESS)
         cameraPos += cameraSpeed * cameraFront;
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_S) == GLFW_PRESS)
         cameraPos -= cameraSpeed * cameraFront;
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_A) == GLFW_PRESS)
         cameraPos -= glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_D) == GLFW_PRESS)
         cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
 }
@@ -1,65 +1,50 @@
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
-
-#include <iostream>
-
-const int WIDTH = 1920;
-const int HEIGHT = 1080;
-const char* TITLE = "OpenGL - Hello World";
-
-void frameBufferSizeCallback(GLFWwindow* window, int width, int height);
-void handleInput(GLFWwindow* window);
-
-void errorCallback(int error, const char* description)
-{
-    std::cout << error << " " << description << std::endl;
-}
-
-int main() {
-    glfwSetErrorCallback(errorCallback);
-
-    int initOk = glfwInit();
-    if (!initOk) {
-        return 1;
-    }
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, TITLE, NULL, NULL);
-    if (window == NULL) {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return 1;
-    }
-
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, frameBufferSizeCallback);
-
-    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
-        std::cout << "Failed to init GLAD" << std::endl;
-        return 1;
-    }
-
-    while(!glfwWindowShouldClose(window)) {
-        handleInput(window);
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-    }
-
-    glfwTerminate();
-    return 0;
-}
-
-void frameBufferSizeCallback(GLFWwindow *window, int width, int height) {
-    glViewport(0, 0, width, height);
-}
-
-void handleInput(GLFWwindow *window) {
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
-        glfwSetWindowShouldClose(window, true);
-    } else if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-    }
-}
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+
+#include "ofs/context.h"
+
+const int WIDTH = 1920;
+const int HEIGHT = 1080;
+const char* TITLE = "OpenGL - Hello World";
+
+void frameBufferSizeCallback(GLFWwindow* window, int width, int height);
+void handleInput(Context &context);
+
+void errorCallback(int error, const char* description)
+{
+    std::cout << error << " " << description << std::endl;
+}
+
+int main(int argc, char** argv) {
+    glfwSetErrorCallback(errorCallback);
+
+    Context context(argc, argv);
+    if (!context.create(WIDTH, HEIGHT, TITLE, 3, 2)) {
+        return 1;
+    }
+
+    context.setFramebufferSizeCallback(frameBufferSizeCallback);
+
+    while(!context.shouldClose()) {
+        handleInput(context);
+        context.swapBuffers();
+        context.pollEvents();
+    }
+
+    return 0;
+}
+
+void frameBufferSizeCallback(GLFWwindow *window, int width, int height) {
+    glViewport(0, 0, width, height);
+}
+
+void handleInput(Context &context) {
+    if (context.getKey(GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+        context.setShouldClose();
+    } else if (context.getKey(GLFW_KEY_SPACE) == GLFW_PRESS) {
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+}
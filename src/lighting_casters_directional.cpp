@@ -6,116 +6,56 @@
 
 #include "ofs/common.h"
 #include "ofs/shader.h"
+#include "ofs/mesh.h"
 #include "ofs/camera.h"
+#include "ofs/uniform_buffer.h"
+#include "ofs/instancing.h"
+#include "ofs/texture_loader.h"
+#include "ofs/gpu_profiler.h"
+#include "ofs/fragment_counter.h"
+#include "ofs/depth_prepass.h"
+#include "ofs/shadows.h"
+#include "ofs/gl_state_cache.h"
 
 const char* TITLE = "OpenGL - Lighting Map";
 
-int main() {
+int main(int argc, char** argv) {
     glfwSetErrorCallback(errorCallback);
 
-    int initOk = glfwInit();
-    if (!initOk) {
+    Context context(argc, argv);
+    if (!context.create(WIDTH, HEIGHT, TITLE, 3, 2)) {
         return 1;
     }
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, TITLE, NULL, NULL);
-    if (window == NULL) {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-    }
-
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, frameBufferSizeCallback);
-    glfwSetCursorPosCallback(window, mouseCallback);
-    glfwSetScrollCallback(window, scrollCallback);
 
-    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
-        std::cout << "Failed to init GLAD" << std::endl;
-        return 1;
+    context.setInputMode(GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    context.setFramebufferSizeCallback(frameBufferSizeCallback);
+    context.setCursorPosCallback(mouseCallback);
+    context.setScrollCallback(scrollCallback);
+
+    GLStateCache &state = GLStateCache::instance();
+    state.enable(GL_DEPTH_TEST);
+
+    Shader lightCubeShader("../shader/lighting/lamp.vs.glsl", "../shader/lighting/lamp.fs.glsl");
+    bool shadowsOn = shadowsEnabled(argc, argv);
+    Shader lightShader("../shader/lighting/light.vs.glsl", "../shader/lighting/light.fs.glsl",
+                       shadowsOn ? "DIRECTIONAL_LIGHT|SPECULAR_MAP|SHADOWS|INSTANCED" : "DIRECTIONAL_LIGHT|SPECULAR_MAP|INSTANCED");
+
+    // decoded in the background straight into pixel buffers; the cubes show a
+    // checker until the maps arrive
+    PixelUploadRing uploadRing;
+    AsyncTextureLoader textureLoader(AsyncTextureLoader::defaultThreads(), 64, &uploadRing);
+    unsigned int diffuseMap = textureLoader.request("../resources/wood_container.png");
+    unsigned int specularMap = textureLoader.request("../resources/wood_container_specular_map.png");
+    if (context.capturing()) {
+        // captured frames must not depend on when the decodes land
+        textureLoader.finish();
     }
 
-    glEnable(GL_DEPTH_TEST);
-
-    Shader lightCubeShader("../shader/light_casters_directional/cube.vs.glsl", "../shader/light_casters_directional/cube.fs.glsl");
-    Shader lightShader("../shader/light_casters_directional/light.vs.glsl", "../shader/light_casters_directional/light.fs.glsl");
-
-    stbi_set_flip_vertically_on_load(true);
-
-    unsigned int diffuseMap = loadTexture("../resources/wood_container.png");
-    unsigned int specularMap = loadTexture("../resources/wood_container_specular_map.png");
-
-    float vertices[] = {
-            // positions          // normals           // texture coords
-            -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
-            0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 0.0f,
-            0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
-            0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
-            -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 1.0f,
-            -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
-
-            -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
-            0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 0.0f,
-            0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
-            0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
-            -0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 1.0f,
-            -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
-
-            -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
-            -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
-            -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
-            -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
-            -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
-            -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
-
-            0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
-            0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
-            0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
-            0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
-            0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
-            0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
-
-            -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
-            0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 1.0f,
-            0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
-            0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
-            -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 0.0f,
-            -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
-
-            -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f,
-            0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 1.0f,
-            0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
-            0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
-            -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 0.0f,
-            -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f
-    };
-
-
-    unsigned int cubeVAO, VBO;
-    glGenVertexArrays(1, &cubeVAO);
-    glGenBuffers(1, &VBO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    glBindVertexArray(cubeVAO);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) 0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) (3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) (6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-
-    unsigned int lightCubeVAO;
-    glGenVertexArrays(1, &lightCubeVAO);
-    glBindVertexArray(lightCubeVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) 0);
-    glEnableVertexAttribArray(0);
+    MeshBuffer meshes;
+    Mesh cube = meshes.addBuiltin("cube");
+    meshes.upload();
+    unsigned int cubeVAO = meshes.createVAO();
+    unsigned int lightCubeVAO = meshes.createVAO();
 
     lightShader.use();
 //    lightShader.setInt("material.diffuse", 0); // cause segmentation fault
@@ -136,78 +76,121 @@ int main() {
             glm::vec3(-1.3f,  1.0f, -1.5f)
     };
 
-    while(!glfwWindowShouldClose(window)) {
-        glClearColor(0.01f, 0.01f, 0.01f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        handleInput(window);
-
-        lightShader.use();
-        lightShader.setVec3("viewPos", camera.Position);
-//        lightShader.setVec3("material.ambient", 1.0f, 0.5f, 0.31f);
-        lightShader.setVec3("material.specular", glm::vec3(0.5f));
-        lightShader.setFloat("material.shininess", 32.0f);
-//        lightShader.setVec3("light.ambient", 0.2f, 0.2f, 0.2f);
-//        lightShader.setVec3("light.diffuse", 0.5f, 0.5f, 0.5f);
-//        lightShader.setVec3("light.specular", 1.0f, 1.0f, 1.0f);
-        lightShader.setVec3("light.position", lightPos);
-
-        glm::vec3 lightColor = glm::vec3(1.0f);
-        glm::vec3 diffuseColor = lightColor * glm::vec3(0.8f);
-        glm::vec3 ambientColor = diffuseColor * glm::vec3(0.2f);
-        lightShader.setVec3("lightColor", lightColor);
-        lightShader.setVec3("light.ambient", ambientColor);
-        lightShader.setVec3("light.diffuse", diffuseColor);
-        lightShader.setVec3("light.direction", -0.2, -1.0f, -0.3f);
-
-        // V[clip] = M[projection] * M[view] * M[model] * V[local]
-        glm::mat4 view = camera.GetViewMatrix();
-        lightShader.setMat4fv("view", view);
-
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
-        lightShader.setMat4fv("projection", projection);
-
+    // the cubes never move, so their instance data is built and uploaded once;
+    // the last one is flattened into a floor for the shadows to fall on
+    glm::mat4 cubeModels[11];
+    for (unsigned int i = 0; i < 10; i++) {
         glm::mat4 model = glm::mat4(1.0f);
-        lightShader.setMat4fv("model", model);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, diffuseMap);
+        model = glm::translate(model, cubePositions[i]);
+        float angle = 20.0f * i;
+        cubeModels[i] = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
+    }
+    cubeModels[10] = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -3.6f, -6.0f)), glm::vec3(30.0f, 0.2f, 30.0f));
+    InstanceBuffer cubeInstances;
+    cubeInstances.attach(cubeVAO);
+    cubeInstances.upload(cubeModels, 11);
+
+    UniformBuffer<CameraBlock> cameraBlock(CAMERA_BLOCK_BINDING);
+    UniformBuffer<LightBlock> lightBlock(LIGHT_BLOCK_BINDING);
+    lightBlock.data.ambient = glm::vec3(0.8f * 0.2f);
+    lightBlock.data.diffuse = glm::vec3(0.8f);
+    lightBlock.data.direction = glm::vec3(-0.2f, -1.0f, -0.3f);
+    // the sun does not move, one upload is enough
+    lightBlock.upload();
 
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, specularMap);
+    lightShader.use();
+    lightShader.setVec3("material.specular", glm::vec3(0.5f));
+    lightShader.setFloat("material.shininess", 32.0f);
+
+    // cascades of the sun over the camera's frustum; with the camera still
+    // they are not rendered again
+    Shadows shadows(2048);
+    ShadowLight sun;
+    sun.direction = lightBlock.data.direction;
+    int sunShadows = shadows.add(sun);
+    shadows.attach(lightShader);
+
+    GpuProfiler gpuProfiler;
+    FragmentCounter fragmentCounter;
+    DepthPrepass prepass(argc, argv);
+    // count the render loop only
+    state.resetCounters();
+    while(!context.shouldClose()) {
+        OFS_PROFILE_ZONE("frame");
+        gpuProfiler.frame();
+        fragmentCounter.frame();
+        glClearColor(0.01f, 0.01f, 0.01f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glBindVertexArray(cubeVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        handleInput(context);
+        prepass.handleInput(context);
+        // at most 2 ms of texture uploads per frame
+        textureLoader.update(2.0);
 
-        for(unsigned int i = 0; i < 10; i++)
         {
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, cubePositions[i]);
-            float angle = 20.0f * i;
-            model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-            lightShader.setMat4fv("model", model);
-
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            OFS_PROFILE_ZONE("uniforms");
+            // V[clip] = M[projection] * M[view] * M[model] * V[local]
+            cameraBlock.data.view = camera.GetViewMatrix();
+            cameraBlock.data.projection = glm::perspective(glm::radians(camera.Zoom), (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
+            cameraBlock.data.viewPos = camera.Position;
+            cameraBlock.upload();
         }
 
-        lightCubeShader.use();
-        lightCubeShader.setMat4fv("projection", projection);
-        lightCubeShader.setMat4fv("view", view);
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, lightPos);
-        model = glm::scale(model, glm::vec3(0.2f));
-        lightCubeShader.setMat4fv("model", model);
-
-        glBindVertexArray(lightCubeVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        {
+            OFS_PROFILE_ZONE("draw");
+            if (shadowsOn) {
+                OFS_GPU_ZONE(gpuProfiler, "shadow maps");
+                shadows.setCamera(camera, (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
+                shadows.render([&](const glm::mat4&) {
+                    state.bindVertexArray(cubeVAO);
+                    cubeInstances.draw(cube);
+                });
+                state.bindFramebuffer(GL_FRAMEBUFFER, context.framebuffer);
+                shadows.bind(sunShadows);
+            }
+
+            if (prepass.enabled) {
+                OFS_GPU_ZONE(gpuProfiler, "depth pre-pass");
+                OFS_FRAGMENT_ZONE(fragmentCounter, "depth pre-pass");
+                prepass.beginDepth();
+                state.bindVertexArray(cubeVAO);
+                cubeInstances.draw(cube);
+                prepass.endDepth();
+            }
+
+            {
+                OFS_GPU_ZONE(gpuProfiler, prepass.shadingPass("lit cubes", "lit cubes after pre-pass"));
+                OFS_FRAGMENT_ZONE(fragmentCounter, prepass.shadingPass("lit cubes", "lit cubes after pre-pass"));
+                prepass.beginShading(lightShader);
+                state.bindTexture(0, GL_TEXTURE_2D, diffuseMap);
+                state.bindTexture(1, GL_TEXTURE_2D, specularMap);
+                state.bindVertexArray(cubeVAO);
+                cubeInstances.draw(cube);
+                prepass.endShading();
+            }
+
+            {
+                OFS_GPU_ZONE(gpuProfiler, "light cube");
+                lightCubeShader.use();
+                glm::mat4 model = glm::mat4(1.0f);
+                model = glm::translate(model, lightPos);
+                model = glm::scale(model, glm::vec3(0.2f));
+                lightCubeShader.setMat4fv("model", model);
+
+                state.bindVertexArray(lightCubeVAO);
+                cube.draw();
+            }
+        }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        context.swapBuffers();
+        context.pollEvents();
     }
+    if (shadowsOn) {
+        shadows.report();
+    }
+    gpuProfiler.report();
+    fragmentCounter.report(WIDTH * HEIGHT);
+    state.report(context.frame);
 
-    glDeleteVertexArrays(1, &cubeVAO);
-    glDeleteVertexArrays(1, &lightCubeVAO);
-    glDeleteBuffers(1, &VBO);
-
-    glfwTerminate();
     return 0;
 }
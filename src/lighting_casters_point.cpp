@@ -4,15 +4,27 @@
 #include <glm/gtc/matrix_transform.hpp> // glm::translate, glm::rotate, glm::scale, glm::perspective
 #include <iostream>
 
+#include "ofs/context.h"
 #include "ofs/shader.h"
+#include "ofs/mesh.h"
+#include "ofs/shader_batch.h"
+#include "ofs/uniform_buffer.h"
+#include "ofs/instancing.h"
 #include "ofs/camera.h"
+#include "ofs/texture_cache.h"
+#include "ofs/gpu_profiler.h"
+#include "ofs/fragment_counter.h"
+#include "ofs/depth_prepass.h"
+#include "ofs/light_bounds.h"
+#include "ofs/shadows.h"
+#include "ofs/gl_state_cache.h"
 
 const int WIDTH = 1920;
 const int HEIGHT = 1080;
 const char* TITLE = "OpenGL - Lighting Map";
 
 void frameBufferSizeCallback(GLFWwindow* window, int width, int height);
-void handleInput(GLFWwindow* window);
+void handleInput(Context &context);
 void mouseCallback(GLFWwindow* window, double xPos, double yPos);
 void scrollCallback(GLFWwindow* window, double xOffset, double yOffset);
 void updateUniformColor(int shaderProgram);
@@ -23,152 +35,66 @@ float pitch = 0.0f;
 Camera camera(cameraPos, cameraUp, yaw, pitch);
 
 glm::vec3 lightPos(1.2f, 0.5f, 2.0f);
+// set by handleInput when lightPos changes, so the light block is uploaded again
+bool lightMoved = true;
 
 void errorCallback(int error, const char* description) {
     std::cout << error << " " << description << std::endl;
 }
 
-unsigned int loadTexture(const char* path, GLenum format) {
-    unsigned int texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    int width, height, nrChannels;
-    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
-
-    if (data) {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    } else {
-        std::cout << "Failed to load texture" << std::endl;
-    }
-
-    stbi_image_free(data);
-
-    return texture;
-}
-
-int main() {
+int main(int argc, char** argv) {
     glfwSetErrorCallback(errorCallback);
 
-    int initOk = glfwInit();
-    if (!initOk) {
+    Context context(argc, argv);
+    if (!context.create(WIDTH, HEIGHT, TITLE, 3, 2)) {
         return 1;
     }
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, TITLE, NULL, NULL);
-    if (window == NULL) {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-    }
-
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, frameBufferSizeCallback);
-    glfwSetCursorPosCallback(window, mouseCallback);
-    glfwSetScrollCallback(window, scrollCallback);
 
-    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
-        std::cout << "Failed to init GLAD" << std::endl;
-        return 1;
-    }
+    context.setInputMode(GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    context.setFramebufferSizeCallback(frameBufferSizeCallback);
+    context.setCursorPosCallback(mouseCallback);
+    context.setScrollCallback(scrollCallback);
 
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache &state = GLStateCache::instance();
+    state.enable(GL_DEPTH_TEST);
 
-    Shader lightCubeShader("../shader/point_light/cube.vs.glsl", "../shader/point_light/cube.fs.glsl");
-    Shader lightShader("../shader/point_light/light.vs.glsl", "../shader/point_light/light.fs.glsl");
+    // compile in the background while textures and buffers are set up
+    ShaderBatch shaders(context.loader());
+    PendingShader pendingLightCubeShader = shaders.add("../shader/lighting/lamp.vs.glsl", "../shader/lighting/lamp.fs.glsl");
+    bool shadowsOn = shadowsEnabled(argc, argv);
+    PendingShader pendingLightShader = shaders.add("../shader/lighting/light.vs.glsl", "../shader/lighting/light.fs.glsl",
+                                                   shadowsOn ? "POINT_LIGHT|SPECULAR_MAP|SHADOWS|INSTANCED" : "POINT_LIGHT|SPECULAR_MAP|INSTANCED");
+    PendingShader pendingAmbientShader = shaders.add("../shader/lighting/light.vs.glsl", "../shader/lighting/light.fs.glsl", "POINT_LIGHT|AMBIENT_ONLY|INSTANCED");
 
     stbi_set_flip_vertically_on_load(true);
 
-    unsigned int diffuseMap = loadTexture("../resources/wood_container.png", GL_RGBA);
-    unsigned int specularMap = loadTexture("../resources/wood_container.png", GL_RGBA);
-
-    float vertices[] = {
-            // positions          // normals           // texture coords
-            -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
-            0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 0.0f,
-            0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
-            0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
-            -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 1.0f,
-            -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
-
-            -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
-            0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 0.0f,
-            0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
-            0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
-            -0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 1.0f,
-            -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
-
-            -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
-            -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
-            -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
-            -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
-            -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
-            -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
-
-            0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
-            0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
-            0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
-            0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
-            0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
-            0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
-
-            -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
-            0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 1.0f,
-            0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
-            0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
-            -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 0.0f,
-            -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
-
-            -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f,
-            0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 1.0f,
-            0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
-            0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
-            -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 0.0f,
-            -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f
-    };
-
-
-    unsigned int cubeVAO, VBO;
-    glGenVertexArrays(1, &cubeVAO);
-    glGenBuffers(1, &VBO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    // both maps are the same image, the cache decodes and uploads it once
+    TextureCache &textures = TextureCache::instance();
+    unsigned int diffuseMap = textures.acquire("../resources/wood_container.png");
+    unsigned int specularMap = textures.acquire("../resources/wood_container.png");
 
-    glBindVertexArray(cubeVAO);
+    MeshBuffer meshes;
+    Mesh cube = meshes.addBuiltin("cube");
+    meshes.upload();
+    unsigned int cubeVAO = meshes.createVAO();
+    unsigned int unlitCubeVAO = meshes.createVAO();
+    unsigned int lightCubeVAO = meshes.createVAO();
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) 0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) (3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) (6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-
-    unsigned int lightCubeVAO;
-    glGenVertexArrays(1, &lightCubeVAO);
-    glBindVertexArray(lightCubeVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) 0);
-    glEnableVertexAttribArray(0);
+    Shader &lightCubeShader = pendingLightCubeShader.get();
+    Shader &lightShader = pendingLightShader.get();
+    Shader &ambientShader = pendingAmbientShader.get();
+    ShaderCache::instance().report();
+    textures.report();
 
     lightShader.use();
 //    lightShader.setInt("material.diffuse", 0); // cause segmentation fault
     lightShader.setInt("diffuseTexture", 0);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, diffuseMap);
+    state.bindTexture(0, GL_TEXTURE_2D, diffuseMap);
 
     lightShader.setInt("specularTexture", 1);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, specularMap);
+    state.bindTexture(1, GL_TEXTURE_2D, specularMap);
+    ambientShader.use();
+    ambientShader.setInt("diffuseTexture", 0);
 
     glm::vec3 cubePositions[] = {
             glm::vec3( 0.0f,  0.0f,  0.0f),
@@ -183,78 +109,147 @@ int main() {
             glm::vec3(-1.3f,  1.0f, -1.5f)
     };
 
-    while(!glfwWindowShouldClose(window)) {
+    // the cubes never move; which of them the light reaches is sorted out
+    // every frame. The last one is flattened into a floor for the shadows to
+    // fall on.
+    glm::mat4 cubeModels[11];
+    for (unsigned int i = 0; i < 10; i++) {
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, cubePositions[i]);
+        float angle = 20.0f * i;
+        cubeModels[i] = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
+    }
+    cubeModels[10] = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -3.6f, -6.0f)), glm::vec3(30.0f, 0.2f, 30.0f));
+    LightCulledInstances cubeInstances;
+    cubeInstances.attach(cubeVAO, unlitCubeVAO);
+
+    UniformBuffer<CameraBlock> cameraBlock(CAMERA_BLOCK_BINDING);
+    UniformBuffer<LightBlock> lightBlock(LIGHT_BLOCK_BINDING);
+    lightBlock.data.ambient = glm::vec3(0.1f);
+    lightBlock.data.diffuse = glm::vec3(0.5f);
+    lightBlock.data.specular = glm::vec3(1.0f);
+    // http://www.ogre3d.org/tikiwiki/tiki-index.php?page=-Point+Light+Attenuation
+    lightBlock.data.constant = 1.0f;
+    lightBlock.data.linear = 0.045f;
+    lightBlock.data.quadratic = 0.0075f;
+    // cubes further away get ambient light only, and so do fragments in the
+    // light's shader
+    lightBlock.data.radius = attenuationRadius(lightBlock.data, luminanceThreshold(argc, argv));
+
+    lightShader.use();
+    lightShader.setFloat("material.shininess", 16.0f);
+    UniformHandle lightCubeModelUniform = lightCubeShader.uniform("model");
+
+    // a cube map of six pages; rendered again only when the light moves
+    Shadows shadows(2048);
+    ShadowLight lamp;
+    lamp.type = SHADOW_POINT;
+    lamp.position = lightPos;
+    lamp.range = std::min(lightBlock.data.radius, 100.0f);
+    lamp.resolution = 512;
+    int lampShadows = shadows.add(lamp);
+    shadows.attach(lightShader);
+
+    GpuProfiler gpuProfiler;
+    FragmentCounter fragmentCounter;
+    DepthPrepass prepass(argc, argv);
+    // count the render loop only
+    state.resetCounters();
+    while(!context.shouldClose()) {
+        OFS_PROFILE_ZONE("frame");
+        gpuProfiler.frame();
+        fragmentCounter.frame();
         glClearColor(0.01f, 0.01f, 0.01f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        handleInput(window);
-
-        lightShader.use();
-        lightShader.setVec3("lightColor", 1.0f, 1.0f, 0.0f);
-        lightShader.setVec3("viewPos", camera.Position.x, camera.Position.y, camera.Position.z);
-//        lightShader.setVec3("material.ambient", 1.0f, 0.5f, 0.31f);
-//        lightShader.setVec3("material.specular", 0.5f, 0.5f, 0.5f);
-        lightShader.setFloat("material.shininess", 16.0f);
-        lightShader.setVec3("light.ambient", 0.1f, 0.1f, 0.1f);
-        lightShader.setVec3("light.diffuse", 0.5f, 0.5f, 0.5f);
-        lightShader.setVec3("light.specular", 1.0f, 1.0f, 1.0f);
-        lightShader.setVec3("light.position", lightPos.x, lightPos.y, lightPos.z);
-        // http://www.ogre3d.org/tikiwiki/tiki-index.php?page=-Point+Light+Attenuation
-        lightShader.setFloat("light.constant", 1.0f);
-        lightShader.setFloat("light.linear", 0.045f);
-        lightShader.setFloat("light.quadratic", 0.0075f);
-
-//        glm::vec3 lightColor = glm::vec3(1.0f);
-//        glm::vec3 diffuseColor = lightColor   * glm::vec3(0.5f);
-//        glm::vec3 ambientColor = diffuseColor * glm::vec3(0.2f);
-//        lightShader.setVec3("light.ambient", ambientColor.x, ambientColor.y, ambientColor.z);
-//        lightShader.setVec3("light.diffuse", diffuseColor.x, diffuseColor.y, diffuseColor.z);
-//        lightShader.setVec3("light.direction", -0.2, -1.0f, -0.3f);
-
-        // V[clip] = M[projection] * M[view] * M[model] * V[local]
-        glm::mat4 view = camera.GetViewMatrix();
-        lightShader.setMat4fv("view", view);
-
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
-        lightShader.setMat4fv("projection", projection);
-
-        glm::mat4 model = glm::mat4(1.0f);
-        lightShader.setMat4fv("model", model);
-
-        glBindVertexArray(cubeVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        handleInput(context);
+        prepass.handleInput(context);
 
-        for(unsigned int i = 0; i < 10; i++)
         {
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, cubePositions[i]);
-            float angle = 20.0f * i;
-            model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-            lightShader.setMat4fv("model", model);
-
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            OFS_PROFILE_ZONE("uniforms");
+            // V[clip] = M[projection] * M[view] * M[model] * V[local]
+            cameraBlock.data.view = camera.GetViewMatrix();
+            cameraBlock.data.projection = glm::perspective(glm::radians(camera.Zoom), (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
+            cameraBlock.data.viewPos = camera.Position;
+            cameraBlock.upload();
+
+            if (lightMoved) {
+                lightBlock.data.position = lightPos;
+                lightBlock.upload();
+                lightMoved = false;
+            }
+            cubeInstances.update(pointLightVolume(lightPos, lightBlock.data.radius), cubeModels, 11, UNIT_CUBE_BOUNDING_RADIUS);
+            shadows.light(lampShadows).position = lightPos;
         }
 
-        lightCubeShader.use();
-        lightCubeShader.setMat4fv("projection", projection);
-        lightCubeShader.setMat4fv("view", view);
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, lightPos);
-        model = glm::scale(model, glm::vec3(0.2f));
-        lightCubeShader.setMat4fv("model", model);
-
-        glBindVertexArray(lightCubeVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        {
+            OFS_PROFILE_ZONE("draw");
+            if (shadowsOn) {
+                OFS_GPU_ZONE(gpuProfiler, "shadow maps");
+                // every cube casts, lit by this light or not
+                shadows.render([&](const glm::mat4&) {
+                    state.bindVertexArray(cubeVAO);
+                    cubeInstances.lit.draw(cube);
+                    state.bindVertexArray(unlitCubeVAO);
+                    cubeInstances.unlit.draw(cube);
+                });
+                state.bindFramebuffer(GL_FRAMEBUFFER, context.framebuffer);
+                shadows.bind(lampShadows);
+            }
+
+            if (prepass.enabled) {
+                OFS_GPU_ZONE(gpuProfiler, "depth pre-pass");
+                OFS_FRAGMENT_ZONE(fragmentCounter, "depth pre-pass");
+                prepass.beginDepth();
+                state.bindVertexArray(cubeVAO);
+                cubeInstances.lit.draw(cube);
+                state.bindVertexArray(unlitCubeVAO);
+                cubeInstances.unlit.draw(cube);
+                prepass.endDepth();
+            }
+
+            {
+                OFS_GPU_ZONE(gpuProfiler, prepass.shadingPass("lit cubes", "lit cubes after pre-pass"));
+                OFS_FRAGMENT_ZONE(fragmentCounter, prepass.shadingPass("lit cubes", "lit cubes after pre-pass"));
+                prepass.beginShading(lightShader);
+                state.bindVertexArray(cubeVAO);
+                cubeInstances.lit.draw(cube);
+                prepass.endShading();
+            }
+
+            {
+                OFS_GPU_ZONE(gpuProfiler, "unlit cubes");
+                OFS_FRAGMENT_ZONE(fragmentCounter, "unlit cubes");
+                prepass.beginShading(ambientShader);
+                state.bindVertexArray(unlitCubeVAO);
+                cubeInstances.unlit.draw(cube);
+                prepass.endShading();
+            }
+
+            {
+                OFS_GPU_ZONE(gpuProfiler, "light cube");
+                lightCubeShader.use();
+                glm::mat4 model = glm::mat4(1.0f);
+                model = glm::translate(model, lightPos);
+                model = glm::scale(model, glm::vec3(0.2f));
+                lightCubeShader.setMat4fv(lightCubeModelUniform, model);
+
+                state.bindVertexArray(lightCubeVAO);
+                cube.draw();
+            }
+        }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        context.swapBuffers();
+        context.pollEvents();
     }
+    std::cout << "Light radius " << lightBlock.data.radius << ", " << cubeInstances.lit.count << " of 11 cubes lit" << std::endl;
+    if (shadowsOn) {
+        shadows.report();
+    }
+    gpuProfiler.report();
+    fragmentCounter.report(WIDTH * HEIGHT);
+    state.report(context.frame);
 
-    glDeleteVertexArrays(1, &cubeVAO);
-    glDeleteVertexArrays(1, &lightCubeVAO);
-    glDeleteBuffers(1, &VBO);
-
-    glfwTerminate();
     return 0;
 }
 
@@ -265,37 +260,44 @@ void frameBufferSizeCallback(GLFWwindow *window, int width, int height) {
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-void handleInput(GLFWwindow *window) {
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
-        glfwSetWindowShouldClose(window, true);
+void handleInput(Context &context) {
+    OFS_PROFILE_ZONE("input");
+    if (context.getKey(GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+        context.setShouldClose();
     }
-    float currentFrame = glfwGetTime();
+    float currentFrame = context.time();
     deltaTime = currentFrame - lastFrame;
     lastFrame = currentFrame;
+    if (context.capturing()) {
+        camera.FollowPath(currentFrame);
+        return;
+    }
     float cameraSpeed = 2.5f * deltaTime; // adjust accordingly
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_W) == GLFW_PRESS)
         camera.ProcessKeyboard(FORWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_S) == GLFW_PRESS)
         camera.ProcessKeyboard(BACKWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_A) == GLFW_PRESS)
         camera.ProcessKeyboard(LEFT, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_Q) == GLFW_PRESS)
         camera.ProcessKeyboard(UP, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_E) == GLFW_PRESS)
         camera.ProcessKeyboard(DOWN, deltaTime);
 
     float LightMovementSpeed = 1;
     float velocity = LightMovementSpeed * deltaTime;
-    if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)
+    glm::vec3 lastLightPos = lightPos;
+    if (context.getKey(GLFW_KEY_UP) == GLFW_PRESS)
         lightPos.y += velocity;
-    if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_DOWN) == GLFW_PRESS)
         lightPos.y -= velocity;
-    if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_LEFT) == GLFW_PRESS)
         lightPos.x -= velocity;
-    if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS)
+    if (context.getKey(GLFW_KEY_RIGHT) == GLFW_PRESS)
         lightPos.x += velocity;
+    lightMoved = lightMoved || lightPos != lastLightPos;
 }
 
 float lastX = WIDTH / 2.0;
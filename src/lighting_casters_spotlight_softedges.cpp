@@ -6,116 +6,51 @@
 
 #include "ofs/common.h"
 #include "ofs/shader.h"
+#include "ofs/mesh.h"
 #include "ofs/camera.h"
+#include "ofs/uniform_buffer.h"
+#include "ofs/instancing.h"
+#include "ofs/gpu_profiler.h"
+#include "ofs/fragment_counter.h"
+#include "ofs/depth_prepass.h"
+#include "ofs/light_bounds.h"
+#include "ofs/shadows.h"
+#include "ofs/gl_state_cache.h"
 
 const char* TITLE = "OpenGL - Lighting Map";
 
-int main() {
+int main(int argc, char** argv) {
     glfwSetErrorCallback(errorCallback);
 
-    int initOk = glfwInit();
-    if (!initOk) {
+    Context context(argc, argv);
+    if (!context.create(WIDTH, HEIGHT, TITLE, 3, 2)) {
         return 1;
     }
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, TITLE, NULL, NULL);
-    if (window == NULL) {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-    }
-
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, frameBufferSizeCallback);
-    glfwSetCursorPosCallback(window, mouseCallback);
-    glfwSetScrollCallback(window, scrollCallback);
 
-    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
-        std::cout << "Failed to init GLAD" << std::endl;
-        return 1;
-    }
+    context.setInputMode(GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    context.setFramebufferSizeCallback(frameBufferSizeCallback);
+    context.setCursorPosCallback(mouseCallback);
+    context.setScrollCallback(scrollCallback);
 
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache &state = GLStateCache::instance();
+    state.enable(GL_DEPTH_TEST);
 
-    Shader lightCubeShader("../shader/light_casters_spotlight_softedges/cube.vs.glsl", "../shader/light_casters_spotlight_softedges/cube.fs.glsl");
-    Shader lightShader("../shader/light_casters_spotlight_softedges/light.vs.glsl", "../shader/light_casters_spotlight_softedges/light.fs.glsl");
+    Shader lightCubeShader("../shader/lighting/lamp.vs.glsl", "../shader/lighting/lamp.fs.glsl");
+    bool shadowsOn = shadowsEnabled(argc, argv);
+    Shader lightShader("../shader/lighting/light.vs.glsl", "../shader/lighting/light.fs.glsl",
+                       shadowsOn ? "SPOT_LIGHT|SPOT_SOFT|SPECULAR_MAP|SHADOWS|INSTANCED" : "SPOT_LIGHT|SPOT_SOFT|SPECULAR_MAP|INSTANCED");
+    Shader ambientShader("../shader/lighting/light.vs.glsl", "../shader/lighting/light.fs.glsl", "SPOT_LIGHT|SPOT_SOFT|AMBIENT_ONLY|INSTANCED");
 
     stbi_set_flip_vertically_on_load(true);
 
     unsigned int diffuseMap = loadTexture("../resources/wood_container.png");
     unsigned int specularMap = loadTexture("../resources/wood_container_specular_map.png");
 
-    float vertices[] = {
-            // positions          // normals           // texture coords
-            -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
-            0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 0.0f,
-            0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
-            0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
-            -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 1.0f,
-            -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
-
-            -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
-            0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 0.0f,
-            0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
-            0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
-            -0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 1.0f,
-            -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
-
-            -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
-            -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
-            -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
-            -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
-            -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
-            -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
-
-            0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
-            0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
-            0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
-            0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
-            0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
-            0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
-
-            -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
-            0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 1.0f,
-            0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
-            0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
-            -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 0.0f,
-            -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
-
-            -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f,
-            0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 1.0f,
-            0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
-            0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
-            -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 0.0f,
-            -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f
-    };
-
-
-    unsigned int cubeVAO, VBO;
-    glGenVertexArrays(1, &cubeVAO);
-    glGenBuffers(1, &VBO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    glBindVertexArray(cubeVAO);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) 0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) (3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) (6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-
-    unsigned int lightCubeVAO;
-    glGenVertexArrays(1, &lightCubeVAO);
-    glBindVertexArray(lightCubeVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) 0);
-    glEnableVertexAttribArray(0);
+    MeshBuffer meshes;
+    Mesh cube = meshes.addBuiltin("cube");
+    meshes.upload();
+    unsigned int cubeVAO = meshes.createVAO();
+    unsigned int unlitCubeVAO = meshes.createVAO();
 
     lightShader.use();
 //    lightShader.setInt("material.diffuse", 0); // cause segmentation fault
@@ -136,61 +71,126 @@ int main() {
             glm::vec3(-1.3f,  1.0f, -1.5f)
     };
 
-    while(!glfwWindowShouldClose(window)) {
+    // the cubes never move; the last one is flattened into a floor for the
+    // shadows to fall on
+    glm::mat4 cubeModels[11];
+    for (unsigned int i = 0; i < 10; i++) {
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, cubePositions[i]);
+        float angle = 20.0f * i;
+        cubeModels[i] = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
+    }
+    cubeModels[10] = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -3.6f, -6.0f)), glm::vec3(30.0f, 0.2f, 30.0f));
+    // the flashlight's cone decides every frame which of them it reaches
+    LightCulledInstances cubeInstances;
+    cubeInstances.attach(cubeVAO, unlitCubeVAO);
+
+    UniformBuffer<CameraBlock> cameraBlock(CAMERA_BLOCK_BINDING);
+    UniformBuffer<LightBlock> lightBlock(LIGHT_BLOCK_BINDING);
+    lightBlock.data.ambient = glm::vec3(0.01f);
+    lightBlock.data.diffuse = glm::vec3(0.8f);
+    lightBlock.data.specular = glm::vec3(1.0f);
+    lightBlock.data.constant = 1.0f;
+    lightBlock.data.linear = 0.09f;
+    lightBlock.data.quadratic = 0.032f;
+    lightBlock.data.cutOff = glm::cos(glm::radians(5.0f));
+    lightBlock.data.outerCutOff = glm::cos(glm::radians(15.0f));
+
+    lightBlock.data.radius = attenuationRadius(lightBlock.data, luminanceThreshold(argc, argv));
+    ambientShader.use();
+    ambientShader.setInt("diffuseTexture", 0);
+
+    lightShader.use();
+    lightShader.setFloat("material.shininess", 16.0f);
+
+    // one perspective page over the cone, rendered again whenever the
+    // flashlight moves with the camera
+    Shadows shadows(2048);
+    ShadowLight flashlightShadow;
+    flashlightShadow.type = SHADOW_SPOT;
+    flashlightShadow.coneCos = lightBlock.data.outerCutOff;
+    flashlightShadow.range = std::min(lightBlock.data.radius, 100.0f);
+    int flashlightShadows = shadows.add(flashlightShadow);
+    shadows.attach(lightShader);
+
+    GpuProfiler gpuProfiler;
+    FragmentCounter fragmentCounter;
+    DepthPrepass prepass(argc, argv);
+    // count the render loop only
+    state.resetCounters();
+    while(!context.shouldClose()) {
+        OFS_PROFILE_ZONE("frame");
+        gpuProfiler.frame();
+        fragmentCounter.frame();
         glClearColor(0.0f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        handleInput(window);
-
-        lightShader.use();
-        lightShader.setVec3("viewPos", camera.Position);
-        lightShader.setFloat("material.shininess", 16.0f);
-
-        lightShader.setVec3("light.ambient", 0.01f, 0.01f, 0.01f);
-        lightShader.setVec3("light.diffuse", 0.8f, 0.8f, 0.8f);
-        lightShader.setVec3("light.specular", 1.0f, 1.0f, 1.0f);
-        lightShader.setFloat("light.constant", 1.0f);
-        lightShader.setFloat("light.linear", 0.09f);
-        lightShader.setFloat("light.quadratic", 0.032f);
-        lightShader.setVec3("light.position", camera.Position);
-        lightShader.setVec3("light.direction", camera.Front);
-        // lightShader.setFloat("light.cutOff", glm::cos(glm::radians(12.5f)));
-         lightShader.setFloat("light.cutOff", glm::cos(glm::radians(5.0f)));
-        lightShader.setFloat("light.outerCutOff", glm::cos(glm::radians(15.0f)));
-
-//        glm::vec3 lightColor = glm::vec3(1.0f);
-//        glm::vec3 diffuseColor = lightColor   * glm::vec3(0.5f);
-//        glm::vec3 ambientColor = diffuseColor * glm::vec3(0.2f);
-//        lightShader.setVec3("light.ambient", ambientColor.x, ambientColor.y, ambientColor.z);
-//        lightShader.setVec3("light.diffuse", diffuseColor.x, diffuseColor.y, diffuseColor.z);
-
-        // V[clip] = M[projection] * M[view] * M[model] * V[local]
-        glm::mat4 view = camera.GetViewMatrix();
-        lightShader.setMat4fv("view", view);
-
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
-        lightShader.setMat4fv("projection", projection);
+        handleInput(context);
+        prepass.handleInput(context);
 
-        glm::mat4 model = glm::mat4(1.0f);
-        lightShader.setMat4fv("model", model);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, 1);
-
-        glBindVertexArray(cubeVAO);
-//        glDrawArrays(GL_TRIANGLES, 0, 36);
-        for(unsigned int i = 0; i < 10; i++)
         {
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, cubePositions[i]);
-            float angle = 20.0f * i;
-            model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-            lightShader.setMat4fv("model", model);
-
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            OFS_PROFILE_ZONE("uniforms");
+            // V[clip] = M[projection] * M[view] * M[model] * V[local]
+            cameraBlock.data.view = camera.GetViewMatrix();
+            cameraBlock.data.projection = glm::perspective(glm::radians(camera.Zoom), (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
+            cameraBlock.data.viewPos = camera.Position;
+            cameraBlock.upload();
+
+            // the flashlight follows the camera
+            lightBlock.data.position = camera.Position;
+            lightBlock.data.direction = camera.Front;
+            lightBlock.upload();
+            LightVolume flashlight = spotLightVolume(camera.Position, camera.Front, lightBlock.data.radius, lightBlock.data.outerCutOff);
+            cubeInstances.update(flashlight, cubeModels, 11, UNIT_CUBE_BOUNDING_RADIUS);
+            shadows.light(flashlightShadows).position = camera.Position;
+            shadows.light(flashlightShadows).direction = camera.Front;
         }
 
+        {
+            OFS_PROFILE_ZONE("draw");
+            if (shadowsOn) {
+                OFS_GPU_ZONE(gpuProfiler, "shadow maps");
+                shadows.render([&](const glm::mat4&) {
+                    state.bindVertexArray(cubeVAO);
+                    cubeInstances.lit.draw(cube);
+                    state.bindVertexArray(unlitCubeVAO);
+                    cubeInstances.unlit.draw(cube);
+                });
+                state.bindFramebuffer(GL_FRAMEBUFFER, context.framebuffer);
+                shadows.bind(flashlightShadows);
+            }
+
+            if (prepass.enabled) {
+                OFS_GPU_ZONE(gpuProfiler, "depth pre-pass");
+                OFS_FRAGMENT_ZONE(fragmentCounter, "depth pre-pass");
+                prepass.beginDepth();
+                state.bindVertexArray(cubeVAO);
+                cubeInstances.lit.draw(cube);
+                state.bindVertexArray(unlitCubeVAO);
+                cubeInstances.unlit.draw(cube);
+                prepass.endDepth();
+            }
+
+            {
+                OFS_GPU_ZONE(gpuProfiler, prepass.shadingPass("spotlight cubes", "spotlight cubes after pre-pass"));
+                OFS_FRAGMENT_ZONE(fragmentCounter, prepass.shadingPass("spotlight cubes", "spotlight cubes after pre-pass"));
+                prepass.beginShading(lightShader);
+                state.bindTexture(0, GL_TEXTURE_2D, diffuseMap);
+                state.bindTexture(1, GL_TEXTURE_2D, specularMap);
+                state.bindVertexArray(cubeVAO);
+                cubeInstances.lit.draw(cube);
+                prepass.endShading();
+            }
+
+            {
+                OFS_GPU_ZONE(gpuProfiler, "unlit cubes");
+                OFS_FRAGMENT_ZONE(fragmentCounter, "unlit cubes");
+                prepass.beginShading(ambientShader);
+                state.bindVertexArray(unlitCubeVAO);
+                cubeInstances.unlit.draw(cube);
+                prepass.endShading();
+            }
+
 //        lightCubeShader.use();
 //        lightCubeShader.setMat4fv("projection", projection);
 //        lightCubeShader.setMat4fv("view", view);
@@ -201,15 +201,18 @@ int main() {
 
 //        glBindVertexArray(lightCubeVAO);
 //        glDrawArrays(GL_TRIANGLES, 0, 36);
+        }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        context.swapBuffers();
+        context.pollEvents();
     }
+    std::cout << "Light radius " << lightBlock.data.radius << ", " << cubeInstances.lit.count << " of 11 cubes lit" << std::endl;
+    if (shadowsOn) {
+        shadows.report();
+    }
+    gpuProfiler.report();
+    fragmentCounter.report(WIDTH * HEIGHT);
+    state.report(context.frame);
 
-    glDeleteVertexArrays(1, &cubeVAO);
-    glDeleteVertexArrays(1, &lightCubeVAO);
-    glDeleteBuffers(1, &VBO);
-
-    glfwTerminate();
     return 0;
 }
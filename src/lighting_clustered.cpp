@@ -0,0 +1,177 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp> // glm::translate, glm::rotate, glm::scale, glm::perspective
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+
+#include "ofs/common.h"
+#include "ofs/shader.h"
+#include "ofs/mesh.h"
+#include "ofs/camera.h"
+#include "ofs/uniform_buffer.h"
+#include "ofs/instancing.h"
+#include "ofs/clustered_lights.h"
+#include "ofs/gpu_profiler.h"
+#include "ofs/gl_state_cache.h"
+
+const char* TITLE = "OpenGL - Clustered Lights";
+
+// Usage: lighting_clustered [--lights N], 256 lights by default.
+int lightCount(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(argv[i]) == "--lights") {
+            return std::max(0, atoi(argv[i + 1]));
+        }
+    }
+    return 256;
+}
+
+// Lights circling above the floor, every fourth a spot light looking down.
+void animateLights(std::vector<ClusterLight> &lights, float seconds) {
+    for (size_t i = 0; i < lights.size(); i++) {
+        float ring = 2.0f + 16.0f * (float) i / lights.size();
+        float angle = 2.39996f * i + seconds * (0.2f + 0.3f * (i % 5) / 4.0f);
+        float height = i % 4 == 3 ? 1.5f : -0.8f + 0.5f * std::sin(seconds + i);
+        lights[i].position = glm::vec3(ring * std::cos(angle), height, ring * std::sin(angle));
+    }
+}
+
+int main(int argc, char** argv) {
+    glfwSetErrorCallback(errorCallback);
+
+    Context context(argc, argv);
+    if (!context.create(WIDTH, HEIGHT, TITLE, 3, 2)) {
+        return 1;
+    }
+
+    context.setInputMode(GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    context.setFramebufferSizeCallback(frameBufferSizeCallback);
+    context.setCursorPosCallback(mouseCallback);
+    context.setScrollCallback(scrollCallback);
+
+    GLStateCache &state = GLStateCache::instance();
+    state.enable(GL_DEPTH_TEST);
+
+    Shader lightCubeShader("../shader/lighting/lamp.vs.glsl", "../shader/lighting/lamp.fs.glsl", "INSTANCED");
+    Shader lightShader("../shader/lighting/light.vs.glsl", "../shader/lighting/clustered.fs.glsl", "SPECULAR_MAP|INSTANCED");
+
+    unsigned int diffuseMap = loadTexture("../resources/wood_container.png");
+    unsigned int specularMap = loadTexture("../resources/wood_container_specular_map.png");
+
+    MeshBuffer meshes;
+    Mesh cube = meshes.addBuiltin("cube");
+    meshes.upload();
+    unsigned int cubeVAO = meshes.createVAO();
+    unsigned int lightCubeVAO = meshes.createVAO();
+
+    // a floor of crates with every third one stacked on it; none of them move
+    std::vector<glm::mat4> cubeModels;
+    for (int z = -12; z <= 12; z++) {
+        for (int x = -12; x <= 12; x++) {
+            glm::vec3 position(1.5f * x, -2.0f, 1.5f * z);
+            cubeModels.push_back(glm::translate(glm::mat4(1.0f), position));
+            if ((x + z) % 3 == 0 && (x != 0 || z != 0)) {
+                glm::mat4 model = glm::translate(glm::mat4(1.0f), position + glm::vec3(0.0f, 1.0f, 0.0f));
+                cubeModels.push_back(glm::rotate(model, glm::radians(20.0f * x), glm::vec3(0.0f, 1.0f, 0.0f)));
+            }
+        }
+    }
+    InstanceBuffer cubeInstances;
+    cubeInstances.attach(cubeVAO);
+    cubeInstances.upload(cubeModels.data(), cubeModels.size());
+
+    std::vector<ClusterLight> lights;
+    for (int i = 0; i < lightCount(argc, argv); i++) {
+        glm::vec3 color(0.5f + 0.5f * std::sin(1.3f * i), 0.5f + 0.5f * std::sin(1.3f * i + 2.1f), 0.5f + 0.5f * std::sin(1.3f * i + 4.2f));
+        if (i % 4 == 3) {
+            lights.push_back(spotLight(glm::vec3(0.0f), glm::vec3(0.0f, -1.0f, 0.0f), 2.0f * color, 6.0f, 20.0f, 30.0f));
+        } else {
+            lights.push_back(pointLight(glm::vec3(0.0f), color, 3.0f));
+        }
+    }
+    std::vector<glm::mat4> lightModels(lights.size());
+    InstanceBuffer lightInstances;
+    lightInstances.attach(lightCubeVAO);
+
+    UniformBuffer<CameraBlock> cameraBlock(CAMERA_BLOCK_BINDING);
+    ClusteredLights clusters;
+    clusters.attach(lightShader);
+
+    lightShader.use();
+    lightShader.setInt("diffuseTexture", 0);
+    lightShader.setInt("specularTexture", 1);
+    lightShader.setFloat("material.shininess", 32.0f);
+
+    GpuProfiler gpuProfiler;
+    // count the render loop only
+    state.resetCounters();
+    while(!context.shouldClose()) {
+        OFS_PROFILE_ZONE("frame");
+        gpuProfiler.frame();
+        glClearColor(0.01f, 0.01f, 0.01f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        handleInput(context);
+        // the clusters tile the framebuffer, which follows window resizes
+        int framebufferWidth, framebufferHeight;
+        context.getFramebufferSize(&framebufferWidth, &framebufferHeight);
+        if (framebufferWidth == 0 || framebufferHeight == 0) {
+            // minimized, there is nothing to tile
+            context.pollEvents();
+            continue;
+        }
+
+        {
+            OFS_PROFILE_ZONE("uniforms");
+            // V[clip] = M[projection] * M[view] * M[model] * V[local]
+            cameraBlock.data.view = camera.GetViewMatrix();
+            cameraBlock.data.projection = glm::perspective(glm::radians(camera.Zoom), (float)framebufferWidth / (float)framebufferHeight, 0.1f, 100.0f);
+            cameraBlock.data.viewPos = camera.Position;
+            cameraBlock.upload();
+        }
+
+        {
+            OFS_PROFILE_ZONE("lights");
+            animateLights(lights, context.time());
+            clusters.setView(cameraBlock.data.view, cameraBlock.data.projection, 0.1f, 100.0f, framebufferWidth, framebufferHeight);
+            clusters.assign(lights.data(), lights.size());
+            clusters.upload();
+            for (size_t i = 0; i < lights.size(); i++) {
+                lightModels[i] = glm::scale(glm::translate(glm::mat4(1.0f), lights[i].position), glm::vec3(0.1f));
+            }
+            lightInstances.upload(lightModels.data(), lightModels.size());
+        }
+
+        {
+            OFS_PROFILE_ZONE("draw");
+            {
+                OFS_GPU_ZONE(gpuProfiler, "lit cubes");
+                lightShader.use();
+                state.bindTexture(0, GL_TEXTURE_2D, diffuseMap);
+                state.bindTexture(1, GL_TEXTURE_2D, specularMap);
+                clusters.bind();
+                state.bindVertexArray(cubeVAO);
+                cubeInstances.draw(cube);
+            }
+
+            {
+                OFS_GPU_ZONE(gpuProfiler, "light cubes");
+                lightCubeShader.use();
+                state.bindVertexArray(lightCubeVAO);
+                lightInstances.draw(cube);
+            }
+        }
+
+        context.swapBuffers();
+        context.pollEvents();
+    }
+    std::cout << lights.size() << " lights, " << clusters.visibleLights << " visible, at most "
+              << clusters.maxClusterLights << " in a cluster" << std::endl;
+    gpuProfiler.report();
+    state.report(context.frame);
+
+    return 0;
+}
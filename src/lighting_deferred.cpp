@@ -0,0 +1,260 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp> // glm::translate, glm::rotate, glm::scale, glm::perspective
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+
+#include "ofs/common.h"
+#include "ofs/shader.h"
+#include "ofs/mesh.h"
+#include "ofs/camera.h"
+#include "ofs/uniform_buffer.h"
+#include "ofs/instancing.h"
+#include "ofs/clustered_lights.h"
+#include "ofs/gbuffer.h"
+#include "ofs/gpu_profiler.h"
+#include "ofs/gl_state_cache.h"
+
+const char* TITLE = "OpenGL - Deferred Shading";
+
+// Usage: lighting_deferred [--lights N] [--forward] [--switch-every N]
+//
+// Starts deferred, or forward with --forward; TAB switches between the two.
+// --switch-every N switches by itself every N frames, so a headless run
+// measures both. On exit the frame times of both paths are compared.
+struct Options {
+    int lights = 256;
+    bool deferred = true;
+    int switchEvery = 0;
+};
+
+Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--lights" && i + 1 < argc) {
+            options.lights = std::max(0, atoi(argv[++i]));
+        } else if (arg == "--forward") {
+            options.deferred = false;
+        } else if (arg == "--switch-every" && i + 1 < argc) {
+            options.switchEvery = std::max(0, atoi(argv[++i]));
+        }
+    }
+    return options;
+}
+
+// Lights circling above the floor, every fourth a spot light looking down.
+void animateLights(std::vector<ClusterLight> &lights, float seconds) {
+    for (size_t i = 0; i < lights.size(); i++) {
+        float ring = 2.0f + 16.0f * (float) i / lights.size();
+        float angle = 2.39996f * i + seconds * (0.2f + 0.3f * (i % 5) / 4.0f);
+        float height = i % 4 == 3 ? 1.5f : -0.8f + 0.5f * std::sin(seconds + i);
+        lights[i].position = glm::vec3(ring * std::cos(angle), height, ring * std::sin(angle));
+    }
+}
+
+int main(int argc, char** argv) {
+    glfwSetErrorCallback(errorCallback);
+    Options options = parseOptions(argc, argv);
+
+    Context context(argc, argv);
+    if (!context.create(WIDTH, HEIGHT, TITLE, 3, 2)) {
+        return 1;
+    }
+
+    context.setInputMode(GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    context.setFramebufferSizeCallback(frameBufferSizeCallback);
+    context.setCursorPosCallback(mouseCallback);
+    context.setScrollCallback(scrollCallback);
+
+    GLStateCache &state = GLStateCache::instance();
+    state.enable(GL_DEPTH_TEST);
+
+    Shader lightCubeShader("../shader/lighting/lamp.vs.glsl", "../shader/lighting/lamp.fs.glsl", "INSTANCED");
+    Shader forwardShader("../shader/lighting/light.vs.glsl", "../shader/lighting/clustered.fs.glsl", "SPECULAR_MAP|INSTANCED");
+    Shader geometryShader("../shader/lighting/light.vs.glsl", "../shader/deferred/gbuffer.fs.glsl", "SPECULAR_MAP|INSTANCED");
+    Shader lightingShader("../shader/deferred/fullscreen.vs.glsl", "../shader/deferred/lighting.fs.glsl");
+
+    unsigned int diffuseMap = loadTexture("../resources/wood_container.png");
+    unsigned int specularMap = loadTexture("../resources/wood_container_specular_map.png");
+
+    MeshBuffer meshes;
+    Mesh cube = meshes.addBuiltin("cube");
+    meshes.upload();
+    unsigned int cubeVAO = meshes.createVAO();
+    unsigned int lightCubeVAO = meshes.createVAO();
+
+    // a floor of crates with every third one stacked on it; none of them move
+    std::vector<glm::mat4> cubeModels;
+    for (int z = -12; z <= 12; z++) {
+        for (int x = -12; x <= 12; x++) {
+            glm::vec3 position(1.5f * x, -2.0f, 1.5f * z);
+            cubeModels.push_back(glm::translate(glm::mat4(1.0f), position));
+            if ((x + z) % 3 == 0 && (x != 0 || z != 0)) {
+                glm::mat4 model = glm::translate(glm::mat4(1.0f), position + glm::vec3(0.0f, 1.0f, 0.0f));
+                cubeModels.push_back(glm::rotate(model, glm::radians(20.0f * x), glm::vec3(0.0f, 1.0f, 0.0f)));
+            }
+        }
+    }
+    InstanceBuffer cubeInstances;
+    cubeInstances.attach(cubeVAO);
+    cubeInstances.upload(cubeModels.data(), cubeModels.size());
+
+    std::vector<ClusterLight> lights;
+    for (int i = 0; i < options.lights; i++) {
+        glm::vec3 color(0.5f + 0.5f * std::sin(1.3f * i), 0.5f + 0.5f * std::sin(1.3f * i + 2.1f), 0.5f + 0.5f * std::sin(1.3f * i + 4.2f));
+        if (i % 4 == 3) {
+            lights.push_back(spotLight(glm::vec3(0.0f), glm::vec3(0.0f, -1.0f, 0.0f), 2.0f * color, 6.0f, 20.0f, 30.0f));
+        } else {
+            lights.push_back(pointLight(glm::vec3(0.0f), color, 3.0f));
+        }
+    }
+    std::vector<glm::mat4> lightModels(lights.size());
+    InstanceBuffer lightInstances;
+    lightInstances.attach(lightCubeVAO);
+
+    UniformBuffer<CameraBlock> cameraBlock(CAMERA_BLOCK_BINDING);
+    ClusteredLights clusters;
+    int gbufferWidth, gbufferHeight;
+    context.getFramebufferSize(&gbufferWidth, &gbufferHeight);
+    GBuffer gbuffer(gbufferWidth, gbufferHeight);
+    FullscreenTriangle fullscreen;
+    clusters.attach(forwardShader);
+    clusters.attach(lightingShader);
+    gbuffer.attach(lightingShader);
+    UniformHandle inverseViewProjectionUniform = lightingShader.uniform("inverseViewProjection");
+
+    for (Shader* shader : {&forwardShader, &geometryShader}) {
+        shader->use();
+        shader->setInt("diffuseTexture", 0);
+        shader->setInt("specularTexture", 1);
+    }
+    for (Shader* shader : {&forwardShader, &lightingShader}) {
+        shader->use();
+        shader->setFloat("material.shininess", 32.0f);
+    }
+    std::cout << "G-buffer: " << gbuffer.bytes() / 1024 << " KiB at " << gbuffer.width << "x" << gbuffer.height << std::endl;
+
+    GpuProfiler gpuProfiler;
+    bool deferred = options.deferred;
+    bool tabWasDown = false;
+    // CPU frame times per path, [0] forward and [1] deferred
+    double frameMs[2] = {0.0, 0.0};
+    int frames[2] = {0, 0};
+    double lastTime = context.time();
+    // count the render loop only
+    state.resetCounters();
+    while(!context.shouldClose()) {
+        OFS_PROFILE_ZONE("frame");
+        gpuProfiler.frame();
+        handleInput(context);
+        bool tabDown = context.getKey(GLFW_KEY_TAB) == GLFW_PRESS;
+        if (tabDown && !tabWasDown) {
+            deferred = !deferred;
+        }
+        tabWasDown = tabDown;
+        if (options.switchEvery > 0 && context.frame > 0 && context.frame % options.switchEvery == 0) {
+            deferred = !deferred;
+        }
+        // the G-buffer and the clusters follow the framebuffer through window resizes
+        int framebufferWidth, framebufferHeight;
+        context.getFramebufferSize(&framebufferWidth, &framebufferHeight);
+        if (framebufferWidth == 0 || framebufferHeight == 0) {
+            // minimized, there is nothing to draw into
+            context.pollEvents();
+            lastTime = context.time();
+            continue;
+        }
+        if (framebufferWidth != gbuffer.width || framebufferHeight != gbuffer.height) {
+            gbuffer.resize(framebufferWidth, framebufferHeight);
+        }
+
+        {
+            OFS_PROFILE_ZONE("uniforms");
+            // V[clip] = M[projection] * M[view] * M[model] * V[local]
+            cameraBlock.data.view = camera.GetViewMatrix();
+            cameraBlock.data.projection = glm::perspective(glm::radians(camera.Zoom), (float)framebufferWidth / (float)framebufferHeight, 0.1f, 100.0f);
+            cameraBlock.data.viewPos = camera.Position;
+            cameraBlock.upload();
+        }
+
+        {
+            OFS_PROFILE_ZONE("lights");
+            animateLights(lights, context.time());
+            clusters.setView(cameraBlock.data.view, cameraBlock.data.projection, 0.1f, 100.0f, framebufferWidth, framebufferHeight);
+            clusters.assign(lights.data(), lights.size());
+            clusters.upload();
+            for (size_t i = 0; i < lights.size(); i++) {
+                lightModels[i] = glm::scale(glm::translate(glm::mat4(1.0f), lights[i].position), glm::vec3(0.1f));
+            }
+            lightInstances.upload(lightModels.data(), lightModels.size());
+        }
+
+        {
+            OFS_PROFILE_ZONE("draw");
+            state.bindTexture(0, GL_TEXTURE_2D, diffuseMap);
+            state.bindTexture(1, GL_TEXTURE_2D, specularMap);
+            clusters.bind();
+            if (deferred) {
+                {
+                    OFS_GPU_ZONE(gpuProfiler, "deferred geometry");
+                    gbuffer.bindForGeometry();
+                    geometryShader.use();
+                    state.bindVertexArray(cubeVAO);
+                    cubeInstances.draw(cube);
+                }
+                {
+                    OFS_GPU_ZONE(gpuProfiler, "deferred lighting");
+                    state.bindFramebuffer(GL_FRAMEBUFFER, context.framebuffer);
+                    // bindForGeometry() set the viewport to the G-buffer
+                    glViewport(0, 0, framebufferWidth, framebufferHeight);
+                    glClearColor(0.01f, 0.01f, 0.01f, 1.0f);
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                    lightingShader.use();
+                    lightingShader.setMat4fv(inverseViewProjectionUniform, glm::inverse(cameraBlock.data.projection * cameraBlock.data.view));
+                    gbuffer.bindTextures();
+                    state.disable(GL_DEPTH_TEST);
+                    fullscreen.draw();
+                    state.enable(GL_DEPTH_TEST);
+                    // the light cubes below are depth tested against the scene
+                    gbuffer.blitDepth(context.framebuffer);
+                }
+            } else {
+                OFS_GPU_ZONE(gpuProfiler, "forward");
+                state.bindFramebuffer(GL_FRAMEBUFFER, context.framebuffer);
+                glClearColor(0.01f, 0.01f, 0.01f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                forwardShader.use();
+                state.bindVertexArray(cubeVAO);
+                cubeInstances.draw(cube);
+            }
+
+            {
+                OFS_GPU_ZONE(gpuProfiler, "light cubes");
+                lightCubeShader.use();
+                state.bindVertexArray(lightCubeVAO);
+                lightInstances.draw(cube);
+            }
+        }
+
+        context.swapBuffers();
+        context.pollEvents();
+        double now = context.time();
+        frameMs[deferred] += 1000.0 * (now - lastTime);
+        frames[deferred]++;
+        lastTime = now;
+    }
+    gpuProfiler.report();
+    const char* names[2] = {"forward", "deferred"};
+    for (int path = 0; path < 2; path++) {
+        if (frames[path] > 0) {
+            std::cout << names[path] << ": " << frames[path] << " frames, " << frameMs[path] / frames[path] << " ms/frame" << std::endl;
+        }
+    }
+    state.report(context.frame);
+
+    return 0;
+}
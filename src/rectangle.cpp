@@ -3,12 +3,14 @@
 
 #include <iostream>
 
+#include "ofs/context.h"
+
 const int WIDTH = 1920;
 const int HEIGHT = 1080;
 const char* TITLE = "OpenGL - Rectangle";
 
 void frameBufferSizeCallback(GLFWwindow* window, int width, int height);
-void handleInput(GLFWwindow* window, unsigned int shaderProgram, int VAO, int EBO);
+void handleInput(Context &context, unsigned int shaderProgram, int VAO, int EBO);
 
 void errorCallback(int error, const char* description) {
     std::cout << error << " " << description << std::endl;
@@ -85,30 +87,15 @@ unsigned int createShaderProgram(unsigned int vertexShader, unsigned int fragmen
     return shaderProgram;
 }
 
-int main() {
+int main(int argc, char** argv) {
     glfwSetErrorCallback(errorCallback);
 
-    int initOk = glfwInit();
-    if (!initOk) {
+    Context context(argc, argv);
+    if (!context.create(WIDTH, HEIGHT, TITLE, 3, 2)) {
         return 1;
     }
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, TITLE, NULL, NULL);
-    if (window == NULL) {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-    }
-
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, frameBufferSizeCallback);
 
-    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
-        std::cout << "Failed to init GLAD" << std::endl;
-        return 1;
-    }
+    context.setFramebufferSizeCallback(frameBufferSizeCallback);
 
     unsigned int vertexShader = getVertexShader();
     if (vertexShader == -1) {
@@ -165,11 +152,11 @@ int main() {
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
-    while(!glfwWindowShouldClose(window)) {
-        handleInput(window, shaderProgram, VAO, EBO);
+    while(!context.shouldClose()) {
+        handleInput(context, shaderProgram, VAO, EBO);
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        context.swapBuffers();
+        context.pollEvents();
     }
 
     glDeleteVertexArrays(1, &VAO);
@@ -177,7 +164,6 @@ int main() {
     glDeleteBuffers(1, &EBO);
     glDeleteProgram(shaderProgram);
 
-    glfwTerminate();
     return 0;
 }
 
@@ -185,17 +171,17 @@ void frameBufferSizeCallback(GLFWwindow *window, int width, int height) {
     glViewport(0, 0, width, height);
 }
 
-void handleInput(GLFWwindow *window, unsigned int shaderProgram, int VAO, int EBO) {
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
-        glfwSetWindowShouldClose(window, true);
-    } else if (glfwGetKey(window, GLFW_KEY_ENTER) == GLFW_PRESS) {
+void handleInput(Context &context, unsigned int shaderProgram, int VAO, int EBO) {
+    if (context.getKey(GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+        context.setShouldClose();
+    } else if (context.getKey(GLFW_KEY_ENTER) == GLFW_PRESS) {
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
         glUseProgram(shaderProgram);
         glBindVertexArray(VAO);
         glDrawArrays(GL_TRIANGLES, 0, 3);
-    } else if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
+    } else if (context.getKey(GLFW_KEY_SPACE) == GLFW_PRESS) {
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
@@ -0,0 +1,93 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+
+#include "ofs/asset_cook.h"
+
+// Cooks shaders, images and the built-in meshes into one asset pack that the
+// demos map at startup instead of reading and decoding the sources.
+//
+//     ofs_cook [--out assets.pack] [--compress none|auto|bc1|bc3|bc5|bc7|etc2|etc2a] [--no-flip] <file or directory>...
+//
+// Run it from the directory the demos run in (the build directory), naming
+// the sources the way the demos do, e.g. `ofs_cook ../shader ../resources`.
+// Directories are walked recursively; .glsl files become shaders, images
+// become textures with their full mip chain. Textures keep 8-bit pixels unless
+// --compress picks a block format (auto is BC1 without alpha, BC7 with it);
+// a GPU without that format falls back to the source image at runtime.
+// Images are flipped like loadTexture() does unless --no-flip is given.
+
+bool isShader(const std::filesystem::path &path) {
+    return path.extension() == ".glsl";
+}
+
+bool isImage(const std::filesystem::path &path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp";
+}
+
+int main(int argc, char** argv) {
+    std::string out = "assets.pack";
+    std::string compress = "none";
+    bool flip = true;
+    std::vector<std::filesystem::path> inputs;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc) {
+            out = argv[++i];
+        } else if (arg == "--compress" && i + 1 < argc) {
+            compress = argv[++i];
+        } else if (arg == "--no-flip") {
+            flip = false;
+        } else if (std::filesystem::is_directory(arg)) {
+            for (const auto &entry : std::filesystem::recursive_directory_iterator(arg)) {
+                if (entry.is_regular_file() && (isShader(entry.path()) || isImage(entry.path()))) {
+                    inputs.push_back(entry.path());
+                }
+            }
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty() || (compress != "none" && compress != "auto" && ktx2Format(compress) == NULL)) {
+        std::cout << "usage: ofs_cook [--out assets.pack] [--compress none|auto|bc1|bc3|bc5|bc7|etc2|etc2a] [--no-flip] <file or directory>..." << std::endl;
+        return 1;
+    }
+    std::sort(inputs.begin(), inputs.end());
+
+    auto start = std::chrono::steady_clock::now();
+    AssetPackWriter writer;
+    int shaders = 0, textures = 0, failures = 0;
+    for (const std::filesystem::path &input : inputs) {
+        if (isShader(input)) {
+            writer.addShader(input.string()) ? shaders++ : failures++;
+            continue;
+        }
+        uint32_t vkFormat = 0;
+        if (compress != "none") {
+            std::string name = compress;
+            if (compress == "auto") {
+                int width, height, channels;
+                name = stbi_info(input.string().c_str(), &width, &height, &channels) && channels == 4 ? "bc7" : "bc1";
+            }
+            vkFormat = ktx2Format(name)->vkFormat;
+        }
+        writer.addTexture(input.string(), flip, vkFormat) ? textures++ : failures++;
+    }
+    for (const BuiltinMesh &mesh : BUILTIN_MESHES) {
+        writer.addMesh(mesh.name, mesh.build());
+    }
+    if (!writer.write(out)) {
+        return 1;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << out << ": " << shaders << " shaders, " << textures << " textures, "
+              << sizeof(BUILTIN_MESHES) / sizeof(BUILTIN_MESHES[0]) << " meshes, " << writer.fileSize / 1024 << " KiB, "
+              << ms << " ms" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+#include <stb_image.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include <filesystem>
+
+#include "ofs/image_diff.h"
+#include "ofs/png_writer.h"
+
+// Compares captured frames against golden images with the perceptual metric
+// of ofs/image_diff.h and fails when any frame differs visibly.
+//
+//     ofs_image_diff [--threshold deltaE] [--tolerance fraction] [--diff dir] <golden> <actual>
+//
+// golden and actual are two images, or two directories whose PNGs are paired
+// by name; a golden frame without a capture counts as a failure. Goldens are
+// captures accepted earlier, e.g.
+//
+//     ofs_lighting_casters_point --headless --capture 30 --out ../golden/lighting_casters_point
+//     ... change the renderer ...
+//     ofs_lighting_casters_point --headless --capture 30 --out capture
+//     ofs_image_diff ../golden/lighting_casters_point capture
+//
+// With --diff, every failing frame also gets a heatmap in dir: the golden
+// frame in grey, the pixels that differ in red.
+
+struct Image {
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels;
+};
+
+bool loadImage(const std::string &path, Image &image) {
+    int channels;
+    unsigned char* data = stbi_load(path.c_str(), &image.width, &image.height, &channels, 3);
+    if (data == NULL) {
+        return false;
+    }
+    image.pixels.assign(data, data + (size_t) image.width * image.height * 3);
+    stbi_image_free(data);
+    return true;
+}
+
+// Prints one line for the pair and returns whether it passes.
+bool compare(const std::string &goldenPath, const std::string &actualPath, float threshold, double tolerance,
+             const std::string &diffDir) {
+    Image golden, actual;
+    std::string name = std::filesystem::path(actualPath).filename().string();
+    if (!loadImage(goldenPath, golden)) {
+        std::cout << name << ": cannot read " << goldenPath << std::endl;
+        return false;
+    }
+    if (!loadImage(actualPath, actual)) {
+        std::cout << name << ": missing or unreadable " << actualPath << std::endl;
+        return false;
+    }
+    if (golden.width != actual.width || golden.height != actual.height) {
+        std::cout << name << ": " << actual.width << "x" << actual.height << ", golden is "
+                  << golden.width << "x" << golden.height << std::endl;
+        return false;
+    }
+
+    std::vector<unsigned char> heatmap;
+    ImageDiff diff = compareImages(golden.pixels.data(), actual.pixels.data(), golden.width, golden.height, 3,
+                                   threshold, diffDir.empty() ? NULL : &heatmap);
+    bool passes = diff.passes(tolerance);
+    std::cout << name << ": " << (passes ? "ok" : "DIFFERS") << ", " << diff.differing << " pixels ("
+              << diff.differingFraction() * 100.0 << "%) above delta E " << threshold << ", max "
+              << diff.maxDeltaE << ", mean " << diff.meanDeltaE << std::endl;
+    if (!passes && !diffDir.empty()) {
+        std::filesystem::create_directories(diffDir);
+        writePng((std::filesystem::path(diffDir) / name).string(), heatmap.data(), golden.width, golden.height, 3);
+    }
+    return passes;
+}
+
+int main(int argc, char** argv) {
+    float threshold = DIFF_DEFAULT_THRESHOLD;
+    double tolerance = DIFF_DEFAULT_TOLERANCE;
+    std::string diffDir;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--threshold" && i + 1 < argc) {
+            threshold = (float) atof(argv[++i]);
+        } else if (arg == "--tolerance" && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        } else if (arg == "--diff" && i + 1 < argc) {
+            diffDir = argv[++i];
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.size() != 2) {
+        std::cout << "usage: ofs_image_diff [--threshold deltaE] [--tolerance fraction] [--diff dir] <golden> <actual>" << std::endl;
+        return 1;
+    }
+
+    if (!std::filesystem::is_directory(paths[0])) {
+        return compare(paths[0], paths[1], threshold, tolerance, diffDir) ? 0 : 1;
+    }
+    std::vector<std::filesystem::path> goldens;
+    for (const auto &entry : std::filesystem::directory_iterator(paths[0])) {
+        if (entry.path().extension() == ".png") {
+            goldens.push_back(entry.path());
+        }
+    }
+    std::sort(goldens.begin(), goldens.end());
+    int failures = 0;
+    for (const std::filesystem::path &golden : goldens) {
+        std::string actual = (std::filesystem::path(paths[1]) / golden.filename()).string();
+        if (!compare(golden.string(), actual, threshold, tolerance, diffDir)) {
+            failures++;
+        }
+    }
+    std::cout << goldens.size() - failures << " of " << goldens.size() << " frames match" << std::endl;
+    return goldens.empty() || failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,97 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+
+#include <stb_image.h>
+
+#include "ofs/texture_cache.h"
+#include "ofs/ktx2.h"
+#include "ofs/texture_compress.h"
+
+// Converts images to block-compressed KTX2 files next to them, which
+// TextureCache and AsyncTextureLoader then pick up in place of the originals.
+//
+//     ofs_ktx2_encode [--format auto|bc1|bc3|bc5|bc7|etc2|etc2a] [--no-flip] <image or directory>...
+//
+// auto is BC1 for images without alpha and BC7 with it. Images are flipped
+// like loadTexture() does unless --no-flip is given. A footprint report
+// compares the GPU memory of every image uncompressed (the estimate
+// TextureCache uses) and compressed, mips included.
+
+bool isImage(const std::filesystem::path &path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp";
+}
+
+int main(int argc, char** argv) {
+    std::string formatName = "auto";
+    bool flip = true;
+    std::vector<std::filesystem::path> inputs;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc) {
+            formatName = argv[++i];
+        } else if (arg == "--no-flip") {
+            flip = false;
+        } else if (std::filesystem::is_directory(arg)) {
+            for (const auto &entry : std::filesystem::directory_iterator(arg)) {
+                if (isImage(entry.path())) {
+                    inputs.push_back(entry.path());
+                }
+            }
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty() || (formatName != "auto" && ktx2Format(formatName) == NULL)) {
+        std::cout << "usage: ofs_ktx2_encode [--format auto|bc1|bc3|bc5|bc7|etc2|etc2a] [--no-flip] <image or directory>..." << std::endl;
+        return 1;
+    }
+    std::sort(inputs.begin(), inputs.end());
+
+    stbi_set_flip_vertically_on_load(flip);
+    size_t totalBefore = 0, totalAfter = 0;
+    int failures = 0;
+    for (const std::filesystem::path &input : inputs) {
+        int width, height, channels;
+        unsigned char* pixels = stbi_load(input.string().c_str(), &width, &height, &channels, 0);
+        if (pixels == NULL) {
+            std::cout << "Failed to load " << input.string() << std::endl;
+            failures++;
+            continue;
+        }
+        const Ktx2Format* format = formatName == "auto" ? ktx2Format(channels == 4 ? "bc7" : "bc1") : ktx2Format(formatName);
+
+        auto start = std::chrono::steady_clock::now();
+        Ktx2Image image = compressTexture(pixels, width, height, channels, format->vkFormat);
+        image.orientation = flip ? "ru" : "rd";
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        stbi_image_free(pixels);
+
+        std::filesystem::path output = ktx2SiblingPath(input.string());
+        if (!writeKtx2(output.string(), image)) {
+            std::cout << "Failed to write " << output.string() << std::endl;
+            failures++;
+            continue;
+        }
+        size_t before = textureResidentBytes(width, height, channels);
+        size_t after = image.byteSize();
+        totalBefore += before;
+        totalAfter += after;
+        std::cout << input.filename().string() << " -> " << output.filename().string() << ": " << width << "x" << height
+                  << ", " << channels << " channels, " << format->name << ", " << image.levels.size() << " levels, "
+                  << before / 1024 << " KiB -> " << after / 1024 << " KiB (" << (double) before / after << "x), "
+                  << ms << " ms" << std::endl;
+    }
+
+    std::cout << "GPU footprint: " << totalBefore / 1024 << " KiB uncompressed, " << totalAfter / 1024 << " KiB compressed";
+    if (totalAfter > 0) {
+        std::cout << " (" << (double) totalBefore / totalAfter << "x smaller)";
+    }
+    std::cout << std::endl;
+    return failures == 0 ? 0 : 1;
+}